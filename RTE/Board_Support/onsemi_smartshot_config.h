@@ -221,11 +221,72 @@
 
 // </e>
 
+// <q> Enable profiling counters
+// <i> Always-on timing zones, counters and gauges readable over BLE.
+// <i> Zones are also recorded as SystemView markers when trace is enabled.
+// <i> Default: enabled
+#define CFG_SMARTSHOT_PROF_ENABLED  (1)
+
+// <q> Enable TFLM layer profiling
+// <i> Records cycles, kernel variant, MACs and bytes of every model layer and the arena usage after the Prepare of each layer.
+// <i> A CSV report is printed after every inference cycle. Needs additional RAM for the profiler and a larger tensor arena.
+// <i> Default: disabled
+#define CFG_SMARTSHOT_TFLM_LAYER_PROF_ENABLED  (0)
+
+// <o> TFLM invoke time slice [cycles] <0-10000000>
+// <i> Runs the model in slices of at least one layer, each ending once this number of CPU cycles has elapsed, so that the main loop services the BLE stack, the ISP and image transfer between slices.
+// <i> A slice overruns the budget by up to the cycles of the slowest layer. 0 runs the whole inference in one call.
+// <i> Default: 200000 (about 4 ms at 48 MHz)
+#define CFG_SMARTSHOT_TFLM_INVOKE_BUDGET_CYCLES  (200000)
+
 // <q> Enable Deep Sleep
 // <i> Allows to disable the deep sleep feature of RSL10 for debugging purposes.
 // <i> Default: enabled
 #define CFG_SMARTSHOT_APP_SLEEP_ENABLED  (0)
 
+// <e> Enable Deep Sleep during image transfer
+// <i> Allows to enter deep sleep between connection events while image data transfer is blocked by BLE.
+// <i> Deep sleep is entered only if predicted idle time until next connection event exceeds the measured wake-up latency.
+// <i> Requires Deep Sleep to be enabled.
+// <i> Default: disabled
+#define CFG_SMARTSHOT_APP_TRANSFER_SLEEP_ENABLED  (0)
+
+// <o> Minimum idle time margin [us] <0-100000>
+// <i> Idle time required on top of the measured wake-up latency to enter deep sleep during image transfer.
+// <i> Default: 1000 us
+#define CFG_SMARTSHOT_APP_TRANSFER_SLEEP_MARGIN_US  (1000)
+
+// </e>
+
+// <e> Enable streaming preview decode
+// <i> Decodes a low resolution grayscale preview of each image from the image data while they are transferred over BLE.
+// <i> The decoder reads the image cache in place. Transfer waits for it only until the image cache is full, then the preview is dropped.
+// <i> Requires about 6 KB of RAM for the picojpeg decoder state and the preview image.
+// <i> Default: disabled
+#define CFG_SMARTSHOT_APP_PREVIEW_ENABLED  (0)
+
+// <o> Decoder lookahead [ISP data chunks] <1-7>
+// <i> Image data cached ahead of the decoder before it runs, until all image data are read from ISP.
+// <i> Must hold JPEG headers and the largest compressed MCU. Less than the image cache size of 8 chunks.
+// <i> Preview decode of images that do not fit is abandoned.
+// <i> Default: 3
+#define CFG_SMARTSHOT_APP_PREVIEW_LOOKAHEAD_CHUNKS  (3)
+
+// <o> Maximum preview width [px] <1-256>
+// <i> Default: 40
+#define CFG_SMARTSHOT_APP_PREVIEW_WIDTH  (40)
+
+// <o> Maximum preview height [px] <1-256>
+// <i> Default: 30
+#define CFG_SMARTSHOT_APP_PREVIEW_HEIGHT  (30)
+
+// <o> MCUs decoded per main loop iteration <1-1024>
+// <i> Limits main loop latency added by preview decode.
+// <i> Default: 32
+#define CFG_SMARTSHOT_APP_PREVIEW_MCUS_PER_LOOP  (32)
+
+// </e>
+
 // <q> Power up ISP on boot
 // <i> Option to start ISP on application start to allow firmware updates for ISP over USB.
 // <i> Default: disabled
@@ -0,0 +1,62 @@
+/* ----------------------------------------------------------------------------
+ * Copyright (c) 2020 Semiconductor Components Industries, LLC (d/b/a
+ * ON Semiconductor), All Rights Reserved
+ *
+ * This code is the property of ON Semiconductor and may not be redistributed
+ * in any form without prior written permission from ON Semiconductor.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between ON Semiconductor and the licensee.
+ *
+ * This is Reusable Code.
+ *
+ * ----------------------------------------------------------------------------
+ * cycle_counter.h
+ * - DWT cycle counter shared by the profiling zones, the message handler
+ *   statistics and the TFLM time source
+ * ------------------------------------------------------------------------- */
+#ifndef CYCLE_COUNTER_H
+#define CYCLE_COUNTER_H
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+#include <rsl10.h>
+
+/* ----------------------------------------------------------------------------
+ * Function      : void CycleCounter_Enable(void)
+ * ----------------------------------------------------------------------------
+ * Description   : Make sure the DWT cycle counter is running. Its
+ *                 configuration is lost when the core is powered down
+ *                 during deep sleep, so users call this before reading it.
+ *                 The counter is never reset, since the other users may be
+ *                 timing an interval that is still open.
+ * Inputs        : None
+ * Outputs       : None
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+static inline void CycleCounter_Enable(void)
+{
+    if(!(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk))
+    {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+}
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif    /* CYCLE_COUNTER_H */
@@ -14,6 +14,7 @@
  * - Message Handler source file
  * ------------------------------------------------------------------------- */
 #include <rsl10.h>
+#include <cycle_counter.h>
 #include <msg_handler.h>
 #include <ble_gap.h>
 #include <ble_gatt.h>
@@ -21,9 +22,168 @@
 #include <ble_l2c.h>
 #endif /* RTE_BLE_L2CC_ENABLE */
 
-#include <stdlib.h>
+#include <string.h>
 
-static MsgHandler_t *msgHandlerHead = NULL;
+/* Dispatch table keyed by message or task ID using open addressing with
+ * linear probing. Entries are never released once assigned to an ID. */
+static MsgHandler_t msgHandlerTable[MSG_HANDLER_TABLE_SIZE];
+
+/* Registration number of the next added handler */
+static uint32_t msgHandlerNextSeq;
+
+/* ----------------------------------------------------------------------------
+ * Function      : uint8_t MsgHandler_Hash(ke_msg_id_t const msg_id)
+ * ----------------------------------------------------------------------------
+ * Description   : Calculate home index of the ID in the dispatch table using
+ *                 Fibonacci hashing of the 16-bit ID.
+ * Inputs        : msg_id   - A task identifier or a message identifier
+ * Outputs       : Dispatch table index
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+static inline uint8_t MsgHandler_Hash(ke_msg_id_t const msg_id)
+{
+    return (uint8_t)((uint16_t)(msg_id * 40503U)
+                     >> (16 - MSG_HANDLER_TABLE_BITS));
+}
+
+/* ----------------------------------------------------------------------------
+ * Function      : MsgHandler_t * MsgHandler_Find(ke_msg_id_t const msg_id,
+ *                                                bool create)
+ * ----------------------------------------------------------------------------
+ * Description   : Find dispatch table entry assigned to the ID.
+ * Inputs        : msg_id   - A task identifier, such as TASK_ID_GAPM
+ *                            or a message identifier, such as GAPM_CMP_EVT;
+ *                 create   - Assign free entry to the ID if not found
+ * Outputs       : Table entry, NULL if not found or table is full
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+static MsgHandler_t * MsgHandler_Find(ke_msg_id_t const msg_id, bool create)
+{
+    uint8_t idx = MsgHandler_Hash(msg_id);
+
+    for(uint8_t i = 0; i < MSG_HANDLER_TABLE_SIZE; i++)
+    {
+        MsgHandler_t *entry = &msgHandlerTable[idx];
+
+        if(!entry->used) /* Free entry terminates the probe sequence */
+        {
+            if(!create)
+            {
+                return NULL;
+            }
+
+            entry->used = true;
+            entry->msg_id = msg_id;
+            return entry;
+        }
+
+        if(entry->msg_id == msg_id)
+        {
+            return entry;
+        }
+
+        idx = (idx + 1) & (MSG_HANDLER_TABLE_SIZE - 1);
+    }
+
+    return NULL;
+}
+
+#if MSG_HANDLER_STATS_ENABLED
+/* ----------------------------------------------------------------------------
+ * Function      : void MsgHandler_UpdateStats(MsgHandler_t *entry,
+ *                                             uint32_t cycles)
+ * ----------------------------------------------------------------------------
+ * Description   : Count a dispatched message of the entry and the time its
+ *                 handlers took
+ * Inputs        : entry    - Dispatch table entry, may be NULL
+ *                 cycles   - CPU cycles of all handlers of the entry
+ * Outputs       : None
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+static inline void MsgHandler_UpdateStats(MsgHandler_t *entry, uint32_t cycles)
+{
+    if(entry)
+    {
+        entry->notify_count++;
+        if(cycles > entry->max_cycles)
+        {
+            entry->max_cycles = cycles;
+        }
+    }
+}
+#endif /* MSG_HANDLER_STATS_ENABLED */
+
+/* ----------------------------------------------------------------------------
+ * Function      : void MsgHandler_Dispatch(MsgHandler_t *task_entry,
+ *                               MsgHandler_t *msg_entry,
+ *                               ke_msg_id_t const msg_id, void *param,
+ *                               ke_task_id_t const dest_id,
+ *                               ke_task_id_t const src_id)
+ * ----------------------------------------------------------------------------
+ * Description   : Call all handlers of the dispatch table entries of the task
+ *                 and of the message in order of registration, like the
+ *                 previous linked list did, and update their statistics
+ * Inputs        : task_entry - Dispatch table entry of the task, may be NULL
+ *                 msg_entry  - Dispatch table entry of the message, may be
+ *                              NULL
+ *                 msg_id     - Kernel message ID number
+ *                 param      - Message parameter
+ *                 dest_id    - destination task
+ *                 src_id     - source task
+ * Outputs       : None
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+static void MsgHandler_Dispatch(MsgHandler_t *task_entry,
+                                MsgHandler_t *msg_entry,
+                                ke_msg_id_t const msg_id, void *param,
+                                ke_task_id_t const dest_id,
+                                ke_task_id_t const src_id)
+{
+    uint8_t task_count = task_entry ? task_entry->count : 0;
+    uint8_t msg_count = msg_entry ? msg_entry->count : 0;
+    uint8_t t = 0;
+    uint8_t m = 0;
+#if MSG_HANDLER_STATS_ENABLED
+    uint32_t task_cycles = 0;
+    uint32_t msg_cycles = 0;
+#endif /* MSG_HANDLER_STATS_ENABLED */
+
+    /* Both handler lists are in order of registration, merge them */
+    while((t < task_count) || (m < msg_count))
+    {
+        bool from_task = (m >= msg_count)
+                         || ((t < task_count)
+                             && (task_entry->seq[t] < msg_entry->seq[m]));
+#if MSG_HANDLER_STATS_ENABLED
+        uint32_t start = DWT->CYCCNT;
+#endif /* MSG_HANDLER_STATS_ENABLED */
+
+        if(from_task)
+        {
+            task_entry->callback[t++](msg_id, param, dest_id, src_id);
+        }
+        else
+        {
+            msg_entry->callback[m++](msg_id, param, dest_id, src_id);
+        }
+
+#if MSG_HANDLER_STATS_ENABLED
+        if(from_task)
+        {
+            task_cycles += DWT->CYCCNT - start;
+        }
+        else
+        {
+            msg_cycles += DWT->CYCCNT - start;
+        }
+#endif /* MSG_HANDLER_STATS_ENABLED */
+    }
+
+#if MSG_HANDLER_STATS_ENABLED
+    MsgHandler_UpdateStats(task_entry, task_cycles);
+    MsgHandler_UpdateStats(msg_entry, msg_cycles);
+#endif /* MSG_HANDLER_STATS_ENABLED */
+}
 
 /* ----------------------------------------------------------------------------
  * Function      : bool MsgHandler_Add(ke_msg_id_t const msg_id,
@@ -31,43 +191,41 @@ static MsgHandler_t *msgHandlerHead = NULL;
  *                               void const *param, ke_task_id_t const dest_id,
  *                               ke_task_id_t const src_id))
  * ----------------------------------------------------------------------------
- * Description   : Add a message handler to the linked list of handlers.
+ * Description   : Add a message handler to the dispatch table entry of the
+ *                 given ID. Handlers of the same ID are called in order of
+ *                 registration.
  * Inputs        : msg_id   - A task identifier, such as TASK_ID_GAPM
  *                            or a message identifier, such as GAPM_CMP_EVT;
  *                 callback - A callback function associated to the msg_id
- * Outputs       : true if successful, false otherwise
+ * Outputs       : true if successful, false if the dispatch table or the
+ *                 handler list of the ID is full
  * Assumptions   : None
  * ------------------------------------------------------------------------- */
 bool MsgHandler_Add(ke_msg_id_t const msg_id,
                     void (*callback)(ke_msg_id_t const msg_id, void const *param,
                     ke_task_id_t const dest_id, ke_task_id_t const src_id))
 {
-    MsgHandler_t *newElem = malloc(sizeof(MsgHandler_t));
+    MsgHandler_t *entry = MsgHandler_Find(msg_id, true);
 
-    if(!newElem) /* Malloc error */
+    if(!entry) /* Dispatch table is full */
     {
         return false;
     }
 
-    newElem->msg_id = msg_id;
-    newElem->callback = callback;
-    newElem->next = NULL;
+    /* Avoid handler duplication, in case it already exists */
+    MsgHandler_Remove(msg_id, callback);
 
-    if(!msgHandlerHead) /* If list is empty, newElem will be the new head */
+    if(entry->count >= MSG_HANDLER_MAX_FANOUT)
     {
-        msgHandlerHead = newElem;
+        return false;
     }
-    else
-    {
-        MsgHandler_t *tmp = msgHandlerHead;
-        MsgHandler_Remove(msg_id, callback); /* Avoid handler duplication, in case it already exists */
 
-        while(tmp->next) /* Go to the end of the list */
-        {
-            tmp = tmp->next;
-        }
-        tmp->next = newElem; /* Insert newElem at the end of the list */
-    }
+    entry->seq[entry->count] = msgHandlerNextSeq++;
+    entry->callback[entry->count++] = callback;
+
+#if MSG_HANDLER_TRACE_ENABLED
+    MsgHandler_TraceAdd(msg_id, callback);
+#endif /* MSG_HANDLER_TRACE_ENABLED */
 
     return true;
 }
@@ -78,50 +236,40 @@ bool MsgHandler_Add(ke_msg_id_t const msg_id,
  *                               void const *param, ke_task_id_t const dest_id,
  *                               ke_task_id_t const src_id))
  * ----------------------------------------------------------------------------
- * Description   : Remove message handler from list
+ * Description   : Remove message handler from dispatch table
  * Inputs        : msg_id   - A task identifier, such as TASK_ID_GAPM
  *                            or a message identifier, such as GAPM_CMP_EVT;
  *                 callback - A callback function associated to the msg_id
- * Outputs       : None
+ * Outputs       : true if the handler was removed, false otherwise
  * Assumptions   : None
  * ------------------------------------------------------------------------- */
 bool MsgHandler_Remove(ke_msg_id_t const msg_id,
                        void (*callback)(ke_msg_id_t const msg_id, void const *param,
                                         ke_task_id_t const dest_id, ke_task_id_t const src_id))
 {
-    MsgHandler_t *tmp, *prev;
-    bool removed = false;
+    MsgHandler_t *entry = MsgHandler_Find(msg_id, false);
 
-    if(!msgHandlerHead)
+    if(!entry)
     {
         return false;
     }
 
-    tmp = msgHandlerHead;
-
-    /* If the element to be removed is the head of the list */
-    if((msgHandlerHead->msg_id == msg_id) && (msgHandlerHead->callback == callback))
+    for(uint8_t i = 0; i < entry->count; i++)
     {
-        msgHandlerHead = msgHandlerHead->next;
-        free(tmp);
-        removed = true;
-    }
-    else /* Search the remainder of the list */
-    {
-        do {
-            prev = tmp; /* Keep track of previous element */
-            tmp = tmp->next;
-        } while(tmp && ((tmp->msg_id != msg_id) || (tmp->callback != callback)));
-
-        if(tmp) /* if element found */
+        if(entry->callback[i] == callback)
         {
-            prev->next = tmp->next; /* Remove element from list */
-            free(tmp);
-            removed = true;
+            /* Keep registration order of remaining handlers */
+            entry->count--;
+            memmove(&entry->callback[i], &entry->callback[i + 1],
+                    (entry->count - i) * sizeof(entry->callback[0]));
+            memmove(&entry->seq[i], &entry->seq[i + 1],
+                    (entry->count - i) * sizeof(entry->seq[0]));
+            entry->callback[entry->count] = NULL;
+            return true;
         }
     }
 
-    return removed;
+    return false;
 }
 
 /* ----------------------------------------------------------------------------
@@ -129,9 +277,12 @@ bool MsgHandler_Remove(ke_msg_id_t const msg_id,
  *                               void const *param, ke_task_id_t const dest_id,
  *                               ke_task_id_t const src_id)
  * ----------------------------------------------------------------------------
- * Description   : Search the lists and call back the functions associated with
- *                 the msg_id, following the priority order (HIGH to LOW). This
- *                 function was designed to be used as the default handler of
+ * Description   : Look up the dispatch table entries of the task and of the
+ *                 msg_id and call back the functions associated with them.
+ *                 Handlers subscribed to the whole task and handlers of the
+ *                 specific message are called in order of registration,
+ *                 like with the previous linked list. This function was
+ *                 designed to be used as the default handler of
  *                 the kernel and shall NOT be called directly by the
  *                 application. To notify an event, the application should
  *                 enqueue a message in the kernel, in order to avoid chaining
@@ -147,9 +298,14 @@ bool MsgHandler_Remove(ke_msg_id_t const msg_id,
 int MsgHandler_Notify(ke_msg_id_t const msg_id, void *param,
                       ke_task_id_t const dest_id, ke_task_id_t const src_id)
 {
-    MsgHandler_t *tmp = msgHandlerHead;
+    MsgHandler_t *task_entry;
+    MsgHandler_t *msg_entry;
     uint8_t task_id = KE_IDX_GET(msg_id);
 
+#if MSG_HANDLER_TRACE_ENABLED
+    MsgHandler_TraceNotify(msg_id, dest_id, src_id);
+#endif /* MSG_HANDLER_TRACE_ENABLED */
+
     /* First notify abstraction layer handlers */
     switch(task_id)
     {
@@ -172,16 +328,53 @@ int MsgHandler_Notify(ke_msg_id_t const msg_id, void *param,
 #endif /* RTE_BLE_L2CC_ENABLE */
     }
 
-    /* Notify subscribed application/profile handlers */
-    while(tmp)
+#if MSG_HANDLER_STATS_ENABLED
+    CycleCounter_Enable();
+#endif /* MSG_HANDLER_STATS_ENABLED */
+
+    /* Notify application/profile handlers subscribed to the whole task and
+     * to this message */
+    task_entry = MsgHandler_Find(task_id, false);
+    msg_entry = (msg_id != task_id) ? MsgHandler_Find(msg_id, false) : NULL;
+    MsgHandler_Dispatch(task_entry, msg_entry, msg_id, param, dest_id, src_id);
+
+    return KE_MSG_CONSUMED;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function      : const MsgHandler_t * MsgHandler_GetEntry(uint8_t index)
+ * ----------------------------------------------------------------------------
+ * Description   : Access dispatch table entry, e.g. to report its statistics
+ * Inputs        : index    - Table index, 0 to MSG_HANDLER_TABLE_SIZE - 1
+ * Outputs       : Table entry, NULL if index is out of range or entry is
+ *                 not assigned to any ID
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+const MsgHandler_t * MsgHandler_GetEntry(uint8_t index)
+{
+    if(index >= MSG_HANDLER_TABLE_SIZE || !msgHandlerTable[index].used)
     {
-        /* If message ID matches or the handler should be called for all
-         * messages of this task type */
-        if((tmp->msg_id == msg_id) || (tmp->msg_id == task_id))
-        {
-            tmp->callback(msg_id, param, dest_id, src_id);
-        }
-        tmp = tmp->next;
+        return NULL;
     }
-    return KE_MSG_CONSUMED;
+
+    return &msgHandlerTable[index];
+}
+
+/* ----------------------------------------------------------------------------
+ * Function      : void MsgHandler_ResetStats(void)
+ * ----------------------------------------------------------------------------
+ * Description   : Clear dispatch count and maximum handler time of all IDs
+ * Inputs        : None
+ * Outputs       : None
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+void MsgHandler_ResetStats(void)
+{
+#if MSG_HANDLER_STATS_ENABLED
+    for(uint8_t i = 0; i < MSG_HANDLER_TABLE_SIZE; i++)
+    {
+        msgHandlerTable[i].notify_count = 0;
+        msgHandlerTable[i].max_cycles = 0;
+    }
+#endif /* MSG_HANDLER_STATS_ENABLED */
 }
@@ -10,8 +10,8 @@
  * This is Reusable Code.
  *
  * ----------------------------------------------------------------------------
- * event.h
- * - Simple event listener implementation based on a linked list
+ * msg_handler.h
+ * - Kernel message dispatch table keyed by message or task ID
  * ------------------------------------------------------------------------- */
 #ifndef MSG_HANDLER_H
 #define MSG_HANDLER_H
@@ -32,11 +32,50 @@ extern "C"
 #include <stdint.h>
 #include <stdbool.h>
 
+/* ----------------------------------------------------------------------------
+ * Defines
+ * --------------------------------------------------------------------------*/
+
+/* Number of bits of the dispatch table index. Table has 2^BITS entries. */
+#ifndef MSG_HANDLER_TABLE_BITS
+#define MSG_HANDLER_TABLE_BITS          5
+#endif
+
+/* Number of entries in the dispatch table (distinct message / task IDs) */
+#define MSG_HANDLER_TABLE_SIZE          (1U << MSG_HANDLER_TABLE_BITS)
+
+/* Maximum number of handlers subscribed to single message / task ID */
+#ifndef MSG_HANDLER_MAX_FANOUT
+#define MSG_HANDLER_MAX_FANOUT          4
+#endif
+
+/* Collect per ID dispatch count and maximum handler execution time */
+#ifndef MSG_HANDLER_STATS_ENABLED
+#define MSG_HANDLER_STATS_ENABLED       1
+#endif
+
+/* Report every subscription and dispatched message to the application, e.g.
+ * to record a trace for the host replay benchmark in test/host */
+#ifndef MSG_HANDLER_TRACE_ENABLED
+#define MSG_HANDLER_TRACE_ENABLED       0
+#endif
+
+typedef void (*MsgHandler_Callback_t)(ke_msg_id_t const msg_id,
+                                      void const *param,
+                                      ke_task_id_t const dest_id,
+                                      ke_task_id_t const src_id);
+
+/* Dispatch table entry holding all handlers subscribed to one ID */
 typedef struct MsgHandler {
     uint16_t msg_id;
-    void (*callback)(ke_msg_id_t const msg_id, void const *param,
-                     ke_task_id_t const dest_id, ke_task_id_t const src_id);
-    struct MsgHandler *next;
+    bool used;                  /* Entry is assigned to msg_id */
+    uint8_t count;              /* Number of subscribed callbacks */
+    MsgHandler_Callback_t callback[MSG_HANDLER_MAX_FANOUT];
+    uint32_t seq[MSG_HANDLER_MAX_FANOUT]; /* Registration number of callback */
+#if MSG_HANDLER_STATS_ENABLED
+    uint32_t notify_count;      /* Number of dispatched messages */
+    uint32_t max_cycles;        /* Longest run of all handlers in CPU cycles */
+#endif /* MSG_HANDLER_STATS_ENABLED */
 } MsgHandler_t;
 
 bool MsgHandler_Add(ke_msg_id_t const msg_id,
@@ -50,6 +89,20 @@ bool MsgHandler_Remove(ke_msg_id_t const msg_id,
 int MsgHandler_Notify(ke_msg_id_t const msg_id, void *param,
                       ke_task_id_t const dest_id, ke_task_id_t const src_id);
 
+const MsgHandler_t * MsgHandler_GetEntry(uint8_t index);
+
+void MsgHandler_ResetStats(void);
+
+#if MSG_HANDLER_TRACE_ENABLED
+/* Trace hooks, provided by the application */
+void MsgHandler_TraceAdd(ke_msg_id_t const msg_id,
+                         MsgHandler_Callback_t callback);
+
+void MsgHandler_TraceNotify(ke_msg_id_t const msg_id,
+                            ke_task_id_t const dest_id,
+                            ke_task_id_t const src_id);
+#endif /* MSG_HANDLER_TRACE_ENABLED */
+
 /* ----------------------------------------------------------------------------
  * Close the 'extern "C"' block
  * ------------------------------------------------------------------------- */
@@ -49,12 +49,14 @@ extern "C"
 #include "calibration.h"
 #include "app_sleep.h"
 #include "app_trace.h"
+#include "app_prof.h"
 #include "app_rtc.h"
 #include "app_ble_peripheral_server.h"
 #include "app_ble_ptss.h"
 #include "app_ble_estss.h"
 #include "app_ble_dfus.h"
 #include "app_circbuf.h"
+#include "app_preview.h"
 
 
 /* ----------------------------------------------------------------------------
@@ -135,10 +137,10 @@ typedef struct APP_Environemnt_t
     /**
      * Used to calculate time of transmission of image data over BLE.
      *
-     * Time from receiving of data transfer request to last data packet
-     * transmission.
+     * Time in microseconds from receiving of data transfer request to last
+     * data packet transmission.
      */
-    uint32_t time_transfer_start;
+    uint64_t time_transfer_start;
 
     /** Store captured image size on application level.
      *
@@ -146,6 +148,22 @@ typedef struct APP_Environemnt_t
      */
     uint32_t img_size;
 
+    /**
+     * RTC time in microseconds of the last connection event that acknowledged
+     * image data packets.
+     *
+     * Used as anchor to predict time of next connection event during image
+     * data transfer.
+     */
+    uint64_t time_conn_event_us;
+
+    /**
+     * time_conn_event_us was set in the current image data transfer.
+     *
+     * Cleared on new connection and on start of image data transfer.
+     */
+    bool conn_event_valid;
+
     /** Store flag if DFU Initiated switch to FOTA Update Mode.
      *
      * Set by DFUS callback and is used to enter Device Firmware Update mode.
@@ -179,6 +197,8 @@ void APP_PTSS_EventHandler(PTSS_ControlPointOpCode_t opcode,
 
 void APP_ESTSS_EventHandler(ESTSS_TriggerId_t trigger_id);
 
+void APP_PREVIEW_EventHandler(const APP_PREVIEW_Image_t *p_img);
+
 /* ----------------------------------------------------------------------------
  * Close the 'extern "C"' block
  * ------------------------------------------------------------------------- */
@@ -69,8 +69,31 @@ typedef struct CIRCBUF_t
      * ::tail index.
      */
     bool is_full;
+
+    /**
+     * Total number of bytes popped since initialization.
+     *
+     * Allows cursors to detect that data they did not read yet were popped.
+     */
+    uint32_t pop_count;
 } CIRCBUF_t;
 
+/**
+ * Read position in a circular buffer that does not consume the data it reads.
+ *
+ * Data stay in the buffer for the consumer that pops them. Cursor that falls
+ * behind the consumer is overrun and cannot read any more data, the consumer
+ * can use @ref CIRCBUF_CursorGetUsed to leave unread data in the buffer.
+ */
+typedef struct CIRCBUF_Cursor_t
+{
+    /**
+     * Number of bytes popped from the buffer when the cursor reaches its
+     * current position. Compared to ::CIRCBUF_t::pop_count.
+     */
+    uint32_t offset;
+} CIRCBUF_Cursor_t;
+
 /* ----------------------------------------------------------------------------
  * Function declarations
  * --------------------------------------------------------------------------*/
@@ -97,6 +120,7 @@ typedef struct CIRCBUF_t
  * - `ENSURE(obj->head == 0)`
  * - `ENSURE(obj->tail == 0)`
  * - `ENSURE(obj->is_full == false)`
+ * - `ENSURE(obj->pop_count == 0)`
  *
  * @param p_buf
  * Pointer to byte array to use for storing of data.
@@ -257,6 +281,94 @@ int32_t CIRCBUF_PushBack(uint8_t *p_data, size_t data_size, CIRCBUF_t *obj);
  */
 int32_t CIRCBUF_PopFront(uint8_t *p_data, size_t data_size, CIRCBUF_t *obj);
 
+/**
+ * Place cursor at the front of the circular buffer.
+ *
+ * @pre
+ * Following requirements must be met:
+ *
+ * - `REQUIRE(obj != NULL)`
+ * - `REQUIRE(cursor != NULL)`
+ * - @p obj was already initialized using @ref CIRCBUF_Initialize
+ *
+ * @post
+ * - The circular buffer @p obj is not modified.
+ * - `ENSURE(cursor->offset == obj->pop_count)`
+ *
+ * @param obj
+ * Circular buffer object to be read by the cursor.
+ *
+ * @param cursor
+ * Cursor to initialize.
+ */
+void CIRCBUF_CursorInitialize(const CIRCBUF_t *obj, CIRCBUF_Cursor_t *cursor);
+
+/**
+ * Returns number of bytes that can be read by the cursor.
+ *
+ * @pre
+ * Following requirements must be met:
+ *
+ * - `REQUIRE(obj != NULL)`
+ * - `REQUIRE(cursor != NULL)`
+ * - @p cursor was initialized using @ref CIRCBUF_CursorInitialize with @p obj
+ *
+ * @post
+ * - Returned value is not larger than number of bytes returned by
+ *   @ref CIRCBUF_GetUsed.
+ * - The circular buffer @p obj and the @p cursor are not modified.
+ *
+ * @param obj
+ * Circular buffer object read by the cursor.
+ *
+ * @param cursor
+ * Cursor to check.
+ *
+ * @return
+ * Number of bytes between the @p cursor and the back of the circular buffer.
+ * 0 if the cursor is overrun.
+ */
+size_t CIRCBUF_CursorGetUsed(const CIRCBUF_t *obj,
+        const CIRCBUF_Cursor_t *cursor);
+
+/**
+ * Copies given amount of bytes at the cursor and advances the cursor without
+ * removing them from the circular buffer.
+ *
+ * @pre
+ * Following requirements must be met:
+ *
+ * - `REQUIRE(p_data != NULL)`
+ * - `REQUIRE(data_size > 0)`
+ * - `REQUIRE(obj != NULL)`
+ * - `REQUIRE(cursor != NULL)`
+ * - @p cursor was initialized using @ref CIRCBUF_CursorInitialize with @p obj
+ *
+ * @post
+ * - The circular buffer @p obj is not modified.
+ * - The @p cursor is modified only if it can read @p data_size bytes.
+ *
+ * @param p_data
+ * Pointer to byte array to store data read from the circular buffer @p obj .
+ *
+ * @param data_size
+ * Number of bytes to read.
+ * @p p_data array must be at least @p data_size bytes long.
+ *
+ * @param obj
+ * Circular buffer object read by the cursor.
+ *
+ * @param cursor
+ * Cursor to read from.
+ *
+ * @return
+ * 0  - On success. <br>
+ * -1 - On failure. If the cursor is overrun or requested more data than
+ *      available at the cursor.
+ */
+int32_t CIRCBUF_CursorRead(uint8_t *p_data, size_t data_size,
+        const CIRCBUF_t *obj, CIRCBUF_Cursor_t *cursor);
+
 /* ----------------------------------------------------------------------------
  * Close the 'extern "C"' block
  * ------------------------------------------------------------------------- */
@@ -0,0 +1,202 @@
+/* ----------------------------------------------------------------------------
+ * Copyright (c) 2020 Semiconductor Components Industries, LLC (d/b/a
+ * ON Semiconductor), All Rights Reserved
+ *
+ * This code is the property of ON Semiconductor and may not be redistributed
+ * in any form without prior written permission from ON Semiconductor.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between ON Semiconductor and the licensee.
+ *
+ * This is Reusable Code.
+ * ------------------------------------------------------------------------- */
+
+/**
+ * @file app_preview.h
+ *
+ * Streaming preview decode of JPEG image data during image transfer.
+ *
+ * The main loop feeds image data to picojpeg through its need bytes callback,
+ * which reads the image cache with a cursor that leaves the data for the
+ * image transfer. A grayscale preview is decoded at 1/8 scale and box
+ * filtered down to at most APP_PREVIEW_WIDTH x APP_PREVIEW_HEIGHT pixels.
+ *
+ * No additional ISP read, no copy of the image data and no full frame buffer
+ * are needed. The preview is complete as soon as the last image data chunk
+ * was read from ISP, which allows to attach analysis results to the image
+ * before the peer device finishes downloading it.
+ *
+ * The image transfer sends only image data the decoder already read, see
+ * @ref APP_PREVIEW_GetUnreadSize. ISP reads are never throttled by the
+ * decoder: once the image cache is full and only the unread data keep the
+ * transfer waiting, the application drops the preview with
+ * @ref APP_PREVIEW_Abort.
+ *
+ * All functions are intended to be called from main loop context only.
+ */
+
+#ifndef APP_PREVIEW_H
+#define APP_PREVIEW_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <onsemi_smartshot.h>
+#include <onsemi_smartshot_config.h>
+
+#include "app_circbuf.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+/** Maximum width of the preview image in pixels. */
+#define APP_PREVIEW_WIDTH              (CFG_SMARTSHOT_APP_PREVIEW_WIDTH)
+
+/** Maximum height of the preview image in pixels. */
+#define APP_PREVIEW_HEIGHT             (CFG_SMARTSHOT_APP_PREVIEW_HEIGHT)
+
+/** Grayscale preview of a captured image. */
+typedef struct APP_PREVIEW_Image_t
+{
+    /** 8-bit luma pixels in raster order, @ref width bytes per row. */
+    const uint8_t *p_pixels;
+
+    /** Preview width in pixels. Not larger than APP_PREVIEW_WIDTH. */
+    uint16_t width;
+
+    /** Preview height in pixels. Not larger than APP_PREVIEW_HEIGHT. */
+    uint16_t height;
+
+    /** Width of the captured image in pixels. */
+    uint16_t img_width;
+
+    /** Height of the captured image in pixels. */
+    uint16_t img_height;
+} APP_PREVIEW_Image_t;
+
+/**
+ * Application callback called once the preview of an image is decoded.
+ *
+ * The preview is valid only for the duration of the call.
+ */
+typedef void (*APP_PREVIEW_Handler)(const APP_PREVIEW_Image_t *p_img);
+
+/* ----------------------------------------------------------------------------
+ * Function declarations
+ * --------------------------------------------------------------------------*/
+
+#if (CFG_SMARTSHOT_APP_PREVIEW_ENABLED == 1)
+
+/**
+ * Initialize preview decoder.
+ *
+ * @pre
+ * - `REQUIRE(handler != NULL)`
+ *
+ * @param handler
+ * Application callback that receives decoded previews.
+ */
+void APP_PREVIEW_Initialize(APP_PREVIEW_Handler handler);
+
+/**
+ * Start preview decode of a new image.
+ *
+ * Any ongoing preview decode is abandoned.
+ *
+ * @pre
+ * - `REQUIRE(p_cache != NULL)`
+ *
+ * @param p_cache
+ * Image cache that receives the image data from ISP, read from its current
+ * front. Must stay valid until the preview decode is completed or abandoned.
+ *
+ * @param img_size
+ * Total size of the image data in bytes as reported by ISP.
+ */
+void APP_PREVIEW_Start(const CIRCBUF_t *p_cache, uint32_t img_size);
+
+/** Abandon ongoing preview decode, if any. */
+void APP_PREVIEW_Abort(void);
+
+/**
+ * Returns number of bytes at the back of the image cache not yet read by the
+ * decoder.
+ *
+ * The image transfer must leave them in the image cache.
+ *
+ * @return
+ * Number of unread bytes. 0 if no preview decode is in progress.
+ */
+size_t APP_PREVIEW_GetUnreadSize(void);
+
+/**
+ * Check if the preview decoder has data it can decode right now.
+ *
+ * Main loop must not wait for interrupt or enter deep sleep while this returns
+ * true.
+ */
+bool APP_PREVIEW_IsBusy(void);
+
+/**
+ * Decode cached image data.
+ *
+ * Decodes at most CFG_SMARTSHOT_APP_PREVIEW_MCUS_PER_LOOP MCUs per call to
+ * keep main loop latency low. Calls the application callback after the last
+ * MCU of the image was decoded.
+ *
+ * @return
+ * true - Decoder read more image data or stopped. Image data held back for
+ *        the decoder can be sent. <br>
+ * false - Otherwise.
+ */
+bool APP_PREVIEW_Process(void);
+
+#else /* if (CFG_SMARTSHOT_APP_PREVIEW_ENABLED == 1) */
+
+static inline void APP_PREVIEW_Initialize(APP_PREVIEW_Handler handler)
+{
+    (void) handler;
+}
+
+static inline void APP_PREVIEW_Start(const CIRCBUF_t *p_cache,
+        uint32_t img_size)
+{
+    (void) p_cache;
+    (void) img_size;
+}
+
+static inline void APP_PREVIEW_Abort(void)
+{
+}
+
+static inline size_t APP_PREVIEW_GetUnreadSize(void)
+{
+    return 0;
+}
+
+static inline bool APP_PREVIEW_IsBusy(void)
+{
+    return false;
+}
+
+static inline bool APP_PREVIEW_Process(void)
+{
+    return false;
+}
+
+#endif /* if (CFG_SMARTSHOT_APP_PREVIEW_ENABLED == 1) */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_PREVIEW_H */
@@ -0,0 +1,252 @@
+/* ----------------------------------------------------------------------------
+ * Copyright (c) 2020 Semiconductor Components Industries, LLC (d/b/a
+ * ON Semiconductor), All Rights Reserved
+ *
+ * This code is the property of ON Semiconductor and may not be redistributed
+ * in any form without prior written permission from ON Semiconductor.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between ON Semiconductor and the licensee.
+ *
+ * This is Reusable Code.
+ * ------------------------------------------------------------------------- */
+
+/**
+ * @file app_prof.h
+ *
+ * Lightweight always-on profiling counters.
+ *
+ * Provides named timing zones measured by the DWT cycle counter, event
+ * counters and gauges. Aggregated statistics can be printed or serialized
+ * into a snapshot that is exposed over BLE by the Profiling Statistics
+ * Service. Zones are also recorded as SystemView markers when trace is
+ * enabled.
+ *
+ * All functions are intended to be called from main loop context only.
+ */
+
+#ifndef APP_PROF_H
+#define APP_PROF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+#include <rsl10.h>
+#include <onsemi_smartshot_config.h>
+
+#include "app_trace.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * ------------------------------------------------------------------------- */
+
+/** Version of the serialized statistics snapshot layout. */
+#define APP_PROF_SNAPSHOT_VERSION      (1)
+
+/** Timing zones measured in CPU cycles. */
+typedef enum APP_PROF_ZoneId_t
+{
+    /** ISP library main loop processing. */
+    APP_PROF_ZONE_ISP,
+
+    /** Push of cached image data into PTSS. */
+    APP_PROF_ZONE_PTSS_PUSH,
+
+    /** ESTSS trigger value notification. */
+    APP_PROF_ZONE_ESTSS_NOTIFY,
+
+    /** TensorFlow Lite Micro inference. */
+    APP_PROF_ZONE_TFLM_INVOKE,
+
+    /** Device_PrepareForSleep before deep sleep entry. */
+    APP_PROF_ZONE_SLEEP_PREPARE,
+
+    /** Device_Wakeup after deep sleep. */
+    APP_PROF_ZONE_SLEEP_WAKEUP,
+
+    /** Streaming preview decode of image data. */
+    APP_PROF_ZONE_PREVIEW,
+
+    APP_PROF_ZONE_COUNT
+} APP_PROF_ZoneId_t;
+
+/** Monotonic event counters. */
+typedef enum APP_PROF_CounterId_t
+{
+    /** Image data bytes read from ISP. */
+    APP_PROF_CNT_ISP_BYTES,
+
+    /** Image data bytes pushed into PTSS. */
+    APP_PROF_CNT_PTSS_BYTES,
+
+    /** ESTSS notifications sent. */
+    APP_PROF_CNT_ESTSS_NOTIFY,
+
+    /** Deep sleep wake-ups. */
+    APP_PROF_CNT_SLEEP_WAKEUP,
+
+    /** Deep sleep entries refused by BLE stack. */
+    APP_PROF_CNT_SLEEP_REFUSED,
+
+    /** MCUs decoded by streaming preview decoder. */
+    APP_PROF_CNT_PREVIEW_MCUS,
+
+    APP_PROF_CNT_COUNT
+} APP_PROF_CounterId_t;
+
+/** Gauges keeping current and peak value. */
+typedef enum APP_PROF_GaugeId_t
+{
+    /** Used space in image data cache in bytes. */
+    APP_PROF_GAUGE_IMG_CACHE_USED,
+
+    APP_PROF_GAUGE_COUNT
+} APP_PROF_GaugeId_t;
+
+/** Aggregated statistics of single timing zone. */
+typedef struct APP_PROF_Zone_t
+{
+    /** Number of completed zone executions. */
+    uint32_t count;
+
+    /** Longest zone execution in CPU cycles. */
+    uint32_t max_cycles;
+
+    /** Sum of all zone executions in CPU cycles. */
+    uint64_t total_cycles;
+} APP_PROF_Zone_t;
+
+/** Current and peak value of a gauge. */
+typedef struct APP_PROF_Gauge_t
+{
+    uint32_t value;
+    uint32_t peak;
+} APP_PROF_Gauge_t;
+
+/**
+ * Size of serialized statistics snapshot in bytes.
+ *
+ * Header: version, zone count, counter count, gauge count (1 byte each),
+ *         CPU frequency in Hz (4 bytes). <br>
+ * Zones: count, max_cycles (4 bytes each), total_cycles (8 bytes). <br>
+ * Counters: value (4 bytes). <br>
+ * Gauges: value, peak (4 bytes each).
+ *
+ * All values are little endian.
+ */
+#define APP_PROF_SNAPSHOT_SIZE         (8 + (APP_PROF_ZONE_COUNT * 16) \
+                                        + (APP_PROF_CNT_COUNT * 4) \
+                                        + (APP_PROF_GAUGE_COUNT * 8))
+
+extern APP_PROF_Zone_t app_prof_zone[APP_PROF_ZONE_COUNT];
+
+extern uint32_t app_prof_counter[APP_PROF_CNT_COUNT];
+
+extern APP_PROF_Gauge_t app_prof_gauge[APP_PROF_GAUGE_COUNT];
+
+/**
+ * Enable DWT cycle counter.
+ *
+ * Must be called after reset and after every deep sleep wake-up since the
+ * debug block is not retained. No-op if profiling is disabled.
+ */
+void APP_PROF_Resume(void);
+
+/** Clear all zone statistics, counters and gauges. */
+void APP_PROF_Reset(void);
+
+/** Print all statistics to debug terminal. */
+void APP_PROF_Print(void);
+
+/**
+ * Serialize current statistics into snapshot format described by
+ * @ref APP_PROF_SNAPSHOT_SIZE.
+ *
+ * @param p_buf
+ * Output buffer of at least APP_PROF_SNAPSHOT_SIZE bytes.
+ */
+void APP_PROF_Snapshot(uint8_t *p_buf);
+
+#if (CFG_SMARTSHOT_PROF_ENABLED == 1)
+
+/**
+ * Start timing zone.
+ *
+ * @return
+ * Cycle counter value to be passed to @ref APP_PROF_ZoneExit.
+ */
+static inline uint32_t APP_PROF_ZoneEnter(APP_PROF_ZoneId_t id)
+{
+    APP_TRACE_MARK_START(APP_TRACE_MARKER_PROF_ZONE + id);
+    (void) id;
+
+    return DWT->CYCCNT;
+}
+
+/** Stop timing zone and aggregate its duration. */
+static inline void APP_PROF_ZoneExit(APP_PROF_ZoneId_t id, uint32_t start)
+{
+    uint32_t cycles = DWT->CYCCNT - start;
+    APP_PROF_Zone_t *p_zone = &app_prof_zone[id];
+
+    p_zone->count += 1;
+    p_zone->total_cycles += cycles;
+    if (cycles > p_zone->max_cycles)
+    {
+        p_zone->max_cycles = cycles;
+    }
+
+    APP_TRACE_MARK_STOP(APP_TRACE_MARKER_PROF_ZONE + id);
+}
+
+/** Increment counter by @p n. */
+static inline void APP_PROF_CounterAdd(APP_PROF_CounterId_t id, uint32_t n)
+{
+    app_prof_counter[id] += n;
+}
+
+/** Set gauge value and update its peak. */
+static inline void APP_PROF_GaugeSet(APP_PROF_GaugeId_t id, uint32_t value)
+{
+    app_prof_gauge[id].value = value;
+    if (value > app_prof_gauge[id].peak)
+    {
+        app_prof_gauge[id].peak = value;
+    }
+}
+
+/** Start timing zone @p id in current scope. */
+#define APP_PROF_ZONE_BEGIN(id) \
+    uint32_t app_prof_start_##id = APP_PROF_ZoneEnter(id)
+
+/** Stop timing zone @p id started in the same scope. */
+#define APP_PROF_ZONE_END(id) \
+    APP_PROF_ZoneExit(id, app_prof_start_##id)
+
+#define APP_PROF_COUNTER_ADD(id, n)    APP_PROF_CounterAdd(id, n)
+#define APP_PROF_GAUGE_SET(id, value)  APP_PROF_GaugeSet(id, value)
+
+#else /* if (CFG_SMARTSHOT_PROF_ENABLED == 1) */
+
+#define APP_PROF_ZONE_BEGIN(id)
+#define APP_PROF_ZONE_END(id)
+#define APP_PROF_COUNTER_ADD(id, n)
+#define APP_PROF_GAUGE_SET(id, value)
+
+#endif /* if (CFG_SMARTSHOT_PROF_ENABLED == 1) */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif    /* APP_PROF_H */
+
+/* ----------------------------------------------------------------------------
+ * End of File
+ * ------------------------------------------------------------------------- */
@@ -34,6 +34,8 @@ extern "C" {
  * Define declaration
  * ------------------------------------------------------------------------- */
 
+/** RTC clock frequency provided by XTAL32K oscillator. */
+#define APP_RTC_TICKS_PER_SECOND       (32768)
 
 /* ----------------------------------------------------------------------------
  * Global variables declaration
@@ -68,23 +70,65 @@ void APP_RTC_Start(void);
 uint32_t APP_RTC_GetTicks(void);
 
 /**
- * Get current system time in milliseconds.
+ * Get monotonic 64-bit number of RTC ticks since @ref APP_RTC_Start.
+ *
+ * Extends the 32-bit RTC counter by counting its reloads. This is the single
+ * time base of the application, all other time functions are derived from it.
  *
- * This function converts the overflowing 32-bit RTC counter at 32768 ticks per
- * second into overflowing 32-bit counter at ~1000 ticks per second.
+ * Safe to call from interrupt context.
  *
- * RTC counter overflows approx. every 36 hours and the converted counter
- * overflows every approx. 49 days.
+ * @pre
+ * This function is called at least once per RTC counter period (~36 hours)
+ * to detect every counter reload. Any of the time functions below counts.
  *
- * \pre
- * This function is called at least every 18 hours to update internal time
- * keeping variables.
+ * @return
+ * Number of RTC ticks since RTC start.
+ */
+uint64_t APP_RTC_GetTicks64(void);
+
+/**
+ * Convert RTC ticks into microseconds.
+ *
+ * Exact conversion: 1000000 / 32768 = 15625 / 512
+ */
+static inline uint64_t APP_RTC_TicksToUs(uint64_t ticks)
+{
+    return (ticks * 15625) >> 9;
+}
+
+/**
+ * Convert RTC ticks into milliseconds.
+ *
+ * Exact conversion: 1000 / 32768 = 125 / 4096
+ */
+static inline uint64_t APP_RTC_TicksToMs(uint64_t ticks)
+{
+    return (ticks * 125) >> 12;
+}
+
+/**
+ * Get current system time in milliseconds.
+ *
+ * Derived from @ref APP_RTC_GetTicks64 so it never drifts from
+ * @ref APP_RTC_GetTimeUs.
+ *
+ * The 32-bit value overflows every approx. 49 days. Use unsigned subtraction
+ * to calculate time differences.
  *
  * \returns
  * System time in milliseconds.
  */
 uint32_t APP_RTC_GetTimeMs(void);
 
+/**
+ * Get current system time in microseconds.
+ *
+ * Derived from @ref APP_RTC_GetTicks64 with resolution of one RTC tick
+ * (~30.5 us).
+ *
+ * \returns
+ * System time in microseconds.
+ */
 uint64_t APP_RTC_GetTimeUs(void);
 
 #ifdef __cplusplus
@@ -40,6 +40,42 @@ extern "C" {
  */
 #define DMA_CHAN_SLP_WK_RF_REGS_COPY   (0)
 
+/**
+ * Part of the deep sleep wake-up latency that is not visible to the
+ * application.
+ *
+ * Covers the WAKEUP_DELAY_32 standby clock cycles and the XTAL48M start up
+ * (twosc) that pass before wake-up code starts to execute.
+ */
+#define APP_SLEEP_WAKEUP_HW_LATENCY_US (2400)
+
+/**
+ * Wake-up sources of deep sleep mode.
+ *
+ * Multiple sources can be reported at once if their events occurred during
+ * the wake-up delay.
+ */
+typedef enum APP_SleepWakeupReason_t
+{
+    /** No wake-up event. Deep sleep mode was not entered. */
+    APP_SLEEP_WAKEUP_NONE = 0,
+
+    /** RTC alarm event. */
+    APP_SLEEP_WAKEUP_RTC_ALARM = (1 << 0),
+
+    /** BLE baseband timer event. Only the radio needs to be serviced. */
+    APP_SLEEP_WAKEUP_BB_TIMER = (1 << 1),
+
+    /** PIR sensor interrupt on wake-up capable DIO. */
+    APP_SLEEP_WAKEUP_PIR = (1 << 2),
+
+    /** Accelerometer interrupt on wake-up capable DIO. */
+    APP_SLEEP_WAKEUP_ACCEL = (1 << 3),
+
+    /** Any other event (WAKEUP pad, other DIO, DCDC overload). */
+    APP_SLEEP_WAKEUP_OTHER = (1 << 4),
+} APP_SleepWakeupReason_t;
+
 /* ----------------------------------------------------------------------------
  * Global variables declaration
  * ------------------------------------------------------------------------- */
@@ -107,6 +143,32 @@ void APP_SleepModeConfigure(void);
  */
 void APP_EnterSleep(void);
 
+/**
+ * Estimate total cost of single deep sleep cycle in terms of time the device
+ * is not able to sleep.
+ *
+ * The estimate consists of the measured duration of
+ * @ref Device_PrepareForSleep, the measured duration of @ref Device_Wakeup
+ * and the constant @ref APP_SLEEP_WAKEUP_HW_LATENCY_US.
+ * Measurements use the same RTC time base as APP_TRACE_SLEEP and
+ * APP_TRACE_RESUME and follow the worst case with slow decay.
+ *
+ * @return
+ * Estimated wake-up latency in microseconds.
+ */
+uint32_t APP_SleepGetWakeupLatencyUs(void);
+
+/**
+ * Get sources of the last deep sleep wake-up.
+ *
+ * Wake-up event flags are captured at the start of @ref ContinueApplication
+ * and remain valid until the next wake-up.
+ *
+ * @return
+ * Bit mask of @ref APP_SleepWakeupReason_t values.
+ */
+uint32_t APP_SleepGetWakeupReason(void);
+
 /**
  * Start up XTAL32K oscillator to be used as STANDBYCLK clock source.
  *
@@ -43,6 +43,33 @@ extern "C" {
  * Defines
  * ------------------------------------------------------------------------- */
 
+/**
+ * SystemView marker IDs used to measure duration of individual wake-up steps.
+ *
+ * Displayed as Start/Stop marker pairs in SystemView timeline.
+ */
+typedef enum APP_TRACE_Marker_t
+{
+    /** DIO pads and external peripheral libraries restore. */
+    APP_TRACE_MARKER_WAKEUP_IO = 1,
+
+    /** Wait for BLE baseband to wake up. */
+    APP_TRACE_MARKER_WAKEUP_BLE = 2,
+
+    /** Deferred initialization of I2C0 CMSIS-Driver. */
+    APP_TRACE_MARKER_I2C0_INIT = 3,
+
+    /** Deferred initialization of SPI0 CMSIS-Driver. */
+    APP_TRACE_MARKER_SPI0_INIT = 4,
+
+    /**
+     * First marker of profiling zones.
+     *
+     * Zone with APP_PROF_ZoneId_t id uses marker APP_TRACE_MARKER_PROF_ZONE + id.
+     */
+    APP_TRACE_MARKER_PROF_ZONE = 16,
+} APP_TRACE_Marker_t;
+
 #if (CFG_SMARTSHOT_TRACE_ENABLED == 1)
 
 /** The application name to be displayed in SystemView */
@@ -97,6 +124,16 @@ static inline bool APP_TRACE_OVERFLOW(void)
     return (SEGGER_SYSVIEW_IsStarted() == 2);
 }
 
+/** Start measurement of code block identified by @ref APP_TRACE_Marker_t */
+#define APP_TRACE_MARK_START(id)      SEGGER_SYSVIEW_MarkStart(id)
+
+/** Stop measurement of code block identified by @ref APP_TRACE_Marker_t */
+#define APP_TRACE_MARK_STOP(id)       SEGGER_SYSVIEW_MarkStop(id)
+
+/** Record reason of deep sleep wake-up. */
+#define APP_TRACE_WAKEUP_REASON(reason) \
+    SEGGER_SYSVIEW_PrintfHost("wakeup reason=0x%x", (reason))
+
 /**
  * Custom application provided timestamp function for SystemView.
  */
@@ -108,6 +145,9 @@ uint32_t SEGGER_SYSVIEW_X_GetTimestamp(void);
 #define APP_TRACE_SLEEP()
 #define APP_TRACE_RESUME()
 #define APP_TRACE_OVERFLOW() (false)
+#define APP_TRACE_MARK_START(id)
+#define APP_TRACE_MARK_STOP(id)
+#define APP_TRACE_WAKEUP_REASON(reason)
 
 #endif /* ifdef CFG_SMARTSHOT_TRACE_ENABLED */
 
@@ -114,16 +114,16 @@ typedef void (*DFUS_DfuEnterCallback_t)(void);
  * All service related attributes are then added to attribute database.
  *
  * @pre
- * The Peripheral Server library was initialized with sufficient attribute
- * database size using APP_BLE_PeripheralServerInitialize.
+ * The Peripheral Server library was initialized using
+ * APP_BLE_PeripheralServerInitialize.
  *
  * @param p_dfu_enter_cb
  * Application provided callback that will be called write to DFU Enter attribute is written.
  *
  * @return
  * 0  - On success. <br>
- * -1 - Attribute database does not have enough free space to fit all DFUS
- *      attributes.
+ * -1 - DFUS attributes are not located at their static offset in the
+ *      attribute database.
  */
 int32_t APP_DFUS_Initialize(DFUS_DfuEnterCallback_t p_dfu_enter_cb);
 
@@ -39,29 +39,11 @@ extern "C"
  * Defines
  * --------------------------------------------------------------------------*/
 
-/**
- * Collects all attribute database related variables of Picture Transfer
- * Service.
- */
-typedef struct DFUS_AttDb_t
-{
-    /**
-     * Offset of the attidx of ESTSS service attributes.
-     *
-     * This can change depending on number and order of registered custom
-     * services in the shared attribute database.
-     */
-    uint16_t attidx_offset;
-} DFUS_AttDb_t;
-
 /**
  * Main storage structure that holds all variables of the DFUS module.
  */
 typedef struct DFUS_Environment_t
 {
-    /** Stores all attribute and attribute database related variables. */
-    DFUS_AttDb_t att;
-
     /**
      * Application callback function called when write to DFU Enter is written.
      */
@@ -340,8 +340,8 @@ typedef uint32_t (*ESTSS_TimeCallbackMs_t)(void);
  * All service related attributes are then added to attribute database.
  *
  * @pre
- * The Peripheral Server library was initialized with sufficient attribute
- * database size using APP_BLE_PeripheralServerInitialize .
+ * The Peripheral Server library was initialized using
+ * APP_BLE_PeripheralServerInitialize.
  *
  * @param p_update_cb
  * Application provided callback that will be called when trigger configuration
@@ -352,8 +352,8 @@ typedef uint32_t (*ESTSS_TimeCallbackMs_t)(void);
  *
  * @return
  * 0  - On success. <br>
- * -1 - Attribute database does not have enough free space to fit all ESTSS
- *      attributes.
+ * -1 - ESTSS attributes are not located at their static offset in the
+ *      attribute database.
  */
 int32_t ESTSS_Initialize(ESTSS_TriggerUpdatedCallback_t p_update_cb,
         ESTSS_TimeCallbackMs_t p_time_cb);
@@ -138,14 +138,6 @@ typedef struct ESTSS_Characteristic_t
  */
 typedef struct ESTSS_AttDb_t
 {
-    /**
-     * Offset of the attidx of ESTSS service attributes.
-     *
-     * This can change depending on number and order of registered custom
-     * services in the shared attribute database.
-     */
-    uint16_t attidx_offset;
-
     /**
      * Storage for the attributes of all supported Value Trigger
      * characteristics.
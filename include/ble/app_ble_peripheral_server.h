@@ -32,6 +32,11 @@
 #include <onsemi_smartshot_config.h>
 #include "calibration.h"
 
+#include <app_ble_ptss.h>
+#include <app_ble_estss.h>
+#include <app_ble_dfus.h>
+#include <app_ble_pss.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -63,7 +68,7 @@ extern "C" {
 
 /* The number of standard profiles and custom services added in this application */
 #define APP_NUM_STD_PRF                 1
-#define APP_NUM_CUSTOM_SVC              1
+#define APP_NUM_CUSTOM_SVC              4
 
 /* RF output power in dBm */
 #define OUTPUT_POWER_DBM                0
@@ -171,16 +176,50 @@ typedef struct APP_BLE_Environment_t
 typedef struct APP_BLE_AttDb_t
 {
     /**
+     * Custom attribute database.
      *
-     * Dynamically allocated on initialization.
-     *
+     * Constant table located in flash that is assembled by the linker from
+     * attribute tables of all custom services.
      */
-    struct att_db_desc *cs_att_db;
-    uint16_t cs_att_db_size;
+    const struct att_db_desc *cs_att_db;
     uint16_t cs_att_count;
     uint16_t cs_service_count;
 } APP_BLE_AttDb_t;
 
+/**
+ * Attidx offsets of all custom services in the shared attribute database.
+ *
+ * Offsets are resolved at compile time and must match the order in which the
+ * linker places service attribute tables (see APP_BLE_CS_ATT_DB_SECTION).
+ */
+typedef enum APP_BLE_CsAttIdx_t
+{
+    APP_BLE_CS_ATTIDX_PTSS  = 0,
+    APP_BLE_CS_ATTIDX_ESTSS = APP_BLE_CS_ATTIDX_PTSS + ATT_PTSS_COUNT,
+    APP_BLE_CS_ATTIDX_DFUS  = APP_BLE_CS_ATTIDX_ESTSS + ESTSS_ATT_COUNT,
+    APP_BLE_CS_ATTIDX_PSS   = APP_BLE_CS_ATTIDX_DFUS + DFUS_ATT_COUNT,
+
+    /* Total number of attributes in the custom attribute database. */
+    APP_BLE_CS_ATT_COUNT    = APP_BLE_CS_ATTIDX_PSS + PSS_ATT_COUNT,
+} APP_BLE_CsAttIdx_t;
+
+/**
+ * Place attribute table of custom service into flash resident custom
+ * attribute database.
+ *
+ * Tables are concatenated by the linker in ascending order of @p order.
+ * Order of the services must match the APP_BLE_CsAttIdx_t offsets.
+ *
+ * @p order must be a zero-padded two digit number (01, 02, ..., 99). The
+ * linker sorts section names as strings, so 10 would be placed before 2.
+ */
+#define APP_BLE_CS_ATT_DB_SECTION(order) \
+    __attribute__((section(".rodata.cs_att_db." #order), used))
+
+/** Boundaries of the custom attribute database provided by linker script. */
+extern const struct att_db_desc __cs_att_db_start__[];
+extern const struct att_db_desc __cs_att_db_end__[];
+
 /* ---------------------------------------------------------------------------
 * Additional Attribute database definitions
 * --------------------------------------------------------------------------*/
@@ -209,10 +248,35 @@ typedef struct APP_BLE_AttDb_t
 * Function prototype definitions
 * --------------------------------------------------------------------------*/
 
-void APP_BLE_PeripheralServerInitialize(const uint16_t cs_att_db_size);
+/**
+ * Initialize BLE stack and the application task.
+ *
+ * The custom attribute database is not copied to RAM. The flash resident
+ * table assembled by the linker is passed to the BLE stack directly.
+ */
+void APP_BLE_PeripheralServerInitialize(void);
 
+/**
+ * Register custom service that is part of the custom attribute database.
+ *
+ * Verifies that the service attribute table was placed by the linker at its
+ * static attidx offset.
+ *
+ * @param p_atts
+ * Attribute table of the service placed with APP_BLE_CS_ATT_DB_SECTION.
+ *
+ * @param atts_count
+ * Number of attributes in the table.
+ *
+ * @param attidx_offset
+ * Static attidx offset of the service from APP_BLE_CsAttIdx_t.
+ *
+ * @return
+ * 0  - On success. <br>
+ * -1 - Service table is not located at given offset of the attribute database.
+ */
 int32_t APP_BLE_PeripheralServerAddCustomService(const struct att_db_desc *p_atts,
-        const uint16_t atts_count, uint16_t *p_attidx_offset);
+        const uint16_t atts_count, const uint16_t attidx_offset);
 
 /**
  * Reserve kernel message IDs from application task id pool that can be used to
@@ -262,6 +326,23 @@ void APP_BLE_UpdateConnectionParameters(const APP_Connection_Parameters_t conn_p
  */
 bool APP_BLE_PeripheralServerConnectedInLowPowerParams(void);
 
+/**
+ * Return connection interval of the active connection.
+ *
+ * @return
+ * Connection interval in microseconds or 0 if there is no active connection.
+ */
+uint32_t APP_BLE_PeripheralServerGetConnIntervalUs(void);
+
+/**
+ * Print dispatch statistics of all kernel message and task IDs that have
+ * registered handlers.
+ *
+ * Prints number of dispatched messages and longest handler execution time
+ * for each ID. Does nothing if MSG_HANDLER_STATS_ENABLED is 0.
+ */
+void APP_BLE_PeripheralServerPrintMsgStats(void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,113 @@
+/* ----------------------------------------------------------------------------
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * ON Semiconductor), All Rights Reserved
+ *
+ * This code is the property of ON Semiconductor and may not be redistributed
+ * in any form without prior written permission from ON Semiconductor.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between ON Semiconductor and the licensee.
+ *
+ * This is Reusable Code.
+ * ------------------------------------------------------------------------- */
+
+/**
+ * @file app_ble_pss.h
+ *
+ * Profiling Statistics Service Server PSS - header file
+ *
+ * Defines custom BLE service to read aggregated profiling statistics
+ * collected by the app_prof module.
+ */
+
+#ifndef APP_BLE_PSS_H
+#define APP_BLE_PSS_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <rsl10_ke.h>
+#include <gattc_task.h>
+
+#include <app_prof.h>
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * --------------------------------------------------------------------------*/
+
+/** 128-bit UUID for the Profiling Statistics Service */
+#define PSS_SVC_UUID \
+    { 0xF8, 0x85, 0x74, 0xD2, 0x2D, 0x01, \
+      0xDA, 0xB5, \
+      0x62, 0x03, \
+      0x01, 0x00, \
+      0x06, 0x00, 0x00, 0x00 }
+
+/** 128-bit UUID for the Statistics Characteristic */
+#define PSS_CHAR_STATS_UUID \
+    { 0xF8, 0x85, 0x74, 0xD2, 0x2D, 0x01, \
+      0xDA, 0xB5, \
+      0x62, 0x03, \
+      0x02, 0x00, \
+      0x06, 0x00, 0x00, 0x00 }
+
+/**
+ * Size of Statistics characteristic value.
+ *
+ * Value layout is described by @ref APP_PROF_SNAPSHOT_SIZE.
+ */
+#define PSS_STATS_CHAR_VALUE_SIZE      (APP_PROF_SNAPSHOT_SIZE)
+
+/** Value to write into Statistics characteristic to reset all statistics. */
+#define PSS_STATS_RESET                (0x00)
+
+/* Descriptions of PSS characteristics. */
+#define PSS_CHAR_STATS_DESC "Profiling Statistics"
+
+/**
+ * List of all attributes supported by PSS server.
+ */
+typedef enum PSS_AttIdx_t
+{
+    /* Profiling Statistics Service */
+    PSS_ATT_SERVICE_0,
+
+    /* Statistics Characteristic */
+    PSS_ATT_STATS_CHAR_0,
+    PSS_ATT_STATS_VAL_0,
+    PSS_ATT_STATS_NAME_0,
+
+    /* Total number of all custom attributes of PSS. */
+    PSS_ATT_COUNT,
+} PSS_AttIdx_t;
+
+/* ----------------------------------------------------------------------------
+ * Function definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * Initialize the Profiling Statistics Service Server.
+ *
+ * All service related attributes are added to attribute database.
+ *
+ * @pre
+ * The Peripheral Server library was initialized using
+ * APP_BLE_PeripheralServerInitialize.
+ *
+ * @return
+ * 0  - On success. <br>
+ * -1 - PSS attributes are not located at their static offset in the
+ *      attribute database.
+ */
+int32_t PSS_Initialize(void);
+
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif    /* APP_BLE_PSS_H */
@@ -65,6 +65,13 @@ extern "C"
 
 #define PTSS_IMG_DATA_MAX_SIZE         (GAPM_DEFAULT_MTU_MAX - 7)
 
+/**
+ * Maximum length of image analysis result sent by @ref PTSS_SendImageResult.
+ *
+ * Fits into Info characteristic notification with default ATT MTU.
+ */
+#define PTSS_IMG_RESULT_MAX_LENGTH     (16)
+
 typedef enum PTSS_ApiError_t
 {
     PTSS_OK = 0,
@@ -191,6 +198,28 @@ int32_t PTSS_StartImageTransfer(uint32_t img_size);
  */
 int32_t PTSS_AbortImageTransfer(PTSS_InfoErrorCode_t errcode);
 
+/**
+ * Inform client about result of on-device analysis of the image that is being
+ * transferred.
+ *
+ * Can be sent at any time between image info and the end of image data
+ * transfer, so the client receives the result without waiting for the image.
+ * The result is sent as Info characteristic notification with opcode
+ * 0x02 (Image Result Indication) followed by @p p_result.
+ *
+ * @param p_result
+ * Application defined result data.
+ *
+ * @param result_len
+ * Length of @p p_result in bytes. Up to PTSS_IMG_RESULT_MAX_LENGTH.
+ *
+ * @return
+ * PTSS_OK - Result notification was transmitted. <br>
+ * PTSS_ERR - Invalid result length. <br>
+ * PTSS_ERR_NOT_PERMITTED - There is no image info provided to the client.
+ */
+int32_t PTSS_SendImageResult(const uint8_t *p_result, uint8_t result_len);
+
 int32_t PTSS_GetMaxImageDataPushSize(void);
 
 /**
@@ -219,6 +248,18 @@ int32_t PTSS_ImageDataPush(const uint8_t* p_img_data, const int32_t data_len);
 
 bool PTSS_IsContinuousCapture(void);
 
+/**
+ * Check if image data transfer is waiting for peer device to acknowledge
+ * already queued packets.
+ *
+ * @return
+ * true - Image data transfer is in progress and all transmit slots are
+ *        occupied. No more data can be pushed before next connection event.
+ * <br>
+ * false - Otherwise.
+ */
+bool PTSS_IsTransmitWindowFull(void);
+
 #ifdef __cplusplus
 }
 #endif    /* ifdef __cplusplus */
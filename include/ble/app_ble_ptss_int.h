@@ -56,6 +56,7 @@ extern "C"
 
 #define PTSS_INFO_OPCODE_ERROR_IND        (0x00)
 #define PTSS_INFO_OPCODE_IMG_CAPTURED_IND (0x01)
+#define PTSS_INFO_OPCODE_IMG_RESULT_IND   (0x02)
 
 #define PTSS_INFO_ERR                     (0x00)
 #define PTSS_INFO_ERR_CANCELLED           (0x01)
@@ -126,14 +127,6 @@ typedef struct PTSS_ImageDataCharacteristic_t
  */
 typedef struct PTSS_AttDb_t
 {
-    /**
-     * Offset of the attidx of PTSS service attributes.
-     *
-     * This can change depending on number and order of registered custom
-     * services to shared attribute database.
-     */
-    uint16_t attidx_offset;
-
     PTSS_ControlPointAttribute_t cp;
     PTSS_InfoCharacteristic_t info;
     PTSS_ImageDataCharacteristic_t img_data;
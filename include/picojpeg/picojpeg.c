@@ -13,11 +13,32 @@
 
 // Define PJPG_INLINE to "inline" if your C compiler supports explicit inlining
 #define PJPG_INLINE
+
+// Saturation instructions (ARMv7-M and later) clamp to 8 bits in a single
+// instruction. The DSP extension (ARMv7E-M, Cortex-M4 class) additionally
+// provides the dual 16-bit multiply-accumulate used for the G component.
+#if defined(__ARM_FEATURE_SAT) && __ARM_FEATURE_SAT
+#define PJPG_USE_SAT 1
+#else
+#define PJPG_USE_SAT 0
+#endif
+
+#if defined(__ARM_FEATURE_DSP) && __ARM_FEATURE_DSP
+#define PJPG_USE_DSP 1
+#else
+#define PJPG_USE_DSP 0
+#endif
+
+#if PJPG_USE_SAT || PJPG_USE_DSP
+#include <arm_acle.h>
+#endif
+
 //------------------------------------------------------------------------------
 typedef unsigned char   uint8;
 typedef unsigned short  uint16;
 typedef signed char     int8;
 typedef signed short    int16;
+typedef uint32_t        uint32;
 //------------------------------------------------------------------------------
 #if PJPG_RIGHT_SHIFT_IS_ALWAYS_UNSIGNED
 static int16 replicateSignBit16(int8 n)
@@ -138,212 +159,187 @@ static const int8 ZAG[] =
    53, 60, 61, 54, 47, 55, 62, 63,
 };
 //------------------------------------------------------------------------------
-// 128 bytes
-static int16 gCoeffBuf[8*8];
-
-// 8*8*4 bytes * 3 = 768
-static uint8 gMCUBufR[256];
-static uint8 gMCUBufG[256];
-static uint8 gMCUBufB[256];
-
-// 256 bytes
-static int16 gQuant0[8*8];
-static int16 gQuant1[8*8];
-
-// 6 bytes
-static int16 gLastDC[3];
-
-typedef struct HuffTableT
-{
-   uint16 mMinCode[16];
-   uint16 mMaxCode[16];
-   uint8 mValPtr[16];
-} HuffTable;
-
-// DC - 192
-static HuffTable gHuffTab0;
-
-static uint8 gHuffVal0[16];
-
-static HuffTable gHuffTab1;
-static uint8 gHuffVal1[16];
-
-// AC - 672
-static HuffTable gHuffTab2;
-static uint8 gHuffVal2[256];
-
-static HuffTable gHuffTab3;
-static uint8 gHuffVal3[256];
-
-static uint8 gValidHuffTables;
-static uint8 gValidQuantTables;
-
-static uint8 gTemFlag;
-#define PJPG_MAX_IN_BUF_SIZE 256
-static uint8 gInBuf[PJPG_MAX_IN_BUF_SIZE];
-static uint8 gInBufOfs;
-static uint8 gInBufLeft;
-
-static uint16 gBitBuf;
-static uint8 gBitsLeft;
+typedef pjpeg_huff_table_t HuffTable;
 //------------------------------------------------------------------------------
-static uint16 gImageXSize;
-static uint16 gImageYSize;
-static uint8 gCompsInFrame;
-static uint8 gCompIdent[3];
-static uint8 gCompHSamp[3];
-static uint8 gCompVSamp[3];
-static uint8 gCompQuant[3];
-
-static uint16 gRestartInterval;
-static uint16 gNextRestartNum;
-static uint16 gRestartsLeft;
+static void fillInBuf(pjpeg_decoder_t* pD)
+{
+   unsigned char status;
 
-static uint8 gCompsInScan;
-static uint8 gCompList[3];
-static uint8 gCompDCTab[3]; // 0,1
-static uint8 gCompACTab[3]; // 0,1
+   if (pD->mpInPending)
+   {
+      // Bytes put back in front of the lent window were read, continue with the window.
+      pD->mpInBuf = pD->mpInPending;
+      pD->mpInWindow = pD->mpInPending;
+      pD->mInBufLeft = pD->mInPendingLeft;
+      pD->mpInPending = 0;
+      return;
+   }
 
-static pjpeg_scan_type_t gScanType;
+   // Reserve a few bytes at the beginning of the buffer for putting back ("stuffing") chars.
+   pD->mpInBuf = pD->mInBuf + 4;
+   pD->mpInWindow = 0;
+   pD->mInBufLeft = 0;
 
-static uint8 gMaxBlocksPerMCU;
-static uint8 gMaxMCUXSize;
-static uint8 gMaxMCUYSize;
-static uint16 gMaxMCUSPerRow;
-static uint16 gMaxMCUSPerCol;
+   if (pD->mpNeedWindowCallback)
+   {
+      const unsigned char* pWindow = 0;
+      unsigned short windowSize = 0;
 
-static uint16 gNumMCUSRemainingX, gNumMCUSRemainingY;
+      status = (*pD->mpNeedWindowCallback)(&pWindow, &windowSize, pD->mpCallback_data);
 
-static uint8 gMCUOrg[6];
+      // At the end of the stream mInBuf stays selected, so the padding returned by getChar() can be put back.
+      if ((pWindow) && (windowSize))
+      {
+         pD->mpInBuf = pWindow;
+         pD->mpInWindow = pWindow;
+         pD->mInBufLeft = windowSize;
+      }
+   }
+   else
+   {
+      unsigned char bytesRead = 0;
 
-static pjpeg_need_bytes_callback_t g_pNeedBytesCallback;
-static void *g_pCallback_data;
-static uint8 gCallbackStatus;
-static uint8 gReduce;
-//------------------------------------------------------------------------------
-static void fillInBuf(void)
-{
-   unsigned char status;
+      status = (*pD->mpNeedBytesCallback)(pD->mInBuf + 4, PJPG_MAX_IN_BUF_SIZE - 4, &bytesRead, pD->mpCallback_data);
 
-   // Reserve a few bytes at the beginning of the buffer for putting back ("stuffing") chars.
-   gInBufOfs = 4;
-   gInBufLeft = 0;
+      pD->mInBufLeft = bytesRead;
+   }
 
-   status = (*g_pNeedBytesCallback)(gInBuf + gInBufOfs, PJPG_MAX_IN_BUF_SIZE - gInBufOfs, &gInBufLeft, g_pCallback_data);
    if (status)
    {
       // The user provided need bytes callback has indicated an error, so record the error and continue trying to decode.
       // The highest level pjpeg entrypoints will catch the error and return the non-zero status.
-      gCallbackStatus = status;
+      pD->mCallbackStatus = status;
    }
 }
 //------------------------------------------------------------------------------
-static PJPG_INLINE uint8 getChar(void)
+static PJPG_INLINE uint8 getChar(pjpeg_decoder_t* pD)
 {
-   if (!gInBufLeft)
+   if (!pD->mInBufLeft)
    {
-      fillInBuf();
-      if (!gInBufLeft)
+      fillInBuf(pD);
+      if (!pD->mInBufLeft)
       {
-         gTemFlag = ~gTemFlag;
-         return gTemFlag ? 0xFF : 0xD9;
+         pD->mTemFlag = ~pD->mTemFlag;
+         return pD->mTemFlag ? 0xFF : 0xD9;
       }
    }
 
-   gInBufLeft--;
-   return gInBuf[gInBufOfs++];
+   pD->mInBufLeft--;
+   return *pD->mpInBuf++;
 }
 //------------------------------------------------------------------------------
-static PJPG_INLINE void stuffChar(uint8 i)
+// Puts back the last byte returned by getChar().
+static PJPG_INLINE void stuffChar(pjpeg_decoder_t* pD, uint8 i)
 {
-   gInBufOfs--;
-   gInBuf[gInBufOfs] = i;
-   gInBufLeft++;
+   if (pD->mpInWindow)
+   {
+      // The byte still is in the lent window, step back over it.
+      if (pD->mpInBuf != pD->mpInWindow)
+      {
+         pD->mpInBuf--;
+         pD->mInBufLeft++;
+         return;
+      }
+
+      // It was read from the previous window. The window can't be written, so continue from the end of mInBuf
+      // and return to the window once the put back bytes are read again.
+      pD->mpInPending = pD->mInBufLeft ? pD->mpInBuf : 0;
+      pD->mInPendingLeft = pD->mInBufLeft;
+      pD->mpInWindow = 0;
+      pD->mpInBuf = pD->mInBuf + PJPG_MAX_IN_BUF_SIZE;
+      pD->mInBufLeft = 0;
+   }
+
+   pD->mpInBuf--;
+   pD->mInBuf[pD->mpInBuf - pD->mInBuf] = i;
+   pD->mInBufLeft++;
 }
 //------------------------------------------------------------------------------
-static PJPG_INLINE uint8 getOctet(uint8 FFCheck)
+static PJPG_INLINE uint8 getOctet(pjpeg_decoder_t* pD, uint8 FFCheck)
 {
-   uint8 c = getChar();
+   uint8 c = getChar(pD);
 
    if ((FFCheck) && (c == 0xFF))
    {
-      uint8 n = getChar();
+      uint8 n = getChar(pD);
 
       if (n)
       {
-         stuffChar(n);
-         stuffChar(0xFF);
+         stuffChar(pD, n);
+         stuffChar(pD, 0xFF);
       }
    }
 
    return c;
 }
 //------------------------------------------------------------------------------
-static uint16 getBits(uint8 numBits, uint8 FFCheck)
+static uint16 getBits(pjpeg_decoder_t* pD, uint8 numBits, uint8 FFCheck)
 {
    uint8 origBits = numBits;
-   uint16 ret = gBitBuf;
+   uint16 ret = pD->mBitBuf;
 
    if (numBits > 8)
    {
       numBits -= 8;
 
-      gBitBuf <<= gBitsLeft;
+      pD->mBitBuf <<= pD->mBitsLeft;
 
-      gBitBuf |= getOctet(FFCheck);
+      pD->mBitBuf |= getOctet(pD, FFCheck);
 
-      gBitBuf <<= (8 - gBitsLeft);
+      pD->mBitBuf <<= (8 - pD->mBitsLeft);
 
-      ret = (ret & 0xFF00) | (gBitBuf >> 8);
+      ret = (ret & 0xFF00) | (pD->mBitBuf >> 8);
    }
 
-   if (gBitsLeft < numBits)
+   if (pD->mBitsLeft < numBits)
    {
-      gBitBuf <<= gBitsLeft;
+      pD->mBitBuf <<= pD->mBitsLeft;
 
-      gBitBuf |= getOctet(FFCheck);
+      pD->mBitBuf |= getOctet(pD, FFCheck);
 
-      gBitBuf <<= (numBits - gBitsLeft);
+      pD->mBitBuf <<= (numBits - pD->mBitsLeft);
 
-      gBitsLeft = 8 - (numBits - gBitsLeft);
+      pD->mBitsLeft = 8 - (numBits - pD->mBitsLeft);
    }
    else
    {
-      gBitsLeft = (uint8)(gBitsLeft - numBits);
-      gBitBuf <<= numBits;
+      pD->mBitsLeft = (uint8)(pD->mBitsLeft - numBits);
+      pD->mBitBuf <<= numBits;
    }
 
    return ret >> (16 - origBits);
 }
 //------------------------------------------------------------------------------
-static PJPG_INLINE uint16 getBits1(uint8 numBits)
+static PJPG_INLINE uint16 getBits1(pjpeg_decoder_t* pD, uint8 numBits)
 {
-   return getBits(numBits, 0);
+   return getBits(pD, numBits, 0);
 }
+#if !PJPG_HUFF_LOOKAHEAD_BITS
 //------------------------------------------------------------------------------
-static PJPG_INLINE uint16 getBits2(uint8 numBits)
+static PJPG_INLINE uint16 getBits2(pjpeg_decoder_t* pD, uint8 numBits)
 {
-   return getBits(numBits, 1);
+   return getBits(pD, numBits, 1);
 }
 //------------------------------------------------------------------------------
-static PJPG_INLINE uint8 getBit(void)
+static PJPG_INLINE uint8 getBit(pjpeg_decoder_t* pD)
 {
    uint8 ret = 0;
-   if (gBitBuf & 0x8000)
+   if (pD->mBitBuf & 0x8000)
       ret = 1;
 
-   if (!gBitsLeft)
+   if (!pD->mBitsLeft)
    {
-      gBitBuf |= getOctet(1);
+      pD->mBitBuf |= getOctet(pD, 1);
 
-      gBitsLeft += 8;
+      pD->mBitsLeft += 8;
    }
 
-   gBitsLeft--;
-   gBitBuf <<= 1;
+   pD->mBitsLeft--;
+   pD->mBitBuf <<= 1;
 
    return ret;
 }
+#endif
 //------------------------------------------------------------------------------
 static uint16 getExtendTest(uint8 i)
 {
@@ -398,11 +394,93 @@ static PJPG_INLINE int16 huffExtend(uint16 x, uint8 s)
    return ((x < getExtendTest(s)) ? ((int16)x + getExtendOffset(s)) : (int16)x);
 }
 //------------------------------------------------------------------------------
-static PJPG_INLINE uint8 huffDecode(const HuffTable* pHuffTable, const uint8* pHuffVal)
+#if PJPG_HUFF_LOOKAHEAD_BITS
+//------------------------------------------------------------------------------
+static PJPG_INLINE void resetEntropyBits(pjpeg_decoder_t* pD)
+{
+   pD->mEntBitBuf = 0;
+   pD->mEntBitsLeft = 0;
+}
+//------------------------------------------------------------------------------
+// Tops up the entropy bit buffer to at least 25 valid bits.
+static PJPG_INLINE void fillEntropyBits(pjpeg_decoder_t* pD)
+{
+   while (pD->mEntBitsLeft <= 24)
+   {
+      pD->mEntBitBuf |= (uint32)getOctet(pD, 1) << (24 - pD->mEntBitsLeft);
+      pD->mEntBitsLeft += 8;
+   }
+}
+//------------------------------------------------------------------------------
+// numBits must be in range 1-16.
+static PJPG_INLINE uint16 getEntropyBits(pjpeg_decoder_t* pD, uint8 numBits)
+{
+   uint16 ret;
+
+   if (pD->mEntBitsLeft < numBits)
+      fillEntropyBits(pD);
+
+   ret = (uint16)(pD->mEntBitBuf >> (32 - numBits));
+
+   pD->mEntBitBuf <<= numBits;
+   pD->mEntBitsLeft = (uint8)(pD->mEntBitsLeft - numBits);
+
+   return ret;
+}
+//------------------------------------------------------------------------------
+static PJPG_INLINE uint8 huffDecode(pjpeg_decoder_t* pD, const HuffTable* pHuffTable, const uint8* pHuffVal)
+{
+   uint8 i;
+   uint16 code;
+   uint16 entry;
+
+   if (pD->mEntBitsLeft < 16)
+      fillEntropyBits(pD);
+
+   entry = pHuffTable->mLookup[pD->mEntBitBuf >> (32 - PJPG_HUFF_LOOKAHEAD_BITS)];
+   if (entry)
+   {
+      uint8 len = (uint8)(entry >> 8);
+
+      pD->mEntBitBuf <<= len;
+      pD->mEntBitsLeft = (uint8)(pD->mEntBitsLeft - len);
+
+      return (uint8)entry;
+   }
+
+   // Slow path for codes longer than the lookahead.
+   for (i = PJPG_HUFF_LOOKAHEAD_BITS; i < 16; i++)
+   {
+      uint16 maxCode = pHuffTable->mMaxCode[i];
+
+      code = (uint16)(pD->mEntBitBuf >> (31 - i));
+
+      if ((code <= maxCode) && (maxCode != 0xFFFF))
+      {
+         uint8 j = pHuffTable->mValPtr[i];
+         j = (uint8)(j + (code - pHuffTable->mMinCode[i]));
+
+         pD->mEntBitBuf <<= (i + 1);
+         pD->mEntBitsLeft = (uint8)(pD->mEntBitsLeft - (i + 1));
+
+         return pHuffVal[j];
+      }
+   }
+
+   pD->mEntBitBuf <<= 16;
+   pD->mEntBitsLeft = (uint8)(pD->mEntBitsLeft - 16);
+
+   return 0;
+}
+#else
+//------------------------------------------------------------------------------
+#define getEntropyBits getBits2
+//------------------------------------------------------------------------------
+static PJPG_INLINE uint8 huffDecode(pjpeg_decoder_t* pD, const HuffTable* pHuffTable, const uint8* pHuffVal)
 {
    uint8 i = 0;
    uint8 j;
-   uint16 code = getBit();
+   uint16 code = getBit(pD);
 
    // This func only reads a bit at a time, which on modern CPU's is not terribly efficient.
    // But on microcontrollers without strong integer shifting support this seems like a
@@ -420,7 +498,7 @@ static PJPG_INLINE uint8 huffDecode(const HuffTable* pHuffTable, const uint8* pH
 
       i++;
       code <<= 1;
-      code |= getBit();
+      code |= getBit(pD);
    }
 
    j = pHuffTable->mValPtr[i];
@@ -428,8 +506,9 @@ static PJPG_INLINE uint8 huffDecode(const HuffTable* pHuffTable, const uint8* pH
 
    return pHuffVal[j];
 }
+#endif
 //------------------------------------------------------------------------------
-static void huffCreate(const uint8* pBits, HuffTable* pHuffTable)
+static void huffCreate(const uint8* pBits, const uint8* pHuffVal, HuffTable* pHuffTable)
 {
    uint8 i = 0;
    uint8 j = 0;
@@ -463,32 +542,64 @@ static void huffCreate(const uint8* pBits, HuffTable* pHuffTable)
       if (i > 15)
          break;
    }
+
+#if PJPG_HUFF_LOOKAHEAD_BITS
+   {
+      uint16 k;
+      uint8 len;
+
+      for (k = 0; k < (1 << PJPG_HUFF_LOOKAHEAD_BITS); k++)
+         pHuffTable->mLookup[k] = 0;
+
+      // Replicate every code of length <= lookahead into all table entries
+      // sharing its prefix.
+      for (len = 1; len <= PJPG_HUFF_LOOKAHEAD_BITS; len++)
+      {
+         uint8 shift = (uint8)(PJPG_HUFF_LOOKAHEAD_BITS - len);
+
+         if (pHuffTable->mMaxCode[len - 1] == 0xFFFF)
+            continue;
+
+         for (code = pHuffTable->mMinCode[len - 1]; code <= pHuffTable->mMaxCode[len - 1]; code++)
+         {
+            uint8 sym = pHuffVal[(uint8)(pHuffTable->mValPtr[len - 1] + (code - pHuffTable->mMinCode[len - 1]))];
+            uint16 entry = (uint16)((len << 8) | sym);
+            uint16 first = (uint16)(code << shift);
+
+            for (k = 0; k < (1U << shift); k++)
+               pHuffTable->mLookup[first + k] = entry;
+         }
+      }
+   }
+#else
+   (void)pHuffVal;
+#endif
 }
 //------------------------------------------------------------------------------
-static HuffTable* getHuffTable(uint8 index)
+static HuffTable* getHuffTable(pjpeg_decoder_t* pD, uint8 index)
 {
    // 0-1 = DC
    // 2-3 = AC
    switch (index)
    {
-      case 0: return &gHuffTab0;
-      case 1: return &gHuffTab1;
-      case 2: return &gHuffTab2;
-      case 3: return &gHuffTab3;
+      case 0: return &pD->mHuffTab0;
+      case 1: return &pD->mHuffTab1;
+      case 2: return &pD->mHuffTab2;
+      case 3: return &pD->mHuffTab3;
       default: return 0;
    }
 }
 //------------------------------------------------------------------------------
-static uint8* getHuffVal(uint8 index)
+static uint8* getHuffVal(pjpeg_decoder_t* pD, uint8 index)
 {
    // 0-1 = DC
    // 2-3 = AC
    switch (index)
    {
-      case 0: return gHuffVal0;
-      case 1: return gHuffVal1;
-      case 2: return gHuffVal2;
-      case 3: return gHuffVal3;
+      case 0: return pD->mHuffVal0;
+      case 1: return pD->mHuffVal1;
+      case 2: return pD->mHuffVal2;
+      case 3: return pD->mHuffVal3;
       default: return 0;
    }
 }
@@ -498,10 +609,10 @@ static uint16 getMaxHuffCodes(uint8 index)
    return (index < 2) ? 12 : 255;
 }
 //------------------------------------------------------------------------------
-static uint8 readDHTMarker(void)
+static uint8 readDHTMarker(pjpeg_decoder_t* pD)
 {
    uint8 bits[16];
-   uint16 left = getBits1(16);
+   uint16 left = getBits1(pD, 16);
 
    if (left < 2)
       return PJPG_BAD_DHT_MARKER;
@@ -515,22 +626,22 @@ static uint8 readDHTMarker(void)
       HuffTable* pHuffTable;
       uint16 count, totalRead;
 
-      index = (uint8)getBits1(8);
+      index = (uint8)getBits1(pD, 8);
 
       if ( ((index & 0xF) > 1) || ((index & 0xF0) > 0x10) )
          return PJPG_BAD_DHT_INDEX;
 
       tableIndex = ((index >> 3) & 2) + (index & 1);
 
-      pHuffTable = getHuffTable(tableIndex);
-      pHuffVal = getHuffVal(tableIndex);
+      pHuffTable = getHuffTable(pD, tableIndex);
+      pHuffVal = getHuffVal(pD, tableIndex);
 
-      gValidHuffTables |= (1 << tableIndex);
+      pD->mValidHuffTables |= (1 << tableIndex);
 
       count = 0;
       for (i = 0; i <= 15; i++)
       {
-         uint8 n = (uint8)getBits1(8);
+         uint8 n = (uint8)getBits1(pD, 8);
          bits[i] = n;
          count = (uint16)(count + n);
       }
@@ -539,7 +650,7 @@ static uint8 readDHTMarker(void)
          return PJPG_BAD_DHT_COUNTS;
 
       for (i = 0; i < count; i++)
-         pHuffVal[i] = (uint8)getBits1(8);
+         pHuffVal[i] = (uint8)getBits1(pD, 8);
 
       totalRead = 1 + 16 + count;
 
@@ -548,7 +659,7 @@ static uint8 readDHTMarker(void)
 
       left = (uint16)(left - totalRead);
 
-      huffCreate(bits, pHuffTable);
+      huffCreate(bits, pHuffVal, pHuffTable);
    }
 
    return 0;
@@ -556,9 +667,9 @@ static uint8 readDHTMarker(void)
 //------------------------------------------------------------------------------
 static void createWinogradQuant(int16* pQuant);
 
-static uint8 readDQTMarker(void)
+static uint8 readDQTMarker(pjpeg_decoder_t* pD)
 {
-   uint16 left = getBits1(16);
+   uint16 left = getBits1(pD, 16);
 
    if (left < 2)
       return PJPG_BAD_DQT_MARKER;
@@ -568,7 +679,7 @@ static uint8 readDQTMarker(void)
    while (left)
    {
       uint8 i;
-      uint8 n = (uint8)getBits1(8);
+      uint8 n = (uint8)getBits1(pD, 8);
       uint8 prec = n >> 4;
       uint16 totalRead;
 
@@ -577,23 +688,25 @@ static uint8 readDQTMarker(void)
       if (n > 1)
          return PJPG_BAD_DQT_TABLE;
 
-      gValidQuantTables |= (n ? 2 : 1);
+      pD->mValidQuantTables |= (n ? 2 : 1);
 
       // read quantization entries, in zag order
       for (i = 0; i < 64; i++)
       {
-         uint16 temp = getBits1(8);
+         uint16 temp = getBits1(pD, 8);
 
          if (prec)
-            temp = (temp << 8) + getBits1(8);
+            temp = (temp << 8) + getBits1(pD, 8);
 
          if (n)
-            gQuant1[i] = (int16)temp;
+            pD->mQuant1[i] = (int16)temp;
          else
-            gQuant0[i] = (int16)temp;
+            pD->mQuant0[i] = (int16)temp;
       }
 
-      createWinogradQuant(n ? gQuant1 : gQuant0);
+      // The reduced size IDCT works on plain dequantized coefficients.
+      if ((pD->mBlockShift == 0) || (pD->mBlockShift == 3))
+         createWinogradQuant(n ? pD->mQuant1 : pD->mQuant0);
 
       totalRead = 64 + 1;
 
@@ -609,40 +722,40 @@ static uint8 readDQTMarker(void)
    return 0;
 }
 //------------------------------------------------------------------------------
-static uint8 readSOFMarker(void)
+static uint8 readSOFMarker(pjpeg_decoder_t* pD)
 {
    uint8 i;
-   uint16 left = getBits1(16);
+   uint16 left = getBits1(pD, 16);
 
-   if (getBits1(8) != 8)
+   if (getBits1(pD, 8) != 8)
       return PJPG_BAD_PRECISION;
 
-   gImageYSize = getBits1(16);
+   pD->mImageYSize = getBits1(pD, 16);
 
-   if ((!gImageYSize) || (gImageYSize > PJPG_MAX_HEIGHT))
+   if ((!pD->mImageYSize) || (pD->mImageYSize > PJPG_MAX_HEIGHT))
       return PJPG_BAD_HEIGHT;
 
-   gImageXSize = getBits1(16);
+   pD->mImageXSize = getBits1(pD, 16);
 
-   if ((!gImageXSize) || (gImageXSize > PJPG_MAX_WIDTH))
+   if ((!pD->mImageXSize) || (pD->mImageXSize > PJPG_MAX_WIDTH))
       return PJPG_BAD_WIDTH;
 
-   gCompsInFrame = (uint8)getBits1(8);
+   pD->mCompsInFrame = (uint8)getBits1(pD, 8);
 
-   if (gCompsInFrame > 3)
+   if (pD->mCompsInFrame > 3)
       return PJPG_TOO_MANY_COMPONENTS;
 
-   if (left != (gCompsInFrame + gCompsInFrame + gCompsInFrame + 8))
+   if (left != (pD->mCompsInFrame + pD->mCompsInFrame + pD->mCompsInFrame + 8))
       return PJPG_BAD_SOF_LENGTH;
 
-   for (i = 0; i < gCompsInFrame; i++)
+   for (i = 0; i < pD->mCompsInFrame; i++)
    {
-      gCompIdent[i] = (uint8)getBits1(8);
-      gCompHSamp[i] = (uint8)getBits1(4);
-      gCompVSamp[i] = (uint8)getBits1(4);
-      gCompQuant[i] = (uint8)getBits1(8);
+      pD->mCompIdent[i] = (uint8)getBits1(pD, 8);
+      pD->mCompHSamp[i] = (uint8)getBits1(pD, 4);
+      pD->mCompVSamp[i] = (uint8)getBits1(pD, 4);
+      pD->mCompQuant[i] = (uint8)getBits1(pD, 8);
 
-      if (gCompQuant[i] > 1)
+      if (pD->mCompQuant[i] > 1)
          return PJPG_UNSUPPORTED_QUANT_TABLE;
    }
 
@@ -650,9 +763,9 @@ static uint8 readSOFMarker(void)
 }
 //------------------------------------------------------------------------------
 // Used to skip unrecognized markers.
-static uint8 skipVariableMarker(void)
+static uint8 skipVariableMarker(pjpeg_decoder_t* pD)
 {
-   uint16 left = getBits1(16);
+   uint16 left = getBits1(pD, 16);
 
    if (left < 2)
       return PJPG_BAD_VARIABLE_MARKER;
@@ -661,7 +774,7 @@ static uint8 skipVariableMarker(void)
 
    while (left)
    {
-      getBits1(8);
+      getBits1(pD, 8);
       left--;
    }
 
@@ -669,67 +782,81 @@ static uint8 skipVariableMarker(void)
 }
 //------------------------------------------------------------------------------
 // Read a define restart interval (DRI) marker.
-static uint8 readDRIMarker(void)
+static uint8 readDRIMarker(pjpeg_decoder_t* pD)
 {
-   if (getBits1(16) != 4)
+   if (getBits1(pD, 16) != 4)
       return PJPG_BAD_DRI_LENGTH;
 
-   gRestartInterval = getBits1(16);
+   pD->mRestartInterval = getBits1(pD, 16);
 
    return 0;
 }
 //------------------------------------------------------------------------------
 // Read a start of scan (SOS) marker.
-static uint8 readSOSMarker(void)
+static uint8 readSOSMarker(pjpeg_decoder_t* pD)
 {
    uint8 i;
-   uint16 left = getBits1(16);
+   uint16 left = getBits1(pD, 16);
    uint8 spectral_start, spectral_end, successive_high, successive_low;
 
-   gCompsInScan = (uint8)getBits1(8);
+   pD->mCompsInScan = (uint8)getBits1(pD, 8);
 
    left -= 3;
 
-   if ( (left != (gCompsInScan + gCompsInScan + 3)) || (gCompsInScan < 1) || (gCompsInScan > PJPG_MAXCOMPSINSCAN) )
+   if ( (left != (pD->mCompsInScan + pD->mCompsInScan + 3)) || (pD->mCompsInScan < 1) || (pD->mCompsInScan > PJPG_MAXCOMPSINSCAN) )
       return PJPG_BAD_SOS_LENGTH;
 
-   for (i = 0; i < gCompsInScan; i++)
+   for (i = 0; i < pD->mCompsInScan; i++)
    {
-      uint8 cc = (uint8)getBits1(8);
-      uint8 c = (uint8)getBits1(8);
+      uint8 cc = (uint8)getBits1(pD, 8);
+      uint8 c = (uint8)getBits1(pD, 8);
       uint8 ci;
 
       left -= 2;
 
-      for (ci = 0; ci < gCompsInFrame; ci++)
-         if (cc == gCompIdent[ci])
+      for (ci = 0; ci < pD->mCompsInFrame; ci++)
+         if (cc == pD->mCompIdent[ci])
             break;
 
-      if (ci >= gCompsInFrame)
+      if (ci >= pD->mCompsInFrame)
          return PJPG_BAD_SOS_COMP_ID;
 
-      gCompList[i]    = ci;
-      gCompDCTab[ci] = (c >> 4) & 15;
-      gCompACTab[ci] = (c & 15);
+      pD->mCompList[i]    = ci;
+      pD->mCompDCTab[ci] = (c >> 4) & 15;
+      pD->mCompACTab[ci] = (c & 15);
    }
 
-   spectral_start  = (uint8)getBits1(8);
-   spectral_end    = (uint8)getBits1(8);
-   successive_high = (uint8)getBits1(4);
-   successive_low  = (uint8)getBits1(4);
+   spectral_start  = (uint8)getBits1(pD, 8);
+   spectral_end    = (uint8)getBits1(pD, 8);
+   successive_high = (uint8)getBits1(pD, 4);
+   successive_low  = (uint8)getBits1(pD, 4);
 
    left -= 3;
 
    while (left)
    {
-      getBits1(8);
+      getBits1(pD, 8);
       left--;
    }
 
+#if PJPG_PROGRESSIVE_DC
+   if (pD->mProgressive)
+   {
+      // Only the first DC scan of all components is decoded.
+      if ((spectral_start != 0) || (spectral_end != 0) || (successive_high != 0) || (successive_low > 13))
+         return PJPG_UNSUPPORTED_MODE;
+
+      if (pD->mCompsInScan != pD->mCompsInFrame)
+         return PJPG_UNSUPPORTED_MODE;
+
+      pD->mSuccessiveLow = successive_low;
+   }
+#endif
+
    return 0;
 }
 //------------------------------------------------------------------------------
-static uint8 nextMarker(void)
+static uint8 nextMarker(pjpeg_decoder_t* pD)
 {
    uint8 c;
    uint8 bytes = 0;
@@ -740,13 +867,13 @@ static uint8 nextMarker(void)
       {
          bytes++;
 
-         c = (uint8)getBits1(8);
+         c = (uint8)getBits1(pD, 8);
 
       } while (c != 0xFF);
 
       do
       {
-         c = (uint8)getBits1(8);
+         c = (uint8)getBits1(pD, 8);
 
       } while (c == 0xFF);
 
@@ -759,11 +886,11 @@ static uint8 nextMarker(void)
 //------------------------------------------------------------------------------
 // Process markers. Returns when an SOFx, SOI, EOI, or SOS marker is
 // encountered.
-static uint8 processMarkers(uint8* pMarker)
+static uint8 processMarkers(pjpeg_decoder_t* pD, uint8* pMarker)
 {
    for ( ; ; )
    {
-      uint8 c = nextMarker();
+      uint8 c = nextMarker(pD);
 
       switch (c)
       {
@@ -790,7 +917,7 @@ static uint8 processMarkers(uint8* pMarker)
          }
          case M_DHT:
          {
-            readDHTMarker();
+            readDHTMarker(pD);
             break;
          }
          // Sorry, no arithmetic support at this time. Dumb patents!
@@ -800,12 +927,12 @@ static uint8 processMarkers(uint8* pMarker)
          }
          case M_DQT:
          {
-            readDQTMarker();
+            readDQTMarker(pD);
             break;
          }
          case M_DRI:
          {
-            readDRIMarker();
+            readDRIMarker(pD);
             break;
          }
          //case M_APP0:  /* no need to read the JFIF marker */
@@ -825,7 +952,7 @@ static uint8 processMarkers(uint8* pMarker)
          }
          default:    /* must be DNL, DHP, EXP, APPn, JPGn, COM, or RESn or APP0 */
          {
-            skipVariableMarker();
+            skipVariableMarker(pD);
             break;
          }
       }
@@ -834,13 +961,13 @@ static uint8 processMarkers(uint8* pMarker)
 }
 //------------------------------------------------------------------------------
 // Finds the start of image (SOI) marker.
-static uint8 locateSOIMarker(void)
+static uint8 locateSOIMarker(pjpeg_decoder_t* pD)
 {
    uint16 bytesleft;
 
-   uint8 lastchar = (uint8)getBits1(8);
+   uint8 lastchar = (uint8)getBits1(pD, 8);
 
-   uint8 thischar = (uint8)getBits1(8);
+   uint8 thischar = (uint8)getBits1(pD, 8);
 
    /* ok if it's a normal JPEG file without a special header */
 
@@ -856,7 +983,7 @@ static uint8 locateSOIMarker(void)
 
       lastchar = thischar;
 
-      thischar = (uint8)getBits1(8);
+      thischar = (uint8)getBits1(pD, 8);
 
       if (lastchar == 0xFF)
       {
@@ -870,7 +997,7 @@ static uint8 locateSOIMarker(void)
    /* Check the next character after marker: if it's not 0xFF, it can't
    be the start of the next marker, so the file is bad */
 
-   thischar = (uint8)((gBitBuf >> 8) & 0xFF);
+   thischar = (uint8)((pD->mBitBuf >> 8) & 0xFF);
 
    if (thischar != 0xFF)
       return PJPG_NOT_JPEG;
@@ -879,15 +1006,15 @@ static uint8 locateSOIMarker(void)
 }
 //------------------------------------------------------------------------------
 // Find a start of frame (SOF) marker.
-static uint8 locateSOFMarker(void)
+static uint8 locateSOFMarker(pjpeg_decoder_t* pD)
 {
    uint8 c;
 
-   uint8 status = locateSOIMarker();
+   uint8 status = locateSOIMarker(pD);
    if (status)
       return status;
 
-   status = processMarkers(&c);
+   status = processMarkers(pD, &c);
    if (status)
       return status;
 
@@ -895,13 +1022,29 @@ static uint8 locateSOFMarker(void)
    {
       case M_SOF2:
       {
+#if PJPG_PROGRESSIVE_DC
+         // Progressive JPEG - full decode would require too much memory, or
+         // too many IDCT's for embedded systems. The first DC scan alone
+         // yields the 1/8 scale image.
+         if (pD->mBlockShift != 0)
+            return PJPG_UNSUPPORTED_MODE;
+
+         pD->mProgressive = 1;
+
+         status = readSOFMarker(pD);
+         if (status)
+            return status;
+
+         break;
+#else
          // Progressive JPEG - not supported by picojpeg (would require too
          // much memory, or too many IDCT's for embedded systems).
          return PJPG_UNSUPPORTED_MODE;
+#endif
       }
       case M_SOF0:  /* baseline DCT */
       {
-         status = readSOFMarker();
+         status = readSOFMarker(pD);
          if (status)
             return status;
 
@@ -922,14 +1065,14 @@ static uint8 locateSOFMarker(void)
 }
 //------------------------------------------------------------------------------
 // Find a start of scan (SOS) marker.
-static uint8 locateSOSMarker(uint8* pFoundEOI)
+static uint8 locateSOSMarker(pjpeg_decoder_t* pD, uint8* pFoundEOI)
 {
    uint8 c;
    uint8 status;
 
    *pFoundEOI = 0;
 
-   status = processMarkers(&c);
+   status = processMarkers(pD, &c);
    if (status)
       return status;
 
@@ -941,48 +1084,54 @@ static uint8 locateSOSMarker(uint8* pFoundEOI)
    else if (c != M_SOS)
       return PJPG_UNEXPECTED_MARKER;
 
-   return readSOSMarker();
+   return readSOSMarker(pD);
 }
 //------------------------------------------------------------------------------
-static uint8 init(void)
-{
-   gImageXSize = 0;
-   gImageYSize = 0;
-   gCompsInFrame = 0;
-   gRestartInterval = 0;
-   gCompsInScan = 0;
-   gValidHuffTables = 0;
-   gValidQuantTables = 0;
-   gTemFlag = 0;
-   gInBufOfs = 0;
-   gInBufLeft = 0;
-   gBitBuf = 0;
-   gBitsLeft = 8;
-
-   getBits1(8);
-   getBits1(8);
+static uint8 init(pjpeg_decoder_t* pD)
+{
+   pD->mImageXSize = 0;
+   pD->mImageYSize = 0;
+   pD->mCompsInFrame = 0;
+   pD->mRestartInterval = 0;
+   pD->mCompsInScan = 0;
+   pD->mValidHuffTables = 0;
+   pD->mValidQuantTables = 0;
+   pD->mTemFlag = 0;
+   pD->mpInBuf = pD->mInBuf;
+   pD->mpInWindow = 0;
+   pD->mpInPending = 0;
+   pD->mInBufLeft = 0;
+   pD->mBitBuf = 0;
+   pD->mBitsLeft = 8;
+
+   getBits1(pD, 8);
+   getBits1(pD, 8);
 
    return 0;
 }
 //------------------------------------------------------------------------------
 // This method throws back into the stream any bytes that where read
 // into the bit buffer during initial marker scanning.
-static void fixInBuffer(void)
+static void fixInBuffer(pjpeg_decoder_t* pD)
 {
    /* In case any 0xFF's where pulled into the buffer during marker scanning */
 
-   if (gBitsLeft > 0)
-      stuffChar((uint8)gBitBuf);
+   if (pD->mBitsLeft > 0)
+      stuffChar(pD, (uint8)pD->mBitBuf);
 
-   stuffChar((uint8)(gBitBuf >> 8));
+   stuffChar(pD, (uint8)(pD->mBitBuf >> 8));
 
-   gBitsLeft = 8;
-   getBits2(8);
-   getBits2(8);
+#if PJPG_HUFF_LOOKAHEAD_BITS
+   resetEntropyBits(pD);
+#else
+   pD->mBitsLeft = 8;
+   getBits2(pD, 8);
+   getBits2(pD, 8);
+#endif
 }
 //------------------------------------------------------------------------------
 // Restart interval processing.
-static uint8 processRestart(void)
+static uint8 processRestart(pjpeg_decoder_t* pD)
 {
    // Let's scan a little bit to find the marker, but not _too_ far.
    // 1536 is a "fudge factor" that determines how much to scan.
@@ -990,59 +1139,63 @@ static uint8 processRestart(void)
    uint8 c = 0;
 
    for (i = 1536; i > 0; i--)
-      if (getChar() == 0xFF)
+      if (getChar(pD) == 0xFF)
          break;
 
    if (i == 0)
       return PJPG_BAD_RESTART_MARKER;
 
    for ( ; i > 0; i--)
-      if ((c = getChar()) != 0xFF)
+      if ((c = getChar(pD)) != 0xFF)
          break;
 
    if (i == 0)
       return PJPG_BAD_RESTART_MARKER;
 
    // Is it the expected marker? If not, something bad happened.
-   if (c != (gNextRestartNum + M_RST0))
+   if (c != (pD->mNextRestartNum + M_RST0))
       return PJPG_BAD_RESTART_MARKER;
 
    // Reset each component's DC prediction values.
-   gLastDC[0] = 0;
-   gLastDC[1] = 0;
-   gLastDC[2] = 0;
+   pD->mLastDC[0] = 0;
+   pD->mLastDC[1] = 0;
+   pD->mLastDC[2] = 0;
 
-   gRestartsLeft = gRestartInterval;
+   pD->mRestartsLeft = pD->mRestartInterval;
 
-   gNextRestartNum = (gNextRestartNum + 1) & 7;
+   pD->mNextRestartNum = (pD->mNextRestartNum + 1) & 7;
 
    // Get the bit buffer going again
 
-   gBitsLeft = 8;
-   getBits2(8);
-   getBits2(8);
+#if PJPG_HUFF_LOOKAHEAD_BITS
+   resetEntropyBits(pD);
+#else
+   pD->mBitsLeft = 8;
+   getBits2(pD, 8);
+   getBits2(pD, 8);
+#endif
 
    return 0;
 }
 //------------------------------------------------------------------------------
-// FIXME: findEOI() is not actually called at the end of the image
+// FIXME: findEOI(pD) is not actually called at the end of the image
 // (it's optional, and probably not needed on embedded devices)
-static uint8 findEOI(void)
+static uint8 findEOI(pjpeg_decoder_t* pD)
 {
    uint8 c;
    uint8 status;
 
    // Prime the bit buffer
-   gBitsLeft = 8;
-   getBits1(8);
-   getBits1(8);
+   pD->mBitsLeft = 8;
+   getBits1(pD, 8);
+   getBits1(pD, 8);
 
    // The next marker _should_ be EOI
-   status = processMarkers(&c);
+   status = processMarkers(pD, &c);
    if (status)
       return status;
-   else if (gCallbackStatus)
-      return gCallbackStatus;
+   else if (pD->mCallbackStatus)
+      return pD->mCallbackStatus;
 
    //gTotalBytesRead -= in_buf_left;
    if (c != M_EOI)
@@ -1051,143 +1204,149 @@ static uint8 findEOI(void)
    return 0;
 }
 //------------------------------------------------------------------------------
-static uint8 checkHuffTables(void)
+static uint8 checkHuffTables(pjpeg_decoder_t* pD)
 {
    uint8 i;
 
-   for (i = 0; i < gCompsInScan; i++)
+   for (i = 0; i < pD->mCompsInScan; i++)
    {
-      uint8 compDCTab = gCompDCTab[gCompList[i]];
-      uint8 compACTab = gCompACTab[gCompList[i]] + 2;
+      uint8 compDCTab = pD->mCompDCTab[pD->mCompList[i]];
+      uint8 compACTab = pD->mCompACTab[pD->mCompList[i]] + 2;
+
+#if PJPG_PROGRESSIVE_DC
+      // DC scans have no AC table.
+      if (pD->mProgressive)
+         compACTab = compDCTab;
+#endif
 
-      if ( ((gValidHuffTables & (1 << compDCTab)) == 0) ||
-           ((gValidHuffTables & (1 << compACTab)) == 0) )
+      if ( ((pD->mValidHuffTables & (1 << compDCTab)) == 0) ||
+           ((pD->mValidHuffTables & (1 << compACTab)) == 0) )
          return PJPG_UNDEFINED_HUFF_TABLE;
    }
 
    return 0;
 }
 //------------------------------------------------------------------------------
-static uint8 checkQuantTables(void)
+static uint8 checkQuantTables(pjpeg_decoder_t* pD)
 {
    uint8 i;
 
-   for (i = 0; i < gCompsInScan; i++)
+   for (i = 0; i < pD->mCompsInScan; i++)
    {
-      uint8 compQuantMask = gCompQuant[gCompList[i]] ? 2 : 1;
+      uint8 compQuantMask = pD->mCompQuant[pD->mCompList[i]] ? 2 : 1;
 
-      if ((gValidQuantTables & compQuantMask) == 0)
+      if ((pD->mValidQuantTables & compQuantMask) == 0)
          return PJPG_UNDEFINED_QUANT_TABLE;
    }
 
    return 0;
 }
 //------------------------------------------------------------------------------
-static uint8 initScan(void)
+static uint8 initScan(pjpeg_decoder_t* pD)
 {
    uint8 foundEOI;
-   uint8 status = locateSOSMarker(&foundEOI);
+   uint8 status = locateSOSMarker(pD, &foundEOI);
    if (status)
       return status;
    if (foundEOI)
       return PJPG_UNEXPECTED_MARKER;
 
-   status = checkHuffTables();
+   status = checkHuffTables(pD);
    if (status)
       return status;
 
-   status = checkQuantTables();
+   status = checkQuantTables(pD);
    if (status)
       return status;
 
-   gLastDC[0] = 0;
-   gLastDC[1] = 0;
-   gLastDC[2] = 0;
+   pD->mLastDC[0] = 0;
+   pD->mLastDC[1] = 0;
+   pD->mLastDC[2] = 0;
 
-   if (gRestartInterval)
+   if (pD->mRestartInterval)
    {
-      gRestartsLeft = gRestartInterval;
-      gNextRestartNum = 0;
+      pD->mRestartsLeft = pD->mRestartInterval;
+      pD->mNextRestartNum = 0;
    }
 
-   fixInBuffer();
+   fixInBuffer(pD);
 
    return 0;
 }
 //------------------------------------------------------------------------------
-static uint8 initFrame(void)
+static uint8 initFrame(pjpeg_decoder_t* pD)
 {
-   if (gCompsInFrame == 1)
+   if (pD->mCompsInFrame == 1)
    {
-      if ((gCompHSamp[0] != 1) || (gCompVSamp[0] != 1))
+      if ((pD->mCompHSamp[0] != 1) || (pD->mCompVSamp[0] != 1))
          return PJPG_UNSUPPORTED_SAMP_FACTORS;
 
-      gScanType = PJPG_GRAYSCALE;
+      pD->mScanType = PJPG_GRAYSCALE;
 
-      gMaxBlocksPerMCU = 1;
-      gMCUOrg[0] = 0;
+      pD->mMaxBlocksPerMCU = 1;
+      pD->mMCUOrg[0] = 0;
 
-      gMaxMCUXSize     = 8;
-      gMaxMCUYSize     = 8;
+      pD->mMaxMCUXSize     = 8;
+      pD->mMaxMCUYSize     = 8;
    }
-   else if (gCompsInFrame == 3)
+   else if (pD->mCompsInFrame == 3)
    {
-      if ( ((gCompHSamp[1] != 1) || (gCompVSamp[1] != 1)) ||
-         ((gCompHSamp[2] != 1) || (gCompVSamp[2] != 1)) )
+      if ( ((pD->mCompHSamp[1] != 1) || (pD->mCompVSamp[1] != 1)) ||
+         ((pD->mCompHSamp[2] != 1) || (pD->mCompVSamp[2] != 1)) )
          return PJPG_UNSUPPORTED_SAMP_FACTORS;
 
-      if ((gCompHSamp[0] == 1) && (gCompVSamp[0] == 1))
+      if ((pD->mCompHSamp[0] == 1) && (pD->mCompVSamp[0] == 1))
       {
-         gScanType = PJPG_YH1V1;
+         pD->mScanType = PJPG_YH1V1;
 
-         gMaxBlocksPerMCU = 3;
-         gMCUOrg[0] = 0;
-         gMCUOrg[1] = 1;
-         gMCUOrg[2] = 2;
+         pD->mMaxBlocksPerMCU = 3;
+         pD->mMCUOrg[0] = 0;
+         pD->mMCUOrg[1] = 1;
+         pD->mMCUOrg[2] = 2;
 
-         gMaxMCUXSize = 8;
-         gMaxMCUYSize = 8;
+         pD->mMaxMCUXSize = 8;
+         pD->mMaxMCUYSize = 8;
       }
-      else if ((gCompHSamp[0] == 1) && (gCompVSamp[0] == 2))
+      else if ((pD->mCompHSamp[0] == 1) && (pD->mCompVSamp[0] == 2))
       {
-         gScanType = PJPG_YH1V2;
+         pD->mScanType = PJPG_YH1V2;
 
-         gMaxBlocksPerMCU = 4;
-         gMCUOrg[0] = 0;
-         gMCUOrg[1] = 0;
-         gMCUOrg[2] = 1;
-         gMCUOrg[3] = 2;
+         pD->mMaxBlocksPerMCU = 4;
+         pD->mMCUOrg[0] = 0;
+         pD->mMCUOrg[1] = 0;
+         pD->mMCUOrg[2] = 1;
+         pD->mMCUOrg[3] = 2;
 
-         gMaxMCUXSize = 8;
-         gMaxMCUYSize = 16;
+         pD->mMaxMCUXSize = 8;
+         pD->mMaxMCUYSize = 16;
       }
-      else if ((gCompHSamp[0] == 2) && (gCompVSamp[0] == 1))
+      else if ((pD->mCompHSamp[0] == 2) && (pD->mCompVSamp[0] == 1))
       {
-         gScanType = PJPG_YH2V1;
+         pD->mScanType = PJPG_YH2V1;
 
-         gMaxBlocksPerMCU = 4;
-         gMCUOrg[0] = 0;
-         gMCUOrg[1] = 0;
-         gMCUOrg[2] = 1;
-         gMCUOrg[3] = 2;
+         pD->mMaxBlocksPerMCU = 4;
+         pD->mMCUOrg[0] = 0;
+         pD->mMCUOrg[1] = 0;
+         pD->mMCUOrg[2] = 1;
+         pD->mMCUOrg[3] = 2;
 
-         gMaxMCUXSize = 16;
-         gMaxMCUYSize = 8;
+         pD->mMaxMCUXSize = 16;
+         pD->mMaxMCUYSize = 8;
       }
-      else if ((gCompHSamp[0] == 2) && (gCompVSamp[0] == 2))
+      else if ((pD->mCompHSamp[0] == 2) && (pD->mCompVSamp[0] == 2))
       {
-         gScanType = PJPG_YH2V2;
-
-         gMaxBlocksPerMCU = 6;
-         gMCUOrg[0] = 0;
-         gMCUOrg[1] = 0;
-         gMCUOrg[2] = 0;
-         gMCUOrg[3] = 0;
-         gMCUOrg[4] = 1;
-         gMCUOrg[5] = 2;
-
-         gMaxMCUXSize = 16;
-         gMaxMCUYSize = 16;
+         pD->mScanType = PJPG_YH2V2;
+
+         pD->mMaxBlocksPerMCU = 6;
+         pD->mMCUOrg[0] = 0;
+         pD->mMCUOrg[1] = 0;
+         pD->mMCUOrg[2] = 0;
+         pD->mMCUOrg[3] = 0;
+         pD->mMCUOrg[4] = 1;
+         pD->mMCUOrg[5] = 2;
+
+         pD->mMaxMCUXSize = 16;
+         pD->mMaxMCUYSize = 16;
       }
       else
          return PJPG_UNSUPPORTED_SAMP_FACTORS;
@@ -1195,13 +1354,13 @@ static uint8 initFrame(void)
    else
       return PJPG_UNSUPPORTED_COLORSPACE;
 
-   gMaxMCUSPerRow = (gImageXSize + (gMaxMCUXSize - 1)) >> ((gMaxMCUXSize == 8) ? 3 : 4);
-   gMaxMCUSPerCol = (gImageYSize + (gMaxMCUYSize - 1)) >> ((gMaxMCUYSize == 8) ? 3 : 4);
+   pD->mMaxMCUSPerRow = (pD->mImageXSize + (pD->mMaxMCUXSize - 1)) >> ((pD->mMaxMCUXSize == 8) ? 3 : 4);
+   pD->mMaxMCUSPerCol = (pD->mImageYSize + (pD->mMaxMCUYSize - 1)) >> ((pD->mMaxMCUYSize == 8) ? 3 : 4);
 
    // This can overflow on large JPEG's.
-   //gNumMCUSRemaining = gMaxMCUSPerRow * gMaxMCUSPerCol;
-   gNumMCUSRemainingX = gMaxMCUSPerRow;
-   gNumMCUSRemainingY = gMaxMCUSPerCol;
+   //gNumMCUSRemaining = pD->mMaxMCUSPerRow * pD->mMaxMCUSPerCol;
+   pD->mNumMCUSRemainingX = pD->mMaxMCUSPerRow;
+   pD->mNumMCUSRemainingY = pD->mMaxMCUSPerCol;
 
    return 0;
 }
@@ -1285,6 +1444,9 @@ static PJPG_INLINE int16 imul_b5(int16 w)
 
 static PJPG_INLINE uint8 clamp(int16 s)
 {
+#if PJPG_USE_SAT
+   return (uint8)__usat(s, 8);
+#else
    if ((uint16)s > 255U)
    {
       if (s < 0)
@@ -1294,12 +1456,13 @@ static PJPG_INLINE uint8 clamp(int16 s)
    }
 
    return (uint8)s;
+#endif
 }
 
-static void idctRows(void)
+static void idctRows(pjpeg_decoder_t* pD)
 {
    uint8 i;
-   int16* pSrc = gCoeffBuf;
+   int16* pSrc = pD->mCoeffBuf;
 
    for (i = 0; i < 8; i++)
    {
@@ -1371,11 +1534,12 @@ static void idctRows(void)
    }
 }
 
-static void idctCols(void)
+#if !PJPG_FUSED_TRANSFORM
+static void idctCols(pjpeg_decoder_t* pD)
 {
    uint8 i;
 
-   int16* pSrc = gCoeffBuf;
+   int16* pSrc = pD->mCoeffBuf;
 
    for (i = 0; i < 8; i++)
    {
@@ -1448,6 +1612,7 @@ static void idctCols(void)
    }
 }
 
+#endif
 /*----------------------------------------------------------------------------*/
 static PJPG_INLINE uint8 addAndClamp(uint8 a, int16 b)
 {
@@ -1487,15 +1652,16 @@ static PJPG_INLINE uint8 subAndClamp(uint8 a, int16 b)
 
 // 198/256
 //B = Y + 1.772 (Cb-128)
+#if !PJPG_FUSED_TRANSFORM
 /*----------------------------------------------------------------------------*/
 // Cb upsample and accumulate, 4x4 to 8x8
-static void upsampleCb(uint8 srcOfs, uint8 dstOfs)
+static void upsampleCb(pjpeg_decoder_t* pD, uint8 srcOfs, uint8 dstOfs)
 {
    // Cb - affects G and B
    uint8 x, y;
-   int16* pSrc = gCoeffBuf + srcOfs;
-   uint8* pDstG = gMCUBufG + dstOfs;
-   uint8* pDstB = gMCUBufB + dstOfs;
+   int16* pSrc = pD->mCoeffBuf + srcOfs;
+   uint8* pDstG = pD->mMCUBufG + dstOfs;
+   uint8* pDstB = pD->mMCUBufB + dstOfs;
    for (y = 0; y < 4; y++)
    {
       for (x = 0; x < 4; x++)
@@ -1526,13 +1692,13 @@ static void upsampleCb(uint8 srcOfs, uint8 dstOfs)
 }
 /*----------------------------------------------------------------------------*/
 // Cb upsample and accumulate, 4x8 to 8x8
-static void upsampleCbH(uint8 srcOfs, uint8 dstOfs)
+static void upsampleCbH(pjpeg_decoder_t* pD, uint8 srcOfs, uint8 dstOfs)
 {
    // Cb - affects G and B
    uint8 x, y;
-   int16* pSrc = gCoeffBuf + srcOfs;
-   uint8* pDstG = gMCUBufG + dstOfs;
-   uint8* pDstB = gMCUBufB + dstOfs;
+   int16* pSrc = pD->mCoeffBuf + srcOfs;
+   uint8* pDstG = pD->mMCUBufG + dstOfs;
+   uint8* pDstB = pD->mMCUBufB + dstOfs;
    for (y = 0; y < 8; y++)
    {
       for (x = 0; x < 4; x++)
@@ -1557,13 +1723,13 @@ static void upsampleCbH(uint8 srcOfs, uint8 dstOfs)
 }
 /*----------------------------------------------------------------------------*/
 // Cb upsample and accumulate, 8x4 to 8x8
-static void upsampleCbV(uint8 srcOfs, uint8 dstOfs)
+static void upsampleCbV(pjpeg_decoder_t* pD, uint8 srcOfs, uint8 dstOfs)
 {
    // Cb - affects G and B
    uint8 x, y;
-   int16* pSrc = gCoeffBuf + srcOfs;
-   uint8* pDstG = gMCUBufG + dstOfs;
-   uint8* pDstB = gMCUBufB + dstOfs;
+   int16* pSrc = pD->mCoeffBuf + srcOfs;
+   uint8* pDstG = pD->mMCUBufG + dstOfs;
+   uint8* pDstB = pD->mMCUBufB + dstOfs;
    for (y = 0; y < 4; y++)
    {
       for (x = 0; x < 8; x++)
@@ -1598,13 +1764,13 @@ static void upsampleCbV(uint8 srcOfs, uint8 dstOfs)
 //B = Y + 1.772 (Cb-128)
 /*----------------------------------------------------------------------------*/
 // Cr upsample and accumulate, 4x4 to 8x8
-static void upsampleCr(uint8 srcOfs, uint8 dstOfs)
+static void upsampleCr(pjpeg_decoder_t* pD, uint8 srcOfs, uint8 dstOfs)
 {
    // Cr - affects R and G
    uint8 x, y;
-   int16* pSrc = gCoeffBuf + srcOfs;
-   uint8* pDstR = gMCUBufR + dstOfs;
-   uint8* pDstG = gMCUBufG + dstOfs;
+   int16* pSrc = pD->mCoeffBuf + srcOfs;
+   uint8* pDstR = pD->mMCUBufR + dstOfs;
+   uint8* pDstG = pD->mMCUBufG + dstOfs;
    for (y = 0; y < 4; y++)
    {
       for (x = 0; x < 4; x++)
@@ -1635,13 +1801,13 @@ static void upsampleCr(uint8 srcOfs, uint8 dstOfs)
 }
 /*----------------------------------------------------------------------------*/
 // Cr upsample and accumulate, 4x8 to 8x8
-static void upsampleCrH(uint8 srcOfs, uint8 dstOfs)
+static void upsampleCrH(pjpeg_decoder_t* pD, uint8 srcOfs, uint8 dstOfs)
 {
    // Cr - affects R and G
    uint8 x, y;
-   int16* pSrc = gCoeffBuf + srcOfs;
-   uint8* pDstR = gMCUBufR + dstOfs;
-   uint8* pDstG = gMCUBufG + dstOfs;
+   int16* pSrc = pD->mCoeffBuf + srcOfs;
+   uint8* pDstR = pD->mMCUBufR + dstOfs;
+   uint8* pDstG = pD->mMCUBufG + dstOfs;
    for (y = 0; y < 8; y++)
    {
       for (x = 0; x < 4; x++)
@@ -1666,13 +1832,13 @@ static void upsampleCrH(uint8 srcOfs, uint8 dstOfs)
 }
 /*----------------------------------------------------------------------------*/
 // Cr upsample and accumulate, 8x4 to 8x8
-static void upsampleCrV(uint8 srcOfs, uint8 dstOfs)
+static void upsampleCrV(pjpeg_decoder_t* pD, uint8 srcOfs, uint8 dstOfs)
 {
    // Cr - affects R and G
    uint8 x, y;
-   int16* pSrc = gCoeffBuf + srcOfs;
-   uint8* pDstR = gMCUBufR + dstOfs;
-   uint8* pDstG = gMCUBufG + dstOfs;
+   int16* pSrc = pD->mCoeffBuf + srcOfs;
+   uint8* pDstR = pD->mMCUBufR + dstOfs;
+   uint8* pDstG = pD->mMCUBufG + dstOfs;
    for (y = 0; y < 4; y++)
    {
       for (x = 0; x < 8; x++)
@@ -1698,13 +1864,13 @@ static void upsampleCrV(uint8 srcOfs, uint8 dstOfs)
 }
 /*----------------------------------------------------------------------------*/
 // Convert Y to RGB
-static void copyY(uint8 dstOfs)
+static void copyY(pjpeg_decoder_t* pD, uint8 dstOfs)
 {
    uint8 i;
-   uint8* pRDst = gMCUBufR + dstOfs;
-   uint8* pGDst = gMCUBufG + dstOfs;
-   uint8* pBDst = gMCUBufB + dstOfs;
-   int16* pSrc = gCoeffBuf;
+   uint8* pRDst = pD->mMCUBufR + dstOfs;
+   uint8* pGDst = pD->mMCUBufG + dstOfs;
+   uint8* pBDst = pD->mMCUBufB + dstOfs;
+   int16* pSrc = pD->mCoeffBuf;
 
    for (i = 64; i > 0; i--)
    {
@@ -1717,12 +1883,12 @@ static void copyY(uint8 dstOfs)
 }
 /*----------------------------------------------------------------------------*/
 // Cb convert to RGB and accumulate
-static void convertCb(uint8 dstOfs)
+static void convertCb(pjpeg_decoder_t* pD, uint8 dstOfs)
 {
    uint8 i;
-   uint8* pDstG = gMCUBufG + dstOfs;
-   uint8* pDstB = gMCUBufB + dstOfs;
-   int16* pSrc = gCoeffBuf;
+   uint8* pDstG = pD->mMCUBufG + dstOfs;
+   uint8* pDstB = pD->mMCUBufB + dstOfs;
+   int16* pSrc = pD->mCoeffBuf;
 
    for (i = 64; i > 0; i--)
    {
@@ -1738,12 +1904,12 @@ static void convertCb(uint8 dstOfs)
 }
 /*----------------------------------------------------------------------------*/
 // Cr convert to RGB and accumulate
-static void convertCr(uint8 dstOfs)
+static void convertCr(pjpeg_decoder_t* pD, uint8 dstOfs)
 {
    uint8 i;
-   uint8* pDstR = gMCUBufR + dstOfs;
-   uint8* pDstG = gMCUBufG + dstOfs;
-   int16* pSrc = gCoeffBuf;
+   uint8* pDstR = pD->mMCUBufR + dstOfs;
+   uint8* pDstG = pD->mMCUBufG + dstOfs;
+   int16* pSrc = pD->mCoeffBuf;
 
    for (i = 64; i > 0; i--)
    {
@@ -1757,18 +1923,172 @@ static void convertCr(uint8 dstOfs)
       *pDstG++ = subAndClamp(pDstG[0], crG);
    }
 }
+#else
+/*----------------------------------------------------------------------------*/
+// Column IDCT of one column of the row transformed coefficients, producing
+// 8 unclamped pixel values.
+static PJPG_INLINE void idctCol(const int16* pSrc, int16* pOut)
+{
+   if ((pSrc[1*8] | pSrc[2*8] | pSrc[3*8] | pSrc[4*8] | pSrc[5*8] | pSrc[6*8] | pSrc[7*8]) == 0)
+   {
+      // Short circuit the 1D IDCT if only the DC component is non-zero
+      int16 c = PJPG_DESCALE(*pSrc) + 128;
+      pOut[0] = c;
+      pOut[1] = c;
+      pOut[2] = c;
+      pOut[3] = c;
+      pOut[4] = c;
+      pOut[5] = c;
+      pOut[6] = c;
+      pOut[7] = c;
+   }
+   else
+   {
+      int16 src4 = *(pSrc+5*8);
+      int16 src7 = *(pSrc+3*8);
+      int16 x4  = src4 - src7;
+      int16 x7  = src4 + src7;
+
+      int16 src5 = *(pSrc+1*8);
+      int16 src6 = *(pSrc+7*8);
+      int16 x5  = src5 + src6;
+      int16 x6  = src5 - src6;
+
+      int16 tmp1 = imul_b5(x4 - x6);
+      int16 stg26 = imul_b4(x6) - tmp1;
+
+      int16 x24 = tmp1 - imul_b2(x4);
+
+      int16 x15 = x5 - x7;
+      int16 x17 = x5 + x7;
+
+      int16 tmp2 = stg26 - x17;
+      int16 tmp3 = imul_b1_b3(x15) - tmp2;
+      int16 x44 = tmp3 + x24;
+
+      int16 src0 = *(pSrc+0*8);
+      int16 src1 = *(pSrc+4*8);
+      int16 x30 = src0 + src1;
+      int16 x31 = src0 - src1;
+
+      int16 src2 = *(pSrc+2*8);
+      int16 src3 = *(pSrc+6*8);
+      int16 x12 = src2 - src3;
+      int16 x13 = src2 + src3;
+
+      int16 x32 = imul_b1_b3(x12) - x13;
+
+      int16 x40 = x30 + x13;
+      int16 x43 = x30 - x13;
+      int16 x41 = x31 + x32;
+      int16 x42 = x31 - x32;
+
+      // descale and convert to unsigned
+      pOut[0] = PJPG_DESCALE(x40 + x17)  + 128;
+      pOut[1] = PJPG_DESCALE(x41 + tmp2) + 128;
+      pOut[2] = PJPG_DESCALE(x42 + tmp3) + 128;
+      pOut[3] = PJPG_DESCALE(x43 - x44)  + 128;
+      pOut[4] = PJPG_DESCALE(x43 + x44)  + 128;
+      pOut[5] = PJPG_DESCALE(x42 - tmp3) + 128;
+      pOut[6] = PJPG_DESCALE(x41 - tmp2) + 128;
+      pOut[7] = PJPG_DESCALE(x40 - x17)  + 128;
+   }
+}
+/*----------------------------------------------------------------------------*/
+// Y samples are kept in mMCUBufR and Cb samples in mMCUBufCb until the Cr
+// block of the MCU is transformed. The column IDCT of the Cr block then
+// converts each Cr sample together with the 1, 2 or 4 Y pixels it covers,
+// clamping every output component once. Y and Cb blocks are clamped straight
+// into their buffers.
+static void idctColsFused(pjpeg_decoder_t* pD, uint8 mcuBlock)
+{
+   uint8 componentID = pD->mMCUOrg[mcuBlock];
+   const int16* pSrc = pD->mCoeffBuf;
+   int16 col[8];
+   uint8 x, y;
+
+   if (componentID == 2)
+   {
+      uint8 hSub = (uint8)((pD->mScanType == PJPG_YH2V1) || (pD->mScanType == PJPG_YH2V2));
+      uint8 vSub = (uint8)((pD->mScanType == PJPG_YH1V2) || (pD->mScanType == PJPG_YH2V2));
+      // Covered pixels are to the right (+1) and below (+8) within the same block.
+      uint8 cover[4];
+      uint8 numCover = 0;
+
+      cover[numCover++] = 0;
+      if (hSub)
+         cover[numCover++] = 1;
+      if (vSub)
+         cover[numCover++] = 8;
+      if (hSub & vSub)
+         cover[numCover++] = 9;
+
+      for (x = 0; x < 8; x++)
+      {
+         uint8 lx = (uint8)(x << hSub);
+
+         idctCol(pSrc + x, col);
+
+         for (y = 0; y < 8; y++)
+         {
+            uint8 ly = (uint8)(y << vSub);
+            uint8 ofs = (uint8)(((ly & 8) << 4) + ((lx & 8) << 3) + ((ly & 7) << 3) + (lx & 7));
+            uint8 cb = pD->mMCUBufCb[(y << 3) + x];
+            uint8 cr = clamp(col[y]);
+            int16 crR = (cr + ((cr * 103U) >> 8U)) - 179;
+            int16 cbB = (cb + ((cb * 198U) >> 8U)) - 227;
+#if PJPG_USE_DSP
+            int16 cbcrG = (int16)((__smlad((int32_t)(cb | ((uint32)cr << 16)), (88 | (183 << 16)), 0) >> 8) - 135);
+#else
+            int16 cbcrG = (int16)(((cb * 88U + cr * 183U) >> 8U) - 135);
+#endif
+            uint8 i;
+
+            for (i = 0; i < numCover; i++)
+            {
+               uint8 o = (uint8)(ofs + cover[i]);
+               int16 lum = pD->mMCUBufR[o];
+
+               pD->mMCUBufR[o] = clamp(lum + crR);
+               pD->mMCUBufG[o] = clamp(lum - cbcrG);
+               pD->mMCUBufB[o] = clamp(lum + cbB);
+            }
+         }
+      }
+   }
+   else
+   {
+      // Y blocks fill the 2x2 block grid of the MCU buffers in decode order.
+      uint8* pDst = pD->mMCUBufCb;
+
+      if (componentID == 0)
+         pDst = pD->mMCUBufR + ((pD->mScanType == PJPG_YH1V2) ? (mcuBlock << 7) : (mcuBlock << 6));
+
+      for (x = 0; x < 8; x++)
+      {
+         idctCol(pSrc + x, col);
+
+         for (y = 0; y < 8; y++)
+            pDst[(y << 3) + x] = clamp(col[y]);
+      }
+   }
+}
+#endif
 /*----------------------------------------------------------------------------*/
-static void transformBlock(uint8 mcuBlock)
+static void transformBlock(pjpeg_decoder_t* pD, uint8 mcuBlock)
 {
-   idctRows();
-   idctCols();
+   idctRows(pD);
+#if PJPG_FUSED_TRANSFORM
+   idctColsFused(pD, mcuBlock);
+#else
+   idctCols(pD);
 
-   switch (gScanType)
+   switch (pD->mScanType)
    {
       case PJPG_GRAYSCALE:
       {
          // MCU size: 1, 1 block per MCU
-         copyY(0);
+         copyY(pD, 0);
          break;
       }
       case PJPG_YH1V1:
@@ -1778,17 +2098,17 @@ static void transformBlock(uint8 mcuBlock)
          {
             case 0:
             {
-               copyY(0);
+               copyY(pD, 0);
                break;
             }
             case 1:
             {
-               convertCb(0);
+               convertCb(pD, 0);
                break;
             }
             case 2:
             {
-               convertCr(0);
+               convertCr(pD, 0);
                break;
             }
          }
@@ -1802,24 +2122,24 @@ static void transformBlock(uint8 mcuBlock)
          {
             case 0:
             {
-               copyY(0);
+               copyY(pD, 0);
                break;
             }
             case 1:
             {
-               copyY(128);
+               copyY(pD, 128);
                break;
             }
             case 2:
             {
-               upsampleCbV(0, 0);
-               upsampleCbV(4*8, 128);
+               upsampleCbV(pD, 0, 0);
+               upsampleCbV(pD, 4*8, 128);
                break;
             }
             case 3:
             {
-               upsampleCrV(0, 0);
-               upsampleCrV(4*8, 128);
+               upsampleCrV(pD, 0, 0);
+               upsampleCrV(pD, 4*8, 128);
                break;
             }
          }
@@ -1833,24 +2153,24 @@ static void transformBlock(uint8 mcuBlock)
          {
             case 0:
             {
-               copyY(0);
+               copyY(pD, 0);
                break;
             }
             case 1:
             {
-               copyY(64);
+               copyY(pD, 64);
                break;
             }
             case 2:
             {
-               upsampleCbH(0, 0);
-               upsampleCbH(4, 64);
+               upsampleCbH(pD, 0, 0);
+               upsampleCbH(pD, 4, 64);
                break;
             }
             case 3:
             {
-               upsampleCrH(0, 0);
-               upsampleCrH(4, 64);
+               upsampleCrH(pD, 0, 0);
+               upsampleCrH(pD, 4, 64);
                break;
             }
          }
@@ -1864,38 +2184,38 @@ static void transformBlock(uint8 mcuBlock)
          {
             case 0:
             {
-               copyY(0);
+               copyY(pD, 0);
                break;
             }
             case 1:
             {
-               copyY(64);
+               copyY(pD, 64);
                break;
             }
             case 2:
             {
-               copyY(128);
+               copyY(pD, 128);
                break;
             }
             case 3:
             {
-               copyY(192);
+               copyY(pD, 192);
                break;
             }
             case 4:
             {
-               upsampleCb(0, 0);
-               upsampleCb(4, 64);
-               upsampleCb(4*8, 128);
-               upsampleCb(4+4*8, 192);
+               upsampleCb(pD, 0, 0);
+               upsampleCb(pD, 4, 64);
+               upsampleCb(pD, 4*8, 128);
+               upsampleCb(pD, 4+4*8, 192);
                break;
             }
             case 5:
             {
-               upsampleCr(0, 0);
-               upsampleCr(4, 64);
-               upsampleCr(4*8, 128);
-               upsampleCr(4+4*8, 192);
+               upsampleCr(pD, 0, 0);
+               upsampleCr(pD, 4, 64);
+               upsampleCr(pD, 4*8, 128);
+               upsampleCr(pD, 4+4*8, 192);
                break;
             }
          }
@@ -1903,19 +2223,20 @@ static void transformBlock(uint8 mcuBlock)
          break;
       }
    }
+#endif
 }
 //------------------------------------------------------------------------------
-static void transformBlockReduce(uint8 mcuBlock)
+static void transformBlockReduce(pjpeg_decoder_t* pD, uint8 mcuBlock)
 {
-   uint8 c = clamp(PJPG_DESCALE(gCoeffBuf[0]) + 128);
+   uint8 c = clamp(PJPG_DESCALE(pD->mCoeffBuf[0]) + 128);
    int16 cbG, cbB, crR, crG;
 
-   switch (gScanType)
+   switch (pD->mScanType)
    {
       case PJPG_GRAYSCALE:
       {
          // MCU size: 1, 1 block per MCU
-         gMCUBufR[0] = c;
+         pD->mMCUBufR[0] = c;
          break;
       }
       case PJPG_YH1V1:
@@ -1925,27 +2246,27 @@ static void transformBlockReduce(uint8 mcuBlock)
          {
             case 0:
             {
-               gMCUBufR[0] = c;
-               gMCUBufG[0] = c;
-               gMCUBufB[0] = c;
+               pD->mMCUBufR[0] = c;
+               pD->mMCUBufG[0] = c;
+               pD->mMCUBufB[0] = c;
                break;
             }
             case 1:
             {
                cbG = ((c * 88U) >> 8U) - 44U;
-               gMCUBufG[0] = subAndClamp(gMCUBufG[0], cbG);
+               pD->mMCUBufG[0] = subAndClamp(pD->mMCUBufG[0], cbG);
 
                cbB = (c + ((c * 198U) >> 8U)) - 227U;
-               gMCUBufB[0] = addAndClamp(gMCUBufB[0], cbB);
+               pD->mMCUBufB[0] = addAndClamp(pD->mMCUBufB[0], cbB);
                break;
             }
             case 2:
             {
                crR = (c + ((c * 103U) >> 8U)) - 179;
-               gMCUBufR[0] = addAndClamp(gMCUBufR[0], crR);
+               pD->mMCUBufR[0] = addAndClamp(pD->mMCUBufR[0], crR);
 
                crG = ((c * 183U) >> 8U) - 91;
-               gMCUBufG[0] = subAndClamp(gMCUBufG[0], crG);
+               pD->mMCUBufG[0] = subAndClamp(pD->mMCUBufG[0], crG);
                break;
             }
          }
@@ -1959,39 +2280,39 @@ static void transformBlockReduce(uint8 mcuBlock)
          {
             case 0:
             {
-               gMCUBufR[0] = c;
-               gMCUBufG[0] = c;
-               gMCUBufB[0] = c;
+               pD->mMCUBufR[0] = c;
+               pD->mMCUBufG[0] = c;
+               pD->mMCUBufB[0] = c;
                break;
             }
             case 1:
             {
-               gMCUBufR[128] = c;
-               gMCUBufG[128] = c;
-               gMCUBufB[128] = c;
+               pD->mMCUBufR[128] = c;
+               pD->mMCUBufG[128] = c;
+               pD->mMCUBufB[128] = c;
                break;
             }
             case 2:
             {
                cbG = ((c * 88U) >> 8U) - 44U;
-               gMCUBufG[0] = subAndClamp(gMCUBufG[0], cbG);
-               gMCUBufG[128] = subAndClamp(gMCUBufG[128], cbG);
+               pD->mMCUBufG[0] = subAndClamp(pD->mMCUBufG[0], cbG);
+               pD->mMCUBufG[128] = subAndClamp(pD->mMCUBufG[128], cbG);
 
                cbB = (c + ((c * 198U) >> 8U)) - 227U;
-               gMCUBufB[0] = addAndClamp(gMCUBufB[0], cbB);
-               gMCUBufB[128] = addAndClamp(gMCUBufB[128], cbB);
+               pD->mMCUBufB[0] = addAndClamp(pD->mMCUBufB[0], cbB);
+               pD->mMCUBufB[128] = addAndClamp(pD->mMCUBufB[128], cbB);
 
                break;
             }
             case 3:
             {
                crR = (c + ((c * 103U) >> 8U)) - 179;
-               gMCUBufR[0] = addAndClamp(gMCUBufR[0], crR);
-               gMCUBufR[128] = addAndClamp(gMCUBufR[128], crR);
+               pD->mMCUBufR[0] = addAndClamp(pD->mMCUBufR[0], crR);
+               pD->mMCUBufR[128] = addAndClamp(pD->mMCUBufR[128], crR);
 
                crG = ((c * 183U) >> 8U) - 91;
-               gMCUBufG[0] = subAndClamp(gMCUBufG[0], crG);
-               gMCUBufG[128] = subAndClamp(gMCUBufG[128], crG);
+               pD->mMCUBufG[0] = subAndClamp(pD->mMCUBufG[0], crG);
+               pD->mMCUBufG[128] = subAndClamp(pD->mMCUBufG[128], crG);
 
                break;
             }
@@ -2005,39 +2326,39 @@ static void transformBlockReduce(uint8 mcuBlock)
          {
             case 0:
             {
-               gMCUBufR[0] = c;
-               gMCUBufG[0] = c;
-               gMCUBufB[0] = c;
+               pD->mMCUBufR[0] = c;
+               pD->mMCUBufG[0] = c;
+               pD->mMCUBufB[0] = c;
                break;
             }
             case 1:
             {
-               gMCUBufR[64] = c;
-               gMCUBufG[64] = c;
-               gMCUBufB[64] = c;
+               pD->mMCUBufR[64] = c;
+               pD->mMCUBufG[64] = c;
+               pD->mMCUBufB[64] = c;
                break;
             }
             case 2:
             {
                cbG = ((c * 88U) >> 8U) - 44U;
-               gMCUBufG[0] = subAndClamp(gMCUBufG[0], cbG);
-               gMCUBufG[64] = subAndClamp(gMCUBufG[64], cbG);
+               pD->mMCUBufG[0] = subAndClamp(pD->mMCUBufG[0], cbG);
+               pD->mMCUBufG[64] = subAndClamp(pD->mMCUBufG[64], cbG);
 
                cbB = (c + ((c * 198U) >> 8U)) - 227U;
-               gMCUBufB[0] = addAndClamp(gMCUBufB[0], cbB);
-               gMCUBufB[64] = addAndClamp(gMCUBufB[64], cbB);
+               pD->mMCUBufB[0] = addAndClamp(pD->mMCUBufB[0], cbB);
+               pD->mMCUBufB[64] = addAndClamp(pD->mMCUBufB[64], cbB);
 
                break;
             }
             case 3:
             {
                crR = (c + ((c * 103U) >> 8U)) - 179;
-               gMCUBufR[0] = addAndClamp(gMCUBufR[0], crR);
-               gMCUBufR[64] = addAndClamp(gMCUBufR[64], crR);
+               pD->mMCUBufR[0] = addAndClamp(pD->mMCUBufR[0], crR);
+               pD->mMCUBufR[64] = addAndClamp(pD->mMCUBufR[64], crR);
 
                crG = ((c * 183U) >> 8U) - 91;
-               gMCUBufG[0] = subAndClamp(gMCUBufG[0], crG);
-               gMCUBufG[64] = subAndClamp(gMCUBufG[64], crG);
+               pD->mMCUBufG[0] = subAndClamp(pD->mMCUBufG[0], crG);
+               pD->mMCUBufG[64] = subAndClamp(pD->mMCUBufG[64], crG);
 
                break;
             }
@@ -2051,61 +2372,61 @@ static void transformBlockReduce(uint8 mcuBlock)
          {
             case 0:
             {
-               gMCUBufR[0] = c;
-               gMCUBufG[0] = c;
-               gMCUBufB[0] = c;
+               pD->mMCUBufR[0] = c;
+               pD->mMCUBufG[0] = c;
+               pD->mMCUBufB[0] = c;
                break;
             }
             case 1:
             {
-               gMCUBufR[64] = c;
-               gMCUBufG[64] = c;
-               gMCUBufB[64] = c;
+               pD->mMCUBufR[64] = c;
+               pD->mMCUBufG[64] = c;
+               pD->mMCUBufB[64] = c;
                break;
             }
             case 2:
             {
-               gMCUBufR[128] = c;
-               gMCUBufG[128] = c;
-               gMCUBufB[128] = c;
+               pD->mMCUBufR[128] = c;
+               pD->mMCUBufG[128] = c;
+               pD->mMCUBufB[128] = c;
                break;
             }
             case 3:
             {
-               gMCUBufR[192] = c;
-               gMCUBufG[192] = c;
-               gMCUBufB[192] = c;
+               pD->mMCUBufR[192] = c;
+               pD->mMCUBufG[192] = c;
+               pD->mMCUBufB[192] = c;
                break;
             }
             case 4:
             {
                cbG = ((c * 88U) >> 8U) - 44U;
-               gMCUBufG[0] = subAndClamp(gMCUBufG[0], cbG);
-               gMCUBufG[64] = subAndClamp(gMCUBufG[64], cbG);
-               gMCUBufG[128] = subAndClamp(gMCUBufG[128], cbG);
-               gMCUBufG[192] = subAndClamp(gMCUBufG[192], cbG);
+               pD->mMCUBufG[0] = subAndClamp(pD->mMCUBufG[0], cbG);
+               pD->mMCUBufG[64] = subAndClamp(pD->mMCUBufG[64], cbG);
+               pD->mMCUBufG[128] = subAndClamp(pD->mMCUBufG[128], cbG);
+               pD->mMCUBufG[192] = subAndClamp(pD->mMCUBufG[192], cbG);
 
                cbB = (c + ((c * 198U) >> 8U)) - 227U;
-               gMCUBufB[0] = addAndClamp(gMCUBufB[0], cbB);
-               gMCUBufB[64] = addAndClamp(gMCUBufB[64], cbB);
-               gMCUBufB[128] = addAndClamp(gMCUBufB[128], cbB);
-               gMCUBufB[192] = addAndClamp(gMCUBufB[192], cbB);
+               pD->mMCUBufB[0] = addAndClamp(pD->mMCUBufB[0], cbB);
+               pD->mMCUBufB[64] = addAndClamp(pD->mMCUBufB[64], cbB);
+               pD->mMCUBufB[128] = addAndClamp(pD->mMCUBufB[128], cbB);
+               pD->mMCUBufB[192] = addAndClamp(pD->mMCUBufB[192], cbB);
 
                break;
             }
             case 5:
             {
                crR = (c + ((c * 103U) >> 8U)) - 179;
-               gMCUBufR[0] = addAndClamp(gMCUBufR[0], crR);
-               gMCUBufR[64] = addAndClamp(gMCUBufR[64], crR);
-               gMCUBufR[128] = addAndClamp(gMCUBufR[128], crR);
-               gMCUBufR[192] = addAndClamp(gMCUBufR[192], crR);
+               pD->mMCUBufR[0] = addAndClamp(pD->mMCUBufR[0], crR);
+               pD->mMCUBufR[64] = addAndClamp(pD->mMCUBufR[64], crR);
+               pD->mMCUBufR[128] = addAndClamp(pD->mMCUBufR[128], crR);
+               pD->mMCUBufR[192] = addAndClamp(pD->mMCUBufR[192], crR);
 
                crG = ((c * 183U) >> 8U) - 91;
-               gMCUBufG[0] = subAndClamp(gMCUBufG[0], crG);
-               gMCUBufG[64] = subAndClamp(gMCUBufG[64], crG);
-               gMCUBufG[128] = subAndClamp(gMCUBufG[128], crG);
-               gMCUBufG[192] = subAndClamp(gMCUBufG[192], crG);
+               pD->mMCUBufG[0] = subAndClamp(pD->mMCUBufG[0], crG);
+               pD->mMCUBufG[64] = subAndClamp(pD->mMCUBufG[64], crG);
+               pD->mMCUBufG[128] = subAndClamp(pD->mMCUBufG[128], crG);
+               pD->mMCUBufG[192] = subAndClamp(pD->mMCUBufG[192], crG);
 
                break;
             }
@@ -2115,62 +2436,242 @@ static void transformBlockReduce(uint8 mcuBlock)
    }
 }
 //------------------------------------------------------------------------------
-static uint8 decodeNextMCU(void)
+// Reduced size IDCT basis in Q11: C(u) / 2 * cos((2i + 1) * u * pi / (2 * N)).
+// The N output samples are located at the centers of the 8 / N wide pixel
+// groups of the full size block, so only the first N coefficients are used.
+static const int16 gIdct4[4][4] =
+{
+   { 724,  946,  724,  392 },
+   { 724,  392, -724, -946 },
+   { 724, -392, -724,  946 },
+   { 724, -946,  724, -392 },
+};
+
+static const int16 gIdct2[2][2] =
+{
+   { 724,  724 },
+   { 724, -724 },
+};
+//------------------------------------------------------------------------------
+// NxN IDCT of the top left coefficients of mCoeffBuf. Output pixels are
+// stored in raster order with a stride of 8 in place of the coefficients.
+static void idctScaled(pjpeg_decoder_t* pD)
+{
+   uint8 n = (uint8)(1 << pD->mBlockShift);
+   const int16* pK = (n == 4) ? &gIdct4[0][0] : &gIdct2[0][0];
+   int16* pSrc = pD->mCoeffBuf;
+   long tmp[4*4];
+   uint8 i, j, u;
+
+   for (i = 1; i < n; i++)
+      if (pSrc[i] | pSrc[i * 8])
+         break;
+
+   if (i == n)
+   {
+      // Only DC is non-zero in the first row/column, check the rest of the corner.
+      for (j = 1; j < n; j++)
+         for (u = 1; u < n; u++)
+            if (pSrc[j * 8 + u])
+               i = 0;
+   }
+
+   if (i == n)
+   {
+      // Short circuit if only the DC component is non-zero
+      uint8 c = clamp((int16)(PJPG_ARITH_SHIFT_RIGHT_N_16((int16)(pSrc[0] + 4), 3) + 128));
+
+      for (j = 0; j < n; j++)
+         for (i = 0; i < n; i++)
+            pSrc[j * 8 + i] = c;
+
+      return;
+   }
+
+   // Rows, keeping 3 fractional bits
+   for (j = 0; j < n; j++)
+   {
+      for (i = 0; i < n; i++)
+      {
+         long x = 0;
+
+         for (u = 0; u < n; u++)
+            x += (long)pK[i * n + u] * pSrc[j * 8 + u];
+
+         tmp[j * n + i] = (x + (1L << 7)) >> 8;
+      }
+   }
+
+   // Columns
+   for (i = 0; i < n; i++)
+   {
+      for (j = 0; j < n; j++)
+      {
+         long x = 0;
+
+         for (u = 0; u < n; u++)
+            x += (long)pK[j * n + u] * tmp[u * n + i];
+
+         x = (x + (1L << 13)) >> 14;
+
+         pSrc[j * 8 + i] = clamp((int16)(x + 128));
+      }
+   }
+}
+//------------------------------------------------------------------------------
+// Color conversion of a block decoded by idctScaled().
+static void transformBlockScaled(pjpeg_decoder_t* pD, uint8 mcuBlock)
+{
+   uint8 shift = pD->mBlockShift;
+   uint8 n = (uint8)(1 << shift);
+   uint8 componentID = pD->mMCUOrg[mcuBlock];
+   const int16* pSrc = pD->mCoeffBuf;
+   uint8 x, y;
+
+   idctScaled(pD);
+
+   if (componentID == 0)
+   {
+      // Y blocks fill the 2x2 block grid of the MCU buffers in decode order.
+      uint8 block;
+      uint16 ofs;
+
+      if (pD->mScanType == PJPG_YH1V2)
+         block = (uint8)(mcuBlock << 1);
+      else
+         block = mcuBlock;
+
+      ofs = (uint16)(block << 6);
+
+      for (y = 0; y < n; y++)
+      {
+         for (x = 0; x < n; x++)
+         {
+            uint8 c = (uint8)pSrc[y * 8 + x];
+
+            pD->mMCUBufR[ofs] = c;
+            pD->mMCUBufG[ofs] = c;
+            pD->mMCUBufB[ofs] = c;
+            ofs++;
+         }
+      }
+   }
+   else
+   {
+      // Chroma is upsampled by pixel replication while accumulating.
+      uint8 hShift = (uint8)((pD->mScanType == PJPG_YH2V1) || (pD->mScanType == PJPG_YH2V2));
+      uint8 vShift = (uint8)((pD->mScanType == PJPG_YH1V2) || (pD->mScanType == PJPG_YH2V2));
+      uint8 width = (uint8)(n << hShift);
+      uint8 height = (uint8)(n << vShift);
+
+      for (y = 0; y < height; y++)
+      {
+         for (x = 0; x < width; x++)
+         {
+            uint8 c = (uint8)pSrc[(y >> vShift) * 8 + (x >> hShift)];
+            uint16 ofs = (uint16)(((((y >> shift) << 1) + (x >> shift)) << 6) + ((y & (n - 1)) << shift) + (x & (n - 1)));
+
+            if (componentID == 1)
+            {
+               int16 cbG = ((c * 88U) >> 8U) - 44U;
+               int16 cbB = (c + ((c * 198U) >> 8U)) - 227U;
+
+               pD->mMCUBufG[ofs] = subAndClamp(pD->mMCUBufG[ofs], cbG);
+               pD->mMCUBufB[ofs] = addAndClamp(pD->mMCUBufB[ofs], cbB);
+            }
+            else
+            {
+               int16 crR = (c + ((c * 103U) >> 8U)) - 179;
+               int16 crG = ((c * 183U) >> 8U) - 91;
+
+               pD->mMCUBufR[ofs] = addAndClamp(pD->mMCUBufR[ofs], crR);
+               pD->mMCUBufG[ofs] = subAndClamp(pD->mMCUBufG[ofs], crG);
+            }
+         }
+      }
+   }
+}
+//------------------------------------------------------------------------------
+static uint8 decodeNextMCU(pjpeg_decoder_t* pD)
 {
    uint8 status;
    uint8 mcuBlock;
 
-   if (gRestartInterval)
+   if (pD->mRestartInterval)
    {
-      if (gRestartsLeft == 0)
+      if (pD->mRestartsLeft == 0)
       {
-         status = processRestart();
+         status = processRestart(pD);
          if (status)
             return status;
       }
-      gRestartsLeft--;
+      pD->mRestartsLeft--;
    }
 
-   for (mcuBlock = 0; mcuBlock < gMaxBlocksPerMCU; mcuBlock++)
+   for (mcuBlock = 0; mcuBlock < pD->mMaxBlocksPerMCU; mcuBlock++)
    {
-      uint8 componentID = gMCUOrg[mcuBlock];
-      uint8 compQuant = gCompQuant[componentID];
-      uint8 compDCTab = gCompDCTab[componentID];
+      uint8 componentID = pD->mMCUOrg[mcuBlock];
+      uint8 compQuant = pD->mCompQuant[componentID];
+      uint8 compDCTab = pD->mCompDCTab[componentID];
       uint8 numExtraBits, compACTab, k;
-      const int16* pQ = compQuant ? gQuant1 : gQuant0;
+      const int16* pQ = compQuant ? pD->mQuant1 : pD->mQuant0;
       uint16 r, dc;
 
-      uint8 s = huffDecode(compDCTab ? &gHuffTab1 : &gHuffTab0, compDCTab ? gHuffVal1 : gHuffVal0);
+      uint8 s = huffDecode(pD, compDCTab ? &pD->mHuffTab1 : &pD->mHuffTab0, compDCTab ? pD->mHuffVal1 : pD->mHuffVal0);
 
       r = 0;
       numExtraBits = s & 0xF;
       if (numExtraBits)
-         r = getBits2(numExtraBits);
+         r = getEntropyBits(pD, numExtraBits);
       dc = huffExtend(r, s);
 
-      dc = dc + gLastDC[componentID];
-      gLastDC[componentID] = dc;
+      dc = dc + pD->mLastDC[componentID];
+      pD->mLastDC[componentID] = dc;
+
+#if PJPG_PROGRESSIVE_DC
+      if (pD->mProgressive)
+      {
+         // The scan holds the DC coefficients shifted right by the successive approximation bits, and no AC coefficients.
+         pD->mCoeffBuf[0] = (int16)(dc << pD->mSuccessiveLow) * pQ[0];
+
+         if (!pD->mSkipTransform)
+            transformBlockReduce(pD, mcuBlock);
+
+         continue;
+      }
+#endif
 
-      gCoeffBuf[0] = dc * pQ[0];
+      pD->mCoeffBuf[0] = dc * pQ[0];
 
-      compACTab = gCompACTab[componentID];
+      compACTab = pD->mCompACTab[componentID];
 
-      if (gReduce)
+      if ((pD->mBlockShift < 3) || (pD->mSkipTransform))
       {
-         // Decode, but throw out the AC coefficients in reduce mode.
+         // Size of the low frequency corner of coefficients that is kept, 0 if none.
+         uint8 keep = pD->mSkipTransform ? 0 : (uint8)((1 << pD->mBlockShift) & 6);
+
+         for (k = 1; k < (keep * 8); k++)
+            pD->mCoeffBuf[k] = 0;
+
+         // Decode, but throw out the AC coefficients not needed by the reduced output.
          for (k = 1; k < 64; k++)
          {
-            s = huffDecode(compACTab ? &gHuffTab3 : &gHuffTab2, compACTab ? gHuffVal3 : gHuffVal2);
+            uint16 extraBits;
 
+            s = huffDecode(pD, compACTab ? &pD->mHuffTab3 : &pD->mHuffTab2, compACTab ? pD->mHuffVal3 : pD->mHuffVal2);
+
+            extraBits = 0;
             numExtraBits = s & 0xF;
             if (numExtraBits)
-               getBits2(numExtraBits);
+               extraBits = getEntropyBits(pD, numExtraBits);
 
             r = s >> 4;
             s &= 15;
 
             if (s)
             {
+               uint8 z;
+
                if (r)
                {
                   if ((k + r) > 63)
@@ -2178,6 +2679,11 @@ static uint8 decodeNextMCU(void)
 
                   k = (uint8)(k + r);
                }
+
+               // Row and column are both below keep if their bitwise or is.
+               z = (uint8)ZAG[k];
+               if (((z >> 3) | (z & 7)) < keep)
+                  pD->mCoeffBuf[z] = huffExtend(extraBits, s) * pQ[k];
             }
             else
             {
@@ -2193,7 +2699,12 @@ static uint8 decodeNextMCU(void)
             }
          }
 
-         transformBlockReduce(mcuBlock);
+         if (pD->mSkipTransform)
+            ;
+         else if (keep)
+            transformBlockScaled(pD, mcuBlock);
+         else
+            transformBlockReduce(pD, mcuBlock);
       }
       else
       {
@@ -2202,12 +2713,12 @@ static uint8 decodeNextMCU(void)
          {
             uint16 extraBits;
 
-            s = huffDecode(compACTab ? &gHuffTab3 : &gHuffTab2, compACTab ? gHuffVal3 : gHuffVal2);
+            s = huffDecode(pD, compACTab ? &pD->mHuffTab3 : &pD->mHuffTab2, compACTab ? pD->mHuffVal3 : pD->mHuffVal2);
 
             extraBits = 0;
             numExtraBits = s & 0xF;
             if (numExtraBits)
-               extraBits = getBits2(numExtraBits);
+               extraBits = getEntropyBits(pD, numExtraBits);
 
             r = s >> 4;
             s &= 15;
@@ -2223,14 +2734,14 @@ static uint8 decodeNextMCU(void)
 
                   while (r)
                   {
-                     gCoeffBuf[ZAG[k++]] = 0;
+                     pD->mCoeffBuf[ZAG[k++]] = 0;
                      r--;
                   }
                }
 
                ac = huffExtend(extraBits, s);
 
-               gCoeffBuf[ZAG[k]] = ac * pQ[k];
+               pD->mCoeffBuf[ZAG[k]] = ac * pQ[k];
             }
             else
             {
@@ -2240,7 +2751,7 @@ static uint8 decodeNextMCU(void)
                      return PJPG_DECODE_ERROR;
 
                   for (r = 16; r > 0; r--)
-                     gCoeffBuf[ZAG[k++]] = 0;
+                     pD->mCoeffBuf[ZAG[k++]] = 0;
 
                   k--; // - 1 because the loop counter is k
                }
@@ -2250,41 +2761,64 @@ static uint8 decodeNextMCU(void)
          }
 
          while (k < 64)
-            gCoeffBuf[ZAG[k++]] = 0;
+            pD->mCoeffBuf[ZAG[k++]] = 0;
 
-         transformBlock(mcuBlock);
+         transformBlock(pD, mcuBlock);
       }
    }
 
    return 0;
 }
 //------------------------------------------------------------------------------
-unsigned char pjpeg_decode_mcu(void)
+// Moves the current MCU position forward by numMCUs.
+static void advanceMCUs(pjpeg_decoder_t* pD, uint16 numMCUs)
+{
+   while ((numMCUs) && ((pD->mNumMCUSRemainingX) || (pD->mNumMCUSRemainingY)))
+   {
+      pD->mNumMCUSRemainingX--;
+      if (!pD->mNumMCUSRemainingX)
+      {
+         pD->mNumMCUSRemainingY--;
+         if (pD->mNumMCUSRemainingY > 0)
+            pD->mNumMCUSRemainingX = pD->mMaxMCUSPerRow;
+      }
+
+      numMCUs--;
+   }
+}
+//------------------------------------------------------------------------------
+unsigned char pjpeg_decoder_decode_mcu(pjpeg_decoder_t* pD)
 {
    uint8 status;
 
-   if (gCallbackStatus)
-      return gCallbackStatus;
+   if (pD->mCallbackStatus)
+      return pD->mCallbackStatus;
 
-   if ((!gNumMCUSRemainingX) && (!gNumMCUSRemainingY))
+   if ((!pD->mNumMCUSRemainingX) && (!pD->mNumMCUSRemainingY))
       return PJPG_NO_MORE_BLOCKS;
 
-   status = decodeNextMCU();
-   if ((status) || (gCallbackStatus))
-      return gCallbackStatus ? gCallbackStatus : status;
+   status = decodeNextMCU(pD);
+   if ((status) || (pD->mCallbackStatus))
+      return pD->mCallbackStatus ? pD->mCallbackStatus : status;
 
-   gNumMCUSRemainingX--;
-   if (!gNumMCUSRemainingX)
-   {
-      gNumMCUSRemainingY--;
-	  if (gNumMCUSRemainingY > 0)
-		  gNumMCUSRemainingX = gMaxMCUSPerRow;
-   }
+   advanceMCUs(pD, 1);
 
    return 0;
 }
 //------------------------------------------------------------------------------
-unsigned char pjpeg_decode_init(pjpeg_image_info_t *pInfo, pjpeg_need_bytes_callback_t pNeed_bytes_callback, void *pCallback_data, unsigned char reduce)
+void pjpeg_decoder_reset(pjpeg_decoder_t* pD)
+{
+   pD->mNumMCUSRemainingX = 0;
+   pD->mNumMCUSRemainingY = 0;
+   pD->mCallbackStatus = 0;
+   pD->mpNeedBytesCallback = 0;
+   pD->mpNeedWindowCallback = 0;
+   pD->mpCallback_data = 0;
+   pD->mpInWindow = 0;
+   pD->mpInPending = 0;
+}
+//------------------------------------------------------------------------------
+static uint8 initDecoder(pjpeg_decoder_t* pD, pjpeg_image_info_t *pInfo, unsigned char reduce)
 {
    uint8 status;
 
@@ -2294,32 +2828,440 @@ unsigned char pjpeg_decode_init(pjpeg_image_info_t *pInfo, pjpeg_need_bytes_call
    pInfo->m_MCUWidth = 0; pInfo->m_MCUHeight = 0;
    pInfo->m_pMCUBufR = (unsigned char*)0; pInfo->m_pMCUBufG = (unsigned char*)0; pInfo->m_pMCUBufB = (unsigned char*)0;
 
-   g_pNeedBytesCallback = pNeed_bytes_callback;
-   g_pCallback_data = pCallback_data;
-   gCallbackStatus = 0;
-   gReduce = reduce;
+   pD->mCallbackStatus = 0;
+   switch (reduce)
+   {
+      case PJPG_REDUCE_NONE: pD->mBlockShift = 3; break;
+      case PJPG_REDUCE_1_2:  pD->mBlockShift = 2; break;
+      case PJPG_REDUCE_1_4:  pD->mBlockShift = 1; break;
+      default:               pD->mBlockShift = 0; break;
+   }
+   pD->mSkipTransform = 0;
+#if PJPG_PROGRESSIVE_DC
+   pD->mProgressive = 0;
+   pD->mSuccessiveLow = 0;
+#endif
+
+   status = init(pD);
+   if ((status) || (pD->mCallbackStatus))
+      return pD->mCallbackStatus ? pD->mCallbackStatus : status;
+
+   status = locateSOFMarker(pD);
+   if ((status) || (pD->mCallbackStatus))
+      return pD->mCallbackStatus ? pD->mCallbackStatus : status;
+
+   status = initFrame(pD);
+   if ((status) || (pD->mCallbackStatus))
+      return pD->mCallbackStatus ? pD->mCallbackStatus : status;
+
+   status = initScan(pD);
+   if ((status) || (pD->mCallbackStatus))
+      return pD->mCallbackStatus ? pD->mCallbackStatus : status;
+
+   pD->mRoiX0 = 0;
+   pD->mRoiY0 = 0;
+   pD->mRoiX1 = pD->mMaxMCUSPerRow;
+   pD->mRoiY1 = pD->mMaxMCUSPerCol;
+
+   pInfo->m_width = pD->mImageXSize; pInfo->m_height = pD->mImageYSize; pInfo->m_comps = pD->mCompsInFrame;
+   pInfo->m_scanType = pD->mScanType;
+   pInfo->m_MCUSPerRow = pD->mMaxMCUSPerRow; pInfo->m_MCUSPerCol = pD->mMaxMCUSPerCol;
+   pInfo->m_MCUWidth = pD->mMaxMCUXSize; pInfo->m_MCUHeight = pD->mMaxMCUYSize;
+   pInfo->m_pMCUBufR = pD->mMCUBufR; pInfo->m_pMCUBufG = pD->mMCUBufG; pInfo->m_pMCUBufB = pD->mMCUBufB;
+
+   return 0;
+}
+//------------------------------------------------------------------------------
+unsigned char pjpeg_decoder_init(pjpeg_decoder_t* pD, pjpeg_image_info_t *pInfo, pjpeg_need_bytes_callback_t pNeed_bytes_callback, void *pCallback_data, unsigned char reduce)
+{
+   pjpeg_decoder_reset(pD);
+
+   pD->mpNeedBytesCallback = pNeed_bytes_callback;
+   pD->mpCallback_data = pCallback_data;
+
+   return initDecoder(pD, pInfo, reduce);
+}
+//------------------------------------------------------------------------------
+unsigned char pjpeg_decoder_init_window(pjpeg_decoder_t* pD, pjpeg_image_info_t *pInfo, pjpeg_need_window_callback_t pNeed_window_callback, void *pCallback_data, unsigned char reduce)
+{
+   pjpeg_decoder_reset(pD);
+
+   pD->mpNeedWindowCallback = pNeed_window_callback;
+   pD->mpCallback_data = pCallback_data;
+
+   return initDecoder(pD, pInfo, reduce);
+}
+//------------------------------------------------------------------------------
+// Returns the number of MCUs of the restart interval starting at the current
+// MCU if none of them lies inside the [x0, x1) x [y0, y1) MCU rectangle and
+// the interval ends within maxMCUs. Returns 0 if the interval has to be
+// decoded, including images without restart markers and MCUs in the middle
+// of an interval.
+static uint16 getSkippableMCUs(pjpeg_decoder_t* pD, uint16 x0, uint16 y0, uint16 x1, uint16 y1, uint16 maxMCUs)
+{
+   uint16 x, y, i;
+   long numMCUs;
+
+   if (!pD->mRestartInterval)
+      return 0;
+
+   if ((pD->mRestartsLeft != 0) && (pD->mRestartsLeft != pD->mRestartInterval))
+      return 0;
+
+   // The last interval of the image may be shorter.
+   numMCUs = pD->mNumMCUSRemainingY ? ((long)(pD->mNumMCUSRemainingY - 1) * pD->mMaxMCUSPerRow + pD->mNumMCUSRemainingX) : 0;
+   if (numMCUs > pD->mRestartInterval)
+      numMCUs = pD->mRestartInterval;
+
+   if ((!numMCUs) || (numMCUs > maxMCUs))
+      return 0;
+
+   x = (uint16)(pD->mMaxMCUSPerRow - pD->mNumMCUSRemainingX);
+   y = (uint16)(pD->mMaxMCUSPerCol - pD->mNumMCUSRemainingY);
+
+   for (i = 0; i < numMCUs; i++)
+   {
+      if ((x >= x0) && (x < x1) && (y >= y0) && (y < y1))
+         return 0;
+
+      if (++x == pD->mMaxMCUSPerRow)
+      {
+         x = 0;
+         y++;
+      }
+   }
+
+   return (uint16)numMCUs;
+}
+//------------------------------------------------------------------------------
+// Skips the entropy coded data of the restart interval starting at the current
+// MCU by scanning for the marker that ends it. No Huffman decoding is done.
+// The marker is left in the stream for processRestart().
+static uint8 skipRestartInterval(pjpeg_decoder_t* pD, uint16 numMCUs)
+{
+   uint8 c;
+
+   if (pD->mRestartsLeft == 0)
+   {
+      uint8 status = processRestart(pD);
+      if (status)
+         return status;
+   }
+
+   for ( ; ; )
+   {
+      if (getChar(pD) != 0xFF)
+         continue;
+
+      do
+      {
+         c = getChar(pD);
+      } while (c == 0xFF);
+
+      // 0xFF 0x00 is a stuffed data byte, anything else is a marker.
+      if (c)
+         break;
+   }
+
+   stuffChar(pD, c);
+   stuffChar(pD, 0xFF);
+
+   pD->mRestartsLeft = 0;
+
+   advanceMCUs(pD, numMCUs);
+
+   return 0;
+}
+//------------------------------------------------------------------------------
+unsigned char pjpeg_decoder_set_roi(pjpeg_decoder_t* pD, int mcuX, int mcuY, int mcuWidth, int mcuHeight)
+{
+   if ((mcuX < 0) || (mcuY < 0) || (mcuWidth <= 0) || (mcuHeight <= 0) ||
+       (mcuX + mcuWidth > pD->mMaxMCUSPerRow) || (mcuY + mcuHeight > pD->mMaxMCUSPerCol))
+      return PJPG_BAD_ROI;
+
+   pD->mRoiX0 = (uint16)mcuX;
+   pD->mRoiY0 = (uint16)mcuY;
+   pD->mRoiX1 = (uint16)(mcuX + mcuWidth);
+   pD->mRoiY1 = (uint16)(mcuY + mcuHeight);
+
+   return 0;
+}
+//------------------------------------------------------------------------------
+unsigned char pjpeg_decoder_decode_roi_mcu(pjpeg_decoder_t* pD, int* pMCUX, int* pMCUY)
+{
+   for ( ; ; )
+   {
+      uint16 x, y, numMCUs;
+      uint8 status;
+
+      if (pD->mCallbackStatus)
+         return pD->mCallbackStatus;
+
+      if ((!pD->mNumMCUSRemainingX) && (!pD->mNumMCUSRemainingY))
+         return PJPG_NO_MORE_BLOCKS;
+
+      x = (uint16)(pD->mMaxMCUSPerRow - pD->mNumMCUSRemainingX);
+      y = (uint16)(pD->mMaxMCUSPerCol - pD->mNumMCUSRemainingY);
+
+      if (y >= pD->mRoiY1)
+         return PJPG_NO_MORE_BLOCKS;
+
+      if ((x >= pD->mRoiX0) && (x < pD->mRoiX1) && (y >= pD->mRoiY0))
+      {
+         *pMCUX = x;
+         *pMCUY = y;
+
+         return pjpeg_decoder_decode_mcu(pD);
+      }
+
+      numMCUs = getSkippableMCUs(pD, pD->mRoiX0, pD->mRoiY0, pD->mRoiX1, pD->mRoiY1, 0xFFFF);
+      if (numMCUs)
+         status = skipRestartInterval(pD, numMCUs);
+      else
+      {
+         pD->mSkipTransform = 1;
+         status = pjpeg_decoder_decode_mcu(pD);
+         pD->mSkipTransform = 0;
+      }
+
+      if (status)
+         return status;
+   }
+}
+//------------------------------------------------------------------------------
+// Byte offset of decoded pixel (x, y) of the current MCU in the MCU buffers.
+// Blocks are kept in a 2x2 grid of 64 byte blocks, see pjpeg_image_info_t.
+// In reduced modes each block holds its (1 << shift)^2 pixels at its start.
+static PJPG_INLINE uint16 getMCUPixelOfs(uint8 x, uint8 y, uint8 shift)
+{
+   uint8 mask = (uint8)((1 << shift) - 1);
+
+   return (uint16)(((((y >> shift) << 1) + (x >> shift)) << 6) + ((y & mask) << shift) + (x & mask));
+}
+//------------------------------------------------------------------------------
+static PJPG_INLINE uint8* storePixel(uint8* pDst, pjpeg_pixel_format_t format, uint8 r, uint8 g, uint8 b)
+{
+   switch (format)
+   {
+      case PJPG_PIXEL_GRAY8:
+      case PJPG_PIXEL_GRAY_S8:
+      {
+         uint8 y = (uint8)((r * 77U + g * 150U + b * 29U + 128U) >> 8U);
+         *pDst++ = (format == PJPG_PIXEL_GRAY8) ? y : (uint8)(y ^ 0x80);
+         break;
+      }
+      case PJPG_PIXEL_RGB888:
+      {
+         *pDst++ = r;
+         *pDst++ = g;
+         *pDst++ = b;
+         break;
+      }
+      case PJPG_PIXEL_RGB565:
+      {
+         uint16 c = (uint16)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+         *pDst++ = (uint8)c;
+         *pDst++ = (uint8)(c >> 8);
+         break;
+      }
+      case PJPG_PIXEL_RGB_S8:
+      {
+         *pDst++ = (uint8)(r ^ 0x80);
+         *pDst++ = (uint8)(g ^ 0x80);
+         *pDst++ = (uint8)(b ^ 0x80);
+         break;
+      }
+   }
+
+   return pDst;
+}
+//------------------------------------------------------------------------------
+static uint8 getPixelSize(pjpeg_pixel_format_t format)
+{
+   switch (format)
+   {
+      case PJPG_PIXEL_GRAY8:
+      case PJPG_PIXEL_GRAY_S8:
+         return 1;
+      case PJPG_PIXEL_RGB565:
+         return 2;
+      case PJPG_PIXEL_RGB888:
+      case PJPG_PIXEL_RGB_S8:
+         return 3;
+      default:
+         return 0;
+   }
+}
+//------------------------------------------------------------------------------
+// Writes the scaled pixels of the [x0, x1) x [y0, y1) area of the current MCU.
+// Coordinates are relative to the MCU and aligned to the scale factor.
+static void emitMCUPixels(pjpeg_decoder_t* pD, const pjpeg_row_config_t* pC, uint8* pDst, uint8 x0, uint8 x1, uint8 y0, uint8 y1, uint8 scaleShift)
+{
+   uint8 scale = (uint8)(1 << scaleShift);
+   uint8 sumShift = (uint8)(scaleShift << 1);
+   uint8 x, y, i, j;
+
+   for (y = y0; y < y1; y = (uint8)(y + scale))
+   {
+      uint8* pOut = pDst;
+
+      for (x = x0; x < x1; x = (uint8)(x + scale))
+      {
+         uint16 r = 0, g = 0, b = 0;
+
+         for (j = 0; j < scale; j++)
+         {
+            for (i = 0; i < scale; i++)
+            {
+               uint16 ofs = getMCUPixelOfs((uint8)(x + i), (uint8)(y + j), pD->mBlockShift);
+
+               r = (uint16)(r + pD->mMCUBufR[ofs]);
+               if (pD->mCompsInFrame == 3)
+               {
+                  g = (uint16)(g + pD->mMCUBufG[ofs]);
+                  b = (uint16)(b + pD->mMCUBufB[ofs]);
+               }
+            }
+         }
+
+         r = (uint16)((r + ((1 << sumShift) >> 1)) >> sumShift);
+         if (pD->mCompsInFrame == 3)
+         {
+            g = (uint16)((g + ((1 << sumShift) >> 1)) >> sumShift);
+            b = (uint16)((b + ((1 << sumShift) >> 1)) >> sumShift);
+         }
+         else
+         {
+            g = r;
+            b = r;
+         }
+
+         pOut = storePixel(pOut, pC->m_format, (uint8)r, (uint8)g, (uint8)b);
+      }
+
+      pDst += pC->m_pitch;
+   }
+}
+//------------------------------------------------------------------------------
+unsigned char pjpeg_decoder_decode_rows(pjpeg_decoder_t* pD, const pjpeg_row_config_t* pC, unsigned char* pDst, int* pNumRows)
+{
+   uint8 reduceShift = (uint8)(3 - pD->mBlockShift);
+   uint8 mcuXSize = (uint8)(pD->mMaxMCUXSize >> reduceShift);
+   uint8 mcuYSize = (uint8)(pD->mMaxMCUYSize >> reduceShift);
+   uint16 imageXSize = (uint16)((pD->mImageXSize + (1 << reduceShift) - 1) >> reduceShift);
+   uint16 imageYSize = (uint16)((pD->mImageYSize + (1 << reduceShift) - 1) >> reduceShift);
+   uint8 pixelSize = getPixelSize(pC->m_format);
+   uint8 scaleShift;
+   long cropX0, cropY0, cropX1, cropY1;
+   long rowY0, y0, y1;
+   uint16 mcuX;
+   uint8 status;
+
+   *pNumRows = 0;
+
+   if (pD->mCallbackStatus)
+      return pD->mCallbackStatus;
+
+   switch (pC->m_scale)
+   {
+      case 1: scaleShift = 0; break;
+      case 2: scaleShift = 1; break;
+      case 4: scaleShift = 2; break;
+      case 8: scaleShift = 3; break;
+      default: return PJPG_BAD_ROW_CONFIG;
+   }
+
+   if ((!pixelSize) || (scaleShift > pD->mBlockShift))
+      return PJPG_BAD_ROW_CONFIG;
+
+   cropX0 = pC->m_cropX;
+   cropY0 = pC->m_cropY;
+   cropX1 = pC->m_cropWidth ? (cropX0 + pC->m_cropWidth) : imageXSize;
+   cropY1 = pC->m_cropHeight ? (cropY0 + pC->m_cropHeight) : imageYSize;
+
+   if ((cropX0 < 0) || (cropY0 < 0) || (cropX1 > imageXSize) || (cropY1 > imageYSize) ||
+       ((cropX0 | cropY0) & (pC->m_scale - 1)))
+      return PJPG_BAD_ROW_CONFIG;
+
+   cropX1 = cropX0 + ((cropX1 - cropX0) & ~(long)(pC->m_scale - 1));
+   cropY1 = cropY0 + ((cropY1 - cropY0) & ~(long)(pC->m_scale - 1));
+
+   if ((cropX1 <= cropX0) || (cropY1 <= cropY0))
+      return PJPG_BAD_ROW_CONFIG;
+
+   if ((!pD->mNumMCUSRemainingX) && (!pD->mNumMCUSRemainingY))
+      return PJPG_NO_MORE_BLOCKS;
+
+   // Rows must be decoded from the first MCU of a row.
+   if (pD->mNumMCUSRemainingX != pD->mMaxMCUSPerRow)
+      return PJPG_ASSERTION_ERROR;
+
+   rowY0 = (long)(pD->mMaxMCUSPerCol - pD->mNumMCUSRemainingY) * mcuYSize;
+   if (rowY0 >= cropY1)
+      return PJPG_NO_MORE_BLOCKS;
+
+   y0 = (rowY0 > cropY0) ? rowY0 : cropY0;
+   y1 = ((rowY0 + mcuYSize) < cropY1) ? (rowY0 + mcuYSize) : cropY1;
+
+   for (mcuX = 0; mcuX < pD->mMaxMCUSPerRow; mcuX++)
+   {
+      long mcuX0 = (long)mcuX * mcuXSize;
+      long x0 = (mcuX0 > cropX0) ? mcuX0 : cropX0;
+      long x1 = ((mcuX0 + mcuXSize) < cropX1) ? (mcuX0 + mcuXSize) : cropX1;
+
+      pD->mSkipTransform = (uint8)((y0 >= y1) || (x0 >= x1));
 
-   status = init();
-   if ((status) || (gCallbackStatus))
-      return gCallbackStatus ? gCallbackStatus : status;
+      if (pD->mSkipTransform)
+      {
+         // Crop rectangle in MCUs
+         uint16 numMCUs = getSkippableMCUs(pD,
+            (uint16)(cropX0 / mcuXSize), (uint16)(cropY0 / mcuYSize),
+            (uint16)((cropX1 + mcuXSize - 1) / mcuXSize), (uint16)((cropY1 + mcuYSize - 1) / mcuYSize),
+            (uint16)(pD->mMaxMCUSPerRow - mcuX));
+
+         if (numMCUs)
+         {
+            pD->mSkipTransform = 0;
+
+            status = skipRestartInterval(pD, numMCUs);
+            if (status)
+               return status;
+
+            mcuX = (uint16)(mcuX + numMCUs - 1);
+            continue;
+         }
+      }
 
-   status = locateSOFMarker();
-   if ((status) || (gCallbackStatus))
-      return gCallbackStatus ? gCallbackStatus : status;
+      status = pjpeg_decoder_decode_mcu(pD);
+      if (status)
+      {
+         pD->mSkipTransform = 0;
+         return status;
+      }
 
-   status = initFrame();
-   if ((status) || (gCallbackStatus))
-      return gCallbackStatus ? gCallbackStatus : status;
+      if (!pD->mSkipTransform)
+      {
+         emitMCUPixels(pD, pC, pDst + (((x0 - cropX0) >> scaleShift) * pixelSize),
+            (uint8)(x0 - mcuX0), (uint8)(x1 - mcuX0), (uint8)(y0 - rowY0), (uint8)(y1 - rowY0), scaleShift);
+      }
+   }
 
-   status = initScan();
-   if ((status) || (gCallbackStatus))
-      return gCallbackStatus ? gCallbackStatus : status;
+   pD->mSkipTransform = 0;
 
-   pInfo->m_width = gImageXSize; pInfo->m_height = gImageYSize; pInfo->m_comps = gCompsInFrame;
-   pInfo->m_scanType = gScanType;
-   pInfo->m_MCUSPerRow = gMaxMCUSPerRow; pInfo->m_MCUSPerCol = gMaxMCUSPerCol;
-   pInfo->m_MCUWidth = gMaxMCUXSize; pInfo->m_MCUHeight = gMaxMCUYSize;
-   pInfo->m_pMCUBufR = gMCUBufR; pInfo->m_pMCUBufG = gMCUBufG; pInfo->m_pMCUBufB = gMCUBufB;
+   if (y0 < y1)
+      *pNumRows = (int)((y1 - y0) >> scaleShift);
 
    return 0;
 }
+//------------------------------------------------------------------------------
+static pjpeg_decoder_t gDecoder;
+
+unsigned char pjpeg_decode_init(pjpeg_image_info_t *pInfo, pjpeg_need_bytes_callback_t pNeed_bytes_callback, void *pCallback_data, unsigned char reduce)
+{
+   return pjpeg_decoder_init(&gDecoder, pInfo, pNeed_bytes_callback, pCallback_data, reduce);
+}
+//------------------------------------------------------------------------------
+unsigned char pjpeg_decode_mcu(void)
+{
+   return pjpeg_decoder_decode_mcu(&gDecoder);
+}
@@ -4,6 +4,8 @@
 #ifndef PICOJPEG_H
 #define PICOJPEG_H
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -47,7 +49,9 @@ enum
    PJPG_NOTENOUGHMEM,
    PJPG_UNSUPPORTED_COMP_IDENT,
    PJPG_UNSUPPORTED_QUANT_TABLE,
-   PJPG_UNSUPPORTED_MODE,        // picojpeg doesn't support progressive JPEG's
+   PJPG_UNSUPPORTED_MODE,        // progressive JPEG's are only supported by PJPG_REDUCE_1_8, see PJPG_PROGRESSIVE_DC
+   PJPG_BAD_ROW_CONFIG,
+   PJPG_BAD_ROI,
 };
 
 // Scan types
@@ -111,14 +115,254 @@ typedef struct
 
 typedef unsigned char (*pjpeg_need_bytes_callback_t)(unsigned char* pBuf, unsigned char buf_size, unsigned char *pBytes_actually_read, void *pCallback_data);
 
-// Initializes the decompressor. Returns 0 on success, or one of the above error codes on failure.
+// Zero-copy alternative to pjpeg_need_bytes_callback_t. Lends the decoder the next window of the stream by setting *ppBuf and *pBuf_size
+// (1-65535 bytes, or 0 at the end of the stream). The decoder reads the window in place and never writes to it.
+// The window must stay valid until the callback is called again, or until the image is done or abandoned with pjpeg_decoder_reset().
+typedef unsigned char (*pjpeg_need_window_callback_t)(const unsigned char** ppBuf, unsigned short *pBuf_size, void *pCallback_data);
+
+// Number of lookahead bits of the per table Huffman decode lookup tables.
+// Codes up to this length are resolved by a single table lookup on top of a
+// 32-bit entropy bit buffer, longer codes fall back to the canonical code walk.
+// Each of the 4 tables costs (2 << PJPG_HUFF_LOOKAHEAD_BITS) bytes of RAM.
+// Set to 0 for the original bit serial decoder with minimal RAM usage.
+// Must be the same for every translation unit including this header.
+#ifndef PJPG_HUFF_LOOKAHEAD_BITS
+#define PJPG_HUFF_LOOKAHEAD_BITS 9
+#endif
+
+// Set to 1 to run IDCT column pass, chroma upsampling and YCbCr to RGB conversion of full size decodes
+// in a single pass with one clamp per output component. Set to 0 for the original separate passes.
+#ifndef PJPG_FUSED_TRANSFORM
+#define PJPG_FUSED_TRANSFORM 1
+#endif
+
+// Set to 1 to decode progressive JPEG's in PJPG_REDUCE_1_8 mode from their first DC scan. The DC coefficients of that scan
+// lack the successive approximation bits of later scans, which costs at most a few levels of accuracy per block.
+// All other scans are ignored, so the image must start with an interleaved DC scan as written by libjpeg and most phones.
+// Set to 0 to reject progressive JPEG's with PJPG_UNSUPPORTED_MODE.
+#ifndef PJPG_PROGRESSIVE_DC
+#define PJPG_PROGRESSIVE_DC 1
+#endif
+
+#define PJPG_MAX_IN_BUF_SIZE 256
+
+typedef struct
+{
+   unsigned short mMinCode[16];
+   unsigned short mMaxCode[16];
+   unsigned char mValPtr[16];
+#if PJPG_HUFF_LOOKAHEAD_BITS
+   // Indexed by the next PJPG_HUFF_LOOKAHEAD_BITS bits of the stream.
+   // Entry is (code length << 8) | symbol, or 0 if the code is longer.
+   unsigned short mLookup[1 << PJPG_HUFF_LOOKAHEAD_BITS];
+#endif
+} pjpeg_huff_table_t;
+
+// Complete state of a single decode. The caller owns the memory, so several
+// images can be decoded at once (one decoder per image or thread) and the
+// state can be placed in any RAM bank. Fields are private to picojpeg.c.
+typedef struct
+{
+   // 128 bytes
+   short mCoeffBuf[8*8];
+
+   // 8*8*4 bytes * 3 = 768
+   unsigned char mMCUBufR[256];
+   unsigned char mMCUBufG[256];
+   unsigned char mMCUBufB[256];
+
+   // 256 bytes
+   short mQuant0[8*8];
+   short mQuant1[8*8];
+
+   // 6 bytes
+   short mLastDC[3];
+
+#if PJPG_FUSED_TRANSFORM
+   // 64 bytes, Cb samples of the current MCU until its Cr block is decoded.
+   unsigned char mMCUBufCb[64];
+#endif
+
+   // DC - 192
+   pjpeg_huff_table_t mHuffTab0;
+   unsigned char mHuffVal0[16];
+
+   pjpeg_huff_table_t mHuffTab1;
+   unsigned char mHuffVal1[16];
+
+   // AC - 672
+   pjpeg_huff_table_t mHuffTab2;
+   unsigned char mHuffVal2[256];
+
+   pjpeg_huff_table_t mHuffTab3;
+   unsigned char mHuffVal3[256];
+
+   unsigned char mValidHuffTables;
+   unsigned char mValidQuantTables;
+
+   unsigned char mTemFlag;
+   unsigned char mInBuf[PJPG_MAX_IN_BUF_SIZE];
+
+   // Next input byte, either in mInBuf or in the window lent by the need window callback.
+   const unsigned char *mpInBuf;
+   unsigned short mInBufLeft;
+
+   // Start of the lent window bytes in front of mpInBuf, 0 while reading mInBuf.
+   const unsigned char *mpInWindow;
+
+   // Rest of the lent window to continue with once bytes put back in front of it are read from mInBuf, 0 if none.
+   const unsigned char *mpInPending;
+   unsigned short mInPendingLeft;
+
+   unsigned short mBitBuf;
+   unsigned char mBitsLeft;
+
+#if PJPG_HUFF_LOOKAHEAD_BITS
+   // Entropy coded segment bit buffer. Valid bits are MSB aligned.
+   // Marker parsing keeps using the byte oriented mBitBuf above.
+   uint32_t mEntBitBuf;
+   unsigned char mEntBitsLeft;
+#endif
+
+   unsigned short mImageXSize;
+   unsigned short mImageYSize;
+   unsigned char mCompsInFrame;
+   unsigned char mCompIdent[3];
+   unsigned char mCompHSamp[3];
+   unsigned char mCompVSamp[3];
+   unsigned char mCompQuant[3];
+
+   unsigned short mRestartInterval;
+   unsigned short mNextRestartNum;
+   unsigned short mRestartsLeft;
+
+   unsigned char mCompsInScan;
+   unsigned char mCompList[3];
+   unsigned char mCompDCTab[3]; // 0,1
+   unsigned char mCompACTab[3]; // 0,1
+
+   pjpeg_scan_type_t mScanType;
+
+   unsigned char mMaxBlocksPerMCU;
+   unsigned char mMaxMCUXSize;
+   unsigned char mMaxMCUYSize;
+   unsigned short mMaxMCUSPerRow;
+   unsigned short mMaxMCUSPerCol;
+
+   unsigned short mNumMCUSRemainingX, mNumMCUSRemainingY;
+
+   unsigned char mMCUOrg[6];
+
+   pjpeg_need_bytes_callback_t mpNeedBytesCallback;
+   pjpeg_need_window_callback_t mpNeedWindowCallback;
+   void *mpCallback_data;
+   unsigned char mCallbackStatus;
+
+   // log2 of the decoded block size: 3 for full size, 2 for 1/2, 1 for 1/4 and 0 for 1/8 scale.
+   unsigned char mBlockShift;
+
+   // Set while decoding MCUs whose pixels are not needed, see pjpeg_decoder_decode_rows().
+   unsigned char mSkipTransform;
+
+   // MCU rectangle used by pjpeg_decoder_decode_roi_mcu(), end exclusive.
+   unsigned short mRoiX0, mRoiY0;
+   unsigned short mRoiX1, mRoiY1;
+
+#if PJPG_PROGRESSIVE_DC
+   // Set while decoding the DC scan of a progressive JPEG, which has no AC coefficients.
+   unsigned char mProgressive;
+   // Successive approximation low bit position of the DC scan.
+   unsigned char mSuccessiveLow;
+#endif
+} pjpeg_decoder_t;
+
+// Pixel formats written by pjpeg_decoder_decode_rows().
+typedef enum
+{
+   PJPG_PIXEL_GRAY8,    // 1 byte per pixel: Y
+   PJPG_PIXEL_RGB888,   // 3 bytes per pixel: R, G, B
+   PJPG_PIXEL_RGB565,   // 2 bytes per pixel, little endian, R in the 5 most significant bits
+   PJPG_PIXEL_GRAY_S8,  // 1 byte per pixel: Y - 128
+   PJPG_PIXEL_RGB_S8    // 3 bytes per pixel: R - 128, G - 128, B - 128
+} pjpeg_pixel_format_t;
+
+// The signed formats match int8 model input tensors with scale 1/255 and zero point -128,
+// so decoded rows can be written straight into the tensor.
+typedef struct
+{
+   pjpeg_pixel_format_t m_format;
+
+   // Crop rectangle in decoded pixels, which are scaled down when the decoder was initialized with reduce.
+   // A width or height of 0 selects the full image width or height.
+   int m_cropX, m_cropY;
+   int m_cropWidth, m_cropHeight;
+
+   // Integer downscale factor: 1, 2, 4 or 8, limited to the decoded block size (4 for PJPG_REDUCE_1_2, 2 for PJPG_REDUCE_1_4, 1 for PJPG_REDUCE_1_8).
+   // Each output pixel is the average of a m_scale x m_scale box of decoded pixels.
+   // m_cropX and m_cropY must be multiples of m_scale, the crop size is truncated to a multiple of it.
+   // The output image is (m_cropWidth / m_scale) x (m_cropHeight / m_scale) pixels.
+   int m_scale;
+
+   // Distance in bytes between the starts of two output rows in pDst.
+   int m_pitch;
+} pjpeg_row_config_t;
+
+// Values of the reduce parameter of the init functions.
+enum
+{
+   PJPG_REDUCE_NONE = 0,   // Full size
+   PJPG_REDUCE_1_8 = 1,    // 1/8 scale, only the DC coefficient of each block is used (1 pixel per block)
+   PJPG_REDUCE_1_2 = 2,    // 1/2 scale, 4x4 IDCT of the low frequency coefficients (4x4 pixels per block)
+   PJPG_REDUCE_1_4 = 4     // 1/4 scale, 2x2 IDCT of the low frequency coefficients (2x2 pixels per block)
+};
+
+// Initializes the decompressor state in pDecoder and parses the image headers. Returns 0 on success, or one of the above error codes on failure.
 // pNeed_bytes_callback will be called to fill the decompressor's internal input buffer.
-// If reduce is 1, only the first pixel of each block will be decoded. This mode is much faster because it skips the AC dequantization, IDCT and chroma upsampling of every image pixel.
+// If reduce is 1 (PJPG_REDUCE_1_8), only the first pixel of each block will be decoded. This mode is much faster because it skips the AC dequantization, IDCT and chroma upsampling of every image pixel.
+// PJPG_REDUCE_1_2 and PJPG_REDUCE_1_4 decode each 8x8 block to 4x4 or 2x2 pixels with a reduced size IDCT. Coefficients outside of the
+// low frequency 4x4 or 2x2 corner are Huffman decoded but neither dequantized nor transformed. Any other non-zero value selects PJPG_REDUCE_1_8.
+// In reduced modes each block in the MCU buffers holds its pixels in raster order at the start of the 64 byte block: 4x4, 2x2 or 1 pixel.
+// The MCU buffer pointers returned in pInfo point into pDecoder.
+// Progressive JPEG's are decoded from their first scan with PJPG_REDUCE_1_8 and rejected with PJPG_UNSUPPORTED_MODE otherwise.
+// Separate decoders may be used concurrently from different threads.
+unsigned char pjpeg_decoder_init(pjpeg_decoder_t *pDecoder, pjpeg_image_info_t *pInfo, pjpeg_need_bytes_callback_t pNeed_bytes_callback, void *pCallback_data, unsigned char reduce);
+
+// Same as pjpeg_decoder_init(), but the stream is read in place from windows lent by pNeed_window_callback instead of being copied
+// into the decoder in chunks of at most PJPG_MAX_IN_BUF_SIZE - 4 bytes. Use it when the compressed image is already in memory,
+// for example in segments of a ring buffer.
+unsigned char pjpeg_decoder_init_window(pjpeg_decoder_t *pDecoder, pjpeg_image_info_t *pInfo, pjpeg_need_window_callback_t pNeed_window_callback, void *pCallback_data, unsigned char reduce);
+
+// Decompresses the next MCU of the image opened by pjpeg_decoder_init(). Returns 0 on success, PJPG_NO_MORE_BLOCKS if no more blocks are available, or an error code.
+// Must be called a total of m_MCUSPerRow*m_MCUSPerCol times to completely decompress the image.
+unsigned char pjpeg_decoder_decode_mcu(pjpeg_decoder_t *pDecoder);
+
+// Abandons the current image. Subsequent pjpeg_decoder_decode_mcu() calls return PJPG_NO_MORE_BLOCKS until the decoder is initialized again.
+// The need bytes callback is not called after this returns.
+void pjpeg_decoder_reset(pjpeg_decoder_t *pDecoder);
+
+// Decodes the next row of MCU's and writes the part of it that falls inside the crop rectangle to pDst in raster order.
+// At most m_MCUHeight / m_scale output rows are written. *pNumRows receives the number of rows written, which is 0 for MCU rows above the crop rectangle.
+// Output rows are produced in order, so a caller filling a complete output image simply advances pDst by *pNumRows * m_pitch after each call.
+// MCU's outside of the crop rectangle are entropy decoded only, or skipped without decoding when they fill whole restart intervals. Returns 0 on success, PJPG_NO_MORE_BLOCKS once the last MCU row or the bottom of the crop
+// rectangle was passed, or an error code. The configuration must not change between calls for the same image and must not be mixed with pjpeg_decoder_decode_mcu().
+unsigned char pjpeg_decoder_decode_rows(pjpeg_decoder_t *pDecoder, const pjpeg_row_config_t *pConfig, unsigned char *pDst, int *pNumRows);
+
+// Sets the MCU rectangle decoded by pjpeg_decoder_decode_roi_mcu(). Must be called after pjpeg_decoder_init(), which resets it to the full image.
+// Returns 0 on success or PJPG_BAD_ROI if the rectangle is empty or not inside the image.
+unsigned char pjpeg_decoder_set_roi(pjpeg_decoder_t *pDecoder, int mcuX, int mcuY, int mcuWidth, int mcuHeight);
+
+// Decompresses the next MCU inside the region of interest and returns its MCU column and row in *pMCUX and *pMCUY.
+// Returns 0 on success, PJPG_NO_MORE_BLOCKS once the last MCU of the region of interest was returned, or an error code.
+// MCUs before it are skipped. In images with restart markers, whole restart intervals outside of the region of interest are skipped by
+// scanning for their restart marker without any Huffman decoding. MCUs in intervals crossing the region are entropy decoded only.
+// Must not be mixed with pjpeg_decoder_decode_mcu() or pjpeg_decoder_decode_rows() for the same image.
+unsigned char pjpeg_decoder_decode_roi_mcu(pjpeg_decoder_t *pDecoder, int *pMCUX, int *pMCUY);
+
+// Same as pjpeg_decoder_init() using a single decoder instance internal to picojpeg.c.
 // Not thread safe.
 unsigned char pjpeg_decode_init(pjpeg_image_info_t *pInfo, pjpeg_need_bytes_callback_t pNeed_bytes_callback, void *pCallback_data, unsigned char reduce);
 
-// Decompresses the file's next MCU. Returns 0 on success, PJPG_NO_MORE_BLOCKS if no more blocks are available, or an error code.
-// Must be called a total of m_MCUSPerRow*m_MCUSPerCol times to completely decompress the image.
+// Same as pjpeg_decoder_decode_mcu() using the internal decoder instance.
 // Not thread safe.
 unsigned char pjpeg_decode_mcu(void);
 
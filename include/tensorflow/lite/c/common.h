@@ -900,8 +900,28 @@ typedef struct TfLiteRegistration {
   // Note: It is the responsibility of the registration binder to set this
   // properly.
   int version;
+
+  // Bitmask of TfLiteInPlaceOp flags declaring which inputs the output of the
+  // op may share its buffer with. Zero-initialized registrations are never
+  // executed in place.
+  // WARNING: This is an experimental interface that is subject to change.
+  uint64_t inplace_operator;
 } TfLiteRegistration;
 
+// Flags for TfLiteRegistration::inplace_operator. An op may only declare an
+// input as shared if its kernel reads every input element before it writes
+// the output element at the same or any higher byte offset, so that writing
+// output 0 over the input buffer gives the same result. The interpreter only
+// shares a buffer if the input is no longer used after the op, is not a graph
+// input or output and is at least as large as output 0.
+typedef enum TfLiteInPlaceOp {
+  kTfLiteInplaceOpNone = 0,
+  // Output 0 may share its buffer with input 0.
+  kTfLiteInplaceOpInput0Shared = 1,
+  // Output 0 may share its buffer with input 1.
+  kTfLiteInplaceOpInput1Shared = 2,
+} TfLiteInPlaceOp;
+
 // The flags used in `TfLiteDelegate`. Note that this is a bitmask, so the
 // values should be 1, 2, 4, 8, ...etc.
 typedef enum TfLiteDelegateFlags {
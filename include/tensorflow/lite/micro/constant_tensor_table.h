@@ -0,0 +1,50 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_CONSTANT_TENSOR_TABLE_H_
+#define TENSORFLOW_LITE_MICRO_CONSTANT_TENSOR_TABLE_H_
+
+#include <stdint.h>
+
+#include "tensorflow/lite/c/common.h"
+
+namespace tflite {
+
+// Eval tensors of the constant tensors of a model, generated at build time by
+// tools/model_packer.py and stored in flash next to the model. The allocator
+// uses them instead of allocating and initializing a TfLiteEvalTensor in the
+// arena for every weight, see MicroInterpreter::SetConstantTensorTable().
+//
+// The packer moves the constant tensors of every subgraph behind all other
+// tensors, so the constants of a subgraph are a single range of tensor
+// indices. The table is checked against the model in AllocateTensors().
+
+// Constant tensors of one subgraph. tensors[i] describes the tensor with index
+// first_index + i, and first_index + count is the number of tensors of the
+// subgraph.
+struct ConstantSubgraphTensors {
+  int32_t first_index;
+  int32_t count;
+  const TfLiteEvalTensor* tensors;
+};
+
+// Constant tensors of all subgraphs of a model, in subgraph order.
+struct ConstantTensorTable {
+  int32_t subgraph_count;
+  const ConstantSubgraphTensors* subgraphs;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_CONSTANT_TENSOR_TABLE_H_
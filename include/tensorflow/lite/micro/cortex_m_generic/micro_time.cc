@@ -15,53 +15,33 @@ limitations under the License.
 
 #include "tensorflow/lite/micro/micro_time.h"
 
-// DWT (Data Watchpoint and Trace) registers, only exists on ARM Cortex with a
-// DWT unit.
-#define KIN1_DWT_CONTROL (*((volatile uint32_t*)0xE0001000))
-/*!< DWT Control register */
+#if defined(TF_LITE_USE_CTIME)
+#include <ctime>
+#else
+#include "cycle_counter.h"
+#endif
 
-// DWT Control register.
-#define KIN1_DWT_CYCCNTENA_BIT (1UL << 0)
-
-// CYCCNTENA bit in DWT_CONTROL register.
-#define KIN1_DWT_CYCCNT (*((volatile uint32_t*)0xE0001004))
-
-// DWT Cycle Counter register.
-#define KIN1_DEMCR (*((volatile uint32_t*)0xE000EDFC))
-
-// DEMCR: Debug Exception and Monitor Control Register.
-#define KIN1_TRCENA_BIT (1UL << 24)
-
-#define KIN1_LAR (*((volatile uint32_t*)0xE0001FB0))
-
-#define KIN1_DWT_CONTROL (*((volatile uint32_t*)0xE0001000))
+namespace tflite {
 
-// Unlock access to DWT (ITM, etc.)registers.
-#define KIN1_UnlockAccessToDWT() KIN1_LAR = 0xC5ACCE55;
+#if defined(TF_LITE_USE_CTIME)
 
-// TRCENA: Enable trace and debug block DEMCR (Debug Exception and Monitor
-// Control Register.
-#define KIN1_InitCycleCounter() KIN1_DEMCR |= KIN1_TRCENA_BIT
+// Host builds of the same sources, e.g. to run the profiling reports on a PC,
+// have no DWT and measure with clock() instead.
+int32_t ticks_per_second() { return CLOCKS_PER_SEC; }
 
-#define KIN1_ResetCycleCounter() KIN1_DWT_CYCCNT = 0
-#define KIN1_EnableCycleCounter() KIN1_DWT_CONTROL |= KIN1_DWT_CYCCNTENA_BIT
-#define KIN1_DisableCycleCounter() KIN1_DWT_CONTROL &= ~KIN1_DWT_CYCCNTENA_BIT
-#define KIN1_GetCycleCounter() KIN1_DWT_CYCCNT
+int32_t GetCurrentTimeTicks() { return clock(); }
 
-namespace tflite {
+#else
 
 int32_t ticks_per_second() { return 0; }
 
+// The DWT cycle counter is shared with the profiling zones and the message
+// handler statistics, so it is only restarted after deep sleep, never reset.
 int32_t GetCurrentTimeTicks() {
-  static bool is_initialized = false;
-  if (!is_initialized) {
-    KIN1_UnlockAccessToDWT();
-    KIN1_InitCycleCounter();
-    KIN1_ResetCycleCounter();
-    KIN1_EnableCycleCounter();
-    is_initialized = true;
-  }
-  return KIN1_GetCycleCounter();
+  CycleCounter_Enable();
+  return DWT->CYCCNT;
 }
 
+#endif  // defined(TF_LITE_USE_CTIME)
+
 }  // namespace tflite
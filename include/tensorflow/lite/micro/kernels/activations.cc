@@ -116,7 +116,8 @@ TfLiteRegistration Register_RELU() {
           /*profiling_string=*/nullptr,
           /*builtin_code=*/0,
           /*custom_name=*/nullptr,
-          /*version=*/0};
+          /*version=*/0,
+          /*inplace_operator=*/kTfLiteInplaceOpInput0Shared};
 }
 
 TfLiteRegistration Register_RELU6() {
@@ -127,7 +128,8 @@ TfLiteRegistration Register_RELU6() {
           /*profiling_string=*/nullptr,
           /*builtin_code=*/0,
           /*custom_name=*/nullptr,
-          /*version=*/0};
+          /*version=*/0,
+          /*inplace_operator=*/kTfLiteInplaceOpInput0Shared};
 }
 
 }  // namespace tflite
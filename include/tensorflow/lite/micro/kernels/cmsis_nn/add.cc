@@ -106,6 +106,7 @@ void EvalAddFloat(TfLiteContext* context, TfLiteNode* node,
                   TfLiteAddParams* params, const OpData* data,
                   const TfLiteEvalTensor* input1,
                   const TfLiteEvalTensor* input2, TfLiteEvalTensor* output) {
+  tflite::micro::SetKernelVariant(context, "reference");
   tflite::ArithmeticParams op_params;
   SetActivationParams(data->output_activation_min_f32,
                       data->output_activation_max_f32, &op_params);
@@ -152,6 +153,7 @@ TfLiteStatus EvalAddQuantized(TfLiteContext* context, TfLiteNode* node,
   switch (output->type) {
     case kTfLiteInt8: {
       if (need_broadcast) {
+        tflite::micro::SetKernelVariant(context, "reference");
         reference_integer_ops::BroadcastAdd4DSlow(
             op_params, tflite::micro::GetTensorShape(input1),
             tflite::micro::GetTensorData<int8_t>(input1),
@@ -160,6 +162,7 @@ TfLiteStatus EvalAddQuantized(TfLiteContext* context, TfLiteNode* node,
             tflite::micro::GetTensorShape(output),
             tflite::micro::GetTensorData<int8_t>(output));
       } else {
+        tflite::micro::SetKernelVariant(context, "arm_elementwise_add_s8");
         arm_elementwise_add_s8(
             tflite::micro::GetTensorData<int8_t>(input1),
             tflite::micro::GetTensorData<int8_t>(input2),
@@ -177,6 +180,7 @@ TfLiteStatus EvalAddQuantized(TfLiteContext* context, TfLiteNode* node,
       break;
     }
     case kTfLiteInt16: {
+      tflite::micro::SetKernelVariant(context, "reference");
       if (need_broadcast) {
         reference_ops::BroadcastAdd4DSlow(
             op_params, tflite::micro::GetTensorShape(input1),
@@ -267,7 +271,9 @@ TfLiteRegistration Register_ADD() {
           /*profiling_string=*/nullptr,
           /*builtin_code=*/0,
           /*custom_name=*/nullptr,
-          /*version=*/0};
+          /*version=*/0,
+          /*inplace_operator=*/kTfLiteInplaceOpInput0Shared |
+                               kTfLiteInplaceOpInput1Shared};
 }
 
 }  // namespace tflite
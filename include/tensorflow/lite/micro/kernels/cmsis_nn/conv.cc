@@ -125,6 +125,27 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   return kTfLiteOk;
 }
 
+// Name of the kernel arm_convolve_wrapper_s8() dispatches to, for the
+// profiler. Mirrors the selection in arm_convolve_wrapper_s8.c.
+const char* ConvolveWrapperVariant(const cmsis_nn_conv_params& conv_params,
+                                   const cmsis_nn_dims& input_dims,
+                                   const cmsis_nn_dims& filter_dims,
+                                   const cmsis_nn_dims& output_dims) {
+  const bool no_dilation =
+      (conv_params.dilation.w == 1) && (conv_params.dilation.h == 1);
+  if ((conv_params.padding.w == 0) && (conv_params.padding.h == 0) &&
+      (input_dims.c % 4 == 0) && (conv_params.stride.w == 1) &&
+      (conv_params.stride.h == 1) && (filter_dims.w == 1) &&
+      (filter_dims.h == 1) && no_dilation) {
+    return "arm_convolve_1x1_s8_fast";
+  }
+  if ((output_dims.h == 1) && (input_dims.h == 1) && (filter_dims.h == 1) &&
+      (output_dims.w % 4 == 0) && (input_dims.n == 1) && no_dilation) {
+    return "arm_convolve_1_x_n_s8";
+  }
+  return "arm_convolve_s8";
+}
+
 TfLiteStatus EvalQuantizedPerChannel(
     TfLiteContext* context, TfLiteNode* node, const TfLiteConvParams& params,
     const OpData& data, const TfLiteEvalTensor* input,
@@ -211,6 +232,9 @@ TfLiteStatus EvalQuantizedPerChannel(
 
   // arm_convolve_wrapper_s8 dispatches the optimized kernel accordingly with
   // the parameters passed
+  tflite::micro::SetKernelVariant(
+      context, ConvolveWrapperVariant(conv_params, input_dims, filter_dims,
+                                      output_dims));
   TFLITE_DCHECK_EQ(
       arm_convolve_wrapper_s8(
           &ctx, &conv_params, &quant_params, &input_dims,
@@ -250,6 +274,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 
   switch (input->type) {  // Already know in/out types are same.
     case kTfLiteFloat32: {
+      tflite::micro::SetKernelVariant(context, "reference");
       tflite::reference_ops::Conv(
           ConvParamsFloat(params, data.reference_op_data),
           tflite::micro::GetTensorShape(input),
@@ -268,6 +293,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
                                      bias, output, nullptr);
       break;
     case kTfLiteInt16: {
+      tflite::micro::SetKernelVariant(context, "reference");
       reference_integer_ops::ConvPerChannel(
           ConvParamsQuantized(params, data.reference_op_data),
           data.reference_op_data.per_channel_output_multiplier,
@@ -152,6 +152,24 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   return kTfLiteOk;
 }
 
+// Name of the kernel arm_depthwise_conv_wrapper_s8() dispatches to, for the
+// profiler. Mirrors the selection in arm_depthwise_conv_wrapper_s8.c.
+const char* DepthwiseConvWrapperVariant(
+    const cmsis_nn_dw_conv_params& dw_conv_params,
+    const cmsis_nn_dims& input_dims, const cmsis_nn_dims& filter_dims) {
+  if ((dw_conv_params.ch_mult == 1) && (input_dims.n == 1) &&
+      (dw_conv_params.dilation.w == 1) && (dw_conv_params.dilation.h == 1)) {
+#if !defined(ARM_MATH_MVEI)
+    if ((filter_dims.w == 3) && (filter_dims.h == 3) &&
+        (dw_conv_params.padding.h <= 1) && (dw_conv_params.padding.w <= 1)) {
+      return "arm_depthwise_conv_3x3_s8";
+    }
+#endif
+    return "arm_depthwise_conv_s8_opt";
+  }
+  return "arm_depthwise_conv_s8";
+}
+
 void EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
                              const TfLiteDepthwiseConvParams& params,
                              const OpData& data, const TfLiteEvalTensor* input,
@@ -227,6 +245,9 @@ void EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
     ctx.buf = context->GetScratchBuffer(context, data.buffer_idx);
   }
 
+  tflite::micro::SetKernelVariant(
+      context,
+      DepthwiseConvWrapperVariant(dw_conv_params, input_dims, filter_dims));
   TFLITE_DCHECK_EQ(
       arm_depthwise_conv_wrapper_s8(
           &ctx, &dw_conv_params, &quant_params, &input_dims,
@@ -258,6 +279,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 
   switch (input->type) {  // Already know in/out types are same.
     case kTfLiteFloat32: {
+      tflite::micro::SetKernelVariant(context, "reference");
       tflite::reference_ops::DepthwiseConv(
           DepthwiseConvParamsFloat(params, data.reference_op_data),
           tflite::micro::GetTensorShape(input),
@@ -161,6 +161,7 @@ TfLiteStatus EvalQuantizedInt8(TfLiteContext* context, TfLiteNode* node,
   const int32_t* bias_data =
       nullptr != bias ? tflite::micro::GetTensorData<int32_t>(bias) : nullptr;
 
+  tflite::micro::SetKernelVariant(context, "arm_fully_connected_s8");
   TF_LITE_ENSURE_EQ(
       context,
       arm_fully_connected_s8(
@@ -196,6 +197,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       const float* bias_data =
           nullptr != bias ? tflite::micro::GetTensorData<float>(bias) : nullptr;
 
+      tflite::micro::SetKernelVariant(context, "reference");
       tflite::reference_ops::FullyConnected(
           FullyConnectedParamsFloat(params->activation),
           tflite::micro::GetTensorShape(input),
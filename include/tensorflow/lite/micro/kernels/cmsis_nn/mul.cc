@@ -46,6 +46,7 @@ void EvalQuantized(TfLiteContext* context, TfLiteNode* node,
       tflite::micro::GetTensorShape(input2), &op_params);
 
   if (need_broadcast) {
+    tflite::micro::SetKernelVariant(context, "reference");
     reference_integer_ops::BroadcastMul4DSlow(
         op_params, tflite::micro::GetTensorShape(input1),
         tflite::micro::GetTensorData<int8_t>(input1),
@@ -54,6 +55,7 @@ void EvalQuantized(TfLiteContext* context, TfLiteNode* node,
         tflite::micro::GetTensorShape(output),
         tflite::micro::GetTensorData<int8_t>(output));
   } else {
+    tflite::micro::SetKernelVariant(context, "arm_elementwise_mul_s8");
     arm_elementwise_mul_s8(
         tflite::micro::GetTensorData<int8_t>(input1),
         tflite::micro::GetTensorData<int8_t>(input2), op_params.input1_offset,
@@ -88,9 +90,11 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       EvalQuantized(context, node, data, input1, input2, output);
       break;
     case kTfLiteInt32:
+      tflite::micro::SetKernelVariant(context, "reference");
       EvalMulQuantizedReference(context, node, data, input1, input2, output);
       break;
     case kTfLiteFloat32:
+      tflite::micro::SetKernelVariant(context, "reference");
       EvalMulFloatReference(context, node, params, data, input1, input2,
                             output);
       break;
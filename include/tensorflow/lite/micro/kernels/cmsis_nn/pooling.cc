@@ -81,6 +81,7 @@ void AverageEvalQuantized(TfLiteContext* context, const TfLiteNode* node,
     ctx.buf = context->GetScratchBuffer(context, data.buffer_idx);
   }
 
+  tflite::micro::SetKernelVariant(context, "arm_avgpool_s8");
   TFLITE_DCHECK_EQ(
       arm_avgpool_s8(&ctx, &pool_params, &input_dims,
                      micro::GetTensorData<int8_t>(input), &filter_dims,
@@ -129,6 +130,7 @@ TfLiteStatus MaxEvalInt8(TfLiteContext* context, const TfLiteNode* node,
     ctx.buf = context->GetScratchBuffer(context, data.buffer_idx);
   }
 
+  tflite::micro::SetKernelVariant(context, "arm_max_pool_s8");
   TFLITE_DCHECK_EQ(
       arm_max_pool_s8(&ctx, &pool_params, &input_dims,
                       micro::GetTensorData<int8_t>(input), &filter_dims,
@@ -195,6 +197,7 @@ TfLiteStatus AverageEval(TfLiteContext* context, TfLiteNode* node) {
   // Inputs and outputs share the same type, guaranteed by the converter.
   switch (input->type) {
     case kTfLiteFloat32:
+      tflite::micro::SetKernelVariant(context, "reference");
       AveragePoolingEvalFloat(context, node, params, &data.reference_op_data,
                               input, output);
       break;
@@ -223,6 +226,7 @@ TfLiteStatus MaxEval(TfLiteContext* context, TfLiteNode* node) {
 
   switch (input->type) {
     case kTfLiteFloat32:
+      tflite::micro::SetKernelVariant(context, "reference");
       MaxPoolingEvalFloat(context, node, params, &data.reference_op_data, input,
                           output);
       break;
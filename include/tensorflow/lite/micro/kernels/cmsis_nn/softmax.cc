@@ -70,6 +70,7 @@ TfLiteStatus SoftmaxEval(TfLiteContext* context, TfLiteNode* node) {
 
   switch (input->type) {
     case kTfLiteFloat32: {
+      tflite::micro::SetKernelVariant(context, "reference");
       tflite::reference_ops::Softmax(
           data, tflite::micro::GetTensorShape(input),
           tflite::micro::GetTensorData<float>(input),
@@ -79,6 +80,10 @@ TfLiteStatus SoftmaxEval(TfLiteContext* context, TfLiteNode* node) {
     }
     case kTfLiteInt8:
     case kTfLiteInt16: {
+      tflite::micro::SetKernelVariant(
+          context, (input->type == kTfLiteInt8 && output->type == kTfLiteInt8)
+                       ? "arm_softmax_s8"
+                       : "reference");
       SoftmaxQuantized(input, output, data);
       return kTfLiteOk;
     }
@@ -265,6 +265,7 @@ void EvalIntegerSVDF(TfLiteContext* context, TfLiteNode* node,
       context->GetScratchBuffer(context, data.scratch_output_tensor_index));
 
   int8_t* output_data = tflite::micro::GetTensorData<int8_t>(output_tensor);
+  tflite::micro::SetKernelVariant(context, "arm_svdf_s8");
   arm_svdf_s8(
       &scratch_ctx, &scratch_output_ctx, &svdf_params, &in_quant_params,
       &out_quant_params, &input_dims,
@@ -442,6 +443,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 
   switch (weights_feature->type) {
     case kTfLiteFloat32: {
+      tflite::micro::SetKernelVariant(context, "reference");
       EvalFloatSVDF(context, node, input, weights_feature, weights_time, bias,
                     params, data.scratch_tensor_index, activation_state,
                     output);
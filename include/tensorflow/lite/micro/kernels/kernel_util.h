@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/compatibility.h"
 #include "tensorflow/lite/kernels/internal/types.h"
 #include "tensorflow/lite/micro/micro_context.h"
+#include "tensorflow/lite/micro/micro_profiler_interface.h"
 
 namespace tflite {
 namespace micro {
@@ -70,6 +71,19 @@ TfLiteStatus CreateWritableTensorDimsWithCopy(TfLiteContext* context,
                                               TfLiteTensor* tensor,
                                               TfLiteEvalTensor* eval_tensor);
 
+// Reports the implementation that runs for the current node to the profiler
+// of the interpreter, if any. Call from Invoke, the variant must be a string
+// literal. Compiled out together with the profiling events for release builds.
+inline void SetKernelVariant(const TfLiteContext* context,
+                             const char* variant) {
+#if !defined(TF_LITE_STRIP_ERROR_STRINGS)
+  if (context->profiler != nullptr) {
+    static_cast<MicroProfilerInterface*>(context->profiler)
+        ->SetKernelVariant(variant);
+  }
+#endif
+}
+
 }  // namespace micro
 }  // namespace tflite
 
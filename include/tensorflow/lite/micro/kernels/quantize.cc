@@ -41,7 +41,8 @@ TfLiteRegistration Register_QUANTIZE() {
           /*profiling_string=*/nullptr,
           /*builtin_code=*/0,
           /*custom_name=*/nullptr,
-          /*version=*/0};
+          /*version=*/0,
+          /*inplace_operator=*/kTfLiteInplaceOpInput0Shared};
 }
 
 }  // namespace tflite
@@ -110,7 +110,8 @@ TfLiteRegistration Register_RESHAPE() {
           /*profiling_string=*/nullptr,
           /*builtin_code=*/0,
           /*custom_name=*/nullptr,
-          /*version=*/0};
+          /*version=*/0,
+          /*inplace_operator=*/kTfLiteInplaceOpInput0Shared};
 }
 
 }  // namespace micro
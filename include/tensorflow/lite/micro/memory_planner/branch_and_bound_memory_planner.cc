@@ -0,0 +1,365 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/memory_planner/branch_and_bound_memory_planner.h"
+
+#include <limits>
+
+#include "tensorflow/lite/micro/memory_planner/greedy_memory_planner.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+
+namespace tflite {
+
+BranchAndBoundMemoryPlanner::BranchAndBoundMemoryPlanner(int max_search_steps)
+    : max_search_steps_(max_search_steps),
+      max_buffer_count_(0),
+      buffer_count_(0),
+      need_to_calculate_offsets_(true) {}
+
+BranchAndBoundMemoryPlanner::~BranchAndBoundMemoryPlanner() {
+  // We don't own the scratch buffer, so don't deallocate anything.
+}
+
+TfLiteStatus BranchAndBoundMemoryPlanner::Init(unsigned char* scratch_buffer,
+                                               int scratch_buffer_size) {
+  // Reset internal states
+  buffer_count_ = 0;
+  need_to_calculate_offsets_ = true;
+
+  // Allocate the arrays we need within the scratch buffer arena.
+  max_buffer_count_ = scratch_buffer_size / per_buffer_size();
+
+  unsigned char* next_free = scratch_buffer;
+  requirements_ = reinterpret_cast<BufferRequirements*>(next_free);
+  next_free += sizeof(BufferRequirements) * max_buffer_count_;
+
+  buffer_ids_sorted_ = reinterpret_cast<int*>(next_free);
+  next_free += sizeof(int) * max_buffer_count_;
+
+  search_order_ = reinterpret_cast<int*>(next_free);
+  next_free += sizeof(int) * max_buffer_count_;
+
+  next_child_ = reinterpret_cast<int*>(next_free);
+  next_free += sizeof(int) * max_buffer_count_;
+
+  high_water_marks_ = reinterpret_cast<int*>(next_free);
+  next_free += sizeof(int) * max_buffer_count_;
+
+  buffer_offsets_ = reinterpret_cast<int*>(next_free);
+  next_free += sizeof(int) * max_buffer_count_;
+
+  best_buffer_offsets_ = reinterpret_cast<int*>(next_free);
+  return kTfLiteOk;
+}
+
+TfLiteStatus BranchAndBoundMemoryPlanner::AddBuffer(
+    tflite::ErrorReporter* error_reporter, int size, int first_time_used,
+    int last_time_used) {
+  if (buffer_count_ >= max_buffer_count_) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Too many buffers (max is %d)",
+                         max_buffer_count_);
+    return kTfLiteError;
+  }
+  BufferRequirements* current = &requirements_[buffer_count_];
+  current->size = size;
+  current->first_time_used = first_time_used;
+  current->last_time_used = last_time_used;
+  current->offline_offset = kOnlinePlannedBuffer;
+  ++buffer_count_;
+  need_to_calculate_offsets_ = true;
+  return kTfLiteOk;
+}
+
+TfLiteStatus BranchAndBoundMemoryPlanner::AddBuffer(
+    tflite::ErrorReporter* error_reporter, int size, int first_time_used,
+    int last_time_used, int offline_offset) {
+  BufferRequirements* current = &requirements_[buffer_count_];
+  if (AddBuffer(error_reporter, size, first_time_used, last_time_used) !=
+      kTfLiteOk) {
+    return kTfLiteError;
+  }
+  current->offline_offset = offline_offset;
+  return kTfLiteOk;
+}
+
+bool BranchAndBoundMemoryPlanner::DoBuffersOverlapInTime(
+    const BufferRequirements* a, const BufferRequirements* b) const {
+  return (a->first_time_used <= b->last_time_used) &&
+         (b->first_time_used <= a->last_time_used);
+}
+
+int BranchAndBoundMemoryPlanner::FindFirstFitOffset(int buffer_id) {
+  const BufferRequirements* wanted = &requirements_[buffer_id];
+  int candidate_offset = 0;
+  ++search_steps_;
+
+  // Move the candidate above every placed buffer it collides with, until a
+  // full pass over the placed buffers finds no collision. The candidate only
+  // ever moves up, so this ends at the lowest gap that fits.
+  bool moved;
+  do {
+    moved = false;
+    for (int i = 0; i < buffer_count_; ++i) {
+      const BufferRequirements* placed = &requirements_[i];
+      if (!placed->is_placed || !DoBuffersOverlapInTime(wanted, placed)) {
+        continue;
+      }
+      const int placed_offset = buffer_offsets_[i];
+      if ((candidate_offset < placed_offset + placed->size) &&
+          (placed_offset < candidate_offset + wanted->size)) {
+        candidate_offset = placed_offset + placed->size;
+        moved = true;
+      }
+    }
+  } while (moved);
+  return candidate_offset;
+}
+
+int BranchAndBoundMemoryPlanner::CalculatePlacementBound(int high_water_mark) {
+  // Placing more buffers can only move the first fit of a buffer up, so each
+  // unplaced buffer will end at least where it would end if placed right now.
+  int bound = high_water_mark;
+  for (int i = 0; i < buffer_count_; ++i) {
+    if (requirements_[i].is_placed) {
+      continue;
+    }
+    const int end = FindFirstFitOffset(i) + requirements_[i].size;
+    if (end > bound) {
+      bound = end;
+    }
+  }
+  return bound;
+}
+
+void BranchAndBoundMemoryPlanner::CalculateOffsetsIfNeeded() {
+  if (!need_to_calculate_offsets_ || (buffer_count_ == 0)) {
+    return;
+  }
+  need_to_calculate_offsets_ = false;
+  search_steps_ = 0;
+
+  // Offline planned buffers are placed before the search starts. Online
+  // planned buffers are sorted in descending order of size, and buffers of
+  // equal size in descending order of id, so that the first search path
+  // matches the GreedyMemoryPlanner.
+  int online_count = 0;
+  int fixed_high_water_mark = 0;
+  for (int i = 0; i < buffer_count_; ++i) {
+    BufferRequirements* current = &requirements_[i];
+    if (current->offline_offset == kOnlinePlannedBuffer) {
+      current->is_placed = false;
+      buffer_offsets_[i] = -1;
+      int n = online_count++;
+      while ((n > 0) && (requirements_[buffer_ids_sorted_[n - 1]].size <=
+                         current->size)) {
+        buffer_ids_sorted_[n] = buffer_ids_sorted_[n - 1];
+        --n;
+      }
+      buffer_ids_sorted_[n] = i;
+    } else {
+      current->is_placed = true;
+      buffer_offsets_[i] = current->offline_offset;
+      const int end = current->offline_offset + current->size;
+      if (end > fixed_high_water_mark) {
+        fixed_high_water_mark = end;
+      }
+    }
+    best_buffer_offsets_[i] = buffer_offsets_[i];
+  }
+
+  // No layout can need less than the buffers active at the same time.
+  lower_bound_memory_size_ = fixed_high_water_mark;
+  for (int i = 0; i < buffer_count_; ++i) {
+    const int time = requirements_[i].first_time_used;
+    int active_size = 0;
+    for (int j = 0; j < buffer_count_; ++j) {
+      if ((requirements_[j].first_time_used <= time) &&
+          (time <= requirements_[j].last_time_used)) {
+        active_size += requirements_[j].size;
+      }
+    }
+    if (active_size > lower_bound_memory_size_) {
+      lower_bound_memory_size_ = active_size;
+    }
+  }
+
+  best_memory_size_ = std::numeric_limits<int>::max();
+  greedy_memory_size_ = 0;
+  if (online_count == 0) {
+    best_memory_size_ = fixed_high_water_mark;
+    greedy_memory_size_ = fixed_high_water_mark;
+    return;
+  }
+
+  int depth = 0;
+  next_child_[0] = 0;
+  high_water_marks_[0] = fixed_high_water_mark;
+  while (depth >= 0) {
+    if ((best_memory_size_ <= lower_bound_memory_size_) ||
+        ((search_steps_ >= max_search_steps_) && (greedy_memory_size_ != 0))) {
+      break;
+    }
+
+    // Pick the next unplaced buffer to try at this depth. Consecutive buffers
+    // that are not active at the same time are only tried in sorted order.
+    const int previous = (depth > 0) ? search_order_[depth - 1] : -1;
+    int child = -1;
+    while (next_child_[depth] < online_count) {
+      const int candidate = next_child_[depth]++;
+      const BufferRequirements* current =
+          &requirements_[buffer_ids_sorted_[candidate]];
+      if (current->is_placed) {
+        continue;
+      }
+      if ((candidate < previous) &&
+          !DoBuffersOverlapInTime(
+              current, &requirements_[buffer_ids_sorted_[previous]])) {
+        continue;
+      }
+      child = candidate;
+      break;
+    }
+
+    if (child == -1) {
+      // All orders below this depth are done, go back up.
+      --depth;
+      if (depth >= 0) {
+        requirements_[buffer_ids_sorted_[search_order_[depth]]].is_placed =
+            false;
+      }
+      continue;
+    }
+
+    const int buffer_id = buffer_ids_sorted_[child];
+    BufferRequirements* current = &requirements_[buffer_id];
+    const int offset = FindFirstFitOffset(buffer_id);
+    int high_water_mark = high_water_marks_[depth];
+    if (offset + current->size > high_water_mark) {
+      high_water_mark = offset + current->size;
+    }
+    if (high_water_mark >= best_memory_size_) {
+      continue;
+    }
+
+    current->is_placed = true;
+    buffer_offsets_[buffer_id] = offset;
+    search_order_[depth] = child;
+
+    if (depth + 1 == online_count) {
+      // A complete layout that's better than the best one so far.
+      best_memory_size_ = high_water_mark;
+      if (greedy_memory_size_ == 0) {
+        greedy_memory_size_ = high_water_mark;
+      }
+      for (int i = 0; i < buffer_count_; ++i) {
+        best_buffer_offsets_[i] = buffer_offsets_[i];
+      }
+      current->is_placed = false;
+      continue;
+    }
+
+    if ((greedy_memory_size_ != 0) &&
+        (CalculatePlacementBound(high_water_mark) >= best_memory_size_)) {
+      current->is_placed = false;
+      continue;
+    }
+
+    ++depth;
+    next_child_[depth] = 0;
+    high_water_marks_[depth] = high_water_mark;
+  }
+}
+
+size_t BranchAndBoundMemoryPlanner::GetMaximumMemorySize() {
+  CalculateOffsetsIfNeeded();
+  if (buffer_count_ == 0) {
+    return 0;
+  }
+  return best_memory_size_;
+}
+
+size_t BranchAndBoundMemoryPlanner::GetGreedyMemorySize() {
+  CalculateOffsetsIfNeeded();
+  if (buffer_count_ == 0) {
+    return 0;
+  }
+  return greedy_memory_size_;
+}
+
+size_t BranchAndBoundMemoryPlanner::GetLowerBoundMemorySize() {
+  CalculateOffsetsIfNeeded();
+  if (buffer_count_ == 0) {
+    return 0;
+  }
+  return lower_bound_memory_size_;
+}
+
+int BranchAndBoundMemoryPlanner::GetSearchSteps() {
+  CalculateOffsetsIfNeeded();
+  if (buffer_count_ == 0) {
+    return 0;
+  }
+  return search_steps_;
+}
+
+int BranchAndBoundMemoryPlanner::GetBufferCount() { return buffer_count_; }
+
+TfLiteStatus BranchAndBoundMemoryPlanner::GetOffsetForBuffer(
+    tflite::ErrorReporter* error_reporter, int buffer_index, int* offset) {
+  CalculateOffsetsIfNeeded();
+  if ((buffer_index < 0) || (buffer_index >= buffer_count_)) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "buffer index %d is outside range 0 to %d",
+                         buffer_index, buffer_count_);
+    return kTfLiteError;
+  }
+  *offset = best_buffer_offsets_[buffer_index];
+  return kTfLiteOk;
+}
+
+TfLiteStatus BranchAndBoundMemoryPlanner::SaveBufferPlan(
+    tflite::ErrorReporter* error_reporter, BufferPlan* buffer_plan,
+    int max_buffer_count) {
+  CalculateOffsetsIfNeeded();
+  if (buffer_count_ > max_buffer_count) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Buffer plan has room for %d buffers, %d needed",
+                         max_buffer_count, buffer_count_);
+    return kTfLiteError;
+  }
+  buffer_plan->buffer_count = buffer_count_;
+  for (int i = 0; i < buffer_count_; ++i) {
+    buffer_plan->buffer_plan_entries[i].offset = best_buffer_offsets_[i];
+  }
+  return kTfLiteOk;
+}
+
+void BranchAndBoundMemoryPlanner::PrintMemoryPlan() {
+  CalculateOffsetsIfNeeded();
+
+  for (int i = 0; i < buffer_count_; ++i) {
+    MicroPrintf("id=%d: size=%d, offset=%d, first_used=%d last_used=%d", i,
+                requirements_[i].size, best_buffer_offsets_[i],
+                requirements_[i].first_time_used,
+                requirements_[i].last_time_used);
+  }
+  MicroPrintf("Planned %d bytes, greedy %d bytes, lower bound %d bytes (%d "
+              "search steps)",
+              static_cast<int>(GetMaximumMemorySize()),
+              static_cast<int>(GetGreedyMemorySize()),
+              static_cast<int>(GetLowerBoundMemorySize()), search_steps_);
+}
+
+}  // namespace tflite
@@ -0,0 +1,180 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_BRANCH_AND_BOUND_MEMORY_PLANNER_H_
+#define TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_BRANCH_AND_BOUND_MEMORY_PLANNER_H_
+
+#include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/memory_planner/memory_plan_struct.h"
+#include "tensorflow/lite/micro/memory_planner/micro_memory_planner.h"
+
+namespace tflite {
+
+// A memory planner that searches for a smaller arena layout than the
+// GreedyMemoryPlanner within a bounded amount of work.
+//
+// Every buffer is placed at the lowest offset where it doesn't collide with
+// the simultaneously active buffers that are already placed, exactly like the
+// GreedyMemoryPlanner does. What differs is the order the buffers are placed
+// in:
+//  - A depth-first search enumerates placement orders. The first order tried
+//    is descending size, which gives the same layout as the
+//    GreedyMemoryPlanner, so the result is never worse than greedy.
+//  - A partial layout is abandoned as soon as it can't beat the best complete
+//    layout found so far. The bound used is the highest end offset any of the
+//    remaining buffers would get if it was placed next, since placing more
+//    buffers can only push the others up.
+//  - Two consecutive buffers that are not active at the same time don't
+//    influence each other, so only one of their two orders is searched.
+//  - The search stops early once the layout needs no more memory than the
+//    largest sum of buffer sizes active at the same time, which no layout can
+//    undercut.
+//  - Otherwise it stops after max_search_steps buffer placements and keeps the
+//    best layout found, so planning time stays bounded on the device.
+//
+// The search is only run once per set of buffers. Its result can be copied
+// into a BufferPlan with SaveBufferPlan(), for example to store it and use it
+// with the NonPersistentMemoryPlannerShim on later boots instead of repeating
+// the search. tools/offline_memory_planner.py runs the same search on the host
+// with a larger step budget and writes the plan as a source file.
+class BranchAndBoundMemoryPlanner : public MicroMemoryPlanner {
+ public:
+  // Default bound of the number of buffer placements tried by the search.
+  static constexpr int kDefaultMaxSearchSteps = 20000;
+
+  explicit BranchAndBoundMemoryPlanner(
+      int max_search_steps = kDefaultMaxSearchSteps);
+  ~BranchAndBoundMemoryPlanner() override;
+
+  // The same scratch memory rules as for GreedyMemoryPlanner::Init() apply.
+  // Each buffer requires per_buffer_size() bytes of scratch.
+  TfLiteStatus Init(unsigned char* scratch_buffer,
+                    int scratch_buffer_size) override;
+
+  // Record details of a buffer we want to place.
+  TfLiteStatus AddBuffer(ErrorReporter* error_reporter, int size,
+                         int first_time_used, int last_time_used) override;
+
+  // Record details of an offline planned buffer offset we want to place.
+  // offline_offset is the buffer offset from the start of the arena.
+  TfLiteStatus AddBuffer(ErrorReporter* error_reporter, int size,
+                         int first_time_used, int last_time_used,
+                         int offline_offset) override;
+
+  // Returns the high-water mark of the best layout found.
+  size_t GetMaximumMemorySize() override;
+
+  // How many buffers have been recorded.
+  int GetBufferCount() override;
+
+  // Where a given buffer should be placed in the memory arena.
+  // This information is stored in the memory arena itself, so once the arena
+  // is used for inference, it will be overwritten.
+  TfLiteStatus GetOffsetForBuffer(ErrorReporter* error_reporter,
+                                  int buffer_index, int* offset) override;
+
+  // Prints the layout and how it compares to the greedy layout.
+  void PrintMemoryPlan() override;
+
+  // High-water mark the GreedyMemoryPlanner would need for the same buffers.
+  size_t GetGreedyMemorySize();
+
+  // Lower bound of the high-water mark of any layout of the buffers.
+  size_t GetLowerBoundMemorySize();
+
+  // Number of buffer placements the search tried.
+  int GetSearchSteps();
+
+  // Copies the layout into buffer_plan, which must have room for at least
+  // max_buffer_count entries.
+  TfLiteStatus SaveBufferPlan(ErrorReporter* error_reporter,
+                              BufferPlan* buffer_plan, int max_buffer_count);
+
+  // Number of bytes required in order to plan a buffer.
+  static size_t per_buffer_size() {
+    const int per_buffer_size =
+        sizeof(BufferRequirements) +  // requirements_
+        sizeof(int) +                 // buffer_ids_sorted_
+        sizeof(int) +                 // search_order_
+        sizeof(int) +                 // next_child_
+        sizeof(int) +                 // high_water_marks_
+        sizeof(int) +                 // buffer_offsets_
+        sizeof(int);                  // best_buffer_offsets_
+    return per_buffer_size;
+  }
+
+ private:
+  // Records the client-provided information about each buffer.
+  struct BufferRequirements {
+    int size;
+    int offline_offset;
+    int first_time_used;
+    int last_time_used;
+    bool is_placed;
+  };
+
+  // Whether two buffers are active at the same time.
+  bool DoBuffersOverlapInTime(const BufferRequirements* a,
+                              const BufferRequirements* b) const;
+
+  // Lowest offset at which a buffer doesn't collide with any placed buffer.
+  int FindFirstFitOffset(int buffer_id);
+
+  // Highest end offset of the unplaced buffers if they were placed next.
+  int CalculatePlacementBound(int high_water_mark);
+
+  // If there isn't an up to date plan, calculate a new one.
+  void CalculateOffsetsIfNeeded();
+
+  // Bound of the number of FindFirstFitOffset() calls of a search.
+  int max_search_steps_;
+
+  // How many buffers we can plan for, based on the scratch buffer size.
+  int max_buffer_count_;
+
+  // The number of buffers added so far.
+  int buffer_count_;
+
+  // Working arrays used during the search.
+  BufferRequirements* requirements_;
+  // Ids of the online planned buffers in descending order of size.
+  int* buffer_ids_sorted_;
+  // Index into buffer_ids_sorted_ of the buffer placed at each search depth.
+  int* search_order_;
+  // Next index into buffer_ids_sorted_ to try at each search depth.
+  int* next_child_;
+  // High-water mark of the buffers placed before each search depth.
+  int* high_water_marks_;
+  // Layout of the current search path.
+  int* buffer_offsets_;
+
+  // Stores the outcome of the plan, the location of each buffer in the arena.
+  int* best_buffer_offsets_;
+
+  // Statistics of the last search.
+  int best_memory_size_;
+  int greedy_memory_size_;
+  int lower_bound_memory_size_;
+  int search_steps_;
+
+  // Whether buffers have been added since the last plan was calculated.
+  bool need_to_calculate_offsets_;
+
+  TF_LITE_REMOVE_VIRTUAL_DELETE
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_BRANCH_AND_BOUND_MEMORY_PLANNER_H_
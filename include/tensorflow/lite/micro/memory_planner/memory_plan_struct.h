@@ -59,6 +59,20 @@ struct BufferPlan {
   BufferDescriptor buffer_plan_entries[1];
 };
 
+// Optional description of the buffer a BufferPlan entry was laid out for.
+// Offline planners can emit one BufferUsage per plan entry so that the plan is
+// checked against the buffers actually requested by the interpreter. A plan
+// that was generated for a different model or a different kernel
+// implementation is then rejected instead of silently overlapping buffers.
+struct BufferUsage {
+  // Size of the buffer in bytes, including arena alignment.
+  int32_t size;
+
+  // First and last node index at which the buffer is in use.
+  int32_t first_time_used;
+  int32_t last_time_used;
+};
+
 // Returns size of a BufferPlan given a buffer count. This size is compile time
 // known if buffer_count is a compile time constant.
 constexpr size_t SizeOfBufferPlan(int32_t buffer_count) {
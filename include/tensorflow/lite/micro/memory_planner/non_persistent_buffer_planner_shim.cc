@@ -21,7 +21,14 @@ namespace tflite {
 
 NonPersistentMemoryPlannerShim::NonPersistentMemoryPlannerShim(
     const BufferPlan* buffer_plan)
-    : buffer_plan_(buffer_plan), buffer_request_count_(0) {}
+    : NonPersistentMemoryPlannerShim(buffer_plan, nullptr) {}
+
+NonPersistentMemoryPlannerShim::NonPersistentMemoryPlannerShim(
+    const BufferPlan* buffer_plan, const BufferUsage* buffer_usages)
+    : buffer_plan_(buffer_plan),
+      buffer_usages_(buffer_usages),
+      buffer_request_count_(0),
+      max_memory_size_(0) {}
 
 NonPersistentMemoryPlannerShim::~NonPersistentMemoryPlannerShim() {}
 
@@ -36,13 +43,39 @@ TfLiteStatus NonPersistentMemoryPlannerShim::AddBuffer(
         buffer_request_count_, buffer_plan_->buffer_count);
     return kTfLiteError;
   }
+
+  const int index = buffer_request_count_ - 1;
+  const int32_t offset = buffer_plan_->buffer_plan_entries[index].offset;
+  if (offset < 0) {
+    MicroPrintf("Buffer %d has invalid offset %d in given buffer plan.", index,
+                offset);
+    return kTfLiteError;
+  }
+
+  if (buffer_usages_ != nullptr) {
+    const BufferUsage& usage = buffer_usages_[index];
+    if (usage.size != size || usage.first_time_used != first_time_used ||
+        usage.last_time_used != last_time_used) {
+      MicroPrintf(
+          "Buffer %d (%d bytes, used %d-%d) does not match given buffer plan "
+          "(%d bytes, used %d-%d).",
+          index, size, first_time_used, last_time_used, usage.size,
+          usage.first_time_used, usage.last_time_used);
+      return kTfLiteError;
+    }
+  }
+
+  const size_t end = static_cast<size_t>(offset) + size;
+  if (end > max_memory_size_) {
+    max_memory_size_ = end;
+  }
   return kTfLiteOk;
 }
 
 size_t NonPersistentMemoryPlannerShim::GetMaximumMemorySize() {
-  // Simply return 0 to let the framework accept this memory plan
-  // because the client ensure validity of the memory plan.
-  return 0;
+  // The framework reserves this much of the arena head for the non-persistent
+  // buffers and checks that it fits into the arena.
+  return max_memory_size_;
 }
 
 // How many buffers are in the given memory plan.
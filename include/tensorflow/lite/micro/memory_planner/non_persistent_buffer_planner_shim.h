@@ -105,6 +105,12 @@ class NonPersistentMemoryPlannerShim : public MicroMemoryPlanner {
   // Does not take ownership of buffer_plan, which must refer to a valid
   // BufferPlan that outlives this object.
   explicit NonPersistentMemoryPlannerShim(const BufferPlan* buffer_plan);
+
+  // Same as above, but additionally checks every requested buffer against
+  // buffer_usages, which must have buffer_plan->buffer_count entries and
+  // outlive this object.
+  NonPersistentMemoryPlannerShim(const BufferPlan* buffer_plan,
+                                 const BufferUsage* buffer_usages);
   ~NonPersistentMemoryPlannerShim() override;
 
   TfLiteStatus GetOffsetForBuffer(ErrorReporter* error_reporter,
@@ -117,11 +123,15 @@ class NonPersistentMemoryPlannerShim : public MicroMemoryPlanner {
   int GetBufferCount() override;
 
  private:
-  const BufferPlan* buffer_plan_;  // not owned, can't be null
+  const BufferPlan* buffer_plan_;      // not owned, can't be null
+  const BufferUsage* buffer_usages_;  // not owned, can be null
 
   // The number of buffers requested so far. Used for error checking.
   int buffer_request_count_;
 
+  // End offset of the highest buffer requested so far.
+  size_t max_memory_size_;
+
   TF_LITE_REMOVE_VIRTUAL_DELETE
 };
 
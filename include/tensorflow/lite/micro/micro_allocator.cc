@@ -55,6 +55,9 @@ struct AllocationInfo {
   int first_created;
   int last_used;
   int32_t offline_offset;
+  // Index of the AllocationInfo whose buffer is reused by this one, or -1 if
+  // this one needs its own buffer.
+  int shared_with;
   bool needs_allocating;
 };
 
@@ -80,6 +83,23 @@ class MicroBuiltinDataAllocator : public BuiltinDataAllocator {
   SimpleMemoryAllocator* memory_allocator_;
 };
 
+// Whether a tensor is an input or an output of a subgraph.
+bool IsSubgraphInputOrOutput(const SubGraph* subgraph, int tensor_index) {
+  for (size_t i = 0;
+       subgraph->inputs() != nullptr && i < subgraph->inputs()->size(); ++i) {
+    if (subgraph->inputs()->Get(i) == tensor_index) {
+      return true;
+    }
+  }
+  for (size_t i = 0;
+       subgraph->outputs() != nullptr && i < subgraph->outputs()->size(); ++i) {
+    if (subgraph->outputs()->Get(i) == tensor_index) {
+      return true;
+    }
+  }
+  return false;
+}
+
 // A helper class to construct AllocationInfo array. This array contains the
 // lifetime of tensors / scratch_buffer and will be used to calculate the memory
 // plan. Methods need to be called in order from `Init`, `Add*`, to `Finish`.
@@ -102,7 +122,14 @@ class AllocationInfoBuilder {
   // Add allocaiton information for the tensors.
   TfLiteStatus AddTensors(const SubGraph* subgraph,
                           const int32_t* offline_offsets,
-                          TfLiteEvalTensor* eval_tensors);
+                          const SubgraphAllocations& subgraph_allocations);
+
+  // Let the output of nodes that support in-place execution reuse the buffer
+  // of an input whose lifetime ends at that node. Must be called after
+  // AddTensors().
+  TfLiteStatus AddInPlaceOutputs(
+      const SubGraph* subgraph,
+      const NodeAndRegistration* node_and_registrations);
 
   // Add allocation information for the scratch buffers.
   TfLiteStatus AddScratchBuffers(
@@ -119,22 +146,25 @@ class AllocationInfoBuilder {
   ErrorReporter* reporter_ = nullptr;
 };
 
-TfLiteStatus AllocationInfoBuilder::AddTensors(const SubGraph* subgraph,
-                                               const int32_t* offline_offsets,
-                                               TfLiteEvalTensor* eval_tensors) {
-  TFLITE_DCHECK(eval_tensors != nullptr);
+TfLiteStatus AllocationInfoBuilder::AddTensors(
+    const SubGraph* subgraph, const int32_t* offline_offsets,
+    const SubgraphAllocations& subgraph_allocations) {
+  TFLITE_DCHECK(subgraph_allocations.tensors != nullptr);
 
   // Set up allocation info for all tensors.
   for (size_t i = 0; i < tensor_count_; ++i) {
     AllocationInfo* current = &info_[i];
-    current->output_ptr = &(eval_tensors[i].data.data);
+    TfLiteEvalTensor* eval_tensor =
+        GetSubgraphEvalTensor(subgraph_allocations, i);
+    current->output_ptr = &(eval_tensor->data.data);
 
     TF_LITE_ENSURE_STATUS(
-        TfLiteEvalTensorByteLength(&eval_tensors[i], &current->bytes));
+        TfLiteEvalTensorByteLength(eval_tensor, &current->bytes));
 
     current->first_created = -1;
     current->last_used = -1;
-    current->needs_allocating = (eval_tensors[i].data.data == nullptr) &&
+    current->shared_with = -1;
+    current->needs_allocating = (eval_tensor->data.data == nullptr) &&
                                 (!subgraph->tensors()->Get(i)->is_variable());
     if (offline_offsets) {
       current->offline_offset = offline_offsets[i];
@@ -187,6 +217,63 @@ TfLiteStatus AllocationInfoBuilder::AddTensors(const SubGraph* subgraph,
   return kTfLiteOk;
 }
 
+TfLiteStatus AllocationInfoBuilder::AddInPlaceOutputs(
+    const SubGraph* subgraph,
+    const NodeAndRegistration* node_and_registrations) {
+  uint32_t operators_size = NumSubgraphOperators(subgraph);
+
+  for (uint32_t i = 0; i < operators_size; ++i) {
+    const uint64_t inplace_operator =
+        node_and_registrations[i].registration->inplace_operator;
+    const TfLiteNode* node = &node_and_registrations[i].node;
+    if ((inplace_operator == kTfLiteInplaceOpNone) ||
+        (node->outputs->size < 1)) {
+      continue;
+    }
+    AllocationInfo* output = &info_[node->outputs->data[0]];
+    if (!output->needs_allocating ||
+        (output->offline_offset != kOnlinePlannedBuffer)) {
+      continue;
+    }
+
+    // The flags of inputs 0 and 1 are consecutive bits.
+    for (int n = 0; n < node->inputs->size && n < 2; ++n) {
+      const uint64_t shared_flag =
+          static_cast<uint64_t>(kTfLiteInplaceOpInput0Shared) << n;
+      const int tensor_index = node->inputs->data[n];
+      if (((inplace_operator & shared_flag) == 0) || (tensor_index < 0)) {
+        continue;
+      }
+
+      // An input that already reuses another buffer passes that buffer on.
+      int owner_index = tensor_index;
+      if (info_[owner_index].shared_with != -1) {
+        owner_index = info_[owner_index].shared_with;
+      }
+      AllocationInfo* owner = &info_[owner_index];
+
+      // The input must be dead after this node, and graph inputs and outputs
+      // must not be overwritten behind the application's back.
+      if (!owner->needs_allocating ||
+          (owner->offline_offset != kOnlinePlannedBuffer) ||
+          (owner->last_used != static_cast<int>(i)) ||
+          (owner->bytes < output->bytes) ||
+          IsSubgraphInputOrOutput(subgraph, tensor_index) ||
+          IsSubgraphInputOrOutput(subgraph, owner_index)) {
+        continue;
+      }
+
+      output->needs_allocating = false;
+      output->shared_with = owner_index;
+      if (owner->last_used < output->last_used) {
+        owner->last_used = output->last_used;
+      }
+      break;
+    }
+  }
+  return kTfLiteOk;
+}
+
 // Get offline tensors allocation plan. See
 // micro/docs/memory_management.md for more info.
 TfLiteStatus AllocationInfoBuilder::GetOfflinePlannedOffsets(
@@ -235,6 +322,7 @@ TfLiteStatus AllocationInfoBuilder::AddScratchBuffers(
     current->first_created = current_request->node_idx;
     current->last_used = current_request->node_idx;
     current->offline_offset = kOnlinePlannedBuffer;
+    current->shared_with = -1;
     current->needs_allocating = true;
   }
   return kTfLiteOk;
@@ -280,6 +368,15 @@ TfLiteStatus CommitPlan(ErrorReporter* error_reporter,
       ++planner_index;
     }
   }
+
+  // Point in-place outputs to the buffer they share.
+  for (size_t i = 0; i < allocation_info_size; ++i) {
+    const AllocationInfo* current = &allocation_info[i];
+    if (current->shared_with != -1) {
+      *current->output_ptr =
+          *allocation_info[current->shared_with].output_ptr;
+    }
+  }
   return kTfLiteOk;
 }
 }  // namespace
@@ -531,7 +628,8 @@ MicroAllocator* MicroAllocator::Create(SimpleMemoryAllocator* memory_allocator,
   return allocator;
 }
 
-SubgraphAllocations* MicroAllocator::StartModelAllocation(const Model* model) {
+SubgraphAllocations* MicroAllocator::StartModelAllocation(
+    const Model* model, const ConstantTensorTable* constant_tensor_table) {
   TFLITE_DCHECK(model != nullptr);
 
   if (model_is_allocating_) {
@@ -545,6 +643,10 @@ SubgraphAllocations* MicroAllocator::StartModelAllocation(const Model* model) {
 
   uint8_t* data_allocator_buffer = memory_allocator_->AllocateFromTail(
       sizeof(MicroBuiltinDataAllocator), alignof(MicroBuiltinDataAllocator));
+  if (data_allocator_buffer == nullptr) {
+    MicroPrintf("Failed to allocate memory for the builtin data allocator.");
+    return nullptr;
+  }
   builtin_data_allocator_ =
       new (data_allocator_buffer) MicroBuiltinDataAllocator(memory_allocator_);
 
@@ -562,6 +664,42 @@ SubgraphAllocations* MicroAllocator::StartModelAllocation(const Model* model) {
     return nullptr;
   }
 
+  if ((constant_tensor_table != nullptr) &&
+      (constant_tensor_table->subgraph_count !=
+       static_cast<int32_t>(model->subgraphs()->size()))) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Constant tensor table has %d subgraphs, the model "
+                         "has %d.",
+                         constant_tensor_table->subgraph_count,
+                         model->subgraphs()->size());
+    return nullptr;
+  }
+  for (size_t subgraph_idx = 0; subgraph_idx < model->subgraphs()->size();
+       subgraph_idx++) {
+    const uint32_t tensor_count =
+        model->subgraphs()->Get(subgraph_idx)->tensors()->size();
+    output[subgraph_idx].tensors_size = tensor_count;
+    output[subgraph_idx].constant_tensors = nullptr;
+    if (constant_tensor_table == nullptr) {
+      continue;
+    }
+    const ConstantSubgraphTensors& constants =
+        constant_tensor_table->subgraphs[subgraph_idx];
+    if ((constants.first_index < 0) || (constants.count < 0) ||
+        (static_cast<uint32_t>(constants.first_index + constants.count) !=
+         tensor_count)) {
+      TF_LITE_REPORT_ERROR(error_reporter_,
+                           "Constant tensors %d to %d don't match the %d "
+                           "tensors of subgraph %d.",
+                           constants.first_index,
+                           constants.first_index + constants.count - 1,
+                           tensor_count, subgraph_idx);
+      return nullptr;
+    }
+    output[subgraph_idx].tensors_size = constants.first_index;
+    output[subgraph_idx].constant_tensors = constants.tensors;
+  }
+
   if (AllocateTfLiteEvalTensors(model, output) != kTfLiteOk ||
       AllocateNodeAndRegistrations(model, output) != kTfLiteOk) {
     return nullptr;
@@ -588,11 +726,12 @@ TfLiteStatus MicroAllocator::FinishModelAllocation(
     TF_LITE_ENSURE_STATUS(AllocateScratchBufferHandles(
         scratch_buffer_handles, scratch_buffer_request_count_));
     TF_LITE_ENSURE_STATUS(CommitStaticMemoryPlan(
-        model, subgraph_allocations[subgraph_idx].tensors,
-        *scratch_buffer_handles, subgraph_idx));
+        model, subgraph_allocations[subgraph_idx], *scratch_buffer_handles,
+        subgraph_idx));
     TF_LITE_ENSURE_STATUS(AllocateVariables(
         subgraph, subgraph_allocations[subgraph_idx].tensors));
   }
+  TF_LITE_ENSURE_STATUS(AllocateExecutionSteps(model, subgraph_allocations));
   model_is_allocating_ = false;
   return kTfLiteOk;
 }
@@ -700,6 +839,44 @@ TfLiteStatus MicroAllocator::AllocateNodeAndRegistrations(
       return kTfLiteError;
     }
     subgraph_allocations[subgraph_idx].node_and_registrations = output;
+    subgraph_allocations[subgraph_idx].execution_steps = nullptr;
+    subgraph_allocations[subgraph_idx].execution_steps_size = 0;
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroAllocator::AllocateExecutionSteps(
+    const Model* model, SubgraphAllocations* subgraph_allocations) {
+  TFLITE_DCHECK(subgraph_allocations != nullptr);
+
+  for (size_t subgraph_idx = 0; subgraph_idx < model->subgraphs()->size();
+       subgraph_idx++) {
+    const SubGraph* subgraph = model->subgraphs()->Get(subgraph_idx);
+    TFLITE_DCHECK(subgraph != nullptr);
+
+    uint32_t operators_size = NumSubgraphOperators(subgraph);
+
+    ExecutionStep* output = reinterpret_cast<ExecutionStep*>(
+        memory_allocator_->AllocateFromTail(
+            sizeof(ExecutionStep) * operators_size, alignof(ExecutionStep)));
+    if (output == nullptr) {
+      TF_LITE_REPORT_ERROR(error_reporter_,
+                           "Failed to allocate memory for execution_steps.");
+      return kTfLiteError;
+    }
+
+    NodeAndRegistration* node_and_registrations =
+        subgraph_allocations[subgraph_idx].node_and_registrations;
+    for (uint32_t i = 0; i < operators_size; ++i) {
+      const TfLiteRegistration* registration =
+          node_and_registrations[i].registration;
+      TFLITE_DCHECK(registration->invoke);
+      output[i].invoke = registration->invoke;
+      output[i].node = &node_and_registrations[i].node;
+      output[i].registration = registration;
+    }
+    subgraph_allocations[subgraph_idx].execution_steps = output;
+    subgraph_allocations[subgraph_idx].execution_steps_size = operators_size;
   }
   return kTfLiteOk;
 }
@@ -712,6 +889,13 @@ TfLiteTensor* MicroAllocator::AllocatePersistentTfLiteTensor(
   // This value is allocated from persistent arena space. It is guaranteed to be
   // around for the lifetime of the application.
   TfLiteTensor* tensor = AllocatePersistentTfLiteTensorInternal();
+  if (tensor == nullptr) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Failed to allocate memory for persistent "
+                         "TfLiteTensor of tensor %d.",
+                         tensor_index);
+    return nullptr;
+  }
 
   // Populate any fields from the flatbuffer, since this TfLiteTensor struct is
   // allocated in the persistent section of the arena, ensure that additional
@@ -730,12 +914,12 @@ TfLiteTensor* MicroAllocator::AllocatePersistentTfLiteTensor(
     // and not located in the flatbuffer are stored on the pre-allocated list of
     // TfLiteEvalTensors structs. These structs are the source of truth, simply
     // point the corresponding buffer to the new TfLiteTensor data value.
-    tensor->data.data =
-        subgraph_allocations[subgraph_index].tensors[tensor_index].data.data;
+    const TfLiteEvalTensor* eval_tensor = GetSubgraphEvalTensor(
+        subgraph_allocations[subgraph_index], tensor_index);
+    tensor->data.data = eval_tensor->data.data;
     // TfLiteEvalTensor structs must also be the source of truth for the
     // TfLiteTensor dims.
-    tensor->dims =
-        subgraph_allocations[subgraph_index].tensors[tensor_index].dims;
+    tensor->dims = eval_tensor->dims;
   }
   return tensor;
 }
@@ -792,12 +976,12 @@ TfLiteTensor* MicroAllocator::AllocateTempTfLiteTensor(
     // and not located in the flatbuffer are stored on the pre-allocated list of
     // TfLiteEvalTensors structs. These structs are the source of truth, simply
     // point the corresponding buffer to the new TfLiteTensor data value.
-    tensor->data.data =
-        subgraph_allocations[subgraph_index].tensors[tensor_index].data.data;
+    const TfLiteEvalTensor* eval_tensor = GetSubgraphEvalTensor(
+        subgraph_allocations[subgraph_index], tensor_index);
+    tensor->data.data = eval_tensor->data.data;
     // TfLiteEvalTensor structs must also be the source of truth for the
     // TfLiteTensor dims.
-    tensor->dims =
-        subgraph_allocations[subgraph_index].tensors[tensor_index].dims;
+    tensor->dims = eval_tensor->dims;
   }
   return tensor;
 }
@@ -819,7 +1003,9 @@ TfLiteStatus MicroAllocator::AllocateTfLiteEvalTensors(
     const SubGraph* subgraph = model->subgraphs()->Get(subgraph_idx);
     TFLITE_DCHECK(subgraph != nullptr);
 
-    size_t alloc_count = subgraph->tensors()->size();
+    // Constant tensors described by a ConstantTensorTable don't need an eval
+    // tensor in the arena.
+    size_t alloc_count = subgraph_allocations[subgraph_idx].tensors_size;
     TfLiteEvalTensor* tensors =
         reinterpret_cast<TfLiteEvalTensor*>(memory_allocator_->AllocateFromTail(
             sizeof(TfLiteEvalTensor) * alloc_count, alignof(TfLiteEvalTensor)));
@@ -842,6 +1028,36 @@ TfLiteStatus MicroAllocator::AllocateTfLiteEvalTensors(
         return kTfLiteError;
       }
     }
+
+    // A table generated for another version of the model would point the
+    // kernels at the wrong weights, so every constant must match the model.
+    const TfLiteEvalTensor* constant_tensors =
+        subgraph_allocations[subgraph_idx].constant_tensors;
+    for (size_t i = alloc_count; i < subgraph->tensors()->size(); ++i) {
+      const tflite::Tensor& flatbuffer_tensor = *subgraph->tensors()->Get(i);
+      const TfLiteEvalTensor& constant = constant_tensors[i - alloc_count];
+      TfLiteType type;
+      TF_LITE_ENSURE_STATUS(
+          ConvertTensorType(flatbuffer_tensor.type(), &type, error_reporter_));
+      // Scalars have no shape in the flatbuffer, the table gives them any
+      // zero length array.
+      const bool dims_match =
+          (constant.dims != nullptr) &&
+          (flatbuffer_tensor.shape() == nullptr
+               ? constant.dims->size == 0
+               : static_cast<const void*>(constant.dims) ==
+                     static_cast<const void*>(flatbuffer_tensor.shape()));
+      if ((constant.data.data == nullptr) || flatbuffer_tensor.is_variable() ||
+          (constant.data.data != internal::GetFlatbufferTensorBuffer(
+                                     flatbuffer_tensor, model->buffers())) ||
+          !dims_match || (constant.type != type)) {
+        TF_LITE_REPORT_ERROR(error_reporter_,
+                             "Constant tensor table doesn't match tensor %d "
+                             "of subgraph %d.",
+                             i, subgraph_idx);
+        return kTfLiteError;
+      }
+    }
     subgraph_allocations[subgraph_idx].tensors = tensors;
   }
   return kTfLiteOk;
@@ -891,7 +1107,7 @@ ErrorReporter* MicroAllocator::error_reporter() const {
 }
 
 TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(
-    const Model* model, TfLiteEvalTensor* eval_tensors,
+    const Model* model, const SubgraphAllocations& subgraph_allocations,
     ScratchBufferHandle* scratch_buffer_handles, int subgraph_idx) {
   size_t head_usage = 0;
   // Create static memory plan
@@ -930,7 +1146,10 @@ TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(
   TF_LITE_ENSURE_STATUS(
       builder.GetOfflinePlannedOffsets(model, &offline_planner_offsets));
   TF_LITE_ENSURE_STATUS(
-      builder.AddTensors(subgraph, offline_planner_offsets, eval_tensors));
+      builder.AddTensors(subgraph, offline_planner_offsets,
+                         subgraph_allocations));
+  TF_LITE_ENSURE_STATUS(builder.AddInPlaceOutputs(
+      subgraph, subgraph_allocations.node_and_registrations));
 
   internal::ScratchBufferRequest* scratch_buffer_requests =
       GetScratchBufferRequests();
@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/lite/core/api/error_reporter.h"
 #include "tensorflow/lite/core/api/flatbuffer_conversions.h"
 #include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/constant_tensor_table.h"
 #include "tensorflow/lite/micro/flatbuffer_utils.h"
 #include "tensorflow/lite/micro/memory_planner/micro_memory_planner.h"
 #include "tensorflow/lite/micro/simple_memory_allocator.h"
@@ -70,6 +71,15 @@ typedef struct {
   const TfLiteRegistration* registration;
 } NodeAndRegistration;
 
+// A node of a subgraph resolved for invocation. The steps of a subgraph are
+// stored contiguously in execution order, so invoking a subgraph is a plain
+// walk over this array without looking anything up in the model.
+typedef struct {
+  TfLiteStatus (*invoke)(TfLiteContext* context, TfLiteNode* node);
+  TfLiteNode* node;
+  const TfLiteRegistration* registration;
+} ExecutionStep;
+
 // Holds a pointer to a buffer for a scratch buffer requested by a kernel during
 // the model prepare stage. This struct is allocated in-place and allows for
 // quick pointer-indexed lookup for speed during model inference.
@@ -79,12 +89,34 @@ typedef struct {
 } ScratchBufferHandle;
 
 // Stores all per-subgraph allocations. This includes the node and registration
-// array, tensor list and scratch buffer handles for each subgraph.
+// array, tensor list, scratch buffer handles and execution plan for each
+// subgraph.
 typedef struct {
   NodeAndRegistration* node_and_registrations;
   TfLiteEvalTensor* tensors;
+  // Number of entries of tensors. The tensors from this index on are constants
+  // that are described by constant_tensors, which is nullptr if the model has
+  // no ConstantTensorTable. Use GetSubgraphEvalTensor() to look up a tensor.
+  uint32_t tensors_size;
+  const TfLiteEvalTensor* constant_tensors;
+  // Set by FinishModelAllocation(), nullptr before.
+  ExecutionStep* execution_steps;
+  uint32_t execution_steps_size;
 } SubgraphAllocations;
 
+// Returns the eval tensor with the given index of a subgraph.
+inline TfLiteEvalTensor* GetSubgraphEvalTensor(
+    const SubgraphAllocations& allocations, int tensor_index) {
+  if (static_cast<uint32_t>(tensor_index) < allocations.tensors_size) {
+    return &allocations.tensors[tensor_index];
+  }
+  // Constant eval tensors are read-only data in flash. The allocator never
+  // plans buffers for them and kernels only read their inputs, so they are
+  // never written through the returned pointer.
+  return const_cast<TfLiteEvalTensor*>(
+      &allocations.constant_tensors[tensor_index - allocations.tensors_size]);
+}
+
 // Allocator responsible for allocating memory for all intermediate tensors
 // necessary to invoke a model.
 //
@@ -146,13 +178,21 @@ class MicroAllocator {
   // pointer to an array of SubgraphAllocations (also stored in the tail of the
   // arena) where each index corresponds to a different subgraph in the model.
   // Return value is nullptr if the allocations failed.
-  SubgraphAllocations* StartModelAllocation(const Model* model);
+  //
+  // If a ConstantTensorTable generated for the model is given, no eval tensors
+  // are allocated for the constant tensors of the model. The table must be
+  // valid for the lifetime of the allocator.
+  SubgraphAllocations* StartModelAllocation(
+      const Model* model,
+      const ConstantTensorTable* constant_tensor_table = nullptr);
 
   // Finish allocating internal resources required for model inference.
   //
   // -Plan the memory for activation tensors and scratch buffers.
   // -Update eval tensors for each subgraph based on planned offsets.
   // -Allocate scratch buffer handles array and update based on planned offsets.
+  // -Allocate the execution plan of each subgraph from its nodes and
+  //  registrations.
   //
   // This method should be called after assigning model resources
   // in StartModelAllocation(). The subgraph_allocations pointer should be the
@@ -205,14 +245,15 @@ class MicroAllocator {
   // This method only requests a buffer with a given size to be used after a
   // model has finished allocation via FinishModelAllocation(). All requested
   // buffers will be accessible by the out-param in that method.
-  TfLiteStatus RequestScratchBufferInArena(size_t bytes, int subgraph_idx,
-                                           int* buffer_idx);
+  virtual TfLiteStatus RequestScratchBufferInArena(size_t bytes,
+                                                   int subgraph_idx,
+                                                   int* buffer_idx);
 
   // Finish allocating a specific NodeAndRegistration prepare block (kernel
   // entry for a model) with a given node ID. This call ensures that any scratch
   // buffer requests and temporary allocations are handled and ready for the
   // next node prepare block.
-  TfLiteStatus FinishPrepareNodeAllocations(int node_id);
+  virtual TfLiteStatus FinishPrepareNodeAllocations(int node_id);
 
   // Returns the arena usage in bytes, only available after
   // `FinishModelAllocation`. Otherwise, it will return 0.
@@ -234,9 +275,17 @@ class MicroAllocator {
 
   // Allocates the list of persistent TfLiteEvalTensors that are used for the
   // "eval" phase of model inference. These structs will be the source of truth
-  // for all tensor buffers.
+  // for all tensor buffers. Only the tensors_size first tensors of every
+  // subgraph are allocated, the constant tensors set by StartModelAllocation()
+  // are checked against the model.
   virtual TfLiteStatus AllocateTfLiteEvalTensors(
       const Model* model, SubgraphAllocations* subgraph_allocations);
+
+  // Allocates the execution plan of every subgraph. Must be called after all
+  // registrations are resolved and the nodes are prepared.
+  virtual TfLiteStatus AllocateExecutionSteps(
+      const Model* model, SubgraphAllocations* subgraph_allocations);
+
   // Allocates persistent tensor buffers for variable tensors in the subgraph.
   virtual TfLiteStatus AllocateVariables(const SubGraph* subgraph,
                                          TfLiteEvalTensor* eval_tensors);
@@ -259,14 +308,15 @@ class MicroAllocator {
 
  private:
   // Commits a memory plan for all non-persistent buffer allocations in the
-  // 'head' section of the memory arena. The eval_tensors pointer is the list of
-  // pre-allocated TfLiteEvalTensor structs that will point to the buffers that
-  // will be allocated into the head section in this function call. The
-  // scratch_buffer_handles pointer is the array of pre-allocated
-  // ScratchBufferHandle structs that will point to allocated buffers also in
-  // the head section.
+  // 'head' section of the memory arena. The eval tensors of subgraph_allocations
+  // are the pre-allocated TfLiteEvalTensor structs that will point to the
+  // buffers that will be allocated into the head section in this function
+  // call. Its node_and_registrations are used to find nodes that can write
+  // their output in place of an input. The scratch_buffer_handles pointer is
+  // the array of pre-allocated ScratchBufferHandle structs that will point to
+  // allocated buffers also in the head section.
   virtual TfLiteStatus CommitStaticMemoryPlan(
-      const Model* model, TfLiteEvalTensor* eval_tensors,
+      const Model* model, const SubgraphAllocations& subgraph_allocations,
       ScratchBufferHandle* scratch_buffer_handles, int subgraph_idx);
 
   // Allocates an array of ScratchBufferHandle structs in the tail section for a
@@ -85,8 +85,8 @@ void MicroContext::DeallocateTempTfLiteTensor(TfLiteTensor* tensor) {
 }
 
 TfLiteEvalTensor* MicroContext::GetEvalTensor(int tensor_idx) {
-  return &graph_.GetAllocations()[graph_.GetCurrentSubgraphIndex()]
-              .tensors[tensor_idx];
+  return GetSubgraphEvalTensor(
+      graph_.GetAllocations()[graph_.GetCurrentSubgraphIndex()], tensor_idx);
 }
 
 void MicroContext::SetScratchBufferHandles(
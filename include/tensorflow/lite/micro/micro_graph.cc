@@ -143,34 +143,67 @@ TfLiteStatus MicroGraph::FreeSubgraphs() {
 }
 
 TfLiteStatus MicroGraph::InvokeSubgraph(int subgraph_idx) {
-  int previous_subgraph_idx = current_subgraph_index_;
-  current_subgraph_index_ = subgraph_idx;
+  if (static_cast<size_t>(subgraph_idx) >= subgraphs_->size()) {
+    MicroPrintf("Accessing subgraph %d but only %d subgraphs found",
+                subgraph_idx, subgraphs_->size());
+    return kTfLiteError;
+  }
+  return InvokeSubgraphNodes(
+      subgraph_idx, 0,
+      subgraph_allocations_[subgraph_idx].execution_steps_size);
+}
 
+TfLiteStatus MicroGraph::InvokeSubgraphNodes(int subgraph_idx, int first_node,
+                                             int end_node) {
   if (static_cast<size_t>(subgraph_idx) >= subgraphs_->size()) {
     MicroPrintf("Accessing subgraph %d but only %d subgraphs found",
                 subgraph_idx, subgraphs_->size());
     return kTfLiteError;
   }
-  uint32_t operators_size = NumSubgraphOperators(model_, subgraph_idx);
-  for (size_t i = 0; i < operators_size; ++i) {
-    TfLiteNode* node =
-        &(subgraph_allocations_[subgraph_idx].node_and_registrations[i].node);
-    const TfLiteRegistration* registration = subgraph_allocations_[subgraph_idx]
-                                                 .node_and_registrations[i]
-                                                 .registration;
+  const SubgraphAllocations* allocations =
+      &subgraph_allocations_[subgraph_idx];
+  TFLITE_DCHECK(allocations->execution_steps != nullptr ||
+                allocations->execution_steps_size == 0);
+  if ((first_node < 0) || (first_node > end_node) ||
+      (static_cast<uint32_t>(end_node) > allocations->execution_steps_size)) {
+    MicroPrintf("Invalid node range [%d, %d) of subgraph %d with %d nodes",
+                first_node, end_node, subgraph_idx,
+                allocations->execution_steps_size);
+    return kTfLiteError;
+  }
+
+  int previous_subgraph_idx = current_subgraph_index_;
+  current_subgraph_index_ = subgraph_idx;
+
+  const ExecutionStep* steps_begin = allocations->execution_steps;
+  const ExecutionStep* steps_end = steps_begin + end_node;
+#if !defined(TF_LITE_STRIP_ERROR_STRINGS)
+  MicroProfilerInterface* profiler =
+      reinterpret_cast<MicroProfilerInterface*>(context_->profiler);
+#endif
+
+  for (const ExecutionStep* step = steps_begin + first_node; step != steps_end;
+       ++step) {
+    TfLiteStatus invoke_status;
 
 // This ifdef is needed (even though ScopedMicroProfiler itself is a no-op with
 // -DTF_LITE_STRIP_ERROR_STRINGS) because the function OpNameFromRegistration is
-// only defined for builds with the error strings.
+// only defined for builds with the error strings. Without a profiler the
+// ScopedMicroProfiler is skipped entirely to keep the loop tight.
 #if !defined(TF_LITE_STRIP_ERROR_STRINGS)
-    ScopedMicroProfiler scoped_profiler(
-        OpNameFromRegistration(registration),
-        reinterpret_cast<MicroProfiler*>(context_->profiler));
+    if (profiler != nullptr) {
+      profiler->SetCurrentNode(subgraph_idx,
+                               static_cast<int>(step - steps_begin));
+      ScopedMicroProfiler scoped_profiler(
+          OpNameFromRegistration(step->registration), profiler);
+      invoke_status = step->invoke(context_, step->node);
+    } else {
+      invoke_status = step->invoke(context_, step->node);
+    }
+#else
+    invoke_status = step->invoke(context_, step->node);
 #endif
 
-    TFLITE_DCHECK(registration->invoke);
-    TfLiteStatus invoke_status = registration->invoke(context_, node);
-
     // All TfLiteTensor structs used in the kernel are allocated from temp
     // memory in the allocator. This creates a chain of allocations in the
     // temp section. The call below resets the chain of allocations to
@@ -179,7 +212,8 @@ TfLiteStatus MicroGraph::InvokeSubgraph(int subgraph_idx) {
 
     if (invoke_status == kTfLiteError) {
       MicroPrintf("Node %s (number %d) failed to invoke with status %d",
-                  OpNameFromRegistration(registration), i, invoke_status);
+                  OpNameFromRegistration(step->registration),
+                  static_cast<int>(step - steps_begin), invoke_status);
       return kTfLiteError;
     } else if (invoke_status != kTfLiteOk) {
       return invoke_status;
@@ -228,7 +262,8 @@ TfLiteEvalTensor* MicroGraph::GetSubgraphInput(int subgraph_idx,
                                                int input_idx) {
   int tensor_idx =
       model_->subgraphs()->Get(subgraph_idx)->inputs()->Get(input_idx);
-  return &subgraph_allocations_[subgraph_idx].tensors[tensor_idx];
+  return GetSubgraphEvalTensor(subgraph_allocations_[subgraph_idx],
+                               tensor_idx);
 }
 
 size_t MicroGraph::NumSubgraphOutputs(int subgraph_idx) {
@@ -239,7 +274,30 @@ TfLiteEvalTensor* MicroGraph::GetSubgraphOutput(int subgraph_idx,
                                                 int output_idx) {
   int tensor_idx =
       model_->subgraphs()->Get(subgraph_idx)->outputs()->Get(output_idx);
-  return &subgraph_allocations_[subgraph_idx].tensors[tensor_idx];
+  return GetSubgraphEvalTensor(subgraph_allocations_[subgraph_idx],
+                               tensor_idx);
+}
+
+int MicroGraph::GetSubgraphOutputNode(int subgraph_idx, int output_idx) {
+  const SubGraph* subgraph = model_->subgraphs()->Get(subgraph_idx);
+  const int tensor_idx = subgraph->outputs()->Get(output_idx);
+  // Nodes run in the order of the operators, so the output is final after
+  // the last node that writes it.
+  for (int node_idx =
+           static_cast<int>(NumSubgraphOperators(subgraph)) - 1;
+       node_idx >= 0; --node_idx) {
+    const flatbuffers::Vector<int32_t>* node_outputs =
+        subgraph->operators()->Get(node_idx)->outputs();
+    if (node_outputs == nullptr) {
+      continue;
+    }
+    for (int32_t node_output : *node_outputs) {
+      if (node_output == tensor_idx) {
+        return node_idx;
+      }
+    }
+  }
+  return -1;
 }
 
 }  // namespace tflite
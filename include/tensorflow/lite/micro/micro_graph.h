@@ -54,6 +54,13 @@ class MicroGraph {
   // the model.
   virtual TfLiteStatus InvokeSubgraph(int subgraph_idx);
 
+  // Calls TfLiteRegistration->Invoke for the operators with index first_node
+  // up to, but not including, end_node of a subgraph. Invoking consecutive
+  // ranges starting at 0 is the same as InvokeSubgraph(), the tensors are kept
+  // between the calls. Only valid after the model was allocated.
+  virtual TfLiteStatus InvokeSubgraphNodes(int subgraph_idx, int first_node,
+                                           int end_node);
+
   // Zeros out all variable tensors in all subgraphs in the model.
   virtual TfLiteStatus ResetVariableTensors();
 
@@ -69,6 +76,12 @@ class MicroGraph {
   // Get the specified output tensor of a specified subgraph in the model.
   virtual TfLiteEvalTensor* GetSubgraphOutput(int subgraph_idx, int output_idx);
 
+  // Index of the last operator of a subgraph that writes the specified output,
+  // i.e. the output is final once the operators up to this one were invoked.
+  // An early exit of a model is an output whose node lies well before the end
+  // of the subgraph. Returns -1 if no operator writes the output.
+  virtual int GetSubgraphOutputNode(int subgraph_idx, int output_idx);
+
   // Number of subgraphs in the model.
   virtual int NumSubgraphs();
 
@@ -28,7 +28,8 @@ limitations under the License.
 #include "tensorflow/lite/micro/micro_allocator.h"
 #include "tensorflow/lite/micro/micro_error_reporter.h"
 #include "tensorflow/lite/micro/micro_op_resolver.h"
-#include "tensorflow/lite/micro/micro_profiler.h"
+#include "tensorflow/lite/micro/micro_profiler_interface.h"
+#include "tensorflow/lite/micro/micro_time.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 #include "tensorflow/lite/schema/schema_utils.h"
 
@@ -40,7 +41,7 @@ MicroInterpreter::MicroInterpreter(const Model* model,
                                    size_t tensor_arena_size,
                                    ErrorReporter* error_reporter,
                                    MicroResourceVariables* resource_variables,
-                                   MicroProfiler* profiler)
+                                   MicroProfilerInterface* profiler)
     : model_(model),
       op_resolver_(op_resolver),
       error_reporter_(error_reporter),
@@ -61,7 +62,7 @@ MicroInterpreter::MicroInterpreter(const Model* model,
                                    MicroAllocator* allocator,
                                    ErrorReporter* error_reporter,
                                    MicroResourceVariables* resource_variables,
-                                   MicroProfiler* profiler)
+                                   MicroProfilerInterface* profiler)
     : model_(model),
       op_resolver_(op_resolver),
       error_reporter_(error_reporter),
@@ -81,7 +82,7 @@ MicroInterpreter::~MicroInterpreter() {
   }
 }
 
-void MicroInterpreter::Init(MicroProfiler* profiler) {
+void MicroInterpreter::Init(MicroProfilerInterface* profiler) {
   context_.impl_ = static_cast<void*>(&micro_context_);
   context_.ReportError = MicroContextReportOpError;
   context_.GetTensor = MicroContextGetTensor;
@@ -185,8 +186,21 @@ TfLiteStatus MicroInterpreter::PrepareNodeAndRegistrationDataFromFlatbuffer() {
   return kTfLiteOk;
 }
 
+TfLiteStatus MicroInterpreter::SetConstantTensorTable(
+    const ConstantTensorTable* table) {
+  if (tensors_allocated_) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "The constant tensor table must be set before "
+                         "AllocateTensors().");
+    return kTfLiteError;
+  }
+  constant_tensor_table_ = table;
+  return kTfLiteOk;
+}
+
 TfLiteStatus MicroInterpreter::AllocateTensors() {
-  SubgraphAllocations* allocations = allocator_.StartModelAllocation(model_);
+  SubgraphAllocations* allocations =
+      allocator_.StartModelAllocation(model_, constant_tensor_table_);
 
   if (allocations == nullptr) {
     TF_LITE_REPORT_ERROR(error_reporter_,
@@ -293,9 +307,85 @@ TfLiteStatus MicroInterpreter::Invoke() {
   if (!tensors_allocated_) {
     TF_LITE_ENSURE_OK(&context_, AllocateTensors());
   }
+  next_step_node_ = 0;
   return graph_.InvokeSubgraph(0);
 }
 
+TfLiteStatus MicroInterpreter::InvokeNodes(size_t first_node,
+                                           size_t end_node) {
+  if (initialization_status_ != kTfLiteOk) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "InvokeNodes() called after initialization failed\n");
+    return kTfLiteError;
+  }
+
+  if (!tensors_allocated_) {
+    TF_LITE_ENSURE_OK(&context_, AllocateTensors());
+  }
+  next_step_node_ = 0;
+  return graph_.InvokeSubgraphNodes(0, static_cast<int>(first_node),
+                                    static_cast<int>(end_node));
+}
+
+TfLiteStatus MicroInterpreter::InvokeStep(uint32_t budget_ticks) {
+  if (initialization_status_ != kTfLiteOk) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "InvokeStep() called after initialization failed\n");
+    return kTfLiteError;
+  }
+
+  if (!tensors_allocated_) {
+    TF_LITE_ENSURE_OK(&context_, AllocateTensors());
+  }
+
+  const size_t node_count = operators_size();
+  // The ticks wrap around, the unsigned difference is still correct.
+  const uint32_t start_ticks = static_cast<uint32_t>(GetCurrentTimeTicks());
+  size_t node = next_step_node_;
+  while (node < node_count) {
+    TfLiteStatus status = graph_.InvokeSubgraphNodes(
+        0, static_cast<int>(node), static_cast<int>(node + 1));
+    if (status != kTfLiteOk) {
+      next_step_node_ = 0;
+      return status;
+    }
+    ++node;
+    if (static_cast<uint32_t>(GetCurrentTimeTicks()) - start_ticks >=
+        budget_ticks) {
+      break;
+    }
+  }
+
+  next_step_node_ = (node < node_count) ? node : 0;
+  return kTfLiteOk;
+}
+
+size_t MicroInterpreter::operators_size() const {
+  return NumSubgraphOperators(model_, 0);
+}
+
+int MicroInterpreter::output_node(size_t index) {
+  if (index >= outputs_size()) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Output index %d out of range (length is %d)", index,
+                         outputs_size());
+    return -1;
+  }
+  return graph_.GetSubgraphOutputNode(0, static_cast<int>(index));
+}
+
+TfLiteEvalTensor* MicroInterpreter::GetTensor(int tensor_index) {
+  const SubGraph* subgraph = model_->subgraphs()->Get(0);
+  if (!tensors_allocated_ || (tensor_index < 0) ||
+      (static_cast<size_t>(tensor_index) >= subgraph->tensors()->size())) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Tensor index %d invalid or tensors not allocated",
+                         tensor_index);
+    return nullptr;
+  }
+  return GetSubgraphEvalTensor(graph_.GetAllocations()[0], tensor_index);
+}
+
 TfLiteTensor* MicroInterpreter::input(size_t index) {
   const size_t length = inputs_size();
   if (index >= length) {
@@ -23,11 +23,12 @@ limitations under the License.
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/core/api/error_reporter.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/micro/constant_tensor_table.h"
 #include "tensorflow/lite/micro/micro_allocator.h"
 #include "tensorflow/lite/micro/micro_context.h"
 #include "tensorflow/lite/micro/micro_graph.h"
 #include "tensorflow/lite/micro/micro_op_resolver.h"
-#include "tensorflow/lite/micro/micro_profiler.h"
+#include "tensorflow/lite/micro/micro_profiler_interface.h"
 #include "tensorflow/lite/portable_type_to_tflitetype.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 
@@ -51,7 +52,7 @@ class MicroInterpreter {
                    uint8_t* tensor_arena, size_t tensor_arena_size,
                    ErrorReporter* error_reporter,
                    MicroResourceVariables* resource_variables = nullptr,
-                   MicroProfiler* profiler = nullptr);
+                   MicroProfilerInterface* profiler = nullptr);
 
   // Create an interpreter instance using an existing MicroAllocator instance.
   // This constructor should be used when creating an allocator that needs to
@@ -61,10 +62,17 @@ class MicroInterpreter {
   MicroInterpreter(const Model* model, const MicroOpResolver& op_resolver,
                    MicroAllocator* allocator, ErrorReporter* error_reporter,
                    MicroResourceVariables* resource_variables = nullptr,
-                   MicroProfiler* profiler = nullptr);
+                   MicroProfilerInterface* profiler = nullptr);
 
   ~MicroInterpreter();
 
+  // Uses the eval tensors of a ConstantTensorTable generated for the model by
+  // tools/model_packer.py instead of allocating them in the arena. Must be
+  // called before AllocateTensors(), which fails if the table doesn't match
+  // the model. The lifetime of the table must be at least as long as that of
+  // the interpreter.
+  TfLiteStatus SetConstantTensorTable(const ConstantTensorTable* table);
+
   // Runs through the model and allocates all necessary input, output and
   // intermediate tensors.
   TfLiteStatus AllocateTensors();
@@ -74,6 +82,65 @@ class MicroInterpreter {
   // TODO(b/149795762): Add this to the TfLiteStatus enum.
   TfLiteStatus Invoke();
 
+  // Partial invocation of the main subgraph, e.g. for cascaded models where a
+  // cheap first stage decides whether the rest of the model runs at all.
+  //
+  // Invokes the nodes with index first_node up to, but not including,
+  // end_node. Ranges must be invoked in order starting at node 0, the tensors
+  // written by earlier ranges are kept. Invoking the ranges [0, n) and
+  // [n, operators_size()) is the same as Invoke(). A new inference can start
+  // at node 0 at any time, so an inference ends early by simply not invoking
+  // the remaining nodes:
+  //
+  //   int exit_node = interpreter.output_node(kEarlyExitOutput);
+  //   interpreter.InvokeNodes(0, exit_node + 1);
+  //   if (Confidence(interpreter.output(kEarlyExitOutput)) < kMinConfidence) {
+  //     interpreter.InvokeNodes(exit_node + 1, interpreter.operators_size());
+  //   }
+  TfLiteStatus InvokeNodes(size_t first_node, size_t end_node);
+
+  // Time-sliced invocation of the main subgraph, so that a long inference
+  // doesn't block a cooperative main loop, e.g. the BLE stack.
+  //
+  // Invokes the nodes following the node last invoked by the previous call
+  // until budget_ticks have elapsed, at least one node per call. A node is
+  // never interrupted, so a call overruns the budget by up to the ticks of the
+  // slowest node. On Cortex-M the ticks are CPU cycles counted by the DWT.
+  // invoke_in_progress() is false once the last node of the inference was
+  // invoked, the next call then starts a new inference at node 0:
+  //
+  //   if (!interpreter.invoke_in_progress()) {
+  //     FillInput(interpreter.input(0));
+  //   }
+  //   interpreter.InvokeStep(kBudgetCycles);
+  //   if (!interpreter.invoke_in_progress()) {
+  //     HandleOutput(interpreter.output(0));
+  //   }
+  //
+  // The outputs are bit-identical to those of Invoke(). Invoke() and
+  // InvokeNodes() abort an inference in progress, as does an error.
+  TfLiteStatus InvokeStep(uint32_t budget_ticks);
+
+  // True while an inference started by InvokeStep() has nodes left.
+  bool invoke_in_progress() const { return next_step_node_ != 0; }
+
+  // Number of nodes of the main subgraph.
+  size_t operators_size() const;
+
+  // Index of the node after which the output with the given index is final,
+  // see MicroGraph::GetSubgraphOutputNode(). Outputs of early exit heads have
+  // a node well before the end of the model. Returns -1 for an invalid index
+  // or if no node writes the output.
+  int output_node(size_t index);
+
+  // Eval tensor of the main subgraph with the given index, e.g. to inspect an
+  // intermediate result between partial invocations. An intermediate tensor
+  // holds valid data only from the node that writes it until the memory
+  // planner reuses its buffer after its last consumer ran. The quantization
+  // parameters are those of the tensor in the model. Returns nullptr for an
+  // invalid index or before AllocateTensors().
+  TfLiteEvalTensor* GetTensor(int tensor_index);
+
   // This is the recommended API for an application to pass an external payload
   // pointer as an external context to kernels. The life time of the payload
   // pointer should be at least as long as this interpreter. TFLM supports only
@@ -142,7 +209,7 @@ class MicroInterpreter {
  private:
   // TODO(b/158263161): Consider switching to Create() function to enable better
   // error reporting during initialization.
-  void Init(MicroProfiler* profiler);
+  void Init(MicroProfilerInterface* profiler);
 
   // Gets the current subgraph index used from within context methods.
   int get_subgraph_index() { return graph_.GetCurrentSubgraphIndex(); }
@@ -154,6 +221,9 @@ class MicroInterpreter {
   MicroAllocator& allocator_;
   MicroGraph graph_;
   bool tensors_allocated_;
+  // Node invoked next by InvokeStep(), 0 if no inference is in progress.
+  size_t next_step_node_ = 0;
+  const ConstantTensorTable* constant_tensor_table_ = nullptr;
 
   TfLiteStatus initialization_status_;
 
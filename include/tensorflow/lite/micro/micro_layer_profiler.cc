@@ -0,0 +1,333 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/micro_layer_profiler.h"
+
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/flatbuffer_conversions.h"
+#include "tensorflow/lite/kernels/internal/compatibility.h"
+#include "tensorflow/lite/micro/memory_helpers.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_time.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/schema/schema_utils.h"
+
+namespace tflite {
+
+namespace {
+
+// Variant of the kernels that don't report one. Only the kernels in
+// kernels/cmsis_nn have optimized implementations in this tree.
+constexpr char kDefaultVariant[] = "reference";
+
+const Tensor* GetTensor(const SubGraph* subgraph, int32_t tensor_index) {
+  if ((tensor_index < 0) || (subgraph->tensors() == nullptr) ||
+      (static_cast<uint32_t>(tensor_index) >= subgraph->tensors()->size())) {
+    return nullptr;
+  }
+  return subgraph->tensors()->Get(tensor_index);
+}
+
+int32_t GetDim(const Tensor* tensor, int dim) {
+  if ((tensor == nullptr) || (tensor->shape() == nullptr)) {
+    return 0;
+  }
+  const int dims_count = tensor->shape()->size();
+  if (dim < 0) {
+    dim += dims_count;
+  }
+  if ((dim < 0) || (dim >= dims_count)) {
+    return 0;
+  }
+  return tensor->shape()->Get(dim);
+}
+
+uint32_t ElementCount(const Tensor* tensor) {
+  if (tensor == nullptr) {
+    return 0;
+  }
+  uint32_t count = 1;
+  if (tensor->shape() != nullptr) {
+    for (int32_t dim : *tensor->shape()) {
+      count *= dim;
+    }
+  }
+  return count;
+}
+
+uint32_t ByteCount(const Tensor* tensor) {
+  if (tensor == nullptr) {
+    return 0;
+  }
+  TfLiteType type;
+  size_t type_size;
+  if ((ConvertTensorType(tensor->type(), &type, GetMicroErrorReporter()) !=
+       kTfLiteOk) ||
+      (TfLiteTypeSizeOf(type, &type_size) != kTfLiteOk)) {
+    return 0;
+  }
+  return ElementCount(tensor) * type_size;
+}
+
+const Tensor* GetOperatorTensor(const SubGraph* subgraph,
+                                const flatbuffers::Vector<int32_t>* indices,
+                                int index) {
+  if ((indices == nullptr) || (index >= static_cast<int>(indices->size()))) {
+    return nullptr;
+  }
+  return GetTensor(subgraph, indices->Get(index));
+}
+
+// Multiply-accumulates of the operators that do most of the work of a model,
+// computed like the kernels loop over the tensors. Other operators count as 0.
+uint32_t CountMacs(BuiltinOperator op_code, const Operator* op,
+                   const SubGraph* subgraph) {
+  const Tensor* input = GetOperatorTensor(subgraph, op->inputs(), 0);
+  const Tensor* filter = GetOperatorTensor(subgraph, op->inputs(), 1);
+  const Tensor* output = GetOperatorTensor(subgraph, op->outputs(), 0);
+  switch (op_code) {
+    case BuiltinOperator_CONV_2D:
+      // Filter is [output channels, height, width, input channels].
+      return ElementCount(output) * GetDim(filter, 1) * GetDim(filter, 2) *
+             GetDim(filter, 3);
+    case BuiltinOperator_DEPTHWISE_CONV_2D:
+      // Filter is [1, height, width, output channels].
+      return ElementCount(output) * GetDim(filter, 1) * GetDim(filter, 2);
+    case BuiltinOperator_TRANSPOSE_CONV: {
+      // Inputs are the output shape, the filter and the input.
+      const Tensor* transpose_input =
+          GetOperatorTensor(subgraph, op->inputs(), 2);
+      return ElementCount(transpose_input) * GetDim(filter, 0) *
+             GetDim(filter, 1) * GetDim(filter, 2);
+    }
+    case BuiltinOperator_FULLY_CONNECTED:
+      // Weights are [units, accumulation depth].
+      return ElementCount(output) * GetDim(filter, -1);
+    case BuiltinOperator_SVDF: {
+      // Feature weights are [filters, input size], time weights are
+      // [filters, memory size].
+      const Tensor* weights_time =
+          GetOperatorTensor(subgraph, op->inputs(), 2);
+      return GetDim(input, 0) * GetDim(filter, 0) *
+             (GetDim(filter, 1) + GetDim(weights_time, 1));
+    }
+    case BuiltinOperator_AVERAGE_POOL_2D:
+    case BuiltinOperator_MAX_POOL_2D: {
+      const Pool2DOptions* options = op->builtin_options_as_Pool2DOptions();
+      if (options == nullptr) {
+        return 0;
+      }
+      return ElementCount(output) * options->filter_width() *
+             options->filter_height();
+    }
+    case BuiltinOperator_ADD:
+    case BuiltinOperator_SUB:
+    case BuiltinOperator_MUL:
+      return ElementCount(output);
+    default:
+      return 0;
+  }
+}
+
+// Bytes of all input and output tensors of an operator, i.e. the data the
+// kernel reads and writes at least once.
+uint32_t CountBytes(const Operator* op, const SubGraph* subgraph) {
+  uint32_t bytes = 0;
+  if (op->inputs() != nullptr) {
+    for (int32_t tensor_index : *op->inputs()) {
+      bytes += ByteCount(GetTensor(subgraph, tensor_index));
+    }
+  }
+  if (op->outputs() != nullptr) {
+    for (int32_t tensor_index : *op->outputs()) {
+      bytes += ByteCount(GetTensor(subgraph, tensor_index));
+    }
+  }
+  return bytes;
+}
+
+}  // namespace
+
+TfLiteStatus MicroLayerProfiler::Init(const Model* model) {
+  TFLITE_DCHECK(model != nullptr);
+
+  node_count_ = 0;
+  for (int i = 0; i < kMaxLayers; ++i) {
+    layers_[i] = {};
+  }
+  ClearEvents();
+
+  if ((model->subgraphs() == nullptr) || (model->subgraphs()->size() == 0)) {
+    MicroPrintf("Model has no subgraph to profile.");
+    return kTfLiteError;
+  }
+  const SubGraph* subgraph = model->subgraphs()->Get(0);
+  if (subgraph->operators() == nullptr) {
+    return kTfLiteOk;
+  }
+
+  node_count_ = subgraph->operators()->size();
+  if (node_count_ > kMaxLayers) {
+    MicroPrintf("Only the first %d of %d nodes are profiled.", kMaxLayers,
+                node_count_);
+  }
+  for (int i = 0; (i < node_count_) && (i < kMaxLayers); ++i) {
+    const Operator* op = subgraph->operators()->Get(i);
+    if ((model->operator_codes() == nullptr) ||
+        (op->opcode_index() >= model->operator_codes()->size())) {
+      MicroPrintf("Invalid operator code of node %d.", i);
+      return kTfLiteError;
+    }
+    const BuiltinOperator op_code =
+        GetBuiltinCode(model->operator_codes()->Get(op->opcode_index()));
+    layers_[i].macs = CountMacs(op_code, op, subgraph);
+    layers_[i].bytes = CountBytes(op, subgraph);
+  }
+  return kTfLiteOk;
+}
+
+uint32_t MicroLayerProfiler::BeginEvent(const char* tag) {
+  ++depth_;
+  // Only the event opened right after SetCurrentNode() for a node of the main
+  // subgraph is recorded.
+  const int node = current_node_;
+  current_node_ = -1;
+  if ((node < 0) || (node >= kMaxLayers) || (active_node_ >= 0)) {
+    return kIgnoredEvent;
+  }
+  active_node_ = node;
+  active_depth_ = depth_;
+  layers_[node].tag = tag;
+  start_ticks_ = GetCurrentTimeTicks();
+  return node;
+}
+
+void MicroLayerProfiler::EndEvent(uint32_t event_handle) {
+  const int32_t end_ticks = GetCurrentTimeTicks();
+  TFLITE_DCHECK(depth_ > 0);
+  --depth_;
+  if (event_handle == kIgnoredEvent) {
+    return;
+  }
+  TFLITE_DCHECK(event_handle < static_cast<uint32_t>(kMaxLayers));
+
+  LayerStats& layer = layers_[event_handle];
+  const uint32_t ticks = static_cast<uint32_t>(end_ticks - start_ticks_);
+  ++layer.count;
+  layer.total_ticks += ticks;
+  if (ticks > layer.max_ticks) {
+    layer.max_ticks = ticks;
+  }
+  active_node_ = -1;
+}
+
+void MicroLayerProfiler::SetCurrentNode(int subgraph_idx, int node_idx) {
+  current_node_ = (subgraph_idx == 0) ? node_idx : -1;
+}
+
+void MicroLayerProfiler::SetKernelVariant(const char* variant) {
+  // Variants reported by nodes of nested subgraphs are ignored.
+  if ((active_node_ >= 0) && (depth_ == active_depth_)) {
+    layers_[active_node_].variant = variant;
+  }
+}
+
+void MicroLayerProfiler::ClearEvents() {
+  for (int i = 0; i < kMaxLayers; ++i) {
+    layers_[i].count = 0;
+    layers_[i].total_ticks = 0;
+    layers_[i].max_ticks = 0;
+  }
+  current_node_ = -1;
+  active_node_ = -1;
+  active_depth_ = 0;
+  depth_ = 0;
+}
+
+uint32_t MicroLayerProfiler::GetTotalTicks() const {
+  uint32_t ticks = 0;
+  for (int i = 0; (i < node_count_) && (i < kMaxLayers); ++i) {
+    if (layers_[i].count > 0) {
+      ticks += layers_[i].total_ticks / layers_[i].count;
+    }
+  }
+  return ticks;
+}
+
+void MicroLayerProfiler::Log() const {
+#if !defined(TF_LITE_STRIP_ERROR_STRINGS)
+  for (int i = 0; (i < node_count_) && (i < kMaxLayers); ++i) {
+    const LayerStats& layer = layers_[i];
+    if (layer.count == 0) {
+      continue;
+    }
+    const uint32_t average_ticks = layer.total_ticks / layer.count;
+    MicroPrintf(
+        "%d %s (%s) took %u ticks on average (%u max, %u runs), %u MACs, "
+        "%u bytes.",
+        i, layer.tag, layer.variant != nullptr ? layer.variant : kDefaultVariant,
+        average_ticks, layer.max_ticks, layer.count, layer.macs, layer.bytes);
+  }
+  MicroPrintf("Total %u ticks per invocation.", GetTotalTicks());
+#endif
+}
+
+void MicroLayerProfiler::LogCsv(
+    const RecordingMicroAllocator* allocator) const {
+#if !defined(TF_LITE_STRIP_ERROR_STRINGS)
+  if (allocator != nullptr) {
+    MicroPrintf(
+        "\"Node\",\"Op\",\"Variant\",\"Runs\",\"AvgTicks\",\"MaxTicks\","
+        "\"MACs\",\"Bytes\",\"MACsPerKTick\",\"ArenaAfterPrepare\","
+        "\"ScratchBytes\"");
+  } else {
+    MicroPrintf(
+        "\"Node\",\"Op\",\"Variant\",\"Runs\",\"AvgTicks\",\"MaxTicks\","
+        "\"MACs\",\"Bytes\",\"MACsPerKTick\"");
+  }
+  for (int i = 0; (i < node_count_) && (i < kMaxLayers); ++i) {
+    const LayerStats& layer = layers_[i];
+    if (layer.count == 0) {
+      continue;
+    }
+    const uint32_t average_ticks = layer.total_ticks / layer.count;
+    const uint32_t macs_per_kilo_tick =
+        average_ticks > 0
+            ? static_cast<uint32_t>(static_cast<uint64_t>(layer.macs) * 1000 /
+                                    average_ticks)
+            : 0;
+    const char* variant =
+        layer.variant != nullptr ? layer.variant : kDefaultVariant;
+    // The main subgraph is prepared first, so its nodes are the first
+    // recordings of the allocator.
+    if ((allocator != nullptr) && (i < allocator->GetRecordedNodeCount())) {
+      const RecordedNodeAllocation node = allocator->GetRecordedNodeAllocation(i);
+      MicroPrintf("%d,%s,%s,%u,%u,%u,%u,%u,%u,%u,%u", i, layer.tag, variant,
+                  layer.count, average_ticks, layer.max_ticks, layer.macs,
+                  layer.bytes, macs_per_kilo_tick,
+                  static_cast<uint32_t>(node.used_bytes),
+                  static_cast<uint32_t>(node.scratch_bytes));
+    } else {
+      MicroPrintf("%d,%s,%s,%u,%u,%u,%u,%u,%u", i, layer.tag, variant,
+                  layer.count, average_ticks, layer.max_ticks, layer.macs,
+                  layer.bytes, macs_per_kilo_tick);
+    }
+  }
+#endif
+}
+
+}  // namespace tflite
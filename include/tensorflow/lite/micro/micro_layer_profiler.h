@@ -0,0 +1,110 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_LAYER_PROFILER_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_LAYER_PROFILER_H_
+
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/micro_profiler_interface.h"
+#include "tensorflow/lite/micro/recording_micro_allocator.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+
+// Profiler that accumulates the ticks of every node of the main subgraph over
+// any number of invocations and relates them to the work of the node.
+//
+// Unlike the MicroProfiler, which keeps every event, memory use doesn't grow
+// with the number of invocations. Per node it keeps the number of runs, the
+// total and maximum ticks, the kernel variant reported by the kernel (see
+// tflite::micro::SetKernelVariant()) and the multiply-accumulates and bytes
+// moved, computed from the tensor shapes of the model by Init(). Together with
+// the arena usage recorded by a RecordingMicroAllocator during Prepare this
+// shows which kernels are worth optimizing.
+//
+// On Cortex-M the ticks are CPU cycles counted by the DWT.
+class MicroLayerProfiler : public MicroProfilerInterface {
+ public:
+  // Maximum number of nodes of the main subgraph that are profiled. Later
+  // nodes are run but not recorded.
+  static constexpr int kMaxLayers = 64;
+
+  MicroLayerProfiler() = default;
+  ~MicroLayerProfiler() override = default;
+
+  // Computes the work of every node of the main subgraph of the model and
+  // clears all recorded ticks. Must be called before the first Invoke().
+  TfLiteStatus Init(const Model* model);
+
+  uint32_t BeginEvent(const char* tag) override;
+  void EndEvent(uint32_t event_handle) override;
+  void SetCurrentNode(int subgraph_idx, int node_idx) override;
+  void SetKernelVariant(const char* variant) override;
+
+  // Clears the recorded ticks of all nodes, the work computed by Init() is
+  // kept.
+  void ClearEvents();
+
+  // Sum of the average ticks of all recorded nodes, i.e. the ticks of one
+  // complete invocation. Nodes skipped by partial invocations show fewer runs
+  // but don't lower their average.
+  uint32_t GetTotalTicks() const;
+
+  // Prints the statistics of every node in human readable form.
+  void Log() const;
+
+  // Prints the statistics of every node in CSV (Comma Separated Value) form.
+  // If the allocator that allocated the model is given, the arena usage after
+  // the Prepare of each node and the scratch buffers it requested are added.
+  void LogCsv(const RecordingMicroAllocator* allocator = nullptr) const;
+
+ private:
+  struct LayerStats {
+    const char* tag;
+    const char* variant;
+    uint32_t macs;
+    uint32_t bytes;
+    uint32_t count;
+    uint64_t total_ticks;
+    uint32_t max_ticks;
+  };
+
+  // Handle of events that aren't recorded: events that don't belong to a node
+  // of the main subgraph, e.g. the nodes of a subgraph run by an IF node,
+  // whose ticks count for the outer node, or nodes beyond kMaxLayers.
+  static constexpr uint32_t kIgnoredEvent = 0xFFFFFFFF;
+
+  LayerStats layers_[kMaxLayers] = {};
+  // Number of nodes of the main subgraph, may exceed kMaxLayers.
+  int node_count_ = 0;
+  // Node of the main subgraph set by SetCurrentNode() for the next event, or
+  // -1.
+  int current_node_ = -1;
+  // Node whose event is open and the depth of its event, or -1.
+  int active_node_ = -1;
+  int active_depth_ = 0;
+  // Number of open events.
+  int depth_ = 0;
+  int32_t start_ticks_ = 0;
+
+  TF_LITE_REMOVE_VIRTUAL_DELETE
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_LAYER_PROFILER_H_
@@ -0,0 +1,179 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/micro_model_manager.h"
+
+#include <new>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/kernels/internal/compatibility.h"
+
+namespace tflite {
+
+MicroModelManager::MicroModelManager(uint8_t* tensor_arena, size_t arena_size,
+                                     ErrorReporter* error_reporter)
+    : error_reporter_(error_reporter),
+      allocator_(
+          MicroAllocator::Create(tensor_arena, arena_size, error_reporter)),
+      model_count_(0),
+      tensors_allocated_(false) {}
+
+MicroModelManager::MicroModelManager(uint8_t* tensor_arena, size_t arena_size,
+                                     MicroMemoryPlanner* memory_planner,
+                                     ErrorReporter* error_reporter)
+    : error_reporter_(error_reporter),
+      allocator_(MicroAllocator::Create(tensor_arena, arena_size,
+                                        memory_planner, error_reporter)),
+      model_count_(0),
+      tensors_allocated_(false) {}
+
+MicroModelManager::~MicroModelManager() {
+  // The interpreters live in the arena, so only their destructors are run.
+  for (int i = 0; i < model_count_; ++i) {
+    models_[i].interpreter->~MicroInterpreter();
+  }
+}
+
+int MicroModelManager::AddModel(const Model* model,
+                                const MicroOpResolver& op_resolver,
+                                int priority, FillInputsFunction fill_inputs,
+                                HandleOutputsFunction handle_outputs,
+                                void* user_data) {
+  TFLITE_DCHECK(model != nullptr);
+
+  if (allocator_ == nullptr) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Arena too small for the model manager.");
+    return -1;
+  }
+  if (tensors_allocated_) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Models must be added before AllocateTensors().");
+    return -1;
+  }
+  if (model_count_ >= kMaxModels) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Couldn't add model, at most %d models supported.",
+                         kMaxModels);
+    return -1;
+  }
+
+  void* interpreter_buffer =
+      allocator_->AllocatePersistentBuffer(sizeof(MicroInterpreter));
+  if (interpreter_buffer == nullptr) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Failed to allocate memory for the interpreter of "
+                         "model %d.",
+                         model_count_);
+    return -1;
+  }
+
+  ModelSlot* slot = &models_[model_count_];
+  slot->interpreter = new (interpreter_buffer)
+      MicroInterpreter(model, op_resolver, allocator_, error_reporter_);
+  slot->priority = priority;
+  slot->fill_inputs = fill_inputs;
+  slot->handle_outputs = handle_outputs;
+  slot->user_data = user_data;
+  slot->pending = false;
+  return model_count_++;
+}
+
+TfLiteStatus MicroModelManager::AllocateTensors() {
+  // Every model plans its non-persistent buffers from the start of the arena
+  // head, which CommitStaticMemoryPlan() grows to the largest plan so far.
+  // StartModelAllocation() shrinks the head again to the scratch buffer
+  // requests of one kernel, so the persistent allocations of a later model can
+  // grow into the region planned for an earlier one. No model runs before all
+  // are allocated, so no tensor is corrupted, but the overlap is only detected
+  // when SetHeadBufferSize() fails to grow the head back for the plan of the
+  // later model. AllocateTensors() then fails, the arena must fit the
+  // persistent allocations of all models plus the largest plan.
+  for (int i = 0; i < model_count_; ++i) {
+    if (models_[i].interpreter->AllocateTensors() != kTfLiteOk) {
+      TF_LITE_REPORT_ERROR(error_reporter_,
+                           "AllocateTensors() failed for model %d.", i);
+      return kTfLiteError;
+    }
+  }
+  tensors_allocated_ = true;
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroModelManager::RequestInvoke(int model_id) {
+  if ((model_id < 0) || (model_id >= model_count_)) {
+    TF_LITE_REPORT_ERROR(error_reporter_, "Invalid model id %d.", model_id);
+    return kTfLiteError;
+  }
+  models_[model_id].pending = true;
+  return kTfLiteOk;
+}
+
+bool MicroModelManager::HasPendingInvoke() const {
+  for (int i = 0; i < model_count_; ++i) {
+    if (models_[i].pending) {
+      return true;
+    }
+  }
+  return false;
+}
+
+TfLiteStatus MicroModelManager::InvokeNext(int* model_id) {
+  TFLITE_DCHECK(model_id != nullptr);
+
+  *model_id = -1;
+  for (int i = 0; i < model_count_; ++i) {
+    if (models_[i].pending &&
+        ((*model_id == -1) ||
+         (models_[i].priority > models_[*model_id].priority))) {
+      *model_id = i;
+    }
+  }
+  if (*model_id == -1) {
+    return kTfLiteOk;
+  }
+
+  ModelSlot* slot = &models_[*model_id];
+  slot->pending = false;
+
+  // The tensors of the previously run model occupy the same memory, so the
+  // inputs have to be written now and not when the invoke was requested.
+  if (slot->fill_inputs != nullptr) {
+    TF_LITE_ENSURE_STATUS(slot->fill_inputs(slot->interpreter,
+                                            slot->user_data));
+  }
+  TF_LITE_ENSURE_STATUS(slot->interpreter->Invoke());
+  if (slot->handle_outputs != nullptr) {
+    slot->handle_outputs(slot->interpreter, slot->user_data);
+  }
+  return kTfLiteOk;
+}
+
+MicroInterpreter* MicroModelManager::interpreter(int model_id) {
+  if ((model_id < 0) || (model_id >= model_count_)) {
+    return nullptr;
+  }
+  return models_[model_id].interpreter;
+}
+
+size_t MicroModelManager::arena_used_bytes() const {
+  if (allocator_ == nullptr) {
+    return 0;
+  }
+  return allocator_->used_bytes();
+}
+
+}  // namespace tflite
@@ -0,0 +1,138 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_MODEL_MANAGER_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_MODEL_MANAGER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/memory_planner/micro_memory_planner.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_op_resolver.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+
+// Runs several models that never execute at the same time from one tensor
+// arena.
+//
+// All models share one MicroAllocator. The persistent allocations of every
+// model (interpreter, nodes, tensor metadata, variables) are stacked in the
+// tail of the arena, while the non-persistent tensors and scratch buffers of
+// all models are overlaid in the head, which is sized for the largest model.
+// The arena therefore needs the sum of the persistent sizes plus the maximum
+// of the non-persistent sizes instead of the sum of both.
+//
+// Because of the overlay, the input, output and intermediate tensors of a
+// model are only valid while that model runs. Running any other model
+// overwrites them. The inputs are therefore filled by a callback right before
+// the model is invoked and the outputs are read by a callback right after.
+//
+// Invocations are requested with RequestInvoke(), e.g. when new sensor data is
+// available, and executed by InvokeNext(), which runs the pending model with
+// the highest priority. Models of equal priority run in the order they were
+// added.
+//
+// All models use the memory planner of the shared allocator, which plans each
+// model on its own. A planner that holds a fixed plan for a single model, like
+// the NonPersistentMemoryPlannerShim, can't be used with several models.
+//
+// Not thread or interrupt safe, all methods must be called from the same
+// context.
+class MicroModelManager {
+ public:
+  // Maximum number of models that can be added.
+  static constexpr int kMaxModels = 4;
+
+  // Writes the input tensors of a model. If this doesn't return kTfLiteOk, the
+  // model isn't invoked and InvokeNext() returns the error.
+  typedef TfLiteStatus (*FillInputsFunction)(MicroInterpreter* interpreter,
+                                             void* user_data);
+
+  // Reads the output tensors of a model after it was invoked.
+  typedef void (*HandleOutputsFunction)(MicroInterpreter* interpreter,
+                                        void* user_data);
+
+  // Uses the GreedyMemoryPlanner. The lifetime of the arena, error reporter and
+  // of everything passed to AddModel() must be at least as long as that of the
+  // manager.
+  MicroModelManager(uint8_t* tensor_arena, size_t arena_size,
+                    ErrorReporter* error_reporter);
+
+  // Uses the given memory planner for all models.
+  MicroModelManager(uint8_t* tensor_arena, size_t arena_size,
+                    MicroMemoryPlanner* memory_planner,
+                    ErrorReporter* error_reporter);
+
+  ~MicroModelManager();
+
+  // Registers a model. All models must be added before AllocateTensors().
+  // Returns the id of the model, or -1 if the model couldn't be added.
+  int AddModel(const Model* model, const MicroOpResolver& op_resolver,
+               int priority, FillInputsFunction fill_inputs,
+               HandleOutputsFunction handle_outputs, void* user_data);
+
+  // Allocates the tensors of all added models.
+  TfLiteStatus AllocateTensors();
+
+  // Marks a model to be run by one of the next calls to InvokeNext(). Requests
+  // for a model that is already pending are merged.
+  TfLiteStatus RequestInvoke(int model_id);
+
+  // Whether any model is waiting to be run.
+  bool HasPendingInvoke() const;
+
+  // Fills the inputs, invokes and handles the outputs of the pending model with
+  // the highest priority. The id of that model is returned in model_id, or -1
+  // if no model was pending.
+  TfLiteStatus InvokeNext(int* model_id);
+
+  // Interpreter of a model, or nullptr for an invalid id.
+  MicroInterpreter* interpreter(int model_id);
+
+  // Number of models added so far.
+  int model_count() const { return model_count_; }
+
+  // Bytes of the arena used by all models, see
+  // MicroInterpreter::arena_used_bytes().
+  size_t arena_used_bytes() const;
+
+ private:
+  struct ModelSlot {
+    MicroInterpreter* interpreter;
+    int priority;
+    FillInputsFunction fill_inputs;
+    HandleOutputsFunction handle_outputs;
+    void* user_data;
+    bool pending;
+  };
+
+  ErrorReporter* error_reporter_;
+  MicroAllocator* allocator_;
+  ModelSlot models_[kMaxModels];
+  int model_count_;
+  bool tensors_allocated_;
+
+  TF_LITE_REMOVE_VIRTUAL_DELETE
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_MODEL_MANAGER_H_
@@ -19,6 +19,7 @@ limitations under the License.
 #include <cstdint>
 
 #include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/micro_profiler_interface.h"
 
 namespace tflite {
 
@@ -26,15 +27,15 @@ namespace tflite {
 // performance. Bottleck operators can be identified along with slow code
 // sections. This can be used in conjunction with running the relevant micro
 // benchmark to evaluate end-to-end performance.
-class MicroProfiler {
+class MicroProfiler : public MicroProfilerInterface {
  public:
   MicroProfiler() = default;
-  virtual ~MicroProfiler() = default;
+  ~MicroProfiler() override = default;
 
   // Marks the start of a new event and returns an event handle that can be used
   // to mark the end of the event via EndEvent. The lifetime of the tag
   // parameter must exceed that of the MicroProfiler.
-  virtual uint32_t BeginEvent(const char* tag);
+  uint32_t BeginEvent(const char* tag) override;
 
   // Marks the end of an event associated with event_handle. It is the
   // responsibility of the caller to ensure than EndEvent is called once and
@@ -43,7 +44,7 @@ class MicroProfiler {
   // If EndEvent is called more than once for the same event_handle, the last
   // call will be used as the end of event marker.If EndEvent is called 0 times
   // for a particular event_handle, the duration of that event will be 0 ticks.
-  virtual void EndEvent(uint32_t event_handle);
+  void EndEvent(uint32_t event_handle) override;
 
   // Clears all the events that have been currently profiled.
   void ClearEvents() { num_events_ = 0; }
@@ -82,13 +83,14 @@ class MicroProfiler {
 // MicroInterpreter and we want to ensure zero overhead for the release builds.
 class ScopedMicroProfiler {
  public:
-  explicit ScopedMicroProfiler(const char* tag, MicroProfiler* profiler) {}
+  explicit ScopedMicroProfiler(const char* tag,
+                               MicroProfilerInterface* profiler) {}
 };
 
 #else
 
-// This class can be used to add events to a MicroProfiler object that span the
-// lifetime of the ScopedMicroProfiler object.
+// This class can be used to add events to a MicroProfilerInterface object that
+// span the lifetime of the ScopedMicroProfiler object.
 // Usage example:
 //
 // MicroProfiler profiler();
@@ -99,7 +101,8 @@ class ScopedMicroProfiler {
 // }
 class ScopedMicroProfiler {
  public:
-  explicit ScopedMicroProfiler(const char* tag, MicroProfiler* profiler)
+  explicit ScopedMicroProfiler(const char* tag,
+                               MicroProfilerInterface* profiler)
       : profiler_(profiler) {
     if (profiler_ != nullptr) {
       event_handle_ = profiler_->BeginEvent(tag);
@@ -114,7 +117,7 @@ class ScopedMicroProfiler {
 
  private:
   uint32_t event_handle_ = 0;
-  MicroProfiler* profiler_ = nullptr;
+  MicroProfilerInterface* profiler_ = nullptr;
 };
 #endif  // !defined(TF_LITE_STRIP_ERROR_STRINGS)
 
@@ -0,0 +1,52 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_PROFILER_INTERFACE_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_PROFILER_INTERFACE_H_
+
+#include <cstdint>
+
+namespace tflite {
+
+// Interface of the profilers that can be passed to the MicroInterpreter. The
+// interpreter opens an event tagged with the operator name around the Invoke
+// of every node.
+class MicroProfilerInterface {
+ public:
+  virtual ~MicroProfilerInterface() {}
+
+  // Marks the start of a new event and returns an event handle that can be used
+  // to mark the end of the event via EndEvent. The lifetime of the tag
+  // parameter must exceed that of the profiler.
+  virtual uint32_t BeginEvent(const char* tag) = 0;
+
+  // Marks the end of an event associated with event_handle.
+  virtual void EndEvent(uint32_t event_handle) = 0;
+
+  // Called by the graph right before the event of a node is opened, with the
+  // subgraph and the index of the node within it. Nodes may be invoked in
+  // ranges, so events don't always start at the first node of a subgraph.
+  virtual void SetCurrentNode(int subgraph_idx, int node_idx) {}
+
+  // Called by a kernel from its Invoke to name the implementation that runs
+  // for the current node, e.g. "reference" or the name of the CMSIS-NN
+  // function. The lifetime of the variant string must exceed that of the
+  // profiler. See tflite::micro::SetKernelVariant().
+  virtual void SetKernelVariant(const char* variant) {}
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_PROFILER_INTERFACE_H_
@@ -0,0 +1,181 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_STATIC_OP_RESOLVER_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_STATIC_OP_RESOLVER_H_
+
+#include <cstdint>
+#include <cstring>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/core/api/flatbuffer_conversions.h"
+#include "tensorflow/lite/kernels/internal/compatibility.h"
+#include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/micro_op_resolver.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+
+// An op resolver for a fixed set of operators that is known when the firmware
+// is built, usually generated from the model with
+// tools/generate_op_resolver.py.
+//
+// Builtin operators are found with a single table lookup instead of the linear
+// scans of MicroMutableOpResolver: the operator code modulo tHashModulus
+// selects a slot that holds the index of the registration. The generator picks
+// the smallest tHashModulus for which the codes of the model don't collide, so
+// the table is a perfect hash of exactly these operators. Custom operators are
+// still found by name.
+//
+// As with MicroMutableOpResolver, only the kernels that are registered get
+// linked into the image.
+template <unsigned int tOpCount, unsigned int tHashModulus>
+class MicroStaticOpResolver : public MicroOpResolver {
+ public:
+  TF_LITE_REMOVE_VIRTUAL_DELETE
+
+  explicit MicroStaticOpResolver(ErrorReporter* error_reporter = nullptr)
+      : error_reporter_(error_reporter) {
+    memset(slots_, kEmptySlot, sizeof(slots_));
+  }
+
+  const TfLiteRegistration* FindOp(tflite::BuiltinOperator op) const override {
+    const uint8_t index = slots_[static_cast<unsigned int>(op) % tHashModulus];
+    if ((index == kEmptySlot) || (registrations_[index].builtin_code != op)) {
+      return nullptr;
+    }
+    return &registrations_[index];
+  }
+
+  const TfLiteRegistration* FindOp(const char* op) const override {
+    for (unsigned int i = 0; i < registrations_len_; ++i) {
+      const TfLiteRegistration& registration = registrations_[i];
+      if ((registration.builtin_code == BuiltinOperator_CUSTOM) &&
+          (strcmp(registration.custom_name, op) == 0)) {
+        return &registration;
+      }
+    }
+    return nullptr;
+  }
+
+  MicroOpResolver::BuiltinParseFunction GetOpDataParser(
+      BuiltinOperator op) const override {
+    const uint8_t index = slots_[static_cast<unsigned int>(op) % tHashModulus];
+    if ((index == kEmptySlot) || (registrations_[index].builtin_code != op)) {
+      return nullptr;
+    }
+    return parsers_[index];
+  }
+
+  // Registers a Builtin Operator with the resolver. Fails if the slot of the
+  // operator code is already taken, i.e. if tHashModulus doesn't match the
+  // operators, or if tOpCount operators are already registered.
+  TfLiteStatus AddBuiltin(tflite::BuiltinOperator op,
+                          const TfLiteRegistration& registration,
+                          MicroOpResolver::BuiltinParseFunction parser) {
+    if (op == BuiltinOperator_CUSTOM) {
+      if (error_reporter_ != nullptr) {
+        TF_LITE_REPORT_ERROR(error_reporter_,
+                             "Invalid parameter BuiltinOperator_CUSTOM to the "
+                             "AddBuiltin function.");
+      }
+      return kTfLiteError;
+    }
+
+    uint8_t* slot = &slots_[static_cast<unsigned int>(op) % tHashModulus];
+    if (*slot != kEmptySlot) {
+      if (error_reporter_ != nullptr) {
+        TF_LITE_REPORT_ERROR(error_reporter_,
+                             "Builtin op #%d collides with op #%d, hash "
+                             "modulus %d doesn't fit the ops.",
+                             op, registrations_[*slot].builtin_code,
+                             tHashModulus);
+      }
+      return kTfLiteError;
+    }
+
+    if (registrations_len_ >= tOpCount) {
+      if (error_reporter_ != nullptr) {
+        TF_LITE_REPORT_ERROR(error_reporter_,
+                             "Couldn't register builtin op #%d, resolver size "
+                             "is too small (%d).",
+                             op, tOpCount);
+      }
+      return kTfLiteError;
+    }
+
+    registrations_[registrations_len_] = registration;
+    registrations_[registrations_len_].builtin_code = op;
+    parsers_[registrations_len_] = parser;
+    *slot = static_cast<uint8_t>(registrations_len_);
+    registrations_len_++;
+    return kTfLiteOk;
+  }
+
+  // Registers a Custom Operator with the resolver. Only the first call for a
+  // given name will be successful.
+  TfLiteStatus AddCustom(const char* name, TfLiteRegistration* registration) {
+    if (registrations_len_ >= tOpCount) {
+      if (error_reporter_ != nullptr) {
+        TF_LITE_REPORT_ERROR(
+            error_reporter_,
+            "Couldn't register custom op '%s', resolver size is too small (%d)",
+            name, tOpCount);
+      }
+      return kTfLiteError;
+    }
+
+    if (FindOp(name) != nullptr) {
+      if (error_reporter_ != nullptr) {
+        TF_LITE_REPORT_ERROR(error_reporter_,
+                             "Calling AddCustom for the same op more than once "
+                             "is not supported (Op: %s).",
+                             name);
+      }
+      return kTfLiteError;
+    }
+
+    TfLiteRegistration* new_registration = &registrations_[registrations_len_];
+    *new_registration = *registration;
+    new_registration->builtin_code = BuiltinOperator_CUSTOM;
+    new_registration->custom_name = name;
+    parsers_[registrations_len_] = nullptr;
+    registrations_len_++;
+    return kTfLiteOk;
+  }
+
+  unsigned int GetRegistrationLength() { return registrations_len_; }
+
+ private:
+  // Marks a slot without a builtin operator.
+  static constexpr uint8_t kEmptySlot = 0xff;
+
+  static_assert(tOpCount > 0, "The resolver needs at least one operator.");
+  static_assert(tHashModulus > 0, "The hash modulus must not be zero.");
+  static_assert(tOpCount < kEmptySlot, "Too many operators for the slots.");
+
+  TfLiteRegistration registrations_[tOpCount];
+  MicroOpResolver::BuiltinParseFunction parsers_[tOpCount];
+  unsigned int registrations_len_ = 0;
+
+  // Index into registrations_ for each hash value of a builtin operator code.
+  uint8_t slots_[tHashModulus];
+
+  ErrorReporter* error_reporter_;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_STATIC_OP_RESOLVER_H_
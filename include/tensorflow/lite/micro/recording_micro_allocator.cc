@@ -72,6 +72,25 @@ RecordingMicroAllocator* RecordingMicroAllocator::Create(
   return allocator;
 }
 
+RecordingMicroAllocator* RecordingMicroAllocator::Create(
+    uint8_t* tensor_arena, size_t arena_size,
+    MicroMemoryPlanner* memory_planner, ErrorReporter* error_reporter) {
+  TFLITE_DCHECK(error_reporter != nullptr);
+  TFLITE_DCHECK(memory_planner != nullptr);
+
+  RecordingSimpleMemoryAllocator* simple_memory_allocator =
+      RecordingSimpleMemoryAllocator::Create(error_reporter, tensor_arena,
+                                             arena_size);
+  TFLITE_DCHECK(simple_memory_allocator != nullptr);
+
+  uint8_t* allocator_buffer = simple_memory_allocator->AllocateFromTail(
+      sizeof(RecordingMicroAllocator), alignof(RecordingMicroAllocator));
+  RecordingMicroAllocator* allocator =
+      new (allocator_buffer) RecordingMicroAllocator(
+          simple_memory_allocator, memory_planner, error_reporter);
+  return allocator;
+}
+
 RecordedAllocation RecordingMicroAllocator::GetRecordedAllocation(
     RecordedAllocationType allocation_type) const {
   switch (allocation_type) {
@@ -100,6 +119,16 @@ RecordingMicroAllocator::GetSimpleMemoryAllocator() const {
   return recording_memory_allocator_;
 }
 
+RecordedNodeAllocation RecordingMicroAllocator::GetRecordedNodeAllocation(
+    int index) const {
+  if ((index < 0) || (index >= recorded_node_count_)) {
+    TF_LITE_REPORT_ERROR(error_reporter(), "Invalid recorded node index: %d",
+                         index);
+    return RecordedNodeAllocation();
+  }
+  return recorded_nodes_[index];
+}
+
 void RecordingMicroAllocator::PrintAllocations() const {
   TF_LITE_REPORT_ERROR(
       error_reporter(),
@@ -130,6 +159,14 @@ void RecordingMicroAllocator::PrintAllocations() const {
                           "NodeAndRegistration structs");
   PrintRecordedAllocation(RecordedAllocationType::kOpData,
                           "Operator runtime data", "OpData structs");
+  for (int i = 0; i < recorded_node_count_; ++i) {
+    TF_LITE_REPORT_ERROR(
+        error_reporter(),
+        "[RecordingMicroAllocator] Node %d used %d bytes after Prepare "
+        "(requested %d scratch bytes)",
+        recorded_nodes_[i].node_id, recorded_nodes_[i].used_bytes,
+        recorded_nodes_[i].scratch_bytes);
+  }
 }
 
 void* RecordingMicroAllocator::AllocatePersistentBuffer(size_t bytes) {
@@ -140,6 +177,30 @@ void* RecordingMicroAllocator::AllocatePersistentBuffer(size_t bytes) {
   return buffer;
 }
 
+TfLiteStatus RecordingMicroAllocator::RequestScratchBufferInArena(
+    size_t bytes, int subgraph_idx, int* buffer_idx) {
+  TfLiteStatus status = MicroAllocator::RequestScratchBufferInArena(
+      bytes, subgraph_idx, buffer_idx);
+  if (status == kTfLiteOk) {
+    pending_scratch_bytes_ += bytes;
+  }
+  return status;
+}
+
+TfLiteStatus RecordingMicroAllocator::FinishPrepareNodeAllocations(
+    int node_id) {
+  TfLiteStatus status = MicroAllocator::FinishPrepareNodeAllocations(node_id);
+  if (recorded_node_count_ < kMaxRecordedNodes) {
+    RecordedNodeAllocation* recorded_node =
+        &recorded_nodes_[recorded_node_count_++];
+    recorded_node->node_id = node_id;
+    recorded_node->used_bytes = recording_memory_allocator_->GetUsedBytes();
+    recorded_node->scratch_bytes = pending_scratch_bytes_;
+  }
+  pending_scratch_bytes_ = 0;
+  return status;
+}
+
 void RecordingMicroAllocator::PrintRecordedAllocation(
     RecordedAllocationType allocation_type, const char* allocation_name,
     const char* allocation_description) const {
@@ -195,9 +256,10 @@ TfLiteStatus RecordingMicroAllocator::AllocateTfLiteEvalTensors(
     // the graph (e.g. sizeof(TfLiteEvalTensor) * num_tensors). To prevent extra
     // overhead and potential for fragmentation, manually adjust the accounting
     // by decrementing by 1 and adding the actual number of tensors used in the
-    // graph:
+    // graph. Constant tensors of a ConstantTensorTable have no eval tensor in
+    // the arena:
     recorded_tflite_eval_tensor_data_.count +=
-        model->subgraphs()->Get(subgraph_idx)->tensors()->size() - 1;
+        subgraph_allocations[subgraph_idx].tensors_size - 1;
   }
   return status;
 }
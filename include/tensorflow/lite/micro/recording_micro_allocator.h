@@ -45,6 +45,15 @@ struct RecordedAllocation {
   size_t count;
 };
 
+// Arena usage recorded when the Prepare of a node has finished.
+struct RecordedNodeAllocation {
+  int node_id;
+  // Bytes of the arena in use after the node was prepared.
+  size_t used_bytes;
+  // Sum of the scratch buffers requested by the node.
+  size_t scratch_bytes;
+};
+
 // Utility subclass of MicroAllocator that records all allocations
 // inside the arena. A summary of allocations can be logged through the
 // ErrorReporter by invoking LogAllocations(). This special allocator requires
@@ -54,10 +63,20 @@ struct RecordedAllocation {
 // auditing memory usage or integration testing.
 class RecordingMicroAllocator : public MicroAllocator {
  public:
+  // Maximum number of nodes for which the Prepare allocations are recorded.
+  static constexpr int kMaxRecordedNodes = 64;
+
   static RecordingMicroAllocator* Create(uint8_t* tensor_arena,
                                          size_t arena_size,
                                          ErrorReporter* error_reporter);
 
+  // Same as above, but uses the given memory planner instead of creating a
+  // GreedyMemoryPlanner in the arena.
+  static RecordingMicroAllocator* Create(uint8_t* tensor_arena,
+                                         size_t arena_size,
+                                         MicroMemoryPlanner* memory_planner,
+                                         ErrorReporter* error_reporter);
+
   // Returns the fixed amount of memory overhead of RecordingMicroAllocator.
   static size_t GetDefaultTailUsage();
 
@@ -67,11 +86,21 @@ class RecordingMicroAllocator : public MicroAllocator {
 
   const RecordingSimpleMemoryAllocator* GetSimpleMemoryAllocator() const;
 
+  // Number of nodes whose Prepare allocations were recorded, in the order the
+  // nodes were prepared. At most kMaxRecordedNodes nodes are recorded.
+  int GetRecordedNodeCount() const { return recorded_node_count_; }
+
+  // Returns the recorded Prepare allocations of the index-th prepared node.
+  RecordedNodeAllocation GetRecordedNodeAllocation(int index) const;
+
   // Logs out through the ErrorReporter all allocation recordings by type
-  // defined in RecordedAllocationType.
+  // defined in RecordedAllocationType and the recordings of every node.
   void PrintAllocations() const;
 
   void* AllocatePersistentBuffer(size_t bytes) override;
+  TfLiteStatus RequestScratchBufferInArena(size_t bytes, int subgraph_idx,
+                                           int* buffer_idx) override;
+  TfLiteStatus FinishPrepareNodeAllocations(int node_id) override;
 
  protected:
   TfLiteStatus AllocateNodeAndRegistrations(
@@ -118,6 +147,11 @@ class RecordingMicroAllocator : public MicroAllocator {
   // TODO(b/187993291): Re-enable OpData allocating tracking.
   RecordedAllocation recorded_op_data_ = {};
 
+  RecordedNodeAllocation recorded_nodes_[kMaxRecordedNodes] = {};
+  int recorded_node_count_ = 0;
+  // Scratch bytes requested by the node that is currently being prepared.
+  size_t pending_scratch_bytes_ = 0;
+
   TF_LITE_REMOVE_VIRTUAL_DELETE
 };
 
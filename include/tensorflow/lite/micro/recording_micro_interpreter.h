@@ -39,7 +39,7 @@ class RecordingMicroInterpreter : public MicroInterpreter {
                             uint8_t* tensor_arena, size_t tensor_arena_size,
                             ErrorReporter* error_reporter,
                             MicroResourceVariables* resource_variable = nullptr,
-                            MicroProfiler* profiler = nullptr)
+                            MicroProfilerInterface* profiler = nullptr)
       : MicroInterpreter(model, op_resolver,
                          RecordingMicroAllocator::Create(
                              tensor_arena, tensor_arena_size, error_reporter),
@@ -52,7 +52,7 @@ class RecordingMicroInterpreter : public MicroInterpreter {
                             RecordingMicroAllocator* allocator,
                             ErrorReporter* error_reporter,
                             MicroResourceVariables* resource_variable = nullptr,
-                            MicroProfiler* profiler = nullptr)
+                            MicroProfilerInterface* profiler = nullptr)
       : MicroInterpreter(model, op_resolver, allocator, error_reporter,
                          resource_variable, profiler),
         recording_micro_allocator_(*allocator) {}
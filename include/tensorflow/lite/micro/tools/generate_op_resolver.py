@@ -0,0 +1,270 @@
+#!/usr/bin/env python3
+""" Op resolver generator for TFLM models.
+
+    Reads the operators a model uses and writes a C++ header with a
+    tflite::MicroStaticOpResolver for exactly these operators, so the firmware
+    neither links unused kernels nor scans registrations in AllocateTensors().
+
+    The builtin operators are sorted by code and the smallest hash modulus for
+    which their codes don't collide is chosen, which makes every lookup a
+    single table access.
+
+    The kernel registration and parse function of every operator are taken
+    from the Add* functions of micro_mutable_op_resolver.h, so both resolvers
+    always register the same kernels. The header includes the kernel headers
+    that declare these registrations.
+
+    Prerequisites:
+    - installed Python, version >=3.4
+
+    Example:
+    generate_op_resolver.py --model hello_world_model_data.cc \\
+        --name hello_world --output-dir include/tinyml
+"""
+
+__version__ = '1.0.0'
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+from offline_memory_planner import Table, read_model
+
+
+# Field indices of the tflite schema tables used below.
+MODEL_OPERATOR_CODES = 1
+MODEL_SUBGRAPHS = 2
+SUBGRAPH_OPERATORS = 3
+OPERATOR_OPCODE_INDEX = 0
+OPERATOR_CODE_DEPRECATED_BUILTIN_CODE = 0
+OPERATOR_CODE_CUSTOM_CODE = 1
+OPERATOR_CODE_BUILTIN_CODE = 3
+
+BUILTIN_OPERATOR_CUSTOM = 32
+
+MICRO_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+LITE_DIR = os.path.dirname(MICRO_DIR)
+
+
+class Operator(object):
+    """ Operator of the model with the code to register its kernel. """
+
+    def __init__(self, name, code, registration, parser=None):
+        self.name = name
+        self.code = code
+        self.registration = registration
+        self.parser = parser
+
+
+def qualify(expression):
+    if expression.startswith('tflite::'):
+        return expression
+    return 'tflite::' + expression
+
+
+def read_builtin_codes(schema_path):
+    """ Returns the tflite::BuiltinOperator values by name. """
+    with open(schema_path) as f:
+        text = f.read()
+    body = re.search(r'enum BuiltinOperator\b[^{]*\{(.*?)\};', text, re.S)
+    return dict((name, int(value)) for name, value in
+                re.findall(r'BuiltinOperator_(\w+) = (-?\d+)', body.group(1)))
+
+
+def read_kernels(resolver_path):
+    """ Returns the registrations of MicroMutableOpResolver.
+
+        Builtin operators map their name to (registration, parse function),
+        custom operators map their name to the registration.
+    """
+    with open(resolver_path) as f:
+        text = f.read()
+
+    builtins = {}
+    customs = {}
+    for params, body in re.findall(
+            r'TfLiteStatus Add\w+\(([^)]*(?:\(\))?[^)]*)\)\s*\{(.*?)\n  \}',
+            text, re.S):
+        body = ' '.join(body.split())
+        match = re.search(r'AddBuiltin\( ?BuiltinOperator_(\w+), (.+?), '
+                          r'(\w+)\);', body)
+        if match is not None and match.group(1) != 'CUSTOM':
+            registration = match.group(2)
+            if registration == 'registration':
+                default = re.search(r'=\s*([\w:]+\(\))', params)
+                if default is None:
+                    continue
+                registration = default.group(1)
+            builtins[match.group(1)] = (qualify(registration),
+                                        qualify(match.group(3)))
+            continue
+        match = re.search(r'AddCustom\("([^"]+)", (.+?)\);', body)
+        if match is not None:
+            customs[match.group(1)] = qualify(match.group(2))
+    return builtins, customs
+
+
+def read_kernel_headers(kernels_dir):
+    """ Returns the kernel header declaring each registration function.
+
+        Functions declared by several headers map to the first one in
+        alphabetical order.
+    """
+    headers = {}
+    for file_name in sorted(os.listdir(kernels_dir)):
+        if not file_name.endswith('.h'):
+            continue
+        with open(os.path.join(kernels_dir, file_name)) as f:
+            text = f.read()
+        for function in re.findall(
+                r'^\s*(?:inline\s+)?TfLiteRegistration\*?\s+(Register_\w+)\(\)'
+                r'\s*[;{]', text, re.M):
+            headers.setdefault(function,
+                               'tensorflow/lite/micro/kernels/' + file_name)
+    return headers
+
+
+def get_operators(model_data, builtin_codes, builtins, customs):
+    """ Returns the operators used by all subgraphs of the model. """
+    model = Table(model_data, struct.unpack_from('<I', model_data, 0)[0])
+    operator_codes = model.tables(MODEL_OPERATOR_CODES)
+    builtin_names = dict((code, name) for name, code in builtin_codes.items())
+
+    used = set()
+    for subgraph in model.tables(MODEL_SUBGRAPHS):
+        for operator in subgraph.tables(SUBGRAPH_OPERATORS):
+            used.add(operator.scalar(OPERATOR_OPCODE_INDEX, 'I'))
+
+    operators = []
+    missing = []
+    for index in sorted(used):
+        operator_code = operator_codes[index]
+        # Models of older converters only set the deprecated field, which is
+        # capped to 127.
+        code = max(operator_code.scalar(OPERATOR_CODE_DEPRECATED_BUILTIN_CODE,
+                                        'b'),
+                   operator_code.scalar(OPERATOR_CODE_BUILTIN_CODE, 'i'))
+        if code == BUILTIN_OPERATOR_CUSTOM:
+            name = custom_code(operator_code)
+            if name in customs:
+                operators.append(Operator(name, code, customs[name]))
+            else:
+                missing.append(name)
+            continue
+        name = builtin_names.get(code, '#%d' % code)
+        if name in builtins:
+            operators.append(Operator(name, code, *builtins[name]))
+        else:
+            missing.append(name)
+
+    if missing:
+        raise ValueError('no TFLM kernel for %s' % ', '.join(missing))
+    return operators
+
+
+def custom_code(operator_code):
+    pos = operator_code._indirect(OPERATOR_CODE_CUSTOM_CODE)
+    length = struct.unpack_from('<I', operator_code.buf, pos)[0]
+    return operator_code.buf[pos + 4:pos + 4 + length].decode('utf-8')
+
+
+def hash_modulus(codes):
+    """ Smallest modulus that maps all codes to different slots. """
+    modulus = max(len(codes), 1)
+    while len(set(code % modulus for code in codes)) != len(codes):
+        modulus += 1
+    return modulus
+
+
+def registration_function(registration):
+    return re.search(r'(\w+)\(\)$', registration).group(1)
+
+
+def write_resolver(path_base, name, model_path, operators, kernel_headers):
+    guard = re.sub(r'\W', '_', os.path.basename(path_base)).upper() + '_H_'
+    camel_name = ''.join(w.capitalize() for w in name.split('_'))
+    builtins = sorted((op for op in operators
+                       if op.code != BUILTIN_OPERATOR_CUSTOM),
+                      key=lambda op: op.code)
+    customs = sorted((op for op in operators
+                      if op.code == BUILTIN_OPERATOR_CUSTOM),
+                     key=lambda op: op.name)
+    functions = sorted(set(registration_function(op.registration)
+                           for op in operators))
+    includes = sorted(set(kernel_headers[function] for function in functions
+                          if function in kernel_headers))
+    undeclared = [op.registration for op in builtins + customs
+                  if registration_function(op.registration)
+                  not in kernel_headers]
+
+    with open(path_base + '.h', 'w') as f:
+        f.write('// Generated by generate_op_resolver.py from %s.\n'
+                '// Do not edit, regenerate whenever the model changes.\n'
+                % os.path.basename(model_path))
+        f.write('\n#ifndef %s\n#define %s\n\n' % (guard, guard))
+        f.write('#include "tensorflow/lite/core/api/flatbuffer_conversions.h"'
+                '\n')
+        for include in includes:
+            f.write('#include "%s"\n' % include)
+        f.write('#include "tensorflow/lite/micro/micro_static_op_resolver.h"'
+                '\n\n')
+        if undeclared:
+            # Kernels without a header, declared like in
+            # micro_mutable_op_resolver.h.
+            f.write('namespace tflite {\n')
+            for registration in sorted(set(undeclared)):
+                f.write('TfLiteRegistration* %s;\n'
+                        % registration[len('tflite::'):])
+            f.write('}  // namespace tflite\n\n')
+        f.write('// Resolver for the operators of the model: %s.\n'
+                % ', '.join(op.name for op in builtins + customs))
+        f.write('using %sOpResolver = tflite::MicroStaticOpResolver<%d, %d>;'
+                '\n\n' % (camel_name, max(len(operators), 1),
+                          hash_modulus([op.code for op in builtins])))
+        f.write('// Registers the kernels of all operators of the model.\n')
+        f.write('inline TfLiteStatus Register%sOps(%sOpResolver* resolver) {\n'
+                % (camel_name, camel_name))
+        for op in builtins:
+            f.write('  TF_LITE_ENSURE_STATUS(resolver->AddBuiltin(\n'
+                    '      tflite::BuiltinOperator_%s,\n'
+                    '      %s,\n'
+                    '      %s));\n' % (op.name, op.registration, op.parser))
+        for op in customs:
+            f.write('  TF_LITE_ENSURE_STATUS(\n'
+                    '      resolver->AddCustom("%s", %s));\n'
+                    % (op.name, op.registration))
+        f.write('  return kTfLiteOk;\n}\n\n')
+        f.write('#endif  // %s\n' % guard)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('--model', required=True,
+                        help='.tflite file or C source with the model array')
+    parser.add_argument('--name', required=True,
+                        help='model name used in the generated symbols')
+    parser.add_argument('--output-dir', default='.',
+                        help='directory of the generated <name>_op_resolver.h')
+    parser.add_argument('--version', action='version', version=__version__)
+    args = parser.parse_args()
+
+    builtin_codes = read_builtin_codes(
+        os.path.join(LITE_DIR, 'schema', 'schema_generated.h'))
+    builtins, customs = read_kernels(
+        os.path.join(MICRO_DIR, 'micro_mutable_op_resolver.h'))
+    operators = get_operators(read_model(args.model), builtin_codes, builtins,
+                              customs)
+
+    write_resolver(os.path.join(args.output_dir, args.name + '_op_resolver'),
+                   args.name, args.model, operators,
+                   read_kernel_headers(os.path.join(MICRO_DIR, 'kernels')))
+
+    print('%d operators: %s' % (len(operators),
+                                ', '.join(op.name for op in operators)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,412 @@
+#!/usr/bin/env python3
+""" Model packer for TFLM models executed in place from flash.
+
+    Rewrites a model so that the firmware can run it directly from flash
+    without any per-weight metadata in RAM, and writes it as a C++ source file
+    together with a tflite::ConstantTensorTable.
+
+    - The constant tensors of every subgraph, i.e. the tensors with data in
+      the model that are not variables, are moved behind all other tensors.
+      The relative order of the other tensors is kept, so memory plans of
+      offline_memory_planner.py stay valid. All tensor indices of operators,
+      subgraph inputs and outputs, signatures and the offline memory
+      allocation metadata are renumbered.
+    - The data of every constant tensor that isn't aligned to --alignment
+      bytes is moved to the end of the model, in the order in which the
+      operators read it, so kernels can read the weights with aligned word
+      loads. The flatbuffer is patched in place, the old data stays in the
+      model as unused bytes.
+    - The TfLiteEvalTensor of every constant tensor is written as a const
+      table pointing into the model array. The interpreter uses it via
+      MicroInterpreter::SetConstantTensorTable() instead of allocating and
+      initializing these structs in the arena at startup.
+
+    The generated source declares the same symbols as the output of xxd, so
+    it replaces the usual <name>_model_data.cc. Memory plans and op resolvers
+    must be generated from the packed model.
+
+    Prerequisites:
+    - installed Python, version >=3.4
+
+    Example:
+    model_packer.py --model hello_world.tflite --name hello_world \\
+        --output-dir include/tinyml
+"""
+
+__version__ = '1.0.0'
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+from offline_memory_planner import Table, align_up, read_model
+
+
+# Alignment of the model array in the generated source.
+MODEL_ALIGNMENT = 16
+
+# sizeof(TfLiteEvalTensor) on 32-bit targets.
+EVAL_TENSOR_SIZE = 12
+
+# TfLiteType names of tflite::TensorType values, see ConvertTensorType().
+TENSOR_TYPE_NAMES = {
+    0: 'kTfLiteFloat32',
+    1: 'kTfLiteFloat16',
+    2: 'kTfLiteInt32',
+    3: 'kTfLiteUInt8',
+    4: 'kTfLiteInt64',
+    5: 'kTfLiteString',
+    6: 'kTfLiteBool',
+    7: 'kTfLiteInt16',
+    8: 'kTfLiteComplex64',
+    9: 'kTfLiteInt8',
+    10: 'kTfLiteFloat64',
+    11: 'kTfLiteComplex128',
+    12: 'kTfLiteUInt64',
+    13: 'kTfLiteResource',
+    14: 'kTfLiteVariant',
+    15: 'kTfLiteUInt32',
+}
+
+OFFLINE_MEMORY_ALLOCATION = 'OFFLINE_MEMORY_ALLOCATION'
+
+# Field indices of the tflite schema tables used below.
+MODEL_SUBGRAPHS = 2
+MODEL_BUFFERS = 4
+MODEL_METADATA = 6
+MODEL_SIGNATURE_DEFS = 7
+SUBGRAPH_TENSORS = 0
+SUBGRAPH_INPUTS = 1
+SUBGRAPH_OUTPUTS = 2
+SUBGRAPH_OPERATORS = 3
+TENSOR_SHAPE = 0
+TENSOR_TYPE = 1
+TENSOR_BUFFER = 2
+TENSOR_NAME = 3
+TENSOR_IS_VARIABLE = 5
+OPERATOR_INPUTS = 1
+OPERATOR_OUTPUTS = 2
+OPERATOR_INTERMEDIATES = 8
+BUFFER_DATA = 0
+METADATA_NAME = 0
+METADATA_BUFFER = 1
+SIGNATURE_DEF_INPUTS = 0
+SIGNATURE_DEF_OUTPUTS = 1
+SIGNATURE_DEF_SUBGRAPH_INDEX = 4
+TENSOR_MAP_TENSOR_INDEX = 1
+
+
+class Constant(object):
+    """ Constant tensor of a subgraph after packing. """
+
+    def __init__(self, index, name, tensor_type, data, shape):
+        self.index = index
+        self.name = name
+        self.type = tensor_type
+        self.data = data
+        self.shape = shape
+
+
+def read_string(table, index):
+    pos = table._indirect(index)
+    if pos is None:
+        return ''
+    length = struct.unpack_from('<I', table.buf, pos)[0]
+    return bytes(table.buf[pos + 4:pos + 4 + length]).decode('utf-8')
+
+
+def field_pos(table, index):
+    """ Position of a field of a table, or None if the field isn't set. """
+    offset = table._field(index)
+    if offset == 0:
+        return None
+    return table.pos + offset
+
+
+def data_pos(buffer):
+    """ Position of the data of a buffer, or None if it has no data. """
+    pos = buffer._indirect(BUFFER_DATA)
+    if pos is None or struct.unpack_from('<I', buffer.buf, pos)[0] == 0:
+        return None
+    return pos + 4
+
+
+class IndexRemapper(object):
+    """ Renumbers the tensor indices stored in int32 vectors of the model. """
+
+    def __init__(self, data):
+        self.data = data
+        self.remapped = {}
+
+    def remap_vector(self, table, index, subgraph_index, new_index):
+        pos = table._indirect(index)
+        if pos is None:
+            return
+        # Identical vectors may be shared between tables, but must only be
+        # renumbered once.
+        if pos in self.remapped:
+            if self.remapped[pos] != subgraph_index:
+                raise ValueError('tensor index vector shared between '
+                                 'subgraphs')
+            return
+        self.remapped[pos] = subgraph_index
+        length = struct.unpack_from('<I', self.data, pos)[0]
+        for i in range(length):
+            element = pos + 4 + 4 * i
+            tensor_index = struct.unpack_from('<i', self.data, element)[0]
+            # Optional inputs that aren't set are -1.
+            if tensor_index >= 0:
+                struct.pack_into('<i', self.data, element,
+                                 new_index[tensor_index])
+
+
+def is_constant(tensor, buffers):
+    return (not tensor.scalar(TENSOR_IS_VARIABLE, 'B')
+            and data_pos(buffers[tensor.scalar(TENSOR_BUFFER, 'I')])
+            is not None)
+
+
+def sort_tensors(data, subgraph, buffers):
+    """ Moves the constant tensors of a subgraph behind all others.
+
+        Returns the new index of every tensor by its old index.
+    """
+    tensors = subgraph.tables(SUBGRAPH_TENSORS)
+    order = ([i for i, t in enumerate(tensors) if not is_constant(t, buffers)]
+             + [i for i, t in enumerate(tensors) if is_constant(t, buffers)])
+
+    vector = subgraph._indirect(SUBGRAPH_TENSORS)
+    for new, old in enumerate(order):
+        element = vector + 4 + 4 * new
+        offset = tensors[old].pos - element
+        if offset <= 0:
+            raise ValueError('tensor %d is stored before the tensor vector'
+                             % old)
+        struct.pack_into('<I', data, element, offset)
+
+    new_index = [0] * len(order)
+    for new, old in enumerate(order):
+        new_index[old] = new
+    return new_index
+
+
+def remap_offline_plan(data, metadata, buffers, subgraph_index, new_index):
+    """ Reorders the offsets of the offline memory allocation metadata. """
+    for entry in metadata:
+        if read_string(entry, METADATA_NAME) != OFFLINE_MEMORY_ALLOCATION:
+            continue
+        pos = data_pos(buffers[entry.scalar(METADATA_BUFFER, 'I')])
+        if pos is None:
+            continue
+        _, planned_subgraph, count = struct.unpack_from('<iii', data, pos)
+        if planned_subgraph != subgraph_index:
+            continue
+        if count != len(new_index):
+            raise ValueError('offline memory plan has %d tensors, subgraph %d '
+                             'has %d' % (count, subgraph_index,
+                                         len(new_index)))
+        offsets = struct.unpack_from('<%di' % count, data, pos + 12)
+        packed = [0] * count
+        for old, offset in enumerate(offsets):
+            packed[new_index[old]] = offset
+        struct.pack_into('<%di' % count, data, pos + 12, *packed)
+
+
+def remap_signatures(data, model, subgraph_index, new_index):
+    for signature in model.tables(MODEL_SIGNATURE_DEFS):
+        if signature.scalar(SIGNATURE_DEF_SUBGRAPH_INDEX, 'I') != \
+                subgraph_index:
+            continue
+        for tensor_map in (signature.tables(SIGNATURE_DEF_INPUTS)
+                           + signature.tables(SIGNATURE_DEF_OUTPUTS)):
+            old = tensor_map.scalar(TENSOR_MAP_TENSOR_INDEX, 'I')
+            pos = field_pos(tensor_map, TENSOR_MAP_TENSOR_INDEX)
+            if pos is not None:
+                struct.pack_into('<I', data, pos, new_index[old])
+            elif new_index[old] != old:
+                raise ValueError('signature tensor index %d can\'t be '
+                                 'renumbered' % old)
+
+
+def align_constant_data(data, subgraphs, buffers, alignment):
+    """ Moves the misaligned data of constant tensors to the end.
+
+        Returns the number of moved buffers.
+    """
+    moved = set()
+    for subgraph in subgraphs:
+        tensors = subgraph.tables(SUBGRAPH_TENSORS)
+        # Buffers in the order the operators read them.
+        for operator in subgraph.tables(SUBGRAPH_OPERATORS):
+            for tensor_index in operator.vector(OPERATOR_INPUTS, 'i'):
+                if tensor_index < 0:
+                    continue
+                tensor = tensors[tensor_index]
+                buffer_index = tensor.scalar(TENSOR_BUFFER, 'I')
+                buffer = buffers[buffer_index]
+                pos = data_pos(buffer)
+                if (not is_constant(tensor, buffers) or buffer_index in moved
+                        or pos % alignment == 0):
+                    continue
+                length = struct.unpack_from('<I', data, pos - 4)[0]
+                new_pos = align_up(len(data) + 4, alignment)
+                data.extend(bytes(new_pos - len(data)))
+                data.extend(data[pos:pos + length])
+                struct.pack_into('<I', data, new_pos - 4, length)
+                pointer = field_pos(buffer, BUFFER_DATA)
+                struct.pack_into('<I', data, pointer, new_pos - 4 - pointer)
+                moved.add(buffer_index)
+    return len(moved)
+
+
+def pack_model(data, alignment):
+    """ Packs the model in place, returns the constants of every subgraph. """
+    model = Table(data, struct.unpack_from('<I', data, 0)[0])
+    subgraphs = model.tables(MODEL_SUBGRAPHS)
+    buffers = model.tables(MODEL_BUFFERS)
+    metadata = model.tables(MODEL_METADATA)
+    remapper = IndexRemapper(data)
+
+    for subgraph_index, subgraph in enumerate(subgraphs):
+        new_index = sort_tensors(data, subgraph, buffers)
+        remapper.remap_vector(subgraph, SUBGRAPH_INPUTS, subgraph_index,
+                              new_index)
+        remapper.remap_vector(subgraph, SUBGRAPH_OUTPUTS, subgraph_index,
+                              new_index)
+        for operator in subgraph.tables(SUBGRAPH_OPERATORS):
+            for field in (OPERATOR_INPUTS, OPERATOR_OUTPUTS,
+                          OPERATOR_INTERMEDIATES):
+                remapper.remap_vector(operator, field, subgraph_index,
+                                      new_index)
+        remap_signatures(data, model, subgraph_index, new_index)
+        remap_offline_plan(data, metadata, buffers, subgraph_index, new_index)
+
+    moved = align_constant_data(data, subgraphs, buffers, alignment)
+
+    # Read the constants back from the packed model.
+    model = Table(data, struct.unpack_from('<I', data, 0)[0])
+    buffers = model.tables(MODEL_BUFFERS)
+    constants = []
+    for subgraph in model.tables(MODEL_SUBGRAPHS):
+        subgraph_constants = []
+        tensors = subgraph.tables(SUBGRAPH_TENSORS)
+        for index, tensor in enumerate(tensors):
+            if not is_constant(tensor, buffers):
+                if subgraph_constants:
+                    raise AssertionError('tensor %d follows the constants'
+                                         % index)
+                continue
+            tensor_type = tensor.scalar(TENSOR_TYPE, 'b')
+            if tensor_type not in TENSOR_TYPE_NAMES:
+                raise ValueError('tensor %d has unsupported type %d'
+                                 % (index, tensor_type))
+            subgraph_constants.append(Constant(
+                index, read_string(tensor, TENSOR_NAME),
+                TENSOR_TYPE_NAMES[tensor_type],
+                data_pos(buffers[tensor.scalar(TENSOR_BUFFER, 'I')]),
+                tensor._indirect(TENSOR_SHAPE)))
+        constants.append((len(tensors), subgraph_constants))
+    return constants, moved
+
+
+def write_model(path_base, name, model_path, data, constants):
+    guard = re.sub(r'\W', '_', os.path.basename(path_base)).upper() + '_H_'
+    header = os.path.basename(path_base) + '.h'
+    array = 'g_%s_model_data' % name
+    generated = ('// Generated by model_packer.py from %s.\n'
+                 '// Do not edit, regenerate whenever the model changes.\n'
+                 % os.path.basename(model_path))
+
+    with open(path_base + '.h', 'w') as f:
+        f.write(generated)
+        f.write('\n#ifndef %s\n#define %s\n\n' % (guard, guard))
+        f.write('#include <cstdint>\n\n')
+        f.write('#include "tensorflow/lite/micro/constant_tensor_table.h"\n\n')
+        f.write('extern const unsigned int %s_size;\n' % array)
+        f.write('extern const unsigned char %s[];\n\n' % array)
+        f.write('// Eval tensors of the constant tensors of the model, for\n'
+                '// tflite::MicroInterpreter::SetConstantTensorTable().\n')
+        f.write('extern const tflite::ConstantTensorTable '
+                'g_%s_constant_tensors;\n\n' % name)
+        f.write('#endif  // %s\n' % guard)
+
+    with open(path_base + '.cc', 'w') as f:
+        f.write(generated)
+        f.write('\n#include "%s"\n\n' % header)
+        f.write('const unsigned int %s_size = %d;\n' % (array, len(data)))
+        f.write('alignas(%d) const unsigned char %s[] = {\n'
+                % (MODEL_ALIGNMENT, array))
+        for i in range(0, len(data), 12):
+            f.write('    %s,\n' % ', '.join('0x%02x' % b
+                                            for b in data[i:i + 12]))
+        f.write('};\n\n')
+
+        f.write('namespace {\n\n')
+        if any(c.shape is None for _, sc in constants for c in sc):
+            f.write('const TfLiteIntArray kScalarDims = {};\n\n')
+        for subgraph_index, (_, subgraph_constants) in enumerate(constants):
+            if not subgraph_constants:
+                continue
+            f.write('const TfLiteEvalTensor kSubgraph%dTensors[] = {\n'
+                    % subgraph_index)
+            for c in subgraph_constants:
+                if c.shape is None:
+                    dims = 'const_cast<TfLiteIntArray*>(&kScalarDims)'
+                else:
+                    dims = ('reinterpret_cast<TfLiteIntArray*>(\n'
+                            '         const_cast<unsigned char*>(&%s[%d])'
+                            ')' % (array, c.shape))
+                f.write('    // Tensor %d: %s\n' % (c.index, c.name))
+                f.write('    {{reinterpret_cast<int32_t*>(\n'
+                        '         const_cast<unsigned char*>(&%s[%d]))},\n'
+                        '     %s,\n'
+                        '     %s},\n' % (array, c.data, dims, c.type))
+            f.write('};\n\n')
+        f.write('const tflite::ConstantSubgraphTensors kSubgraphs[] = {\n')
+        for subgraph_index, (tensor_count, subgraph_constants) in \
+                enumerate(constants):
+            f.write('    {%d, %d, %s},\n'
+                    % (tensor_count - len(subgraph_constants),
+                       len(subgraph_constants),
+                       'kSubgraph%dTensors' % subgraph_index
+                       if subgraph_constants else 'nullptr'))
+        f.write('};\n\n')
+        f.write('}  // namespace\n\n')
+        f.write('const tflite::ConstantTensorTable g_%s_constant_tensors = {\n'
+                '    %d, kSubgraphs};\n' % (name, len(constants)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('--model', required=True,
+                        help='.tflite file or C source with the model array')
+    parser.add_argument('--name', required=True,
+                        help='model name used in the generated symbols')
+    parser.add_argument('--output-dir', default='.',
+                        help='directory of the generated <name>_model_data.cc/.h')
+    parser.add_argument('--alignment', type=int, default=4,
+                        help='alignment of the constant tensor data in bytes')
+    parser.add_argument('--version', action='version', version=__version__)
+    args = parser.parse_args()
+
+    if args.alignment <= 0 or MODEL_ALIGNMENT % args.alignment != 0:
+        parser.error('--alignment must divide %d' % MODEL_ALIGNMENT)
+
+    data = bytearray(read_model(args.model))
+    size = len(data)
+    constants, moved = pack_model(data, args.alignment)
+
+    write_model(os.path.join(args.output_dir, args.name + '_model_data'),
+                args.name, args.model, data, constants)
+
+    count = sum(len(c) for _, c in constants)
+    print('%d constant tensors, %d bytes of eval tensors less in the arena, '
+          '%d buffers realigned, model %d -> %d bytes'
+          % (count, EVAL_TENSOR_SIZE * count, moved, size, len(data)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
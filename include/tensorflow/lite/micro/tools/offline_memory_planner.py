@@ -0,0 +1,555 @@
+#!/usr/bin/env python3
+""" Offline memory planner for TFLM models.
+
+    Computes the arena offsets of all non-persistent buffers of a model on the
+    host and writes them as a C++ source file with a tflite::BufferPlan. The
+    firmware passes the plan to tflite::NonPersistentMemoryPlannerShim, so
+    AllocateTensors() neither runs the GreedyMemoryPlanner nor needs planner
+    scratch memory in the tensor arena.
+
+    Buffers are derived from the model the same way as in
+    MicroAllocator::CommitStaticMemoryPlan(): every tensor without constant data
+    that is not a variable, in tensor order, followed by the scratch buffers
+    requested by the kernels in the order of their requests. Outputs that the
+    kernel writes in place of a dead input (see TfLiteRegistration::
+    inplace_operator) share the buffer of that input. Scratch buffers depend on
+    the kernel implementation and must be given with --scratch.
+
+    The layout is searched with the branch-and-bound search of
+    tflite::BranchAndBoundMemoryPlanner, with a larger step budget than on the
+    device, followed by first fit over randomly perturbed placement orders.
+    The plan is stored in flash by the firmware, so the search costs neither
+    boot time nor planner scratch memory.
+
+    The plan also records the size and lifetime of every buffer, which the shim
+    checks against the actual requests, so a stale plan fails AllocateTensors()
+    instead of corrupting memory.
+
+    Prerequisites:
+    - installed Python, version >=3.4
+
+    Example:
+    offline_memory_planner.py --model hello_world_model_data.cc \\
+        --name hello_world --output-dir include/tinyml
+"""
+
+__version__ = '1.1.0'
+
+import argparse
+import os
+import random
+import re
+import struct
+import sys
+
+
+# Buffer alignment, see MicroArenaBufferAlignment().
+ARENA_BUFFER_ALIGNMENT = 16
+
+# Element sizes of tflite::TensorType values, see TfLiteTypeSizeOf().
+TENSOR_TYPE_SIZES = {
+    0: 4,   # FLOAT32
+    1: 2,   # FLOAT16
+    2: 4,   # INT32
+    3: 1,   # UINT8
+    4: 8,   # INT64
+    6: 1,   # BOOL
+    7: 2,   # INT16
+    8: 8,   # COMPLEX64
+    9: 1,   # INT8
+    10: 8,  # FLOAT64
+    11: 16, # COMPLEX128
+    12: 8,  # UINT64
+    13: 4,  # RESOURCE
+    15: 4,  # UINT32
+}
+
+# Inputs that the output of a builtin operator may share its buffer with, see
+# the inplace_operator of the kernel registrations.
+INPLACE_OPERATORS = {
+    0: (0, 1),  # ADD
+    19: (0,),   # RELU
+    21: (0,),   # RELU6
+    22: (0,),   # RESHAPE
+    114: (0,),  # QUANTIZE
+}
+
+# Field indices of the tflite schema tables used below.
+MODEL_OPERATOR_CODES = 1
+MODEL_SUBGRAPHS = 2
+MODEL_BUFFERS = 4
+SUBGRAPH_TENSORS = 0
+SUBGRAPH_INPUTS = 1
+SUBGRAPH_OUTPUTS = 2
+SUBGRAPH_OPERATORS = 3
+TENSOR_SHAPE = 0
+TENSOR_TYPE = 1
+TENSOR_BUFFER = 2
+TENSOR_IS_VARIABLE = 5
+OPERATOR_OPCODE_INDEX = 0
+OPERATOR_INPUTS = 1
+OPERATOR_OUTPUTS = 2
+BUFFER_DATA = 0
+OPERATOR_CODE_DEPRECATED_BUILTIN_CODE = 0
+OPERATOR_CODE_BUILTIN_CODE = 3
+
+
+class Table(object):
+    """ Read-only view of a flatbuffer table. """
+
+    def __init__(self, buf, pos):
+        self.buf = buf
+        self.pos = pos
+        self.vtable = pos - struct.unpack_from('<i', buf, pos)[0]
+        self.vtable_size = struct.unpack_from('<H', buf, self.vtable)[0]
+
+    def _field(self, index):
+        entry = 4 + 2 * index
+        if entry >= self.vtable_size:
+            return 0
+        return struct.unpack_from('<H', self.buf, self.vtable + entry)[0]
+
+    def scalar(self, index, fmt, default=0):
+        offset = self._field(index)
+        if offset == 0:
+            return default
+        return struct.unpack_from('<' + fmt, self.buf, self.pos + offset)[0]
+
+    def _indirect(self, index):
+        offset = self._field(index)
+        if offset == 0:
+            return None
+        pos = self.pos + offset
+        return pos + struct.unpack_from('<I', self.buf, pos)[0]
+
+    def vector(self, index, fmt):
+        pos = self._indirect(index)
+        if pos is None:
+            return []
+        length = struct.unpack_from('<I', self.buf, pos)[0]
+        return list(struct.unpack_from('<%d%s' % (length, fmt), self.buf,
+                                       pos + 4))
+
+    def vector_length(self, index):
+        pos = self._indirect(index)
+        if pos is None:
+            return 0
+        return struct.unpack_from('<I', self.buf, pos)[0]
+
+    def tables(self, index):
+        pos = self._indirect(index)
+        if pos is None:
+            return []
+        length = struct.unpack_from('<I', self.buf, pos)[0]
+        result = []
+        for i in range(length):
+            element = pos + 4 + 4 * i
+            result.append(Table(self.buf, element
+                                + struct.unpack_from('<I', self.buf, element)[0]))
+        return result
+
+
+class Buffer(object):
+    """ Non-persistent buffer to be placed in the arena. """
+
+    def __init__(self, name, size, first_time_used, last_time_used):
+        self.name = name
+        self.size = size
+        self.bytes = size
+        self.first_time_used = first_time_used
+        self.last_time_used = last_time_used
+
+    def overlaps_in_time(self, other):
+        return (self.first_time_used <= other.last_time_used
+                and other.first_time_used <= self.last_time_used)
+
+
+def align_up(value, alignment):
+    return (value + alignment - 1) // alignment * alignment
+
+
+def read_model(path):
+    """ Reads a .tflite file, or the first byte array of a C/C++ source. """
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[4:8] == b'TFL3':
+        return data
+
+    text = data.decode('utf-8', 'replace')
+    array = re.search(r'\[\s*\]\s*=\s*\{([^}]*)\}', text)
+    if array is None:
+        raise ValueError('%s is neither a .tflite file nor a C array' % path)
+    return bytes(bytearray(int(x, 0) for x in
+                           re.findall(r'0x[0-9a-fA-F]+|\d+', array.group(1))))
+
+
+def get_buffers(model_data, subgraph_index, scratch):
+    """ Returns the buffers planned by MicroAllocator in request order. """
+    model = Table(model_data, struct.unpack_from('<I', model_data, 0)[0])
+    subgraph = model.tables(MODEL_SUBGRAPHS)[subgraph_index]
+    model_buffers = model.tables(MODEL_BUFFERS)
+    tensors = subgraph.tables(SUBGRAPH_TENSORS)
+    operators = subgraph.tables(SUBGRAPH_OPERATORS)
+
+    first_created = [-1] * len(tensors)
+    last_used = [-1] * len(tensors)
+
+    for index in subgraph.vector(SUBGRAPH_INPUTS, 'i'):
+        first_created[index] = 0
+    for index in subgraph.vector(SUBGRAPH_OUTPUTS, 'i'):
+        last_used[index] = len(operators) - 1
+    for i in reversed(range(len(operators))):
+        for index in operators[i].vector(OPERATOR_INPUTS, 'i'):
+            if index >= 0 and last_used[index] < i:
+                last_used[index] = i
+        for index in operators[i].vector(OPERATOR_OUTPUTS, 'i'):
+            if first_created[index] == -1 or first_created[index] > i:
+                first_created[index] = i
+            if last_used[index] < i:
+                last_used[index] = i
+
+    tensor_buffers = {}
+    for i, tensor in enumerate(tensors):
+        buffer_index = tensor.scalar(TENSOR_BUFFER, 'I')
+        has_data = (buffer_index < len(model_buffers) and
+                    model_buffers[buffer_index].vector_length(BUFFER_DATA) > 0)
+        if has_data or tensor.scalar(TENSOR_IS_VARIABLE, 'B'):
+            continue
+
+        tensor_type = tensor.scalar(TENSOR_TYPE, 'b')
+        if tensor_type not in TENSOR_TYPE_SIZES:
+            raise ValueError('Tensor %d has unsupported type %d'
+                             % (i, tensor_type))
+        size = TENSOR_TYPE_SIZES[tensor_type]
+        for dim in tensor.vector(TENSOR_SHAPE, 'i'):
+            size *= dim
+        tensor_buffers[i] = Buffer('tensor %d' % i,
+                                   align_up(size, ARENA_BUFFER_ALIGNMENT),
+                                   first_created[i], last_used[i])
+        tensor_buffers[i].bytes = size
+
+    # Same rules as AllocationInfoBuilder::AddInPlaceOutputs().
+    graph_tensors = set(subgraph.vector(SUBGRAPH_INPUTS, 'i') +
+                        subgraph.vector(SUBGRAPH_OUTPUTS, 'i'))
+    operator_codes = model.tables(MODEL_OPERATOR_CODES)
+    owners = {}
+    for i, op in enumerate(operators):
+        code = operator_codes[op.scalar(OPERATOR_OPCODE_INDEX, 'I')]
+        builtin_code = max(
+            code.scalar(OPERATOR_CODE_DEPRECATED_BUILTIN_CODE, 'b'),
+            code.scalar(OPERATOR_CODE_BUILTIN_CODE, 'i'))
+        outputs = op.vector(OPERATOR_OUTPUTS, 'i')
+        if (builtin_code not in INPLACE_OPERATORS or not outputs
+                or outputs[0] not in tensor_buffers):
+            continue
+        output = tensor_buffers[outputs[0]]
+        inputs = op.vector(OPERATOR_INPUTS, 'i')
+        for n in INPLACE_OPERATORS[builtin_code]:
+            if n >= len(inputs) or inputs[n] < 0:
+                continue
+            owner_index = owners.get(inputs[n], inputs[n])
+            owner = tensor_buffers.get(owner_index)
+            if (owner is None or owner.last_time_used != i
+                    or owner.bytes < output.bytes
+                    or inputs[n] in graph_tensors
+                    or owner_index in graph_tensors):
+                continue
+            owners[outputs[0]] = owner_index
+            owner.last_time_used = max(owner.last_time_used,
+                                       output.last_time_used)
+            break
+
+    buffers = [tensor_buffers[i] for i in sorted(tensor_buffers)
+               if i not in owners]
+
+    for i, (size, node) in enumerate(scratch):
+        buffers.append(Buffer('scratch %d' % i,
+                              align_up(size, ARENA_BUFFER_ALIGNMENT),
+                              node, node))
+    return buffers
+
+
+def place(buffers, order):
+    """ Places buffers in the given order at the lowest offset that fits. """
+    offsets = [None] * len(buffers)
+    for i in order:
+        active = sorted((offsets[j], buffers[j].size) for j in range(len(buffers))
+                        if offsets[j] is not None
+                        and buffers[i].overlaps_in_time(buffers[j]))
+        candidate = 0
+        for offset, size in active:
+            if offset - candidate >= buffers[i].size:
+                break
+            candidate = max(candidate, offset + size)
+        offsets[i] = candidate
+    return offsets
+
+
+def plan_size(buffers, offsets):
+    return max([o + b.size for o, b in zip(offsets, buffers)] or [0])
+
+
+def lower_bound(buffers):
+    """ Largest total size of the buffers alive at the same time. """
+    times = set(b.first_time_used for b in buffers)
+    return max([sum(b.size for b in buffers
+                    if b.first_time_used <= t <= b.last_time_used)
+                for t in times] or [0])
+
+
+def greedy_order(buffers):
+    """ Placement order of GreedyMemoryPlanner, largest buffers first and
+        buffers of equal size in descending index.
+    """
+    return sorted(range(len(buffers)), key=lambda i: (-buffers[i].size, -i))
+
+
+def branch_and_bound(buffers, max_search_steps):
+    """ Search of BranchAndBoundMemoryPlanner::CalculateOffsetsIfNeeded().
+
+        Returns the offsets and the placement order of the best layout found
+        within max_search_steps first fit placements. The first layout is
+        the greedy one, so the result is never worse.
+    """
+    count = len(buffers)
+    if count == 0:
+        return [], []
+
+    # The first search path is the greedy order.
+    ids = greedy_order(buffers)
+    offsets = [None] * count
+    steps = [0]
+
+    def first_fit(i):
+        steps[0] += 1
+        candidate = 0
+        moved = True
+        while moved:
+            moved = False
+            for j in range(count):
+                if (offsets[j] is not None
+                        and buffers[i].overlaps_in_time(buffers[j])
+                        and candidate < offsets[j] + buffers[j].size
+                        and offsets[j] < candidate + buffers[i].size):
+                    candidate = offsets[j] + buffers[j].size
+                    moved = True
+        return candidate
+
+    def placement_bound(high_water_mark):
+        # Placing more buffers can only move the first fit of the others up.
+        return max([high_water_mark] + [first_fit(i) + buffers[i].size
+                                        for i in range(count)
+                                        if offsets[i] is None])
+
+    bound = lower_bound(buffers)
+    best = None
+    best_offsets = best_order = None
+    order = [0] * count
+    next_child = [0] * count
+    high_water_marks = [0] * count
+    depth = 0
+    while depth >= 0:
+        if best is not None and (best <= bound
+                                 or steps[0] >= max_search_steps):
+            break
+
+        # Consecutive buffers that are not active at the same time are only
+        # tried in sorted order.
+        previous = order[depth - 1] if depth > 0 else -1
+        child = None
+        while next_child[depth] < count:
+            candidate = next_child[depth]
+            next_child[depth] += 1
+            if offsets[ids[candidate]] is not None:
+                continue
+            if candidate < previous and not buffers[ids[candidate]] \
+                    .overlaps_in_time(buffers[ids[previous]]):
+                continue
+            child = candidate
+            break
+
+        if child is None:
+            depth -= 1
+            if depth >= 0:
+                offsets[ids[order[depth]]] = None
+            continue
+
+        i = ids[child]
+        offset = first_fit(i)
+        high_water_mark = max(high_water_marks[depth], offset + buffers[i].size)
+        if best is not None and high_water_mark >= best:
+            continue
+
+        offsets[i] = offset
+        order[depth] = child
+        if depth + 1 == count:
+            best = high_water_mark
+            best_offsets = list(offsets)
+            best_order = [ids[c] for c in order]
+            offsets[i] = None
+            continue
+
+        if best is not None and placement_bound(high_water_mark) >= best:
+            offsets[i] = None
+            continue
+
+        depth += 1
+        next_child[depth] = 0
+        high_water_marks[depth] = high_water_mark
+
+    return best_offsets, best_order
+
+
+def plan_memory(buffers, iterations, seed, max_search_steps):
+    """ Returns the smallest plan found by the branch-and-bound search and by
+        first fit over perturbed orders.
+    """
+    def lifetime(i):
+        return buffers[i].last_time_used - buffers[i].first_time_used + 1
+
+    indices = list(range(len(buffers)))
+    orders = [
+        greedy_order(buffers),
+        sorted(indices, key=lambda i: (-buffers[i].size * lifetime(i))),
+        sorted(indices, key=lambda i: (-lifetime(i), -buffers[i].size)),
+        sorted(indices, key=lambda i: (buffers[i].first_time_used,
+                                       -buffers[i].size)),
+    ]
+
+    bound = lower_bound(buffers)
+    best_offsets, best_order = branch_and_bound(buffers, max_search_steps)
+    best = plan_size(buffers, best_offsets)
+    if best == bound or len(buffers) < 2:
+        return best_offsets
+
+    rng = random.Random(seed)
+    for n in range(len(orders) + iterations):
+        if n < len(orders):
+            order = orders[n]
+        else:
+            # Perturb the best order found so far by swapping a few entries.
+            order = list(best_order)
+            for _ in range(rng.randint(1, 3)):
+                a = rng.randrange(len(order))
+                b = rng.randrange(len(order))
+                order[a], order[b] = order[b], order[a]
+        offsets = place(buffers, order)
+        size = plan_size(buffers, offsets)
+        if size < best:
+            best, best_offsets, best_order = size, offsets, order
+        if best == bound:
+            break
+    return best_offsets
+
+
+def check_plan(buffers, offsets):
+    for i in range(len(buffers)):
+        if offsets[i] < 0 or offsets[i] % ARENA_BUFFER_ALIGNMENT:
+            raise AssertionError('Bad offset of %s' % buffers[i].name)
+        for j in range(i):
+            if (buffers[i].overlaps_in_time(buffers[j])
+                    and offsets[i] < offsets[j] + buffers[j].size
+                    and offsets[j] < offsets[i] + buffers[i].size):
+                raise AssertionError('%s overlaps %s'
+                                     % (buffers[i].name, buffers[j].name))
+
+
+def write_plan(path_base, name, model_path, buffers, offsets):
+    guard = re.sub(r'\W', '_', os.path.basename(path_base)).upper() + '_H_'
+    header = os.path.basename(path_base) + '.h'
+    generated = ('// Generated by offline_memory_planner.py from %s.\n'
+                 '// Do not edit, regenerate whenever the model changes.\n'
+                 % os.path.basename(model_path))
+
+    with open(path_base + '.h', 'w') as f:
+        f.write(generated)
+        f.write('\n#ifndef %s\n#define %s\n\n' % (guard, guard))
+        f.write('#include "tensorflow/lite/micro/memory_planner/'
+                'memory_plan_struct.h"\n\n')
+        f.write('// Arena offsets of the non-persistent buffers, for\n'
+                '// tflite::NonPersistentMemoryPlannerShim.\n')
+        f.write('extern const tflite::BufferPlan* const g_%s_memory_plan;\n\n'
+                % name)
+        f.write('// Size and lifetime each buffer of the plan was laid out for.\n')
+        f.write('extern const tflite::BufferUsage g_%s_memory_plan_usage[];\n\n'
+                % name)
+        f.write('// Bytes of the arena head used by the plan.\n')
+        f.write('constexpr int k%sMemoryPlanSize = %d;\n\n'
+                % (''.join(w.capitalize() for w in name.split('_')),
+                   plan_size(buffers, offsets)))
+        f.write('#endif  // %s\n' % guard)
+
+    with open(path_base + '.cc', 'w') as f:
+        f.write(generated)
+        f.write('\n#include "%s"\n\n' % header)
+        f.write('namespace {\n\n')
+        f.write('struct PlanStorage {\n'
+                '  int32_t buffer_count;\n'
+                '  tflite::BufferDescriptor buffer_plan_entries[%d];\n'
+                '};\n\n' % max(len(buffers), 1))
+        f.write('const PlanStorage kPlan = {\n    %d,\n    {\n' % len(buffers))
+        for buffer, offset in zip(buffers, offsets):
+            f.write('        {%d},  // %s\n' % (offset, buffer.name))
+        f.write('    }};\n\n')
+        f.write('}  // namespace\n\n')
+        f.write('const tflite::BufferPlan* const g_%s_memory_plan =\n'
+                '    reinterpret_cast<const tflite::BufferPlan*>(&kPlan);\n\n'
+                % name)
+        f.write('const tflite::BufferUsage g_%s_memory_plan_usage[] = {\n'
+                % name)
+        for buffer in buffers:
+            f.write('    {%d, %d, %d},  // %s\n'
+                    % (buffer.size, buffer.first_time_used,
+                       buffer.last_time_used, buffer.name))
+        if not buffers:
+            f.write('    {0, 0, 0},\n')
+        f.write('};\n')
+
+
+def parse_scratch(text):
+    match = re.match(r'^(\d+)@(\d+)$', text)
+    if match is None:
+        raise argparse.ArgumentTypeError('expected BYTES@NODE, got %s' % text)
+    return int(match.group(1)), int(match.group(2))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('--model', required=True,
+                        help='.tflite file or C source with the model array')
+    parser.add_argument('--name', required=True,
+                        help='model name used in the generated symbols')
+    parser.add_argument('--output-dir', default='.',
+                        help='directory of the generated <name>_memory_plan.cc/.h')
+    parser.add_argument('--subgraph', type=int, default=0)
+    parser.add_argument('--scratch', type=parse_scratch, action='append',
+                        default=[], metavar='BYTES@NODE',
+                        help='scratch buffer requested by the kernel of a node,'
+                        ' in request order')
+    parser.add_argument('--max-search-steps', type=int, default=200000,
+                        help='first fit placements of the branch-and-bound '
+                        'search')
+    parser.add_argument('--iterations', type=int, default=2000,
+                        help='placement orders to try after the search and '
+                        'the heuristics')
+    parser.add_argument('--seed', type=int, default=1)
+    parser.add_argument('--version', action='version', version=__version__)
+    args = parser.parse_args()
+
+    buffers = get_buffers(read_model(args.model), args.subgraph, args.scratch)
+    greedy = plan_size(buffers, place(buffers, greedy_order(buffers)))
+    offsets = plan_memory(buffers, args.iterations, args.seed,
+                          args.max_search_steps)
+    check_plan(buffers, offsets)
+
+    write_plan(os.path.join(args.output_dir, args.name + '_memory_plan'),
+               args.name, args.model, buffers, offsets)
+
+    print('%d buffers, plan %d bytes, greedy %d bytes, lower bound %d bytes'
+          % (len(buffers), plan_size(buffers, offsets), greedy,
+             lower_bound(buffers)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
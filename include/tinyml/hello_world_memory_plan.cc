@@ -0,0 +1,32 @@
+// Generated by offline_memory_planner.py from hello_world_model_data.cc.
+// Do not edit, regenerate whenever the model changes.
+
+#include "hello_world_memory_plan.h"
+
+namespace {
+
+struct PlanStorage {
+  int32_t buffer_count;
+  tflite::BufferDescriptor buffer_plan_entries[4];
+};
+
+const PlanStorage kPlan = {
+    4,
+    {
+        {16},  // tensor 0
+        {0},  // tensor 1
+        {16},  // tensor 2
+        {0},  // tensor 3
+    }};
+
+}  // namespace
+
+const tflite::BufferPlan* const g_hello_world_memory_plan =
+    reinterpret_cast<const tflite::BufferPlan*>(&kPlan);
+
+const tflite::BufferUsage g_hello_world_memory_plan_usage[] = {
+    {16, 0, 0},  // tensor 0
+    {16, 0, 1},  // tensor 1
+    {16, 1, 2},  // tensor 2
+    {16, 2, 2},  // tensor 3
+};
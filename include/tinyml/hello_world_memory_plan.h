@@ -0,0 +1,19 @@
+// Generated by offline_memory_planner.py from hello_world_model_data.cc.
+// Do not edit, regenerate whenever the model changes.
+
+#ifndef HELLO_WORLD_MEMORY_PLAN_H_
+#define HELLO_WORLD_MEMORY_PLAN_H_
+
+#include "tensorflow/lite/micro/memory_planner/memory_plan_struct.h"
+
+// Arena offsets of the non-persistent buffers, for
+// tflite::NonPersistentMemoryPlannerShim.
+extern const tflite::BufferPlan* const g_hello_world_memory_plan;
+
+// Size and lifetime each buffer of the plan was laid out for.
+extern const tflite::BufferUsage g_hello_world_memory_plan_usage[];
+
+// Bytes of the arena head used by the plan.
+constexpr int kHelloWorldMemoryPlanSize = 32;
+
+#endif  // HELLO_WORLD_MEMORY_PLAN_H_
@@ -1,5 +1,251 @@
-#include <cstdint>
+// Generated by model_packer.py from hello_world_model_data.cc.
+// Do not edit, regenerate whenever the model changes.
 
 #include "hello_world_model_data.h"
 
-const unsigned int g_hello_world_model_data_size = 2312;alignas(16) const unsigned char g_hello_world_model_data[] = {0x20,0x00,0x00,0x00,0x54,0x46,0x4c,0x33,0x00,0x00,0x00,0x00,0x14,0x00,0x20,0x00,0x1c,0x00,0x18,0x00,0x14,0x00,0x10,0x00,0x0c,0x00,0x00,0x00,0x08,0x00,0x04,0x00,0x14,0x00,0x00,0x00,0x1c,0x00,0x00,0x00,0x1c,0x00,0x00,0x00,0x4c,0x00,0x00,0x00,0xa0,0x02,0x00,0x00,0xb0,0x02,0x00,0x00,0xac,0x08,0x00,0x00,0x03,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x0c,0x00,0x00,0x00,0x08,0x00,0x0c,0x00,0x08,0x00,0x04,0x00,0x08,0x00,0x00,0x00,0x0b,0x00,0x00,0x00,0x04,0x00,0x00,0x00,0x13,0x00,0x00,0x00,0x6d,0x69,0x6e,0x5f,0x72,0x75,0x6e,0x74,0x69,0x6d,0x65,0x5f,0x76,0x65,0x72,0x73,0x69,0x6f,0x6e,0x00,0x0c,0x00,0x00,0x00,0x50,0x02,0x00,0x00,0x48,0x02,0x00,0x00,0x28,0x02,0x00,0x00,0xd0,0x01,0x00,0x00,0xc0,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0x3c,0x00,0x00,0x00,0x34,0x00,0x00,0x00,0x2c,0x00,0x00,0x00,0x24,0x00,0x00,0x00,0x04,0x00,0x00,0x00,0x06,0xfe,0xff,0xff,0x04,0x00,0x00,0x00,0x10,0x00,0x00,0x00,0x31,0x2e,0x31,0x34,0x2e,0x30,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x84,0xfd,0xff,0xff,0x88,0xfd,0xff,0xff,0x8c,0xfd,0xff,0xff,0x2e,0xfe,0xff,0xff,0x04,0x00,0x00,0x00,0x04,0x00,0x00,0x00,0x8c,0xef,0xff,0xff,0x3e,0xfe,0xff,0xff,0x04,0x00,0x00,0x00,0x10,0x00,0x00,0x00,0x21,0xa5,0x8b,0xca,0x5e,0x1d,0xce,0x42,0x9d,0xce,0x1f,0xb0,0xdf,0x54,0x2f,0x81,0x5a,0xfe,0xff,0xff,0x04,0x00,0x00,0x00,0x40,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xb5,0x04,0x00,0x00,0x78,0x0a,0x00,0x00,0x2d,0x06,0x00,0x00,0x71,0xf8,0xff,0xff,0x00,0x00,0x00,0x00,0x99,0x0a,0x00,0x00,0xfe,0xf7,0xff,0xff,0x0f,0x05,0x00,0x00,0xd4,0x09,0x00,0x00,0x47,0xfe,0xff,0xff,0xb6,0x04,0x00,0x00,0x00,0x00,0x00,0x00,0xac,0xf7,0xff,0xff,0x4b,0xf9,0xff,0xff,0x4a,0x05,0x00,0x00,0xa6,0xfe,0xff,0xff,0x04,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0xee,0xfc,0x00,0xec,0x05,0x17,0xef,0xec,0xe6,0xf8,0x03,0x01,0x00,0xfa,0xf8,0xf5,0xdc,0xeb,0x27,0x14,0xf1,0xde,0xe2,0xdb,0xf0,0xde,0x31,0x06,0x02,0xe6,0xee,0xf9,0x00,0x16,0x07,0xe0,0xfe,0xff,0xe9,0x06,0xe7,0xef,0x81,0x1b,0x18,0xea,0xc9,0x01,0x0f,0x00,0xda,0xf7,0x0e,0xec,0x13,0x1f,0x04,0x13,0xb4,0xe6,0xfd,0x06,0xb9,0xe0,0x0d,0xec,0xf0,0xde,0xeb,0xf7,0x05,0x26,0x1a,0xe4,0x6f,0x1a,0xea,0x1e,0x35,0xdf,0x1a,0xf3,0xf1,0x19,0x0f,0x03,0x1b,0xe1,0xde,0x13,0xf6,0x19,0xff,0xf6,0x1b,0x18,0xf0,0x1c,0xda,0x1b,0x1b,0x20,0xe5,0x1a,0xf5,0xff,0x96,0x0b,0x00,0x01,0xcd,0xde,0x0d,0xf6,0x16,0xe3,0xed,0xfc,0x0e,0xe9,0xfa,0xeb,0x5c,0xfc,0x1d,0x02,0x5b,0xe2,0xe1,0xf5,0x15,0xec,0xf4,0x00,0x13,0x05,0xec,0x0c,0x1d,0x14,0x0e,0xe7,0x0b,0xf4,0x19,0x00,0xd7,0x05,0x27,0x02,0x15,0xea,0xea,0x02,0x9b,0x00,0x0c,0xfa,0xe8,0xea,0xfd,0x00,0x14,0xfd,0x0b,0x02,0xef,0xee,0x06,0xee,0x01,0x0d,0x06,0xe6,0xf7,0x11,0xf7,0x09,0xf8,0xf1,0x21,0xff,0x0e,0xf3,0xec,0x12,0x26,0x1d,0xf2,0xe9,0x28,0x18,0xe0,0xfb,0xf3,0xf4,0x05,0x1d,0x1d,0xfb,0xfd,0x1e,0xfc,0x11,0xe8,0x07,0x09,0x03,0x12,0xf2,0x36,0xfb,0xdc,0x1c,0xf9,0xef,0xf3,0xe7,0x6f,0x0c,0x1d,0x00,0x45,0xfd,0x0e,0xf0,0x0b,0x19,0x1a,0xfa,0xe0,0x19,0x1f,0x13,0x36,0x1c,0x12,0xeb,0x3b,0x0c,0xb4,0xcb,0xe6,0x13,0xfa,0xeb,0xf1,0x06,0x1c,0xfa,0x18,0xe5,0xeb,0xcb,0x0c,0xf4,0xb2,0xff,0xff,0xff,0x04,0x00,0x00,0x00,0x40,0x00,0x00,0x00,0x06,0x00,0x00,0x00,0x77,0x0b,0x00,0x00,0x53,0xf6,0xff,0xff,0x00,0x00,0x00,0x00,0x77,0x0c,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xd3,0x06,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x72,0x21,0x00,0x00,0x00,0x00,0x00,0x00,0x2f,0x07,0x00,0x00,0x67,0xf5,0xff,0xff,0x34,0xf0,0xff,0xff,0x00,0x00,0x00,0x00,0x00,0x00,0x06,0x00,0x08,0x00,0x04,0x00,0x06,0x00,0x00,0x00,0x04,0x00,0x00,0x00,0x10,0x00,0x00,0x00,0x75,0x1c,0x11,0xe1,0x0c,0x81,0xa5,0x42,0xfe,0xd5,0xd4,0xb2,0x61,0x78,0x19,0xdf,0x84,0xff,0xff,0xff,0x88,0xff,0xff,0xff,0x0f,0x00,0x00,0x00,0x4d,0x4c,0x49,0x52,0x20,0x43,0x6f,0x6e,0x76,0x65,0x72,0x74,0x65,0x64,0x2e,0x00,0x01,0x00,0x00,0x00,0x14,0x00,0x00,0x00,0x00,0x00,0x0e,0x00,0x18,0x00,0x14,0x00,0x10,0x00,0x0c,0x00,0x08,0x00,0x04,0x00,0x0e,0x00,0x00,0x00,0x14,0x00,0x00,0x00,0x1c,0x00,0x00,0x00,0xdc,0x00,0x00,0x00,0xe0,0x00,0x00,0x00,0xe4,0x00,0x00,0x00,0x04,0x00,0x00,0x00,0x6d,0x61,0x69,0x6e,0x00,0x00,0x00,0x00,0x03,0x00,0x00,0x00,0x84,0x00,0x00,0x00,0x3c,0x00,0x00,0x00,0x04,0x00,0x00,0x00,0x96,0xff,0xff,0xff,0x14,0x00,0x00,0x00,0x00,0x00,0x00,0x08,0x10,0x00,0x00,0x00,0x14,0x00,0x00,0x00,0x04,0x00,0x04,0x00,0x04,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x09,0x00,0x00,0x00,0x03,0x00,0x00,0x00,0x08,0x00,0x00,0x00,0x05,0x00,0x00,0x00,0x06,0x00,0x00,0x00,0xca,0xff,0xff,0xff,0x10,0x00,0x00,0x00,0x00,0x00,0x00,0x08,0x10,0x00,0x00,0x00,0x14,0x00,0x00,0x00,0xba,0xff,0xff,0xff,0x00,0x00,0x00,0x01,0x01,0x00,0x00,0x00,0x08,0x00,0x00,0x00,0x03,0x00,0x00,0x00,0x07,0x00,0x00,0x00,0x03,0x00,0x00,0x00,0x04,0x00,0x00,0x00,0x00,0x00,0x0e,0x00,0x16,0x00,0x00,0x00,0x10,0x00,0x0c,0x00,0x0b,0x00,0x04,0x00,0x0e,0x00,0x00,0x00,0x18,0x00,0x00,0x00,0x00,0x00,0x00,0x08,0x18,0x00,0x00,0x00,0x1c,0x00,0x00,0x00,0x00,0x00,0x06,0x00,0x08,0x00,0x07,0x00,0x06,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x01,0x00,0x00,0x00,0x07,0x00,0x00,0x00,0x03,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x09,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x0a,0x00,0x00,0x00,0x64,0x04,0x00,0x00,0xe4,0x03,0x00,0x00,0x78,0x03,0x00,0x00,0x0c,0x03,0x00,0x00,0xb0,0x02,0x00,0x00,0x44,0x02,0x00,0x00,0xe8,0x01,0x00,0x00,0x34,0x01,0x00,0x00,0x80,0x00,0x00,0x00,0x04,0x00,0x00,0x00,0xd8,0xfb,0xff,0xff,0x18,0x00,0x00,0x00,0x20,0x00,0x00,0x00,0x40,0x00,0x00,0x00,0x0a,0x00,0x00,0x00,0x00,0x00,0x00,0x09,0x54,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0xff,0xff,0xff,0xff,0x01,0x00,0x00,0x00,0xc4,0xfb,0xff,0xff,0x08,0x00,0x00,0x00,0x14,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x04,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x2c,0xce,0x0a,0x3c,0x19,0x00,0x00,0x00,0x53,0x74,0x61,0x74,0x65,0x66,0x75,0x6c,0x50,0x61,0x72,0x74,0x69,0x74,0x69,0x6f,0x6e,0x65,0x64,0x43,0x61,0x6c,0x6c,0x3a,0x30,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x50,0xfc,0xff,0xff,0x18,0x00,0x00,0x00,0x20,0x00,0x00,0x00,0x40,0x00,0x00,0x00,0x09,0x00,0x00,0x00,0x00,0x00,0x00,0x09,0x8c,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0xff,0xff,0xff,0xff,0x10,0x00,0x00,0x00,0x3c,0xfc,0xff,0xff,0x08,0x00,0x00,0x00,0x14,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x80,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0xee,0xd1,0xc0,0x3b,0x52,0x00,0x00,0x00,0x73,0x65,0x71,0x75,0x65,0x6e,0x74,0x69,0x61,0x6c,0x5f,0x31,0x2f,0x64,0x65,0x6e,0x73,0x65,0x5f,0x33,0x2f,0x4d,0x61,0x74,0x4d,0x75,0x6c,0x3b,0x73,0x65,0x71,0x75,0x65,0x6e,0x74,0x69,0x61,0x6c,0x5f,0x31,0x2f,0x64,0x65,0x6e,0x73,0x65,0x5f,0x33,0x2f,0x42,0x69,0x61,0x73,0x41,0x64,0x64,0x3b,0x73,0x65,0x71,0x75,0x65,0x6e,0x74,0x69,0x61,0x6c,0x5f,0x31,0x2f,0x64,0x65,0x6e,0x73,0x65,0x5f,0x33,0x2f,0x52,0x65,0x6c,0x75,0x00,0x00,0x02,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x10,0x00,0x00,0x00,0x00,0xfd,0xff,0xff,0x18,0x00,0x00,0x00,0x20,0x00,0x00,0x00,0x40,0x00,0x00,0x00,0x08,0x00,0x00,0x00,0x00,0x00,0x00,0x09,0x8c,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0xff,0xff,0xff,0xff,0x10,0x00,0x00,0x00,0xec,0xfc,0xff,0xff,0x08,0x00,0x00,0x00,0x14,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x80,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x56,0xdf,0x47,0x3c,0x52,0x00,0x00,0x00,0x73,0x65,0x71,0x75,0x65,0x6e,0x74,0x69,0x61,0x6c,0x5f,0x31,0x2f,0x64,0x65,0x6e,0x73,0x65,0x5f,0x32,0x2f,0x4d,0x61,0x74,0x4d,0x75,0x6c,0x3b,0x73,0x65,0x71,0x75,0x65,0x6e,0x74,0x69,0x61,0x6c,0x5f,0x31,0x2f,0x64,0x65,0x6e,0x73,0x65,0x5f,0x32,0x2f,0x42,0x69,0x61,0x73,0x41,0x64,0x64,0x3b,0x73,0x65,0x71,0x75,0x65,0x6e,0x74,0x69,0x61,0x6c,0x5f,0x31,0x2f,0x64,0x65,0x6e,0x73,0x65,0x5f,0x32,0x2f,0x52,0x65,0x6c,0x75,0x00,0x00,0x02,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x10,0x00,0x00,0x00,0x26,0xfe,0xff,0xff,0x14,0x00,0x00,0x00,0x34,0x00,0x00,0x00,0x07,0x00,0x00,0x00,0x00,0x00,0x00,0x02,0x3c,0x00,0x00,0x00,0x8c,0xfd,0xff,0xff,0x08,0x00,0x00,0x00,0x14,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x3b,0xd9,0x51,0x38,0x0c,0x00,0x00,0x00,0x64,0x65,0x6e,0x73,0x65,0x5f,0x34,0x2f,0x62,0x69,0x61,0x73,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x7e,0xfe,0xff,0xff,0x14,0x00,0x00,0x00,0x34,0x00,0x00,0x00,0x06,0x00,0x00,0x00,0x00,0x00,0x00,0x09,0x48,0x00,0x00,0x00,0xe4,0xfd,0xff,0xff,0x08,0x00,0x00,0x00,0x14,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0xd7,0x4d,0x0b,0x3c,0x1b,0x00,0x00,0x00,0x73,0x65,0x71,0x75,0x65,0x6e,0x74,0x69,0x61,0x6c,0x5f,0x31,0x2f,0x64,0x65,0x6e,0x73,0x65,0x5f,0x34,0x2f,0x4d,0x61,0x74,0x4d,0x75,0x6c,0x00,0x02,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x10,0x00,0x00,0x00,0xe6,0xfe,0xff,0xff,0x14,0x00,0x00,0x00,0x34,0x00,0x00,0x00,0x05,0x00,0x00,0x00,0x00,0x00,0x00,0x02,0x3c,0x00,0x00,0x00,0x4c,0xfe,0xff,0xff,0x08,0x00,0x00,0x00,0x14,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0xaa,0x9e,0x21,0x39,0x0c,0x00,0x00,0x00,0x64,0x65,0x6e,0x73,0x65,0x5f,0x33,0x2f,0x62,0x69,0x61,0x73,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x10,0x00,0x00,0x00,0x3e,0xff,0xff,0xff,0x14,0x00,0x00,0x00,0x34,0x00,0x00,0x00,0x04,0x00,0x00,0x00,0x00,0x00,0x00,0x09,0x48,0x00,0x00,0x00,0xa4,0xfe,0xff,0xff,0x08,0x00,0x00,0x00,0x14,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x61,0x01,0x4f,0x3c,0x1b,0x00,0x00,0x00,0x73,0x65,0x71,0x75,0x65,0x6e,0x74,0x69,0x61,0x6c,0x5f,0x31,0x2f,0x64,0x65,0x6e,0x73,0x65,0x5f,0x33,0x2f,0x4d,0x61,0x74,0x4d,0x75,0x6c,0x00,0x02,0x00,0x00,0x00,0x10,0x00,0x00,0x00,0x10,0x00,0x00,0x00,0xa6,0xff,0xff,0xff,0x14,0x00,0x00,0x00,0x34,0x00,0x00,0x00,0x03,0x00,0x00,0x00,0x00,0x00,0x00,0x02,0x3c,0x00,0x00,0x00,0x0c,0xff,0xff,0xff,0x08,0x00,0x00,0x00,0x14,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x28,0xb3,0xd9,0x38,0x0c,0x00,0x00,0x00,0x64,0x65,0x6e,0x73,0x65,0x5f,0x32,0x2f,0x62,0x69,0x61,0x73,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x10,0x00,0x00,0x00,0x00,0x00,0x0e,0x00,0x18,0x00,0x14,0x00,0x13,0x00,0x0c,0x00,0x08,0x00,0x04,0x00,0x0e,0x00,0x00,0x00,0x14,0x00,0x00,0x00,0x34,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0x00,0x00,0x00,0x09,0x48,0x00,0x00,0x00,0x74,0xff,0xff,0xff,0x08,0x00,0x00,0x00,0x14,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0xd5,0x6b,0x8a,0x3b,0x1b,0x00,0x00,0x00,0x73,0x65,0x71,0x75,0x65,0x6e,0x74,0x69,0x61,0x6c,0x5f,0x31,0x2f,0x64,0x65,0x6e,0x73,0x65,0x5f,0x32,0x2f,0x4d,0x61,0x74,0x4d,0x75,0x6c,0x00,0x02,0x00,0x00,0x00,0x10,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x14,0x00,0x1c,0x00,0x18,0x00,0x17,0x00,0x10,0x00,0x0c,0x00,0x08,0x00,0x00,0x00,0x00,0x00,0x04,0x00,0x14,0x00,0x00,0x00,0x18,0x00,0x00,0x00,0x2c,0x00,0x00,0x00,0x4c,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x09,0x64,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0xff,0xff,0xff,0xff,0x01,0x00,0x00,0x00,0x0c,0x00,0x0c,0x00,0x00,0x00,0x00,0x00,0x08,0x00,0x04,0x00,0x0c,0x00,0x00,0x00,0x08,0x00,0x00,0x00,0x14,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x80,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x5d,0x4f,0xc9,0x3c,0x1f,0x00,0x00,0x00,0x73,0x65,0x72,0x76,0x69,0x6e,0x67,0x5f,0x64,0x65,0x66,0x61,0x75,0x6c,0x74,0x5f,0x64,0x65,0x6e,0x73,0x65,0x5f,0x32,0x5f,0x69,0x6e,0x70,0x75,0x74,0x3a,0x30,0x00,0x02,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x10,0x00,0x00,0x00,0x0c,0x00,0x10,0x00,0x0f,0x00,0x00,0x00,0x08,0x00,0x04,0x00,0x0c,0x00,0x00,0x00,0x09,0x00,0x00,0x00,0x04,0x00,0x00,0x00,0x00,0x00,0x00,0x09,};
+const unsigned int g_hello_world_model_data_size = 2312;
+alignas(16) const unsigned char g_hello_world_model_data[] = {
+    0x20, 0x00, 0x00, 0x00, 0x54, 0x46, 0x4c, 0x33, 0x00, 0x00, 0x00, 0x00,
+    0x14, 0x00, 0x20, 0x00, 0x1c, 0x00, 0x18, 0x00, 0x14, 0x00, 0x10, 0x00,
+    0x0c, 0x00, 0x00, 0x00, 0x08, 0x00, 0x04, 0x00, 0x14, 0x00, 0x00, 0x00,
+    0x1c, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00, 0x4c, 0x00, 0x00, 0x00,
+    0xa0, 0x02, 0x00, 0x00, 0xb0, 0x02, 0x00, 0x00, 0xac, 0x08, 0x00, 0x00,
+    0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0x0c, 0x00, 0x00, 0x00, 0x08, 0x00, 0x0c, 0x00, 0x08, 0x00, 0x04, 0x00,
+    0x08, 0x00, 0x00, 0x00, 0x0b, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00,
+    0x13, 0x00, 0x00, 0x00, 0x6d, 0x69, 0x6e, 0x5f, 0x72, 0x75, 0x6e, 0x74,
+    0x69, 0x6d, 0x65, 0x5f, 0x76, 0x65, 0x72, 0x73, 0x69, 0x6f, 0x6e, 0x00,
+    0x0c, 0x00, 0x00, 0x00, 0x50, 0x02, 0x00, 0x00, 0x48, 0x02, 0x00, 0x00,
+    0x28, 0x02, 0x00, 0x00, 0xd0, 0x01, 0x00, 0x00, 0xc0, 0x00, 0x00, 0x00,
+    0x70, 0x00, 0x00, 0x00, 0x50, 0x00, 0x00, 0x00, 0x3c, 0x00, 0x00, 0x00,
+    0x34, 0x00, 0x00, 0x00, 0x2c, 0x00, 0x00, 0x00, 0x24, 0x00, 0x00, 0x00,
+    0x04, 0x00, 0x00, 0x00, 0x06, 0xfe, 0xff, 0xff, 0x04, 0x00, 0x00, 0x00,
+    0x10, 0x00, 0x00, 0x00, 0x31, 0x2e, 0x31, 0x34, 0x2e, 0x30, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x84, 0xfd, 0xff, 0xff,
+    0x88, 0xfd, 0xff, 0xff, 0x8c, 0xfd, 0xff, 0xff, 0x2e, 0xfe, 0xff, 0xff,
+    0x04, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x8c, 0xef, 0xff, 0xff,
+    0x3e, 0xfe, 0xff, 0xff, 0x04, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00,
+    0x21, 0xa5, 0x8b, 0xca, 0x5e, 0x1d, 0xce, 0x42, 0x9d, 0xce, 0x1f, 0xb0,
+    0xdf, 0x54, 0x2f, 0x81, 0x5a, 0xfe, 0xff, 0xff, 0x04, 0x00, 0x00, 0x00,
+    0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xb5, 0x04, 0x00, 0x00,
+    0x78, 0x0a, 0x00, 0x00, 0x2d, 0x06, 0x00, 0x00, 0x71, 0xf8, 0xff, 0xff,
+    0x00, 0x00, 0x00, 0x00, 0x99, 0x0a, 0x00, 0x00, 0xfe, 0xf7, 0xff, 0xff,
+    0x0f, 0x05, 0x00, 0x00, 0xd4, 0x09, 0x00, 0x00, 0x47, 0xfe, 0xff, 0xff,
+    0xb6, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xac, 0xf7, 0xff, 0xff,
+    0x4b, 0xf9, 0xff, 0xff, 0x4a, 0x05, 0x00, 0x00, 0xa6, 0xfe, 0xff, 0xff,
+    0x04, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0xee, 0xfc, 0x00, 0xec,
+    0x05, 0x17, 0xef, 0xec, 0xe6, 0xf8, 0x03, 0x01, 0x00, 0xfa, 0xf8, 0xf5,
+    0xdc, 0xeb, 0x27, 0x14, 0xf1, 0xde, 0xe2, 0xdb, 0xf0, 0xde, 0x31, 0x06,
+    0x02, 0xe6, 0xee, 0xf9, 0x00, 0x16, 0x07, 0xe0, 0xfe, 0xff, 0xe9, 0x06,
+    0xe7, 0xef, 0x81, 0x1b, 0x18, 0xea, 0xc9, 0x01, 0x0f, 0x00, 0xda, 0xf7,
+    0x0e, 0xec, 0x13, 0x1f, 0x04, 0x13, 0xb4, 0xe6, 0xfd, 0x06, 0xb9, 0xe0,
+    0x0d, 0xec, 0xf0, 0xde, 0xeb, 0xf7, 0x05, 0x26, 0x1a, 0xe4, 0x6f, 0x1a,
+    0xea, 0x1e, 0x35, 0xdf, 0x1a, 0xf3, 0xf1, 0x19, 0x0f, 0x03, 0x1b, 0xe1,
+    0xde, 0x13, 0xf6, 0x19, 0xff, 0xf6, 0x1b, 0x18, 0xf0, 0x1c, 0xda, 0x1b,
+    0x1b, 0x20, 0xe5, 0x1a, 0xf5, 0xff, 0x96, 0x0b, 0x00, 0x01, 0xcd, 0xde,
+    0x0d, 0xf6, 0x16, 0xe3, 0xed, 0xfc, 0x0e, 0xe9, 0xfa, 0xeb, 0x5c, 0xfc,
+    0x1d, 0x02, 0x5b, 0xe2, 0xe1, 0xf5, 0x15, 0xec, 0xf4, 0x00, 0x13, 0x05,
+    0xec, 0x0c, 0x1d, 0x14, 0x0e, 0xe7, 0x0b, 0xf4, 0x19, 0x00, 0xd7, 0x05,
+    0x27, 0x02, 0x15, 0xea, 0xea, 0x02, 0x9b, 0x00, 0x0c, 0xfa, 0xe8, 0xea,
+    0xfd, 0x00, 0x14, 0xfd, 0x0b, 0x02, 0xef, 0xee, 0x06, 0xee, 0x01, 0x0d,
+    0x06, 0xe6, 0xf7, 0x11, 0xf7, 0x09, 0xf8, 0xf1, 0x21, 0xff, 0x0e, 0xf3,
+    0xec, 0x12, 0x26, 0x1d, 0xf2, 0xe9, 0x28, 0x18, 0xe0, 0xfb, 0xf3, 0xf4,
+    0x05, 0x1d, 0x1d, 0xfb, 0xfd, 0x1e, 0xfc, 0x11, 0xe8, 0x07, 0x09, 0x03,
+    0x12, 0xf2, 0x36, 0xfb, 0xdc, 0x1c, 0xf9, 0xef, 0xf3, 0xe7, 0x6f, 0x0c,
+    0x1d, 0x00, 0x45, 0xfd, 0x0e, 0xf0, 0x0b, 0x19, 0x1a, 0xfa, 0xe0, 0x19,
+    0x1f, 0x13, 0x36, 0x1c, 0x12, 0xeb, 0x3b, 0x0c, 0xb4, 0xcb, 0xe6, 0x13,
+    0xfa, 0xeb, 0xf1, 0x06, 0x1c, 0xfa, 0x18, 0xe5, 0xeb, 0xcb, 0x0c, 0xf4,
+    0xb2, 0xff, 0xff, 0xff, 0x04, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00, 0x00,
+    0x06, 0x00, 0x00, 0x00, 0x77, 0x0b, 0x00, 0x00, 0x53, 0xf6, 0xff, 0xff,
+    0x00, 0x00, 0x00, 0x00, 0x77, 0x0c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0xd3, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x72, 0x21, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x2f, 0x07, 0x00, 0x00, 0x67, 0xf5, 0xff, 0xff, 0x34, 0xf0, 0xff, 0xff,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x00, 0x08, 0x00, 0x04, 0x00,
+    0x06, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00,
+    0x75, 0x1c, 0x11, 0xe1, 0x0c, 0x81, 0xa5, 0x42, 0xfe, 0xd5, 0xd4, 0xb2,
+    0x61, 0x78, 0x19, 0xdf, 0x84, 0xff, 0xff, 0xff, 0x88, 0xff, 0xff, 0xff,
+    0x0f, 0x00, 0x00, 0x00, 0x4d, 0x4c, 0x49, 0x52, 0x20, 0x43, 0x6f, 0x6e,
+    0x76, 0x65, 0x72, 0x74, 0x65, 0x64, 0x2e, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0e, 0x00, 0x18, 0x00, 0x14, 0x00,
+    0x10, 0x00, 0x0c, 0x00, 0x08, 0x00, 0x04, 0x00, 0x0e, 0x00, 0x00, 0x00,
+    0x14, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00, 0xdc, 0x00, 0x00, 0x00,
+    0xe0, 0x00, 0x00, 0x00, 0xe4, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00,
+    0x6d, 0x61, 0x69, 0x6e, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00,
+    0x84, 0x00, 0x00, 0x00, 0x3c, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00,
+    0x96, 0xff, 0xff, 0xff, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08,
+    0x10, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x04, 0x00, 0x04, 0x00,
+    0x04, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00,
+    0x03, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00,
+    0x09, 0x00, 0x00, 0x00, 0xca, 0xff, 0xff, 0xff, 0x10, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x08, 0x10, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00,
+    0xba, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x01, 0x01, 0x00, 0x00, 0x00,
+    0x02, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0x06, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0e, 0x00,
+    0x16, 0x00, 0x00, 0x00, 0x10, 0x00, 0x0c, 0x00, 0x0b, 0x00, 0x04, 0x00,
+    0x0e, 0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08,
+    0x18, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x00,
+    0x08, 0x00, 0x07, 0x00, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+    0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00, 0x00, 0x64, 0x04, 0x00, 0x00,
+    0x4c, 0x01, 0x00, 0x00, 0x98, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00,
+    0xd8, 0x03, 0x00, 0x00, 0x6c, 0x03, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00,
+    0xa4, 0x02, 0x00, 0x00, 0x38, 0x02, 0x00, 0x00, 0xdc, 0x01, 0x00, 0x00,
+    0xd8, 0xfb, 0xff, 0xff, 0x18, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00,
+    0x40, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09,
+    0x54, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff,
+    0x01, 0x00, 0x00, 0x00, 0xc4, 0xfb, 0xff, 0xff, 0x08, 0x00, 0x00, 0x00,
+    0x14, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0x2c, 0xce, 0x0a, 0x3c, 0x19, 0x00, 0x00, 0x00, 0x53, 0x74, 0x61, 0x74,
+    0x65, 0x66, 0x75, 0x6c, 0x50, 0x61, 0x72, 0x74, 0x69, 0x74, 0x69, 0x6f,
+    0x6e, 0x65, 0x64, 0x43, 0x61, 0x6c, 0x6c, 0x3a, 0x30, 0x00, 0x00, 0x00,
+    0x02, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0x50, 0xfc, 0xff, 0xff, 0x18, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00,
+    0x40, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09,
+    0x8c, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff,
+    0x10, 0x00, 0x00, 0x00, 0x3c, 0xfc, 0xff, 0xff, 0x08, 0x00, 0x00, 0x00,
+    0x14, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x80, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0xee, 0xd1, 0xc0, 0x3b, 0x52, 0x00, 0x00, 0x00, 0x73, 0x65, 0x71, 0x75,
+    0x65, 0x6e, 0x74, 0x69, 0x61, 0x6c, 0x5f, 0x31, 0x2f, 0x64, 0x65, 0x6e,
+    0x73, 0x65, 0x5f, 0x33, 0x2f, 0x4d, 0x61, 0x74, 0x4d, 0x75, 0x6c, 0x3b,
+    0x73, 0x65, 0x71, 0x75, 0x65, 0x6e, 0x74, 0x69, 0x61, 0x6c, 0x5f, 0x31,
+    0x2f, 0x64, 0x65, 0x6e, 0x73, 0x65, 0x5f, 0x33, 0x2f, 0x42, 0x69, 0x61,
+    0x73, 0x41, 0x64, 0x64, 0x3b, 0x73, 0x65, 0x71, 0x75, 0x65, 0x6e, 0x74,
+    0x69, 0x61, 0x6c, 0x5f, 0x31, 0x2f, 0x64, 0x65, 0x6e, 0x73, 0x65, 0x5f,
+    0x33, 0x2f, 0x52, 0x65, 0x6c, 0x75, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0xfd, 0xff, 0xff,
+    0x18, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00, 0x00,
+    0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09, 0x8c, 0x00, 0x00, 0x00,
+    0x02, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0x10, 0x00, 0x00, 0x00,
+    0xec, 0xfc, 0xff, 0xff, 0x08, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x80, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x56, 0xdf, 0x47, 0x3c,
+    0x52, 0x00, 0x00, 0x00, 0x73, 0x65, 0x71, 0x75, 0x65, 0x6e, 0x74, 0x69,
+    0x61, 0x6c, 0x5f, 0x31, 0x2f, 0x64, 0x65, 0x6e, 0x73, 0x65, 0x5f, 0x32,
+    0x2f, 0x4d, 0x61, 0x74, 0x4d, 0x75, 0x6c, 0x3b, 0x73, 0x65, 0x71, 0x75,
+    0x65, 0x6e, 0x74, 0x69, 0x61, 0x6c, 0x5f, 0x31, 0x2f, 0x64, 0x65, 0x6e,
+    0x73, 0x65, 0x5f, 0x32, 0x2f, 0x42, 0x69, 0x61, 0x73, 0x41, 0x64, 0x64,
+    0x3b, 0x73, 0x65, 0x71, 0x75, 0x65, 0x6e, 0x74, 0x69, 0x61, 0x6c, 0x5f,
+    0x31, 0x2f, 0x64, 0x65, 0x6e, 0x73, 0x65, 0x5f, 0x32, 0x2f, 0x52, 0x65,
+    0x6c, 0x75, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0x10, 0x00, 0x00, 0x00, 0x26, 0xfe, 0xff, 0xff, 0x14, 0x00, 0x00, 0x00,
+    0x34, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02,
+    0x3c, 0x00, 0x00, 0x00, 0x8c, 0xfd, 0xff, 0xff, 0x08, 0x00, 0x00, 0x00,
+    0x14, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0x3b, 0xd9, 0x51, 0x38, 0x0c, 0x00, 0x00, 0x00, 0x64, 0x65, 0x6e, 0x73,
+    0x65, 0x5f, 0x34, 0x2f, 0x62, 0x69, 0x61, 0x73, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x7e, 0xfe, 0xff, 0xff,
+    0x14, 0x00, 0x00, 0x00, 0x34, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x09, 0x48, 0x00, 0x00, 0x00, 0xe4, 0xfd, 0xff, 0xff,
+    0x08, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0xd7, 0x4d, 0x0b, 0x3c, 0x1b, 0x00, 0x00, 0x00,
+    0x73, 0x65, 0x71, 0x75, 0x65, 0x6e, 0x74, 0x69, 0x61, 0x6c, 0x5f, 0x31,
+    0x2f, 0x64, 0x65, 0x6e, 0x73, 0x65, 0x5f, 0x34, 0x2f, 0x4d, 0x61, 0x74,
+    0x4d, 0x75, 0x6c, 0x00, 0x02, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0x10, 0x00, 0x00, 0x00, 0xe6, 0xfe, 0xff, 0xff, 0x14, 0x00, 0x00, 0x00,
+    0x34, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02,
+    0x3c, 0x00, 0x00, 0x00, 0x4c, 0xfe, 0xff, 0xff, 0x08, 0x00, 0x00, 0x00,
+    0x14, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0xaa, 0x9e, 0x21, 0x39, 0x0c, 0x00, 0x00, 0x00, 0x64, 0x65, 0x6e, 0x73,
+    0x65, 0x5f, 0x33, 0x2f, 0x62, 0x69, 0x61, 0x73, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x3e, 0xff, 0xff, 0xff,
+    0x14, 0x00, 0x00, 0x00, 0x34, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x09, 0x48, 0x00, 0x00, 0x00, 0xa4, 0xfe, 0xff, 0xff,
+    0x08, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x61, 0x01, 0x4f, 0x3c, 0x1b, 0x00, 0x00, 0x00,
+    0x73, 0x65, 0x71, 0x75, 0x65, 0x6e, 0x74, 0x69, 0x61, 0x6c, 0x5f, 0x31,
+    0x2f, 0x64, 0x65, 0x6e, 0x73, 0x65, 0x5f, 0x33, 0x2f, 0x4d, 0x61, 0x74,
+    0x4d, 0x75, 0x6c, 0x00, 0x02, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00,
+    0x10, 0x00, 0x00, 0x00, 0xa6, 0xff, 0xff, 0xff, 0x14, 0x00, 0x00, 0x00,
+    0x34, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02,
+    0x3c, 0x00, 0x00, 0x00, 0x0c, 0xff, 0xff, 0xff, 0x08, 0x00, 0x00, 0x00,
+    0x14, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0x28, 0xb3, 0xd9, 0x38, 0x0c, 0x00, 0x00, 0x00, 0x64, 0x65, 0x6e, 0x73,
+    0x65, 0x5f, 0x32, 0x2f, 0x62, 0x69, 0x61, 0x73, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0e, 0x00,
+    0x18, 0x00, 0x14, 0x00, 0x13, 0x00, 0x0c, 0x00, 0x08, 0x00, 0x04, 0x00,
+    0x0e, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x34, 0x00, 0x00, 0x00,
+    0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09, 0x48, 0x00, 0x00, 0x00,
+    0x74, 0xff, 0xff, 0xff, 0x08, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0xd5, 0x6b, 0x8a, 0x3b,
+    0x1b, 0x00, 0x00, 0x00, 0x73, 0x65, 0x71, 0x75, 0x65, 0x6e, 0x74, 0x69,
+    0x61, 0x6c, 0x5f, 0x31, 0x2f, 0x64, 0x65, 0x6e, 0x73, 0x65, 0x5f, 0x32,
+    0x2f, 0x4d, 0x61, 0x74, 0x4d, 0x75, 0x6c, 0x00, 0x02, 0x00, 0x00, 0x00,
+    0x10, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x14, 0x00, 0x1c, 0x00,
+    0x18, 0x00, 0x17, 0x00, 0x10, 0x00, 0x0c, 0x00, 0x08, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x04, 0x00, 0x14, 0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00,
+    0x2c, 0x00, 0x00, 0x00, 0x4c, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x09, 0x64, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,
+    0xff, 0xff, 0xff, 0xff, 0x01, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x0c, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x04, 0x00, 0x0c, 0x00, 0x00, 0x00,
+    0x08, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0x80, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x5d, 0x4f, 0xc9, 0x3c, 0x1f, 0x00, 0x00, 0x00,
+    0x73, 0x65, 0x72, 0x76, 0x69, 0x6e, 0x67, 0x5f, 0x64, 0x65, 0x66, 0x61,
+    0x75, 0x6c, 0x74, 0x5f, 0x64, 0x65, 0x6e, 0x73, 0x65, 0x5f, 0x32, 0x5f,
+    0x69, 0x6e, 0x70, 0x75, 0x74, 0x3a, 0x30, 0x00, 0x02, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0x10, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x10, 0x00, 0x0f, 0x00, 0x00, 0x00,
+    0x08, 0x00, 0x04, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00,
+    0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09,
+};
+
+namespace {
+
+const TfLiteEvalTensor kSubgraph0Tensors[] = {
+    // Tensor 4: sequential_1/dense_2/MatMul
+    {{reinterpret_cast<int32_t*>(
+         const_cast<unsigned char*>(&g_hello_world_model_data[696]))},
+     reinterpret_cast<TfLiteIntArray*>(
+         const_cast<unsigned char*>(&g_hello_world_model_data[2108])),
+     kTfLiteInt8},
+    // Tensor 5: dense_2/bias
+    {{reinterpret_cast<int32_t*>(
+         const_cast<unsigned char*>(&g_hello_world_model_data[612]))},
+     reinterpret_cast<TfLiteIntArray*>(
+         const_cast<unsigned char*>(&g_hello_world_model_data[1992])),
+     kTfLiteInt32},
+    // Tensor 6: sequential_1/dense_3/MatMul
+    {{reinterpret_cast<int32_t*>(
+         const_cast<unsigned char*>(&g_hello_world_model_data[344]))},
+     reinterpret_cast<TfLiteIntArray*>(
+         const_cast<unsigned char*>(&g_hello_world_model_data[1900])),
+     kTfLiteInt8},
+    // Tensor 7: dense_3/bias
+    {{reinterpret_cast<int32_t*>(
+         const_cast<unsigned char*>(&g_hello_world_model_data[268]))},
+     reinterpret_cast<TfLiteIntArray*>(
+         const_cast<unsigned char*>(&g_hello_world_model_data[1800])),
+     kTfLiteInt32},
+    // Tensor 8: sequential_1/dense_4/MatMul
+    {{reinterpret_cast<int32_t*>(
+         const_cast<unsigned char*>(&g_hello_world_model_data[240]))},
+     reinterpret_cast<TfLiteIntArray*>(
+         const_cast<unsigned char*>(&g_hello_world_model_data[1708])),
+     kTfLiteInt8},
+    // Tensor 9: dense_4/bias
+    {{reinterpret_cast<int32_t*>(
+         const_cast<unsigned char*>(&g_hello_world_model_data[224]))},
+     reinterpret_cast<TfLiteIntArray*>(
+         const_cast<unsigned char*>(&g_hello_world_model_data[1608])),
+     kTfLiteInt32},
+};
+
+const tflite::ConstantSubgraphTensors kSubgraphs[] = {
+    {4, 6, kSubgraph0Tensors},
+};
+
+}  // namespace
+
+const tflite::ConstantTensorTable g_hello_world_constant_tensors = {
+    1, kSubgraphs};
@@ -1,3 +1,18 @@
+// Generated by model_packer.py from hello_world_model_data.cc.
+// Do not edit, regenerate whenever the model changes.
+
+#ifndef HELLO_WORLD_MODEL_DATA_H_
+#define HELLO_WORLD_MODEL_DATA_H_
+
 #include <cstdint>
 
-extern const unsigned int g_hello_world_model_data_size;extern const unsigned char g_hello_world_model_data[];
+#include "tensorflow/lite/micro/constant_tensor_table.h"
+
+extern const unsigned int g_hello_world_model_data_size;
+extern const unsigned char g_hello_world_model_data[];
+
+// Eval tensors of the constant tensors of the model, for
+// tflite::MicroInterpreter::SetConstantTensorTable().
+extern const tflite::ConstantTensorTable g_hello_world_constant_tensors;
+
+#endif  // HELLO_WORLD_MODEL_DATA_H_
@@ -0,0 +1,23 @@
+// Generated by generate_op_resolver.py from hello_world_model_data.cc.
+// Do not edit, regenerate whenever the model changes.
+
+#ifndef HELLO_WORLD_OP_RESOLVER_H_
+#define HELLO_WORLD_OP_RESOLVER_H_
+
+#include "tensorflow/lite/core/api/flatbuffer_conversions.h"
+#include "tensorflow/lite/micro/kernels/fully_connected.h"
+#include "tensorflow/lite/micro/micro_static_op_resolver.h"
+
+// Resolver for the operators of the model: FULLY_CONNECTED.
+using HelloWorldOpResolver = tflite::MicroStaticOpResolver<1, 1>;
+
+// Registers the kernels of all operators of the model.
+inline TfLiteStatus RegisterHelloWorldOps(HelloWorldOpResolver* resolver) {
+  TF_LITE_ENSURE_STATUS(resolver->AddBuiltin(
+      tflite::BuiltinOperator_FULLY_CONNECTED,
+      tflite::Register_FULLY_CONNECTED(),
+      tflite::ParseFullyConnected));
+  return kTfLiteOk;
+}
+
+#endif  // HELLO_WORLD_OP_RESOLVER_H_
@@ -14,12 +14,16 @@ void* __dso_handle;
 
 #include "main_functions.h"
 
-#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
 #include "constants.h"
+#include "hello_world_memory_plan.h"
 #include "hello_world_model_data.h"
+#include "hello_world_op_resolver.h"
 #include "output_handler.h"
 #include "tensorflow/lite/micro/micro_error_reporter.h"
 #include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_layer_profiler.h"
+#include "tensorflow/lite/micro/memory_planner/non_persistent_buffer_planner_shim.h"
+#include "tensorflow/lite/micro/recording_micro_allocator.h"
 #include "tensorflow/lite/micro/system_setup.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 #include "tensorflow/lite/micro/cortex_m_generic/debug_log_callback.h"
@@ -34,7 +38,14 @@ TfLiteTensor* input = nullptr;
 TfLiteTensor* output = nullptr;
 int inference_count = 0;
 
+#if (CFG_SMARTSHOT_TFLM_LAYER_PROF_ENABLED == 1)
+// The RecordingMicroAllocator keeps its per-node records in the arena.
+constexpr int kTensorArenaSize = 2000 + 1024;
+tflite::RecordingMicroAllocator* recording_allocator = nullptr;
+tflite::MicroLayerProfiler layer_profiler;
+#else
 constexpr int kTensorArenaSize = 2000;
+#endif
 uint8_t tensor_arena[kTensorArenaSize];
 }  // namespace
 
@@ -66,15 +77,54 @@ void setup() {
     return;
   }
 
-  // This pulls in all the operation implementations we need.
+  // This pulls in all the operation implementations we need. The resolver is
+  // generated from the model by generate_op_resolver.py.
   // NOLINTNEXTLINE(runtime-global-variables)
-  static   tflite::MicroMutableOpResolver<1> micro_op_resolver;
-  micro_op_resolver.AddFullyConnected();
+  static HelloWorldOpResolver micro_op_resolver(error_reporter);
+  if (RegisterHelloWorldOps(&micro_op_resolver) != kTfLiteOk) {
+    TF_LITE_REPORT_ERROR(error_reporter, "RegisterHelloWorldOps() failed");
+    return;
+  }
+
+  // Place the non-persistent buffers as planned offline by the
+  // branch-and-bound search of offline_memory_planner.py instead of running a
+  // planner at startup. The plan is checked against the model in
+  // AllocateTensors().
+  // NOLINTNEXTLINE(runtime-global-variables)
+  static tflite::NonPersistentMemoryPlannerShim memory_planner(
+      g_hello_world_memory_plan, g_hello_world_memory_plan_usage);
+  tflite::MicroProfilerInterface* profiler = nullptr;
+#if (CFG_SMARTSHOT_TFLM_LAYER_PROF_ENABLED == 1)
+  // Record the arena usage of every node and profile every layer.
+  recording_allocator = tflite::RecordingMicroAllocator::Create(
+      tensor_arena, kTensorArenaSize, &memory_planner, error_reporter);
+  tflite::MicroAllocator* allocator = recording_allocator;
+  if (layer_profiler.Init(model) != kTfLiteOk) {
+    TF_LITE_REPORT_ERROR(error_reporter, "MicroLayerProfiler::Init() failed");
+    return;
+  }
+  profiler = &layer_profiler;
+#else
+  tflite::MicroAllocator* allocator = tflite::MicroAllocator::Create(
+      tensor_arena, kTensorArenaSize, &memory_planner, error_reporter);
+#endif
+  if (allocator == nullptr) {
+    TF_LITE_REPORT_ERROR(error_reporter, "MicroAllocator::Create() failed");
+    return;
+  }
 
   // Build an interpreter to run the model with.
   static tflite::MicroInterpreter static_interpreter(
-      model, micro_op_resolver, tensor_arena, kTensorArenaSize, error_reporter);
+      model, micro_op_resolver, allocator, error_reporter, nullptr, profiler);
   interpreter = &static_interpreter;
+
+  // The model was packed by model_packer.py, the eval tensors of its weights
+  // are read from flash instead of being allocated in the arena.
+  if (interpreter->SetConstantTensorTable(&g_hello_world_constant_tensors) !=
+      kTfLiteOk) {
+    TF_LITE_REPORT_ERROR(error_reporter, "SetConstantTensorTable() failed");
+    return;
+  }
 //
 //  // Allocate memory from the tensor_arena for the model's tensors.
   TfLiteStatus allocate_status = interpreter->AllocateTensors();
@@ -82,6 +132,9 @@ void setup() {
     TF_LITE_REPORT_ERROR(error_reporter, "AllocateTensors() failed");
     return;
   }
+#if (CFG_SMARTSHOT_TFLM_LAYER_PROF_ENABLED == 1)
+  recording_allocator->PrintAllocations();
+#endif
 //
 //  // Obtain pointers to the model's input and output tensors.
   input = interpreter->input(0);
@@ -104,16 +157,32 @@ void loop() {
 
   // Quantize the input from floating-point to integer
   int8_t x_quantized = x / input->params.scale + input->params.zero_point;
-  // Place the quantized input in the model's input tensor
-  input->data.int8[0] = x_quantized;
+  // Place the quantized input in the model's input tensor, unless the
+  // previous call left an inference in progress
+  if (!interpreter->invoke_in_progress()) {
+    input->data.int8[0] = x_quantized;
+  }
 
   // Run inference, and report any error
+  APP_PROF_ZONE_BEGIN(APP_PROF_ZONE_TFLM_INVOKE);
+#if (CFG_SMARTSHOT_TFLM_INVOKE_BUDGET_CYCLES > 0)
+  // Run only a time slice of the inference, the main loop services the BLE
+  // stack before the next slice.
+  TfLiteStatus invoke_status =
+      interpreter->InvokeStep(CFG_SMARTSHOT_TFLM_INVOKE_BUDGET_CYCLES);
+#else
   TfLiteStatus invoke_status = interpreter->Invoke();
+#endif
+  APP_PROF_ZONE_END(APP_PROF_ZONE_TFLM_INVOKE);
   if (invoke_status != kTfLiteOk) {
     TF_LITE_REPORT_ERROR(error_reporter, "Invoke failed on x: %f\n",
                          static_cast<double>(x));
     return;
   }
+  // The output is valid once the last slice of the inference has run
+  if (interpreter->invoke_in_progress()) {
+    return;
+  }
 
   // Obtain the quantized output from model's output tensor
   int8_t y_quantized = output->data.int8[0];
@@ -127,5 +196,12 @@ void loop() {
   // Increment the inference_counter, and reset it if we have reached
   // the total number per cycle
   inference_count += 1;
-  if (inference_count >= kInferencesPerCycle) inference_count = 0;
+  if (inference_count >= kInferencesPerCycle) {
+    inference_count = 0;
+#if (CFG_SMARTSHOT_TFLM_LAYER_PROF_ENABLED == 1)
+    // Report the layers averaged over the cycle and start the next one.
+    layer_profiler.LogCsv(recording_allocator);
+    layer_profiler.ClearEvents();
+#endif
+  }
 }
@@ -107,13 +107,18 @@ static void APP_ISP_ReadNextDataChunk(void)
 /**
  * Attempts to push image data from buffer to BLE service every time new chunk
  * of data is received or BLE indicates it transmitted a packet.
+ *
+ * Image data not yet read by the preview decoder are left in the buffer.
  */
 static void APP_PTSS_PushImageData(void)
 {
+    APP_PROF_ZONE_BEGIN(APP_PROF_ZONE_PTSS_PUSH);
+
     do
     {
         uint32_t max_data_to_push = PTSS_GetMaxImageDataPushSize();
-        uint32_t data_available = CIRCBUF_GetUsed(&app_env.img_cache);
+        uint32_t data_available = CIRCBUF_GetUsed(&app_env.img_cache)
+                                  - APP_PREVIEW_GetUnreadSize();
 
         if ((max_data_to_push > 0) && (data_available > 0))
         {
@@ -134,6 +139,8 @@ static void APP_PTSS_PushImageData(void)
             status = PTSS_ImageDataPush(buf, buf_to_write);
             ENSURE(status == PTSS_OK);
 
+            APP_PROF_COUNTER_ADD(APP_PROF_CNT_PTSS_BYTES, buf_to_write);
+
             /* for unused variable warnings. */
             (void)status;
         }
@@ -142,6 +149,10 @@ static void APP_PTSS_PushImageData(void)
             break;
         }
     } while (1);
+
+    APP_PROF_GAUGE_SET(APP_PROF_GAUGE_IMG_CACHE_USED,
+            CIRCBUF_GetUsed(&app_env.img_cache));
+    APP_PROF_ZONE_END(APP_PROF_ZONE_PTSS_PUSH);
 }
 
 #if (CFG_SMARTSHOT_PRINTF_INTERFACE != SMARTSHOT_PRINTF_INTERFACE_DISABLED)
@@ -252,6 +263,7 @@ void APP_ISP_EventHandler(SMARTSHOT_ISP_MessageId_t msgid, const void *p_param)
                     p_err_ind->error);
 
             PTSS_AbortImageTransfer(PTSS_INFO_ERR_ABORTED_BY_SERVER);
+            APP_PREVIEW_Abort();
             SMARTSHOT_ISP_PowerDownCommand();
             break;
         }
@@ -348,6 +360,7 @@ void APP_ISP_EventHandler(SMARTSHOT_ISP_MessageId_t msgid, const void *p_param)
                     p_img_data->size, &app_env.img_cache);
             /* Enough free space is guaranteed when data retrieval is started. */
             ENSURE(status == 0);
+            APP_PROF_COUNTER_ADD(APP_PROF_CNT_ISP_BYTES, p_img_data->size);
 
             /* Try to pass cached data to PTSS. */
             APP_PTSS_PushImageData();
@@ -445,6 +458,7 @@ void APP_PTSS_EventHandler(PTSS_ControlPointOpCode_t opcode,
 
             APP_BLE_UpdateConnectionParameters(APP_UPD_CONN_LOW_POWER);
 
+            APP_PREVIEW_Abort();
             SMARTSHOT_ISP_PowerDownCommand();
 
             Sys_PWM_Config(0, APP_LED_DUTY_CYCLE, APP_LED_IDLE_PWM_DUTY);
@@ -457,13 +471,17 @@ void APP_PTSS_EventHandler(PTSS_ControlPointOpCode_t opcode,
         case PTSS_OP_IMAGE_DATA_TRANSFER_REQ:
         {
             PRINTF("PTSS: IMAGE_DATA_TRANSFER_REQ\r\n");
-            app_env.time_transfer_start = APP_RTC_GetTimeMs();
+            app_env.time_transfer_start = APP_RTC_GetTimeUs();
+            app_env.conn_event_valid = false;
+            MsgHandler_ResetStats();
 
             /* Reset circular buffer to receive new image. */
             CIRCBUF_Initialize(app_img_cache_storage, APP_IMG_CACHE_SIZE,
                     &app_env.img_cache);
             app_env.isp_read_in_progress = 0;
 
+            APP_PREVIEW_Start(&app_env.img_cache, app_env.img_size);
+
             APP_ISP_ReadNextDataChunk();
 
             Sys_PWM_Config(0, APP_LED_DUTY_CYCLE, APP_LED_TRANSFER_PWM_DUTY);
@@ -480,12 +498,18 @@ void APP_PTSS_EventHandler(PTSS_ControlPointOpCode_t opcode,
             }
 
             /* Print image transfer statistics */
-            uint32_t time_transfer_done = APP_RTC_GetTimeMs();
-            PRINTF("STAT: time_transfer = %d ms\r\n",
-                (time_transfer_done - app_env.time_transfer_start));
-            PRINTF("STAT: transfer_rate = %d Bps\r\n",
-                app_env.img_size * 1000
-                    / (time_transfer_done - app_env.time_transfer_start));
+            uint64_t time_transfer_us = APP_RTC_GetTimeUs()
+                    - app_env.time_transfer_start;
+            PRINTF("STAT: time_transfer = %lu ms\r\n",
+                (uint32_t) (time_transfer_us / 1000));
+            if (time_transfer_us > 0)
+            {
+                PRINTF("STAT: transfer_rate = %lu Bps\r\n",
+                    (uint32_t) (app_env.img_size * 1000000ULL
+                                / time_transfer_us));
+            }
+            APP_BLE_PeripheralServerPrintMsgStats();
+            APP_PROF_Print();
 
             /* Return LED brightness into idle level.  */
             Sys_PWM_Config(0, APP_LED_DUTY_CYCLE, APP_LED_IDLE_PWM_DUTY);
@@ -495,6 +519,12 @@ void APP_PTSS_EventHandler(PTSS_ControlPointOpCode_t opcode,
         /* PTSS is able to accept more image data. */
         case PTSS_OP_IMAGE_DATA_SPACE_AVAIL_IND:
         {
+            /* Space is freed after packets were acknowledged in connection
+             * event.
+             */
+            app_env.time_conn_event_us = APP_RTC_GetTimeUs();
+            app_env.conn_event_valid = true;
+
             /* Push any cached data. */
             APP_PTSS_PushImageData();
 
@@ -513,6 +543,40 @@ void APP_PTSS_EventHandler(PTSS_ControlPointOpCode_t opcode,
     }
 }
 
+/**
+ * Event handler for the streaming preview decoder.
+ *
+ * Called during image data transfer once the preview of the transferred image
+ * is decoded. Sends analysis result to the client before it finishes
+ * downloading the image.
+ */
+void APP_PREVIEW_EventHandler(const APP_PREVIEW_Image_t *p_img)
+{
+    uint32_t luma_sum = 0;
+    uint32_t pixel_count = (uint32_t) p_img->width * p_img->height;
+    uint8_t result[1];
+    int32_t status;
+
+    /* Placeholder analysis until an image classification model is added to
+     * the TFLM application: mean luma of the preview.
+     */
+    for (uint32_t i = 0; i < pixel_count; ++i)
+    {
+        luma_sum += p_img->p_pixels[i];
+    }
+
+    result[0] = (uint8_t) ((luma_sum + (pixel_count >> 1)) / pixel_count);
+
+    PRINTF("PREVIEW: %dx%d mean_luma=%d\r\n", p_img->width, p_img->height,
+            result[0]);
+
+    status = PTSS_SendImageResult(result, sizeof(result));
+    if (status != PTSS_OK)
+    {
+        PRINTF("PTSS: Image result not sent (err=%d)\r\n", status);
+    }
+}
+
 /**
  * Event handler for the External Sensor Trigger Service Server BLE service.
  *
@@ -628,6 +692,18 @@ void APP_ESTSS_EventHandler(ESTSS_TriggerId_t tidx)
     }
 }
 
+/**
+ * Kernel message handler for new connections.
+ *
+ * Invalidates the connection event time of any previous connection.
+ */
+static void APP_BLE_ConnectionHandler(ke_msg_id_t const msg_id,
+        void const *param, ke_task_id_t const dest_id,
+        ke_task_id_t const src_id)
+{
+    app_env.conn_event_valid = false;
+}
+
 int main(void)
 {
     /* Configure hardware and initialize BLE stack */
@@ -659,6 +735,10 @@ int main(void)
     CIRCBUF_Initialize(app_img_cache_storage, APP_IMG_CACHE_SIZE,
             &app_env.img_cache);
 
+    MsgHandler_Add(GAPC_CONNECTION_REQ_IND, APP_BLE_ConnectionHandler);
+
+    APP_PREVIEW_Initialize(APP_PREVIEW_EventHandler);
+
 #if (CFG_SMARTSHOT_APP_POWER_ISP_ON_BOOT == 1)
     /* Power-up ISP to allow to update ISP firmware over USB.
      * RSL10 will not enter into sleep mode if this option is enabled!
@@ -673,9 +753,78 @@ int main(void)
     }
 }
 
+#if (CFG_SMARTSHOT_APP_SLEEP_ENABLED == 1) && (CFG_SMARTSHOT_APP_TRANSFER_SLEEP_ENABLED == 1)
+/**
+ * Check if deep sleep can be entered between connection events during image
+ * data transfer.
+ *
+ * Deep sleep is allowed if the following conditions are met:
+ *
+ * - A connection event acknowledged image data since the transfer started,
+ *   so its time can be used to predict the next one.
+ * - PTSS transmit window is full. No data can be pushed before next
+ *   connection event.
+ * - Image cache is filled and no SPI transfer is in progress. Next SPI read
+ *   is needed only after PTSS frees space in next connection event.
+ * - Predicted idle time until next connection event is longer than measured
+ *   wake-up latency plus configured margin.
+ *
+ * @param isp_busy
+ * ISP library requested to stay awake.
+ */
+static bool APP_TransferSleepAllowed(bool isp_busy)
+{
+    uint32_t conn_interval_us = APP_BLE_PeripheralServerGetConnIntervalUs();
+
+    if (isp_busy || app_env.isp_read_in_progress
+        || (conn_interval_us == 0)
+        || (app_env.conn_event_valid == false)
+        || (PTSS_IsTransmitWindowFull() == false)
+        || (CIRCBUF_GetFree(&app_env.img_cache) >= SMARTSHOT_ISP_DATA_CHUNK_SIZE))
+    {
+        return false;
+    }
+
+    /* Predict next connection event from the last acknowledged one. */
+    uint64_t elapsed_us = APP_RTC_GetTimeUs() - app_env.time_conn_event_us;
+    uint32_t idle_us = conn_interval_us - (uint32_t) (elapsed_us % conn_interval_us);
+
+    return idle_us > (APP_SleepGetWakeupLatencyUs()
+                      + CFG_SMARTSHOT_APP_TRANSFER_SLEEP_MARGIN_US);
+}
+#endif /* (CFG_SMARTSHOT_APP_SLEEP_ENABLED == 1) && (CFG_SMARTSHOT_APP_TRANSFER_SLEEP_ENABLED == 1) */
+
+/**
+ * Decode image data of the preview and pass data read by the decoder to the
+ * image transfer.
+ *
+ * Preview decode is dropped once it is the only reason both ISP reads and the
+ * image transfer wait, so the decoder never throttles ISP.
+ */
+static void APP_PreviewProcess(void)
+{
+    if (APP_PREVIEW_Process() == true)
+    {
+        APP_PTSS_PushImageData();
+        APP_ISP_ReadNextDataChunk();
+    }
+
+    if ((APP_PREVIEW_GetUnreadSize() > 0)
+        && (CIRCBUF_GetFree(&app_env.img_cache) < SMARTSHOT_ISP_DATA_CHUNK_SIZE)
+        && (PTSS_GetMaxImageDataPushSize() > 0))
+    {
+        PRINTF("PREVIEW: Decoder fell behind image transfer, dropped\r\n");
+        APP_PREVIEW_Abort();
+
+        APP_PTSS_PushImageData();
+        APP_ISP_ReadNextDataChunk();
+    }
+}
+
 void Main_Loop(void)
 {
     bool isp_busy = false;
+    bool preview_busy = false;
 
     while (1)
     {
@@ -685,7 +834,12 @@ void Main_Loop(void)
 
         loop();
 
+        APP_PROF_ZONE_BEGIN(APP_PROF_ZONE_ISP);
         isp_busy = SMARTSHOT_ISP_MainLoop();
+        APP_PROF_ZONE_END(APP_PROF_ZONE_ISP);
+
+        APP_PreviewProcess();
+        preview_busy = APP_PREVIEW_IsBusy();
 
 
         if (SMARTSHOT_PIR_IsEventPending() == true)
@@ -749,17 +903,27 @@ void Main_Loop(void)
              * - ISP power down sequence completed.
              * - Device is in Advertising mode or Connected mode with Low Power Connection Parameters
              */
-            if ((SMARTSHOT_ISP_IsPowered() == false) &&
+            if ((SMARTSHOT_ISP_IsPowered() == false) && (preview_busy == false) &&
                 (APP_BLE_PeripheralServerIsAdvertising() ||
                  APP_BLE_PeripheralServerConnectedInLowPowerParams()))
             {
                 APP_EnterSleep();
             }
+#if (CFG_SMARTSHOT_APP_TRANSFER_SLEEP_ENABLED == 1)
+            /* Sleep between connection events during image data transfer.
+             *
+             * ISP stays powered, its pads are kept by pad retention.
+             */
+            else if (APP_TransferSleepAllowed(isp_busy || preview_busy))
+            {
+                APP_EnterSleep();
+            }
+#endif /* if (CFG_SMARTSHOT_APP_TRANSFER_SLEEP_ENABLED == 1) */
 #endif /* if (CFG_SMARTSHOT_APP_SLEEP_ENABLED == 1) */
 
 
         /* Wait for event. */
-        if (!isp_busy)
+        if (!isp_busy && !preview_busy)
         {
             SMARTSHOT_TRACE_ON_TASK_STOP_READY(app_main_task_id, 0);
             SMARTSHOT_TRACE_ON_IDLE();
@@ -64,12 +64,14 @@ void CIRCBUF_Initialize(uint8_t *p_buf, size_t buf_size, CIRCBUF_t *obj)
     obj->head = 0;
     obj->tail = 0;
     obj->is_full = false;
+    obj->pop_count = 0;
 
     ENSURE(obj->p_buf == p_buf);
     ENSURE(obj->size == buf_size);
     ENSURE(obj->head == 0);
     ENSURE(obj->tail == 0);
     ENSURE(obj->is_full == false);
+    ENSURE(obj->pop_count == 0);
 }
 
 bool CIRCBUF_IsEmpty(const CIRCBUF_t *obj)
@@ -119,12 +121,8 @@ size_t CIRCBUF_GetUsed(const CIRCBUF_t *obj)
     }
     else
     {
-        count = obj->size - obj->head;
-
-        if (obj->tail > 0)
-        {
-            count += (obj->tail - 1);
-        }
+        /* Data wrap around the end of the buffer. */
+        count = (obj->size - obj->head) + obj->tail;
     }
 
     ENSURE(count <= obj->size);
@@ -176,6 +174,8 @@ int32_t CIRCBUF_PopFront(uint8_t *p_data, size_t data_size, CIRCBUF_t *obj)
         return -1;
     }
 
+    obj->pop_count += (uint32_t) data_size;
+
     while (data_size--)
     {
         /* Read element from head. */
@@ -194,3 +194,61 @@ int32_t CIRCBUF_PopFront(uint8_t *p_data, size_t data_size, CIRCBUF_t *obj)
     ENSURE(obj->is_full == false);
     return 0;
 }
+
+void CIRCBUF_CursorInitialize(const CIRCBUF_t *obj, CIRCBUF_Cursor_t *cursor)
+{
+    REQUIRE(obj != NULL);
+    REQUIRE(cursor != NULL);
+
+    cursor->offset = obj->pop_count;
+
+    ENSURE(cursor->offset == obj->pop_count);
+}
+
+size_t CIRCBUF_CursorGetUsed(const CIRCBUF_t *obj,
+        const CIRCBUF_Cursor_t *cursor)
+{
+    REQUIRE(obj != NULL);
+    REQUIRE(cursor != NULL);
+
+    size_t used = CIRCBUF_GetUsed(obj);
+    /* Distance from the front of the buffer, wraps around with pop_count. */
+    uint32_t distance = cursor->offset - obj->pop_count;
+    size_t count = (distance > used) ? 0 : (used - distance);
+
+    ENSURE(count <= used);
+    return count;
+}
+
+int32_t CIRCBUF_CursorRead(uint8_t *p_data, size_t data_size,
+        const CIRCBUF_t *obj, CIRCBUF_Cursor_t *cursor)
+{
+    REQUIRE(p_data != NULL);
+    REQUIRE(data_size > 0);
+    REQUIRE(obj != NULL);
+    REQUIRE(cursor != NULL);
+
+    if (data_size > CIRCBUF_CursorGetUsed(obj, cursor))
+    {
+        /* Cursor is overrun or asked for more elements than available. */
+        return -1;
+    }
+
+    size_t index = (obj->head + (cursor->offset - obj->pop_count)) % obj->size;
+
+    cursor->offset += (uint32_t) data_size;
+
+    while (data_size--)
+    {
+        /* Read element at the cursor. */
+        *p_data++ = obj->p_buf[index++];
+
+        /* Rotate index if end of buffer was reached. */
+        if (index == obj->size)
+        {
+            index = 0;
+        }
+    }
+
+    return 0;
+}
@@ -37,6 +37,281 @@ static void Device_SPI0EventHandler(uint32_t event)
     SMARTSHOT_ISP_SPIEventHandler(event);
 }
 
+/* ----------------------------------------------------------------------------
+ * Lazily initialized communication peripherals
+ *
+ * External peripheral libraries access I2C0 and SPI0 through the proxy
+ * CMSIS-Driver instances below. Hardware drivers are uninitialized before
+ * deep sleep and initialized again only on the first driver call after
+ * wake-up. Wake-ups that do not use the bus (i.e. BLE connection events)
+ * therefore skip the driver bring-up completely.
+ * ------------------------------------------------------------------------- */
+
+/** State of lazily initialized CMSIS-Driver. */
+typedef struct Device_LazyDriver_t
+{
+    /** Hardware driver is initialized and ready for use. */
+    bool active;
+
+    /** Event callback passed to the last Initialize call. */
+    void (*cb_event)(uint32_t event);
+} Device_LazyDriver_t;
+
+static Device_LazyDriver_t device_i2c0_state;
+
+static Device_LazyDriver_t device_spi0_state;
+
+static void Device_I2C0Activate(void)
+{
+    if (device_i2c0_state.active == false)
+    {
+        APP_TRACE_MARK_START(APP_TRACE_MARKER_I2C0_INIT);
+
+        /* Automatic peripheral configuration must be enabled in RTE_Device.h !
+         */
+        Driver_I2C0.Initialize(device_i2c0_state.cb_event);
+        device_i2c0_state.active = true;
+
+        APP_TRACE_MARK_STOP(APP_TRACE_MARKER_I2C0_INIT);
+    }
+}
+
+static void Device_SPI0Activate(void)
+{
+    if (device_spi0_state.active == false)
+    {
+        APP_TRACE_MARK_START(APP_TRACE_MARKER_SPI0_INIT);
+
+        /* Customized local variant of SPI CMSIS-Driver is used that does not
+         * configure the SSEL pad during initialization.
+         * This is required to prevent current spike caused by protection
+         * diodes of disabled ISP from the SSEL DIO output which is configured
+         * to high level by default in RSL10 CMSIS-Pack provided code.
+         */
+        Driver_SPI0.Initialize(device_spi0_state.cb_event);
+        device_spi0_state.active = true;
+
+        APP_TRACE_MARK_STOP(APP_TRACE_MARKER_SPI0_INIT);
+    }
+}
+
+/**
+ * Uninitialize hardware drivers that were used since last wake-up to ensure
+ * that software library and hardware peripheral states match after wake-up.
+ */
+static void Device_SuspendDrivers(void)
+{
+    if (device_i2c0_state.active == true)
+    {
+        Driver_I2C0.PowerControl(ARM_POWER_OFF);
+        Driver_I2C0.Uninitialize();
+        device_i2c0_state.active = false;
+    }
+
+    if (device_spi0_state.active == true)
+    {
+        Driver_SPI0.PowerControl(ARM_POWER_OFF);
+        Driver_SPI0.Uninitialize();
+        device_spi0_state.active = false;
+    }
+}
+
+static ARM_DRIVER_VERSION Device_I2C0GetVersion(void)
+{
+    return Driver_I2C0.GetVersion();
+}
+
+static ARM_I2C_CAPABILITIES Device_I2C0GetCapabilities(void)
+{
+    return Driver_I2C0.GetCapabilities();
+}
+
+static int32_t Device_I2C0Initialize(ARM_I2C_SignalEvent_t cb_event)
+{
+    device_i2c0_state.cb_event = cb_event;
+    device_i2c0_state.active = false;
+    Device_I2C0Activate();
+
+    return ARM_DRIVER_OK;
+}
+
+static int32_t Device_I2C0Uninitialize(void)
+{
+    if (device_i2c0_state.active == true)
+    {
+        Driver_I2C0.Uninitialize();
+        device_i2c0_state.active = false;
+    }
+
+    return ARM_DRIVER_OK;
+}
+
+static int32_t Device_I2C0PowerControl(ARM_POWER_STATE state)
+{
+    if ((state == ARM_POWER_OFF) && (device_i2c0_state.active == false))
+    {
+        return ARM_DRIVER_OK;
+    }
+
+    Device_I2C0Activate();
+    return Driver_I2C0.PowerControl(state);
+}
+
+static int32_t Device_I2C0MasterTransmit(uint32_t addr, const uint8_t *data,
+        uint32_t num, bool xfer_pending)
+{
+    Device_I2C0Activate();
+    return Driver_I2C0.MasterTransmit(addr, data, num, xfer_pending);
+}
+
+static int32_t Device_I2C0MasterReceive(uint32_t addr, uint8_t *data,
+        uint32_t num, bool xfer_pending)
+{
+    Device_I2C0Activate();
+    return Driver_I2C0.MasterReceive(addr, data, num, xfer_pending);
+}
+
+static int32_t Device_I2C0SlaveTransmit(const uint8_t *data, uint32_t num)
+{
+    Device_I2C0Activate();
+    return Driver_I2C0.SlaveTransmit(data, num);
+}
+
+static int32_t Device_I2C0SlaveReceive(uint8_t *data, uint32_t num)
+{
+    Device_I2C0Activate();
+    return Driver_I2C0.SlaveReceive(data, num);
+}
+
+static int32_t Device_I2C0GetDataCount(void)
+{
+    return (device_i2c0_state.active == true) ? Driver_I2C0.GetDataCount() : 0;
+}
+
+static int32_t Device_I2C0Control(uint32_t control, uint32_t arg)
+{
+    Device_I2C0Activate();
+    return Driver_I2C0.Control(control, arg);
+}
+
+static ARM_I2C_STATUS Device_I2C0GetStatus(void)
+{
+    ARM_I2C_STATUS idle = { 0 };
+
+    return (device_i2c0_state.active == true) ? Driver_I2C0.GetStatus() : idle;
+}
+
+/** I2C0 proxy driver passed to external peripheral libraries. */
+static ARM_DRIVER_I2C Device_I2C0 =
+{
+    Device_I2C0GetVersion,
+    Device_I2C0GetCapabilities,
+    Device_I2C0Initialize,
+    Device_I2C0Uninitialize,
+    Device_I2C0PowerControl,
+    Device_I2C0MasterTransmit,
+    Device_I2C0MasterReceive,
+    Device_I2C0SlaveTransmit,
+    Device_I2C0SlaveReceive,
+    Device_I2C0GetDataCount,
+    Device_I2C0Control,
+    Device_I2C0GetStatus
+};
+
+static ARM_DRIVER_VERSION Device_SPI0GetVersion(void)
+{
+    return Driver_SPI0.GetVersion();
+}
+
+static ARM_SPI_CAPABILITIES Device_SPI0GetCapabilities(void)
+{
+    return Driver_SPI0.GetCapabilities();
+}
+
+static int32_t Device_SPI0Initialize(ARM_SPI_SignalEvent_t cb_event)
+{
+    device_spi0_state.cb_event = cb_event;
+    device_spi0_state.active = false;
+    Device_SPI0Activate();
+
+    return ARM_DRIVER_OK;
+}
+
+static int32_t Device_SPI0Uninitialize(void)
+{
+    if (device_spi0_state.active == true)
+    {
+        Driver_SPI0.Uninitialize();
+        device_spi0_state.active = false;
+    }
+
+    return ARM_DRIVER_OK;
+}
+
+static int32_t Device_SPI0PowerControl(ARM_POWER_STATE state)
+{
+    if ((state == ARM_POWER_OFF) && (device_spi0_state.active == false))
+    {
+        return ARM_DRIVER_OK;
+    }
+
+    Device_SPI0Activate();
+    return Driver_SPI0.PowerControl(state);
+}
+
+static int32_t Device_SPI0Send(const void *data, uint32_t num)
+{
+    Device_SPI0Activate();
+    return Driver_SPI0.Send(data, num);
+}
+
+static int32_t Device_SPI0Receive(void *data, uint32_t num)
+{
+    Device_SPI0Activate();
+    return Driver_SPI0.Receive(data, num);
+}
+
+static int32_t Device_SPI0Transfer(const void *data_out, void *data_in,
+        uint32_t num)
+{
+    Device_SPI0Activate();
+    return Driver_SPI0.Transfer(data_out, data_in, num);
+}
+
+static uint32_t Device_SPI0GetDataCount(void)
+{
+    return (device_spi0_state.active == true) ? Driver_SPI0.GetDataCount() : 0;
+}
+
+static int32_t Device_SPI0Control(uint32_t control, uint32_t arg)
+{
+    Device_SPI0Activate();
+    return Driver_SPI0.Control(control, arg);
+}
+
+static ARM_SPI_STATUS Device_SPI0GetStatus(void)
+{
+    ARM_SPI_STATUS idle = { 0 };
+
+    return (device_spi0_state.active == true) ? Driver_SPI0.GetStatus() : idle;
+}
+
+/** SPI0 proxy driver passed to external peripheral libraries. */
+static ARM_DRIVER_SPI Device_SPI0 =
+{
+    Device_SPI0GetVersion,
+    Device_SPI0GetCapabilities,
+    Device_SPI0Initialize,
+    Device_SPI0Uninitialize,
+    Device_SPI0PowerControl,
+    Device_SPI0Send,
+    Device_SPI0Receive,
+    Device_SPI0Transfer,
+    Device_SPI0GetDataCount,
+    Device_SPI0Control,
+    Device_SPI0GetStatus
+};
+
 static void Device_SetPowerSupplies(void)
 {
     uint8_t trim_status;
@@ -198,6 +473,7 @@ void Device_Initialize(void)
 
     /* Initialize trace functionality. */
     APP_TRACE_INIT();
+    APP_PROF_Resume();
 
     /* APP INITIALIZE  */
 
@@ -205,7 +481,7 @@ void Device_Initialize(void)
     {
         int32_t status;
 
-        APP_BLE_PeripheralServerInitialize(ATT_PTSS_COUNT + ESTSS_ATT_COUNT + DFUS_ATT_COUNT);
+        APP_BLE_PeripheralServerInitialize();
 
         status = PTSS_Initialize(APP_PTSS_EventHandler);
         ENSURE(status == PTSS_OK);
@@ -215,6 +491,9 @@ void Device_Initialize(void)
 
         status = APP_DFUS_Initialize(APP_DFU_EventHandler);
         ENSURE(status == 0);
+
+        status = PSS_Initialize();
+        ENSURE(status == 0);
     }
 
 #if (CFG_SMARTSHOT_APP_SLEEP_ENABLED == 1)
@@ -229,8 +508,8 @@ void Device_Initialize(void)
     /* Initialize peripheral drivers.
      * Automatic peripheral configuration must be enabled in RTE_Device.h !
      */
-    Driver_I2C0.Initialize(&Device_I2C0EventHandler);
-    Driver_SPI0.Initialize(&Device_SPI0EventHandler);
+    Device_I2C0.Initialize(&Device_I2C0EventHandler);
+    Device_SPI0.Initialize(&Device_SPI0EventHandler);
 
     /* Stop masking interrupts */
     __set_PRIMASK(PRIMASK_ENABLE_INTERRUPTS);
@@ -255,17 +534,17 @@ void Device_Initialize(void)
         Sys_PWM_Enable(0, PWM0_ENABLE_BITBAND);
         Sys_DIO_Config(SMARTSHOT_PIN_LED_GREEN, DIO_MODE_PWM0 | DIO_6X_DRIVE);
 
-        status = SMARTSHOT_ISP_Initialize(&Driver_I2C0, &Driver_SPI0,
+        status = SMARTSHOT_ISP_Initialize(&Device_I2C0, &Device_SPI0,
             &APP_ISP_EventHandler);
         ASSERT(status == 0);
 
         SMARTSHOT_PIR_Initialize();
 
-        status = SMARTSHOT_ENV_Initialize(&Driver_I2C0, APP_RTC_GetTimeMs,
+        status = SMARTSHOT_ENV_Initialize(&Device_I2C0, APP_RTC_GetTimeMs,
             APP_ENV_DataReadyHandler);
         ASSERT(status == 0);
 
-        status = SMARTSHOT_ACCEL_Intitialize(&Driver_I2C0, APP_RTC_GetTimeMs);
+        status = SMARTSHOT_ACCEL_Intitialize(&Device_I2C0, APP_RTC_GetTimeMs);
         ASSERT(status == 0);
     }
 }
@@ -276,6 +555,9 @@ void Device_Initialize(void)
  * - Restores system clock dividers
  * - Restores DIO pad configuration before disabling PAD retention feature.
  * - Wait for BLE stack to fully wake up.
+ *
+ * I2C and SPI drivers are not initialized here. They are initialized on first
+ * use by external peripheral library.
  */
 void Device_Wakeup(void)
 {
@@ -299,6 +581,8 @@ void Device_Wakeup(void)
     /* Initialize IO functionality. */
     SMARTSHOT_PRINTF_INIT();
     APP_TRACE_RESUME();
+    APP_TRACE_WAKEUP_REASON(APP_SleepGetWakeupReason());
+    APP_TRACE_MARK_START(APP_TRACE_MARKER_WAKEUP_IO);
 
     /* Configure push button DIO */
     Sys_DIO_Config(SMARTSHOT_PIN_PUSH_BUTTON,
@@ -315,6 +599,9 @@ void Device_Wakeup(void)
     Sys_PWM_Enable(0, PWM0_ENABLE_BITBAND);
     Sys_DIO_Config(SMARTSHOT_PIN_LED_GREEN, DIO_MODE_PWM0 | DIO_6X_DRIVE);
 
+    /* ISP library only restores its DIO pads here. SPI transfers initialize
+     * the SPI0 driver on demand.
+     */
     SMARTSHOT_ISP_HostWakeup();
 
     SMARTSHOT_PIR_HostWakeup();
@@ -327,30 +614,27 @@ void Device_Wakeup(void)
      *
      * All application managed DIO pads must be restored at this point!
      * Exception are I2C and SPI peripherals that need pad retention disabled
-     * to initialize.
+     * to initialize. These are initialized later on first use.
      */
     ACS_WAKEUP_CTRL->PADS_RETENTION_EN_BYTE = PADS_RETENTION_DISABLE_BYTE;
 
+    APP_TRACE_MARK_STOP(APP_TRACE_MARKER_WAKEUP_IO);
+
     /* Stop masking interrupts. */
     __set_FAULTMASK(FAULTMASK_ENABLE_INTERRUPTS);
     __set_PRIMASK(PRIMASK_ENABLE_INTERRUPTS);
     __enable_irq();
 
-    /* Re-initialize communication peripherals.
-     * Automatic peripheral configuration must be enabled in RTE_Device.h !
-     */
-    Driver_I2C0.Initialize(Device_I2C0EventHandler);
+    APP_TRACE_MARK_START(APP_TRACE_MARKER_WAKEUP_BLE);
 
-    /* Customized local variant of SPI CMSIS-Driver is used that does not
-     * configure the SSEL pad during initialization.
-     * This is required to prevent current spike caused by protection diodes of
-     * disabled ISP from the SSEL DIO output which is configured to high level
-     * by default in RSL10 CMSIS-Pack provided code.
+    /* Force BaseBand wake-up in case of external interrupt.
+     *
+     * Not needed when the BB timer itself woke up the system.
      */
-    Driver_SPI0.Initialize(Device_SPI0EventHandler);
-
-    /* Force BaseBand wake-up in case of external interrupt. */
-    BBIF->CTRL = BB_CLK_ENABLE | BBCLK_DIVIDER_8 | BB_WAKEUP;
+    if ((APP_SleepGetWakeupReason() & APP_SLEEP_WAKEUP_BB_TIMER) == 0)
+    {
+        BBIF->CTRL = BB_CLK_ENABLE | BBCLK_DIVIDER_8 | BB_WAKEUP;
+    }
 
     /* Disable interrupts */
    __disable_irq();
@@ -371,6 +655,8 @@ void Device_Wakeup(void)
 
    /* Stop forcing baseband to wake-up. */
    BBIF->CTRL = BB_CLK_ENABLE | BBCLK_DIVIDER_8 | BB_DEEP_SLEEP;
+
+   APP_TRACE_MARK_STOP(APP_TRACE_MARKER_WAKEUP_BLE);
 }
 
 /**
@@ -388,11 +674,7 @@ void Device_PrepareForSleep(void)
     /* Uninitialize CMSIS-Drivers to ensure that software library and hardware
      * peripheral states match after wake-up.
      */
-    Driver_I2C0.PowerControl(ARM_POWER_OFF);
-    Driver_I2C0.Uninitialize();
-
-    Driver_SPI0.PowerControl(ARM_POWER_OFF);
-    Driver_SPI0.Uninitialize();
+    Device_SuspendDrivers();
 
     for (int dio_pad = 0; dio_pad < 16; ++dio_pad)
     {
@@ -457,17 +739,7 @@ void Device_Restore(void)
 
     __enable_irq();
 
-    /* Re-initialize communication peripherals.
-     * Automatic peripheral configuration must be enabled in RTE_Device.h !
-     */
-    Driver_I2C0.Initialize(Device_I2C0EventHandler);
-    /* Customized local variant of SPI CMSIS-Driver is used that does not
-     * configure the SSEL pad during initialization.
-     * This is required to prevent current spike caused by protection diodes of
-     * disabled ISP from the SSEL DIO output which is configured to high level
-     * by default in RSL10 CMSIS-Pack provided code.
-     */
-    Driver_SPI0.Initialize(Device_SPI0EventHandler);
+    /* Communication peripherals are initialized again on first use. */
 }
 
 /* ----------------------------------------------------------------------------
@@ -0,0 +1,423 @@
+/* ----------------------------------------------------------------------------
+ * Copyright (c) 2020 Semiconductor Components Industries, LLC (d/b/a
+ * ON Semiconductor), All Rights Reserved
+ *
+ * This code is the property of ON Semiconductor and may not be redistributed
+ * in any form without prior written permission from ON Semiconductor.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between ON Semiconductor and the licensee.
+ *
+ * This is Reusable Code.
+ *
+ * ------------------------------------------------------------------------- */
+
+/**
+ * @file app_preview.c
+ *
+ * Streaming preview decode of JPEG image data during image transfer.
+ */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include <smartshot_assert.h>
+#include <smartshot_printf.h>
+
+#include "app_preview.h"
+#include "app_circbuf.h"
+#include "app_prof.h"
+#include "picojpeg/picojpeg.h"
+
+#if (CFG_SMARTSHOT_APP_PREVIEW_ENABLED == 1)
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * --------------------------------------------------------------------------*/
+
+/**
+ * Number of cached bytes ahead of the decoder required before it is allowed to
+ * run while image data are still being read from ISP.
+ */
+#define APP_PREVIEW_DECODE_THRESHOLD   (CFG_SMARTSHOT_APP_PREVIEW_LOOKAHEAD_CHUNKS \
+                                        * SMARTSHOT_ISP_DATA_CHUNK_SIZE)
+
+/* ----------------------------------------------------------------------------
+ * Types
+ * --------------------------------------------------------------------------*/
+
+typedef enum APP_PREVIEW_State_t
+{
+    /** No preview decode in progress. */
+    APP_PREVIEW_STATE_IDLE,
+
+    /** Waiting for enough data to parse JPEG headers. */
+    APP_PREVIEW_STATE_HEADER,
+
+    /** Decoding MCUs of the image. */
+    APP_PREVIEW_STATE_DECODING,
+} APP_PREVIEW_State_t;
+
+typedef struct APP_PREVIEW_Environment_t
+{
+    APP_PREVIEW_Handler handler;
+
+    APP_PREVIEW_State_t state;
+
+    /** Image cache filled from ISP and drained by the image transfer. */
+    const CIRCBUF_t *p_cache;
+
+    /** Position of the decoder in the image cache. */
+    CIRCBUF_Cursor_t cursor;
+
+    /** Number of image data bytes not yet read by the decoder. */
+    uint32_t bytes_pending;
+
+    pjpeg_decoder_t decoder;
+
+    pjpeg_image_info_t info;
+
+    /** Position of the next MCU to be decoded. */
+    uint16_t mcu_x;
+    uint16_t mcu_y;
+
+    /** Size of the box of 1/8 scale pixels averaged into one preview pixel. */
+    uint16_t factor;
+
+    /**
+     * Number of 1/8 scale pixels in the box, less than factor if the image is
+     * narrower or lower than one box.
+     */
+    uint16_t box_width;
+    uint16_t box_height;
+
+    /** Next preview row to be completed. */
+    uint16_t next_row;
+
+    APP_PREVIEW_Image_t img;
+
+    /**
+     * Sums of preview pixels of the two rows that can be accumulated at once.
+     * Indexed by the lowest bit of the preview row number.
+     */
+    uint32_t acc[2][APP_PREVIEW_WIDTH];
+} APP_PREVIEW_Environment_t;
+
+/* ----------------------------------------------------------------------------
+ * Global Variables
+ * --------------------------------------------------------------------------*/
+
+/* Stores file name when assertions are enabled. */
+DEFINE_THIS_FILE_FOR_ASSERT;
+
+static APP_PREVIEW_Environment_t app_preview_env;
+
+static uint8_t app_preview_pixels[APP_PREVIEW_WIDTH * APP_PREVIEW_HEIGHT];
+
+/* ----------------------------------------------------------------------------
+ * Function Definitions
+ * --------------------------------------------------------------------------*/
+
+/**
+ * Returns number of image data bytes cached ahead of the decoder, not counting
+ * any data beyond the reported image size.
+ */
+static size_t APP_PREVIEW_GetAvailable(void)
+{
+    size_t avail = CIRCBUF_CursorGetUsed(app_preview_env.p_cache,
+            &app_preview_env.cursor);
+
+    return (avail > app_preview_env.bytes_pending) ?
+           app_preview_env.bytes_pending : avail;
+}
+
+/**
+ * Check if the decoder can run without running out of cached data.
+ *
+ * A single MCU may span multiple ISP data chunks, so the decoder runs only
+ * while enough data are cached ahead of it or all image data were already
+ * received.
+ */
+static bool APP_PREVIEW_IsDataReady(void)
+{
+    size_t avail = APP_PREVIEW_GetAvailable();
+
+    return (avail == app_preview_env.bytes_pending)
+           || (avail >= APP_PREVIEW_DECODE_THRESHOLD);
+}
+
+/** picojpeg need bytes callback reading from the image cache. */
+static unsigned char APP_PREVIEW_NeedBytes(unsigned char *p_buf,
+        unsigned char buf_size, unsigned char *p_bytes_read,
+        void *p_callback_data)
+{
+    size_t avail = APP_PREVIEW_GetAvailable();
+
+    (void) p_callback_data;
+
+    if (avail > buf_size)
+    {
+        avail = buf_size;
+    }
+
+    *p_bytes_read = (unsigned char) avail;
+
+    if (avail > 0)
+    {
+        int32_t status = CIRCBUF_CursorRead(p_buf, avail,
+                app_preview_env.p_cache, &app_preview_env.cursor);
+        ENSURE(status == 0);
+
+        app_preview_env.bytes_pending -= (uint32_t) avail;
+
+        (void) status;
+    }
+    else if (app_preview_env.bytes_pending > 0)
+    {
+        /* Compressed MCU or JPEG headers larger than the data cached ahead of
+         * the decoder.
+         */
+        return PJPG_STREAM_READ_ERROR;
+    }
+
+    return 0;
+}
+
+/**
+ * Parse JPEG headers and compute preview dimensions.
+ *
+ * @return
+ * true - Image can be decoded. <br>
+ * false - Unsupported or corrupted image.
+ */
+static bool APP_PREVIEW_BeginImage(void)
+{
+    APP_PREVIEW_Environment_t *p_env = &app_preview_env;
+    uint16_t src_width, src_height;
+    uint16_t factor_y;
+    uint8_t status;
+
+    status = pjpeg_decoder_init(&p_env->decoder, &p_env->info,
+            APP_PREVIEW_NeedBytes, NULL, PJPG_REDUCE_1_8);
+    if (status != 0)
+    {
+        PRINTF("PREVIEW: Header decode failed (err=%d)\r\n", status);
+        return false;
+    }
+
+    /* Decoding at 1/8 scale yields one pixel per 8x8 block. */
+    src_width = (uint16_t) ((p_env->info.m_width + 7) >> 3);
+    src_height = (uint16_t) ((p_env->info.m_height + 7) >> 3);
+
+    p_env->factor = (uint16_t) ((src_width + APP_PREVIEW_WIDTH - 1)
+                                / APP_PREVIEW_WIDTH);
+    factor_y = (uint16_t) ((src_height + APP_PREVIEW_HEIGHT - 1)
+                           / APP_PREVIEW_HEIGHT);
+    if (factor_y > p_env->factor)
+    {
+        p_env->factor = factor_y;
+    }
+
+    /* Images narrower or lower than one box, e.g. 8x1000 pixels, have a
+     * single preview pixel in that direction from the blocks there are.
+     */
+    p_env->box_width = (src_width < p_env->factor) ? src_width : p_env->factor;
+    p_env->box_height = (src_height < p_env->factor) ? src_height : p_env->factor;
+
+    p_env->img.p_pixels = app_preview_pixels;
+    p_env->img.width = src_width / p_env->box_width;
+    p_env->img.height = src_height / p_env->box_height;
+    p_env->img.img_width = (uint16_t) p_env->info.m_width;
+    p_env->img.img_height = (uint16_t) p_env->info.m_height;
+
+    p_env->mcu_x = 0;
+    p_env->mcu_y = 0;
+    p_env->next_row = 0;
+    memset(p_env->acc, 0, sizeof(p_env->acc));
+
+    return true;
+}
+
+/** Add pixels of the last decoded MCU to the preview pixel sums. */
+static void APP_PREVIEW_AccumulateMCU(void)
+{
+    APP_PREVIEW_Environment_t *p_env = &app_preview_env;
+    const pjpeg_image_info_t *p_info = &p_env->info;
+    uint8_t blocks_x = (uint8_t) (p_info->m_MCUWidth >> 3);
+    uint8_t blocks_y = (uint8_t) (p_info->m_MCUHeight >> 3);
+
+    for (uint8_t by = 0; by < blocks_y; ++by)
+    {
+        uint16_t py = (uint16_t) ((p_env->mcu_y * blocks_y + by) / p_env->factor);
+
+        if (py >= p_env->img.height)
+        {
+            break;
+        }
+
+        for (uint8_t bx = 0; bx < blocks_x; ++bx)
+        {
+            uint16_t px = (uint16_t) ((p_env->mcu_x * blocks_x + bx) / p_env->factor);
+            /* Reduced blocks hold their single pixel at the block start. */
+            uint16_t ofs = (uint16_t) (((by << 1) + bx) << 6);
+            uint8_t luma;
+
+            if (px >= p_env->img.width)
+            {
+                break;
+            }
+
+            if (p_info->m_comps == 3)
+            {
+                luma = (uint8_t) ((77 * p_info->m_pMCUBufR[ofs]
+                                   + 150 * p_info->m_pMCUBufG[ofs]
+                                   + 29 * p_info->m_pMCUBufB[ofs] + 128) >> 8);
+            }
+            else
+            {
+                luma = p_info->m_pMCUBufR[ofs];
+            }
+
+            p_env->acc[py & 1][px] += luma;
+        }
+    }
+}
+
+/**
+ * Advance to the next MCU and store preview rows that received all of their
+ * pixels.
+ */
+static void APP_PREVIEW_NextMCU(void)
+{
+    APP_PREVIEW_Environment_t *p_env = &app_preview_env;
+    uint32_t box = (uint32_t) p_env->box_width * p_env->box_height;
+    uint32_t rows_done;
+
+    if (++p_env->mcu_x < p_env->info.m_MCUSPerRow)
+    {
+        return;
+    }
+
+    p_env->mcu_x = 0;
+    p_env->mcu_y++;
+
+    rows_done = (uint32_t) p_env->mcu_y * (p_env->info.m_MCUHeight >> 3);
+
+    while ((p_env->next_row < p_env->img.height)
+           && ((uint32_t) p_env->next_row * p_env->factor + p_env->box_height
+               <= rows_done))
+    {
+        uint32_t *p_acc = p_env->acc[p_env->next_row & 1];
+        uint8_t *p_row = app_preview_pixels
+                         + (p_env->next_row * p_env->img.width);
+
+        for (uint16_t px = 0; px < p_env->img.width; ++px)
+        {
+            p_row[px] = (uint8_t) ((p_acc[px] + (box >> 1)) / box);
+            p_acc[px] = 0;
+        }
+
+        p_env->next_row++;
+    }
+}
+
+void APP_PREVIEW_Initialize(APP_PREVIEW_Handler handler)
+{
+    REQUIRE(handler != NULL);
+
+    app_preview_env.handler = handler;
+    app_preview_env.state = APP_PREVIEW_STATE_IDLE;
+}
+
+void APP_PREVIEW_Start(const CIRCBUF_t *p_cache, uint32_t img_size)
+{
+    REQUIRE(p_cache != NULL);
+
+    app_preview_env.p_cache = p_cache;
+    CIRCBUF_CursorInitialize(p_cache, &app_preview_env.cursor);
+
+    app_preview_env.bytes_pending = img_size;
+    app_preview_env.state = (img_size > 0) ? APP_PREVIEW_STATE_HEADER :
+                                             APP_PREVIEW_STATE_IDLE;
+}
+
+void APP_PREVIEW_Abort(void)
+{
+    app_preview_env.state = APP_PREVIEW_STATE_IDLE;
+}
+
+size_t APP_PREVIEW_GetUnreadSize(void)
+{
+    if (app_preview_env.state == APP_PREVIEW_STATE_IDLE)
+    {
+        return 0;
+    }
+
+    return CIRCBUF_CursorGetUsed(app_preview_env.p_cache,
+            &app_preview_env.cursor);
+}
+
+bool APP_PREVIEW_IsBusy(void)
+{
+    return (app_preview_env.state != APP_PREVIEW_STATE_IDLE)
+           && APP_PREVIEW_IsDataReady();
+}
+
+bool APP_PREVIEW_Process(void)
+{
+    APP_PREVIEW_Environment_t *p_env = &app_preview_env;
+    uint32_t offset = p_env->cursor.offset;
+    uint32_t budget = CFG_SMARTSHOT_APP_PREVIEW_MCUS_PER_LOOP;
+
+    if (APP_PREVIEW_IsBusy() == false)
+    {
+        return false;
+    }
+
+    APP_PROF_ZONE_BEGIN(APP_PROF_ZONE_PREVIEW);
+
+    if (p_env->state == APP_PREVIEW_STATE_HEADER)
+    {
+        p_env->state = APP_PREVIEW_BeginImage() ? APP_PREVIEW_STATE_DECODING :
+                                                  APP_PREVIEW_STATE_IDLE;
+    }
+
+    while ((p_env->state == APP_PREVIEW_STATE_DECODING) && (budget > 0)
+           && APP_PREVIEW_IsDataReady())
+    {
+        uint8_t status = pjpeg_decoder_decode_mcu(&p_env->decoder);
+
+        if (status != 0)
+        {
+            PRINTF("PREVIEW: MCU decode failed (err=%d)\r\n", status);
+            p_env->state = APP_PREVIEW_STATE_IDLE;
+            break;
+        }
+
+        APP_PREVIEW_AccumulateMCU();
+        APP_PREVIEW_NextMCU();
+        APP_PROF_COUNTER_ADD(APP_PROF_CNT_PREVIEW_MCUS, 1);
+        budget--;
+
+        /* Complete the preview without waiting for the rest of the data. */
+        if (p_env->mcu_y == p_env->info.m_MCUSPerCol)
+        {
+            p_env->state = APP_PREVIEW_STATE_IDLE;
+            p_env->handler(&p_env->img);
+        }
+    }
+
+    APP_PROF_ZONE_END(APP_PROF_ZONE_PREVIEW);
+
+    /* Decoder read more image data or released them with the preview. */
+    return (p_env->cursor.offset != offset)
+           || (p_env->state == APP_PREVIEW_STATE_IDLE);
+}
+
+#endif /* if (CFG_SMARTSHOT_APP_PREVIEW_ENABLED == 1) */
+
+/* ----------------------------------------------------------------------------
+ * End of File
+ * ------------------------------------------------------------------------- */
@@ -0,0 +1,150 @@
+/* ----------------------------------------------------------------------------
+ * Copyright (c) 2020 Semiconductor Components Industries, LLC (d/b/a
+ * ON Semiconductor), All Rights Reserved
+ *
+ * This code is the property of ON Semiconductor and may not be redistributed
+ * in any form without prior written permission from ON Semiconductor.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between ON Semiconductor and the licensee.
+ *
+ * This is Reusable Code.
+ *
+ * ------------------------------------------------------------------------- */
+
+/**
+ * @file app_prof.c
+ *
+ * Storage and reporting of always-on profiling counters.
+ */
+
+#include <string.h>
+
+#include <cycle_counter.h>
+#include <smartshot_printf.h>
+
+#include "app_prof.h"
+
+APP_PROF_Zone_t app_prof_zone[APP_PROF_ZONE_COUNT];
+
+uint32_t app_prof_counter[APP_PROF_CNT_COUNT];
+
+APP_PROF_Gauge_t app_prof_gauge[APP_PROF_GAUGE_COUNT];
+
+#if (CFG_SMARTSHOT_PRINTF_INTERFACE != SMARTSHOT_PRINTF_INTERFACE_DISABLED)
+static const char *app_prof_zone_name[APP_PROF_ZONE_COUNT] =
+{
+    [APP_PROF_ZONE_ISP]           = "isp",
+    [APP_PROF_ZONE_PTSS_PUSH]     = "ptss_push",
+    [APP_PROF_ZONE_ESTSS_NOTIFY]  = "estss_notify",
+    [APP_PROF_ZONE_TFLM_INVOKE]   = "tflm_invoke",
+    [APP_PROF_ZONE_SLEEP_PREPARE] = "sleep_prepare",
+    [APP_PROF_ZONE_SLEEP_WAKEUP]  = "sleep_wakeup",
+    [APP_PROF_ZONE_PREVIEW]       = "preview",
+};
+
+static const char *app_prof_counter_name[APP_PROF_CNT_COUNT] =
+{
+    [APP_PROF_CNT_ISP_BYTES]     = "isp_bytes",
+    [APP_PROF_CNT_PTSS_BYTES]    = "ptss_bytes",
+    [APP_PROF_CNT_ESTSS_NOTIFY]  = "estss_notify",
+    [APP_PROF_CNT_SLEEP_WAKEUP]  = "sleep_wakeup",
+    [APP_PROF_CNT_SLEEP_REFUSED] = "sleep_refused",
+    [APP_PROF_CNT_PREVIEW_MCUS]  = "preview_mcus",
+};
+
+static const char *app_prof_gauge_name[APP_PROF_GAUGE_COUNT] =
+{
+    [APP_PROF_GAUGE_IMG_CACHE_USED] = "img_cache_used",
+};
+#endif /* if (CFG_SMARTSHOT_PRINTF_INTERFACE != SMARTSHOT_PRINTF_INTERFACE_DISABLED) */
+
+void APP_PROF_Resume(void)
+{
+#if (CFG_SMARTSHOT_PROF_ENABLED == 1)
+    CycleCounter_Enable();
+#endif /* if (CFG_SMARTSHOT_PROF_ENABLED == 1) */
+}
+
+void APP_PROF_Reset(void)
+{
+    memset(app_prof_zone, 0, sizeof(app_prof_zone));
+    memset(app_prof_counter, 0, sizeof(app_prof_counter));
+    memset(app_prof_gauge, 0, sizeof(app_prof_gauge));
+}
+
+void APP_PROF_Print(void)
+{
+#if (CFG_SMARTSHOT_PRINTF_INTERFACE != SMARTSHOT_PRINTF_INTERFACE_DISABLED)
+    uint32_t cycles_per_us = SystemCoreClock / 1000000;
+
+    for (int i = 0; i < APP_PROF_ZONE_COUNT; ++i)
+    {
+        const APP_PROF_Zone_t *p_zone = &app_prof_zone[i];
+
+        if (p_zone->count > 0)
+        {
+            PRINTF("PROF: %s count=%lu avg=%lu us max=%lu us\r\n",
+                    app_prof_zone_name[i], p_zone->count,
+                    (uint32_t) (p_zone->total_cycles / p_zone->count
+                                / cycles_per_us),
+                    p_zone->max_cycles / cycles_per_us);
+        }
+    }
+
+    for (int i = 0; i < APP_PROF_CNT_COUNT; ++i)
+    {
+        PRINTF("PROF: %s=%lu\r\n", app_prof_counter_name[i],
+                app_prof_counter[i]);
+    }
+
+    for (int i = 0; i < APP_PROF_GAUGE_COUNT; ++i)
+    {
+        PRINTF("PROF: %s=%lu peak=%lu\r\n", app_prof_gauge_name[i],
+                app_prof_gauge[i].value, app_prof_gauge[i].peak);
+    }
+#endif /* if (CFG_SMARTSHOT_PRINTF_INTERFACE != SMARTSHOT_PRINTF_INTERFACE_DISABLED) */
+}
+
+/** Store 32-bit value in little endian format and advance buffer pointer. */
+static uint8_t * APP_PROF_PutU32(uint8_t *p_buf, uint32_t value)
+{
+    p_buf[0] = (uint8_t) value;
+    p_buf[1] = (uint8_t) (value >> 8);
+    p_buf[2] = (uint8_t) (value >> 16);
+    p_buf[3] = (uint8_t) (value >> 24);
+
+    return p_buf + 4;
+}
+
+void APP_PROF_Snapshot(uint8_t *p_buf)
+{
+    *p_buf++ = APP_PROF_SNAPSHOT_VERSION;
+    *p_buf++ = APP_PROF_ZONE_COUNT;
+    *p_buf++ = APP_PROF_CNT_COUNT;
+    *p_buf++ = APP_PROF_GAUGE_COUNT;
+    p_buf = APP_PROF_PutU32(p_buf, SystemCoreClock);
+
+    for (int i = 0; i < APP_PROF_ZONE_COUNT; ++i)
+    {
+        p_buf = APP_PROF_PutU32(p_buf, app_prof_zone[i].count);
+        p_buf = APP_PROF_PutU32(p_buf, app_prof_zone[i].max_cycles);
+        p_buf = APP_PROF_PutU32(p_buf, (uint32_t) app_prof_zone[i].total_cycles);
+        p_buf = APP_PROF_PutU32(p_buf,
+                (uint32_t) (app_prof_zone[i].total_cycles >> 32));
+    }
+
+    for (int i = 0; i < APP_PROF_CNT_COUNT; ++i)
+    {
+        p_buf = APP_PROF_PutU32(p_buf, app_prof_counter[i]);
+    }
+
+    for (int i = 0; i < APP_PROF_GAUGE_COUNT; ++i)
+    {
+        p_buf = APP_PROF_PutU32(p_buf, app_prof_gauge[i].value);
+        p_buf = APP_PROF_PutU32(p_buf, app_prof_gauge[i].peak);
+    }
+}
+
+/* ----------------------------------------------------------------------------
+ * End of File
+ * ------------------------------------------------------------------------- */
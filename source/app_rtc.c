@@ -52,32 +52,39 @@ uint32_t APP_RTC_GetTicks(void)
     return rtc_time;
 }
 
-uint32_t APP_RTC_GetTimeMs(void)
+uint64_t APP_RTC_GetTicks64(void)
 {
-    static uint32_t ms_time = 0;
-    static uint32_t tick_checkpoint = 0;
+    /* Upper 32 bits of the tick counter and the last observed RTC ticks used
+     * to detect counter reload.
+     */
+    static uint32_t ticks_high = 0;
+    static uint32_t ticks_last = 0;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
 
     uint32_t now = APP_RTC_GetTicks();
-    uint32_t diff = (now - tick_checkpoint) / 32;
+    if (now < ticks_last)
+    {
+        ticks_high += 1;
+    }
+    ticks_last = now;
 
-    ms_time += diff;
-    tick_checkpoint += (diff * 32);
+    uint64_t ticks = ((uint64_t) ticks_high << 32) | now;
 
-    return ms_time;
+    __set_PRIMASK(primask);
+
+    return ticks;
 }
 
-uint64_t APP_RTC_GetTimeUs(void)
+uint32_t APP_RTC_GetTimeMs(void)
 {
-    static uint64_t us_time = 0;
-    static uint32_t tick_checkpoint = 0;
-
-    uint32_t now = APP_RTC_GetTicks();
-    uint64_t diff = (uint64_t)(now - tick_checkpoint) * 30;
-
-    us_time += diff;
-    tick_checkpoint += (diff / 30);
+    return (uint32_t) APP_RTC_TicksToMs(APP_RTC_GetTicks64());
+}
 
-    return us_time;
+uint64_t APP_RTC_GetTimeUs(void)
+{
+    return APP_RTC_TicksToUs(APP_RTC_GetTicks64());
 }
 
 /* ----------------------------------------------------------------------------
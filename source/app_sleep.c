@@ -26,6 +26,93 @@ DEFINE_THIS_FILE_FOR_ASSERT;
 /** Sleep mode environment structure used when entering sleep mode. */
 static struct sleep_mode_env_tag app_sleep_mode_env;
 
+/** Sources of the last deep sleep wake-up. */
+static uint32_t app_sleep_wakeup_reason;
+
+/** Measured cost of entering into and waking up from deep sleep. */
+static struct
+{
+    /** Estimated duration of Device_PrepareForSleep in us. */
+    uint32_t prepare_us;
+
+    /** Estimated duration of Device_Wakeup in us. */
+    uint32_t wakeup_us;
+} app_sleep_cost;
+
+/**
+ * Update latency estimate with new measurement.
+ *
+ * Worst case is taken immediately while lower measurements decrease the
+ * estimate only by 1/8 of the difference.
+ */
+static uint32_t APP_SleepCostUpdate(uint32_t estimate, uint64_t sample)
+{
+    if (sample >= estimate)
+    {
+        return (uint32_t) sample;
+    }
+
+    return estimate - ((estimate - (uint32_t) sample) >> 3);
+}
+
+uint32_t APP_SleepGetWakeupLatencyUs(void)
+{
+    return app_sleep_cost.prepare_us + app_sleep_cost.wakeup_us
+           + APP_SLEEP_WAKEUP_HW_LATENCY_US;
+}
+
+uint32_t APP_SleepGetWakeupReason(void)
+{
+    return app_sleep_wakeup_reason;
+}
+
+/**
+ * Decode wake-up sources from ACS_WAKEUP_CTRL register value.
+ *
+ * Wake-up event status flags share bit positions with their respective
+ * *_CLEAR bits. DIO[0-3] event flags occupy consecutive bits.
+ */
+static uint32_t APP_SleepDecodeWakeupReason(uint32_t wakeup_ctrl)
+{
+    uint32_t reason = APP_SLEEP_WAKEUP_NONE;
+    uint32_t other = (WAKEUP_DCDC_OVERLOAD_CLEAR | WAKEUP_PAD_EVENT_CLEAR
+                      | WAKEUP_DIO3_EVENT_CLEAR | WAKEUP_DIO2_EVENT_CLEAR
+                      | WAKEUP_DIO1_EVENT_CLEAR | WAKEUP_DIO0_EVENT_CLEAR);
+
+    if ((wakeup_ctrl & WAKEUP_RTC_ALARM_CLEAR) != 0)
+    {
+        reason |= APP_SLEEP_WAKEUP_RTC_ALARM;
+    }
+
+    if ((wakeup_ctrl & WAKEUP_BB_TIMER_CLEAR) != 0)
+    {
+        reason |= APP_SLEEP_WAKEUP_BB_TIMER;
+    }
+
+#if ((SMARTSHOT_PIR_IRQ_DIO_NUM >= 0) && (SMARTSHOT_PIR_IRQ_DIO_NUM <= 3))
+    if ((wakeup_ctrl & (WAKEUP_DIO0_EVENT_CLEAR << SMARTSHOT_PIR_IRQ_DIO_NUM)) != 0)
+    {
+        reason |= APP_SLEEP_WAKEUP_PIR;
+    }
+    other &= ~(WAKEUP_DIO0_EVENT_CLEAR << SMARTSHOT_PIR_IRQ_DIO_NUM);
+#endif /* if ((SMARTSHOT_PIR_IRQ_DIO_NUM >= 0) && (SMARTSHOT_PIR_IRQ_DIO_NUM <= 3)) */
+
+#if ((SMARTSHOT_ACCEL_INT1_DIO_NUM >= 0) && (SMARTSHOT_ACCEL_INT1_DIO_NUM <= 3))
+    if ((wakeup_ctrl & (WAKEUP_DIO0_EVENT_CLEAR << SMARTSHOT_ACCEL_INT1_DIO_NUM)) != 0)
+    {
+        reason |= APP_SLEEP_WAKEUP_ACCEL;
+    }
+    other &= ~(WAKEUP_DIO0_EVENT_CLEAR << SMARTSHOT_ACCEL_INT1_DIO_NUM);
+#endif /* if ((SMARTSHOT_ACCEL_INT1_DIO_NUM >= 0) && (SMARTSHOT_ACCEL_INT1_DIO_NUM <= 3)) */
+
+    if ((wakeup_ctrl & other) != 0)
+    {
+        reason |= APP_SLEEP_WAKEUP_OTHER;
+    }
+
+    return reason;
+}
+
 /**
  * Start up XTAL32K oscillator to be used as STANDBYCLK clock source.
  *
@@ -296,13 +383,23 @@ void APP_SleepModeConfigure(void)
 
 void APP_EnterSleep(void)
 {
+    uint64_t prepare_start = APP_RTC_GetTimeUs();
+
     /* Disable all peripherals and configure DIO pads for sleep. */
+    APP_PROF_ZONE_BEGIN(APP_PROF_ZONE_SLEEP_PREPARE);
     Device_PrepareForSleep();
+    APP_PROF_ZONE_END(APP_PROF_ZONE_SLEEP_PREPARE);
+
+    app_sleep_cost.prepare_us = APP_SleepCostUpdate(app_sleep_cost.prepare_us,
+            APP_RTC_GetTimeUs() - prepare_start);
 
     /* Clear all reset flags. */
     ACS->RESET_STATUS = 0x7F;
     DIG->RESET_STATUS = 0xF0;
 
+    /* Wake-up reason is updated only if deep sleep mode is entered. */
+    app_sleep_wakeup_reason = APP_SLEEP_WAKEUP_NONE;
+
     /* Attempt to enter into deep sleep mode. */
     __disable_irq();
     BLE_Power_Mode_Enter(&app_sleep_mode_env, POWER_MODE_SLEEP);
@@ -310,6 +407,7 @@ void APP_EnterSleep(void)
 
     /* Restore Device State if BLE stack refused to enter into
      * low power mode */
+    APP_PROF_COUNTER_ADD(APP_PROF_CNT_SLEEP_REFUSED, 1);
     Device_Restore();
 
     /* Execute any pending BLE events */
@@ -327,8 +425,22 @@ void Wakeup_From_Sleep_Application(void)
 
 void ContinueApplication(void)
 {
+    uint64_t wakeup_start = APP_RTC_GetTimeUs();
+
+    /* Capture wake-up event flags. They are cleared on next sleep entry. */
+    app_sleep_wakeup_reason = APP_SleepDecodeWakeupReason(ACS->WAKEUP_CTRL);
+
+    /* Debug block is not retained in deep sleep. */
+    APP_PROF_Resume();
+    APP_PROF_COUNTER_ADD(APP_PROF_CNT_SLEEP_WAKEUP, 1);
+
     /* Restore device configuration. */
+    APP_PROF_ZONE_BEGIN(APP_PROF_ZONE_SLEEP_WAKEUP);
     Device_Wakeup();
+    APP_PROF_ZONE_END(APP_PROF_ZONE_SLEEP_WAKEUP);
+
+    app_sleep_cost.wakeup_us = APP_SleepCostUpdate(app_sleep_cost.wakeup_us,
+            APP_RTC_GetTimeUs() - wakeup_start);
 
     /* Continue application from main loop. */
     Main_Loop();
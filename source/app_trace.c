@@ -76,8 +76,8 @@ const uint32_t app_main_task_id = (uint32_t) &app_main_task_id;
  */
 const uint32_t app_sleep_task_id = (uint32_t) &app_sleep_task_id;
 
-/** Stores system time in us when switching to deep sleep mode. */
-static uint64_t app_trace_sleep_enter_time;
+/** Stores RTC ticks when switching to deep sleep mode. */
+static uint64_t app_trace_sleep_enter_ticks;
 
 /** Stores value of SYSTICK counter when switching to deep sleep mode. */
 static uint32_t app_trace_sleep_enter_counter;
@@ -149,16 +149,21 @@ void APP_TRACE_SLEEP(void)
     /* Save current RTC time and systick counter to restore timebase after
      * wake-up.
      */
-    app_trace_sleep_enter_time = APP_RTC_GetTimeUs();
+    app_trace_sleep_enter_ticks = APP_RTC_GetTicks64();
     app_trace_sleep_enter_counter = SYSCTRL->SYSCLK_CNT;
 }
 
 void APP_TRACE_RESUME(void)
 {
-    /* Restore SYSCLK counter and adjust for sleep duration. */
-    uint64_t rtc_time = APP_RTC_GetTimeUs();
-    SYSCTRL->SYSCLK_CNT = app_trace_sleep_enter_counter;
-    SYSCTRL->SYSCLK_CNT += ((rtc_time - app_trace_sleep_enter_time) * (SystemCoreClock / 1E6));
+    /* Restore SYSCLK counter and adjust for sleep duration.
+     *
+     * Sleep duration is converted from RTC ticks directly into SYSCLK cycles
+     * to avoid rounding error of intermediate time units.
+     */
+    uint64_t sleep_ticks = APP_RTC_GetTicks64() - app_trace_sleep_enter_ticks;
+    SYSCTRL->SYSCLK_CNT = app_trace_sleep_enter_counter
+            + (uint32_t) ((sleep_ticks * SystemCoreClock)
+                          / APP_RTC_TICKS_PER_SECOND);
     SYSCTRL_CNT_CTRL->CNT_START_ALIAS = 1;
 
     SEGGER_SYSVIEW_OnTaskStartExec(app_main_task_id);
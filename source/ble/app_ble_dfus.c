@@ -36,6 +36,7 @@ static uint8_t DFUS_Handler(uint8_t conidx, uint16_t attidx,
 static DFUS_Environment_t dfus_env;
 
 /** Complete attribute database of the DFUS. */
+APP_BLE_CS_ATT_DB_SECTION(03)
 const static struct att_db_desc dfus_att_db[DFUS_ATT_COUNT] =
 {
     /* Device Firmware Update Service 0 */
@@ -124,7 +125,7 @@ int32_t APP_DFUS_Initialize(DFUS_DfuEnterCallback_t p_dfu_enter_cb)
 
     /* Add custom attributes into the attribute database. */
     status = APP_BLE_PeripheralServerAddCustomService(dfus_att_db,
-            DFUS_ATT_COUNT, &dfus_env.att.attidx_offset);
+            DFUS_ATT_COUNT, APP_BLE_CS_ATTIDX_DFUS);
     if (status != 0)
     {
         return -1;
@@ -138,10 +139,10 @@ static uint8_t DFUS_Handler(uint8_t conidx, uint16_t attidx, uint16_t handle,
         uint8_t *to, const uint8_t *from, uint16_t length,
         uint16_t operation)
 {
-    REQUIRE(attidx > dfus_env.att.attidx_offset);
-    REQUIRE(attidx < (dfus_env.att.attidx_offset + DFUS_ATT_COUNT));
+    REQUIRE(attidx > APP_BLE_CS_ATTIDX_DFUS);
+    REQUIRE(attidx < (APP_BLE_CS_ATTIDX_DFUS + DFUS_ATT_COUNT));
 
-    const uint16_t dfus_attidx = attidx - dfus_env.att.attidx_offset;
+    const uint16_t dfus_attidx = attidx - APP_BLE_CS_ATTIDX_DFUS;
 
     if (operation == GATTC_WRITE_REQ_IND)
     {
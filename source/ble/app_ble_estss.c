@@ -14,6 +14,7 @@
 
 #include <app_ble_estss_int.h>
 #include <app_ble_peripheral_server.h>
+#include <app_prof.h>
 #include <msg_handler.h>
 
 #include <smartshot_assert.h>
@@ -41,6 +42,7 @@ static uint8_t ESTSS_TimeTriggerSettingUpdateHandler(uint8_t conidx,
 static ESTSS_Environment_t estss_env;
 
 /** Complete attribute database of the ESTSS. */
+APP_BLE_CS_ATT_DB_SECTION(02)
 const static struct att_db_desc estss_att_db[ESTSS_ATT_COUNT] =
 {
     /* External Sensor Trigger Service 0 */
@@ -240,28 +242,14 @@ const static uint16_t estss_value_trigger_setting_atlas[ESTSS_TRIGGER_COUNT] =
  */
 static ESTSS_TriggerId_t ESTSS_GetTriggerIdFromAttidx(uint16_t attidx)
 {
-    REQUIRE(attidx > estss_env.att.attidx_offset);
-    REQUIRE(attidx < (estss_env.att.attidx_offset + ESTSS_ATT_COUNT));
+    REQUIRE(attidx > APP_BLE_CS_ATTIDX_ESTSS);
+    REQUIRE(attidx < (APP_BLE_CS_ATTIDX_ESTSS + ESTSS_ATT_COUNT));
 
-    uint16_t estss_attidx = attidx - estss_env.att.attidx_offset;
-    ESTSS_TriggerId_t tidx;
+    uint16_t estss_attidx = attidx - APP_BLE_CS_ATTIDX_ESTSS;
 
-    if (estss_attidx < ESTSS_ATT_ACCELERATION_CHAR_0)
-    {
-        tidx = ESTSS_TRIGGER_MOTION;
-    }
-    else if (estss_attidx < ESTSS_ATT_TEMPERATURE_CHAR_0)
-    {
-        tidx = ESTSS_TRIGGER_ACCELERATION;
-    }
-    else if (estss_attidx < ESTSS_ATT_HUMIDITY_CHAR_0)
-    {
-        tidx = ESTSS_TRIGGER_TEMPERATURE;
-    }
-    else
-    {
-        tidx = ESTSS_TRIGGER_HUMIDITY;
-    }
+    /* All trigger characteristics have the same number of attributes. */
+    ESTSS_TriggerId_t tidx = (ESTSS_TriggerId_t)
+            ((estss_attidx - ESTSS_ATT_MOTION_CHAR_0) / ESTSS_CHAR_ATT_COUNT);
 
     ENSURE(tidx < ESTSS_TRIGGER_COUNT);
     return tidx;
@@ -511,6 +499,8 @@ static void ESTSS_NotifyValue(ESTSS_TriggerId_t tidx)
 
     REQUIRE(tidx < ESTSS_TRIGGER_COUNT);
 
+    APP_PROF_ZONE_BEGIN(APP_PROF_ZONE_ESTSS_NOTIFY);
+
     ESTSS_Characteristic_t *p_char = estss_env.att.trigger + tidx;
 
     /* Clear notify pending flag and update last notify timestamp. */
@@ -518,7 +508,7 @@ static void ESTSS_NotifyValue(ESTSS_TriggerId_t tidx)
     p_char->trig.ntf_last_timestamp = estss_env.p_time_cb();
 
     /* Calculate attidx of the characteristic's value attribute. */
-    uint16_t attidx = estss_env.att.attidx_offset
+    uint16_t attidx = APP_BLE_CS_ATTIDX_ESTSS
                       + ESTSS_ATT_MOTION_VAL_0
                       + (tidx * ESTSS_CHAR_ATT_COUNT);
     uint16_t handle = GATTM_GetHandle(attidx);
@@ -527,6 +517,9 @@ static void ESTSS_NotifyValue(ESTSS_TriggerId_t tidx)
     GATTC_SendEvtCmd(0, GATTC_NOTIFY, attidx, handle, ESTSS_CHAR_VALUE_SIZE,
             p_char->value);
 
+    APP_PROF_COUNTER_ADD(APP_PROF_CNT_ESTSS_NOTIFY, 1);
+    APP_PROF_ZONE_END(APP_PROF_ZONE_ESTSS_NOTIFY);
+
     PRINTF("ESTSS: Notify tidx=%d\r\n", tidx);
 }
 
@@ -608,7 +601,7 @@ static uint8_t ESTSS_TriggerValueReadHandler(uint8_t conidx, uint16_t attidx,
 {
     REQUIRE(conidx == 0);
     REQUIRE(operation == GATTC_READ_REQ_IND);
-    REQUIRE(attidx > estss_env.att.attidx_offset);
+    REQUIRE(attidx > APP_BLE_CS_ATTIDX_ESTSS);
     REQUIRE(length == ESTSS_CHAR_VALUE_SIZE);
 
     ESTSS_TriggerId_t tidx = ESTSS_GetTriggerIdFromAttidx(attidx);
@@ -655,7 +648,7 @@ static uint8_t ESTSS_TriggerCCCUpdateHandler(uint8_t conidx, uint16_t attidx,
 {
     REQUIRE(conidx == 0);
     REQUIRE(operation == GATTC_READ_REQ_IND || operation == GATTC_WRITE_REQ_IND);
-    REQUIRE(attidx > estss_env.att.attidx_offset);
+    REQUIRE(attidx > APP_BLE_CS_ATTIDX_ESTSS);
 
     const ESTSS_TriggerId_t tidx = ESTSS_GetTriggerIdFromAttidx(attidx);
     uint8_t status = ATT_ERR_NO_ERROR;
@@ -724,7 +717,7 @@ static uint8_t ESTSS_ValueTriggerSettingUpdateHandler(uint8_t conidx,
 {
     REQUIRE(conidx == 0);
     REQUIRE(operation == GATTC_READ_REQ_IND || operation == GATTC_WRITE_REQ_IND);
-    REQUIRE(attidx > estss_env.att.attidx_offset);
+    REQUIRE(attidx > APP_BLE_CS_ATTIDX_ESTSS);
     REQUIRE(length >= 1);
 
     const ESTSS_TriggerId_t tidx = ESTSS_GetTriggerIdFromAttidx(attidx);
@@ -834,7 +827,7 @@ static uint8_t ESTSS_TimeTriggerSettingUpdateHandler(uint8_t conidx,
 {
     REQUIRE(conidx == 0);
     REQUIRE(operation == GATTC_READ_REQ_IND || operation == GATTC_WRITE_REQ_IND);
-    REQUIRE(attidx > estss_env.att.attidx_offset);
+    REQUIRE(attidx > APP_BLE_CS_ATTIDX_ESTSS);
     REQUIRE(length >= 1);
 
     const ESTSS_TriggerId_t tidx = ESTSS_GetTriggerIdFromAttidx(attidx);
@@ -1051,7 +1044,7 @@ int32_t ESTSS_Initialize(ESTSS_TriggerUpdatedCallback_t p_update_cb,
 
     /* Add custom attributes into the attribute database. */
     status = APP_BLE_PeripheralServerAddCustomService(estss_att_db,
-            ESTSS_ATT_COUNT, &estss_env.att.attidx_offset);
+            ESTSS_ATT_COUNT, APP_BLE_CS_ATTIDX_ESTSS);
     if (status != 0)
     {
         return -1;
@@ -771,12 +771,13 @@ static void APP_BLE_ParamUpdate_Timeout_Handler(ke_msg_id_t const msg_id,
 }
 
 
-void APP_BLE_PeripheralServerInitialize(const uint16_t cs_att_db_size)
+void APP_BLE_PeripheralServerInitialize(void)
 {
     /* Check if RF output power is compatible with current calibration settings. */
     REQUIRE(OUTPUT_POWER_DBM <= RF_TX_POWER_LEVEL_DBM);
 
-    REQUIRE(cs_att_db_size > 1);
+    /* Linker must place all service tables into the custom attribute database. */
+    REQUIRE((__cs_att_db_end__ - __cs_att_db_start__) == APP_BLE_CS_ATT_COUNT);
 
     /* Set radio clock accuracy in ppm */
     BLE_DeviceParam_Set_ClockAccuracy(RADIO_CLOCK_ACCURACY);
@@ -822,30 +823,24 @@ void APP_BLE_PeripheralServerInitialize(const uint16_t cs_att_db_size)
     /* Restart BLE stack to start the initialization process. */
     GAPM_ResetCmd();
 
-    cs_att_env.cs_att_count = 0;
+    cs_att_env.cs_att_db = __cs_att_db_start__;
+    cs_att_env.cs_att_count = APP_BLE_CS_ATT_COUNT;
     cs_att_env.cs_service_count = 0;
-    cs_att_env.cs_att_db_size = cs_att_db_size;
-    cs_att_env.cs_att_db = malloc(cs_att_db_size * sizeof(struct att_db_desc));
-
-    ENSURE(cs_att_env.cs_att_db != NULL);
 }
 
 int32_t APP_BLE_PeripheralServerAddCustomService(const struct att_db_desc *p_atts,
-        const uint16_t atts_count, uint16_t *p_attidx_offset)
+        const uint16_t atts_count, const uint16_t attidx_offset)
 {
     REQUIRE(p_atts != NULL);
     REQUIRE(atts_count > 0);
-    REQUIRE(p_attidx_offset != NULL);
 
-    /* Is there enough space for additional service in the att db? */
-    if ((cs_att_env.cs_att_db_size - cs_att_env.cs_att_count) < atts_count)
+    /* Is the service table located at its static offset in the att db? */
+    if ((p_atts != (cs_att_env.cs_att_db + attidx_offset))
+        || ((cs_att_env.cs_att_count - attidx_offset) < atts_count))
     {
         return -1;
     }
 
-    /* Store offset that will be applied to all attidx of this service. */
-    *p_attidx_offset = cs_att_env.cs_att_count;
-
     /* Increment number of services in the db */
     cs_att_env.cs_service_count += 1;
 
@@ -858,18 +853,9 @@ int32_t APP_BLE_PeripheralServerAddCustomService(const struct att_db_desc *p_att
         REQUIRE(p_atts[i].att_idx == i);
         /* Only first attribute is allowed to declare a service. */
         REQUIRE((i == 0) || (p_atts[i].is_service == false));
-
-        /* Copy attribute data to internal database. */
-        struct att_db_desc *p_att = cs_att_env.cs_att_db + cs_att_env.cs_att_count;
-        memcpy(p_att, p_atts + i, sizeof(struct att_db_desc));
-
-        /* Add the attidx offset */
-        p_att->att_idx += *p_attidx_offset;
-
-        cs_att_env.cs_att_count += 1;
     }
 
-    ENSURE(cs_att_env.cs_att_count <= cs_att_env.cs_att_db_size);
+    ENSURE(cs_att_env.cs_service_count <= APP_NUM_CUSTOM_SVC);
     return 0;
 }
 
@@ -903,3 +889,48 @@ bool APP_BLE_PeripheralServerConnectedInLowPowerParams(void)
     const struct gapc_connection_req_ind * const curr_conn_params = GAPC_GetConnectionInfo(0);
     return ((GAPC_GetConnectionCount() > 0) && (curr_conn_params->con_interval > APP_UPD_CONN_INTV_LL_MAX));
 }
+
+uint32_t APP_BLE_PeripheralServerGetConnIntervalUs(void)
+{
+    if (GAPC_GetConnectionCount() == 0)
+    {
+        return 0;
+    }
+
+    /* Connection interval is in units of 1.25 ms. */
+    return GAPC_GetConnectionInfo(0)->con_interval * 1250U;
+}
+
+void APP_BLE_PeripheralServerPrintMsgStats(void)
+{
+#if MSG_HANDLER_STATS_ENABLED
+    for (uint8_t i = 0; i < MSG_HANDLER_TABLE_SIZE; ++i)
+    {
+        const MsgHandler_t *p_entry = MsgHandler_GetEntry(i);
+
+        if ((p_entry != NULL) && (p_entry->notify_count > 0))
+        {
+            PRINTF("STAT: msg_id=0x%04x count=%lu max=%lu us\r\n",
+                    p_entry->msg_id, p_entry->notify_count,
+                    p_entry->max_cycles / (SystemCoreClock / 1000000));
+        }
+    }
+#endif /* MSG_HANDLER_STATS_ENABLED */
+}
+
+#if MSG_HANDLER_TRACE_ENABLED
+/* Trace lines are read by test/host/msg_handler/msg_handler_replay.c. */
+void MsgHandler_TraceAdd(ke_msg_id_t const msg_id,
+                         MsgHandler_Callback_t callback)
+{
+    PRINTF("TRACE: sub 0x%04x 0x%08lx\r\n", msg_id,
+            (unsigned long) (uintptr_t) callback);
+}
+
+void MsgHandler_TraceNotify(ke_msg_id_t const msg_id,
+                            ke_task_id_t const dest_id,
+                            ke_task_id_t const src_id)
+{
+    PRINTF("TRACE: msg 0x%04x 0x%04x 0x%04x\r\n", msg_id, dest_id, src_id);
+}
+#endif /* MSG_HANDLER_TRACE_ENABLED */
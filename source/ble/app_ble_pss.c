@@ -0,0 +1,112 @@
+/* ----------------------------------------------------------------------------
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * ON Semiconductor), All Rights Reserved
+ *
+ * This code is the property of ON Semiconductor and may not be redistributed
+ * in any form without prior written permission from ON Semiconductor.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between ON Semiconductor and the licensee.
+ *
+ * This is Reusable Code.
+ * ------------------------------------------------------------------------- */
+
+/**
+ * @file app_ble_pss.c
+ *
+ * Profiling Statistics Service Server PSS - implementation
+ */
+
+#include <app_ble_pss.h>
+#include <app_ble_peripheral_server.h>
+
+#include <smartshot_assert.h>
+#include <smartshot_printf.h>
+
+/* Stores one copy of filename for ASSERT calls. */
+DEFINE_THIS_FILE_FOR_ASSERT;
+
+#define  CS_CHAR_TEXT_DESC(idx, text)   \
+    CS_CHAR_USER_DESC(idx, sizeof(text) - 1, text, NULL)
+
+static uint8_t PSS_Handler(uint8_t conidx, uint16_t attidx,
+        uint16_t handle, uint8_t *to, const uint8_t *from, uint16_t length,
+        uint16_t operation);
+
+/** Complete attribute database of the PSS. */
+APP_BLE_CS_ATT_DB_SECTION(04)
+const static struct att_db_desc pss_att_db[PSS_ATT_COUNT] =
+{
+    /* Profiling Statistics Service 0 */
+    CS_SERVICE_UUID_128(
+            PSS_ATT_SERVICE_0, /* attidx */
+            PSS_SVC_UUID), /* uuid */
+
+    /* Statistics Characteristic in Service PSS */
+    CS_CHAR_UUID_128(
+            PSS_ATT_STATS_CHAR_0, /* attidx_char */
+            PSS_ATT_STATS_VAL_0, /* attidx_val */
+            PSS_CHAR_STATS_UUID, /* uuid */
+            PERM(RD, ENABLE) | PERM(WRITE_REQ, ENABLE), /* perm */
+            PSS_STATS_CHAR_VALUE_SIZE, /* length */
+            NULL, /* data */
+            PSS_Handler), /* callback */
+    CS_CHAR_TEXT_DESC(PSS_ATT_STATS_NAME_0, PSS_CHAR_STATS_DESC),
+};
+
+int32_t PSS_Initialize(void)
+{
+    int32_t status;
+
+    /* Add custom attributes into the attribute database. */
+    status = APP_BLE_PeripheralServerAddCustomService(pss_att_db,
+            PSS_ATT_COUNT, APP_BLE_CS_ATTIDX_PSS);
+    if (status != 0)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+static uint8_t PSS_Handler(uint8_t conidx, uint16_t attidx, uint16_t handle,
+        uint8_t *to, const uint8_t *from, uint16_t length,
+        uint16_t operation)
+{
+    REQUIRE(attidx > APP_BLE_CS_ATTIDX_PSS);
+    REQUIRE(attidx < (APP_BLE_CS_ATTIDX_PSS + PSS_ATT_COUNT));
+
+    const uint16_t pss_attidx = attidx - APP_BLE_CS_ATTIDX_PSS;
+
+    if (pss_attidx != PSS_ATT_STATS_VAL_0)
+    {
+        return ATT_ERR_REQUEST_NOT_SUPPORTED;
+    }
+
+    if (operation == GATTC_READ_REQ_IND)
+    {
+        if (length != PSS_STATS_CHAR_VALUE_SIZE)
+        {
+            return ATT_ERR_INVALID_ATTRIBUTE_VAL_LEN;
+        }
+
+        APP_PROF_Snapshot(to);
+    }
+
+    if (operation == GATTC_WRITE_REQ_IND)
+    {
+        if (length != 1)
+        {
+            return ATT_ERR_INVALID_ATTRIBUTE_VAL_LEN;
+        }
+
+        if (*from != PSS_STATS_RESET)
+        {
+            return ATT_ERR_REQUEST_NOT_SUPPORTED;
+        }
+
+        PRINTF("PSS: Statistics reset.\r\n");
+        APP_PROF_Reset();
+    }
+
+    return ATT_ERR_NO_ERROR;
+}
@@ -30,6 +30,7 @@ static uint8_t PTSS_ControlPointWriteHandler(uint8_t conidx, uint16_t attidx,
 
 static PTSS_Environment_t ptss_env = { 0 };
 
+APP_BLE_CS_ATT_DB_SECTION(01)
 const struct att_db_desc ptss_att_db[ATT_PTSS_COUNT] =
 {
     /* Picture Transfer Service 0 */
@@ -120,7 +121,7 @@ static void PTSS_MsgHandler(ke_msg_id_t const msg_id, void const *param,
 
             if (p->operation == GATTC_NOTIFY)
             {
-                uint16_t attidx = ptss_env.att.attidx_offset
+                uint16_t attidx = APP_BLE_CS_ATTIDX_PTSS
                                   + ATT_PTSS_IMAGE_DATA_VAL_0;
 
                 /* If the sequence number is the number of Image Data Value
@@ -393,7 +394,7 @@ static void PTSS_TransmitImgDataNotification(void)
      */
     REQUIRE(ptss_env.att.img_data.value_length > PTSS_INFO_OFFSET_LENGTH);
 
-    uint16_t attidx = ptss_env.att.attidx_offset + ATT_PTSS_IMAGE_DATA_VAL_0;
+    uint16_t attidx = APP_BLE_CS_ATTIDX_PTSS + ATT_PTSS_IMAGE_DATA_VAL_0;
     uint16_t att_handle = GATTM_GetHandle(attidx);
 
     GATTC_SendEvtCmd(0, GATTC_NOTIFY, attidx, att_handle,
@@ -414,7 +415,6 @@ int32_t PTSS_Initialize(PTSS_ControlHandler control_event_handler)
         return PTSS_ERR;
     }
 
-    ptss_env.att.attidx_offset = 0;
     ptss_env.att.cp.callback = control_event_handler;
     ptss_env.att.cp.capture_mode = 0;
     ptss_env.att.info.ccc[0] = 0x00;
@@ -430,7 +430,7 @@ int32_t PTSS_Initialize(PTSS_ControlHandler control_event_handler)
 
     /* Add custom attributes into the attribute database. */
     status = APP_BLE_PeripheralServerAddCustomService(ptss_att_db, ATT_PTSS_COUNT,
-            &ptss_env.att.attidx_offset);
+            APP_BLE_CS_ATTIDX_PTSS);
     if (status != 0)
     {
         return PTSS_ERR_INSUFFICIENT_ATT_DB_SIZE;
@@ -454,7 +454,7 @@ int32_t PTSS_StartImageTransfer(uint32_t img_size)
     {
         if (ptss_env.transfer.state == PTSS_STATE_CAPTURE_REQUEST)
         {
-            uint16_t attidx = ptss_env.att.attidx_offset + ATT_PTSS_INFO_VAL_0;
+            uint16_t attidx = APP_BLE_CS_ATTIDX_PTSS + ATT_PTSS_INFO_VAL_0;
             uint16_t att_handle = GATTM_GetHandle(attidx);
             uint8_t data[PTSS_INFO_IMG_CAPTURED_LENGTH];
 
@@ -490,7 +490,7 @@ int32_t PTSS_AbortImageTransfer(PTSS_InfoErrorCode_t errcode)
 
     if (ptss_env.transfer.state >= PTSS_STATE_CAPTURE_REQUEST)
     {
-        uint16_t attidx = ptss_env.att.attidx_offset + ATT_PTSS_INFO_VAL_0;
+        uint16_t attidx = APP_BLE_CS_ATTIDX_PTSS + ATT_PTSS_INFO_VAL_0;
         uint16_t att_handle = GATTM_GetHandle(attidx);
         uint8_t data[2];
 
@@ -510,6 +510,36 @@ int32_t PTSS_AbortImageTransfer(PTSS_InfoErrorCode_t errcode)
     return status;
 }
 
+int32_t PTSS_SendImageResult(const uint8_t *p_result, uint8_t result_len)
+{
+    int32_t status = PTSS_OK;
+
+    REQUIRE(p_result != NULL);
+
+    if ((result_len == 0) || (result_len > PTSS_IMG_RESULT_MAX_LENGTH))
+    {
+        status = PTSS_ERR;
+    }
+    else if (ptss_env.transfer.state >= PTSS_STATE_IMG_INFO_PROVIDED)
+    {
+        uint16_t attidx = APP_BLE_CS_ATTIDX_PTSS + ATT_PTSS_INFO_VAL_0;
+        uint16_t att_handle = GATTM_GetHandle(attidx);
+        uint8_t data[1 + PTSS_IMG_RESULT_MAX_LENGTH];
+
+        data[0] = PTSS_INFO_OPCODE_IMG_RESULT_IND;
+        memcpy(data + 1, p_result, result_len);
+
+        GATTC_SendEvtCmd(0, GATTC_NOTIFY, attidx, att_handle,
+                1 + result_len, data);
+    }
+    else
+    {
+        status = PTSS_ERR_NOT_PERMITTED;
+    }
+
+    return status;
+}
+
 int32_t PTSS_GetMaxImageDataPushSize(void)
 {
     int32_t avail_bytes;
@@ -542,6 +572,12 @@ int32_t PTSS_GetMaxImageDataPushSize(void)
     return avail_bytes;
 }
 
+bool PTSS_IsTransmitWindowFull(void)
+{
+    return (ptss_env.transfer.state == PTSS_STATE_IMG_DATA_TRANSMISSION)
+           && (ptss_env.transfer.packets_pending == PTSS_MAX_PENDING_PACKET_COUNT);
+}
+
 int32_t PTSS_ImageDataPush(const uint8_t* p_img_data, const int32_t data_len)
 {
     if ((p_img_data == NULL)
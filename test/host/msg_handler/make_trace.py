@@ -0,0 +1,187 @@
+#!/usr/bin/env python3
+""" Kernel message trace of a camera session for msg_handler_replay.
+
+    Writes the subscriptions of the firmware and the kernel messages of one
+    session in the trace format of msg_handler_replay.c: boot, advertising,
+    connection setup, capture and transfer of several images, disconnection.
+
+    The subscriptions are those of the MsgHandler_Add() calls of the firmware.
+    Message IDs hold the task number in the upper byte, like the IDs of the BLE
+    stack. The message indexes within a task are representative, the dispatch
+    cost only depends on which IDs are subscribed and how they hash. A trace
+    recorded on the device with MSG_HANDLER_TRACE_ENABLED can be replayed
+    instead.
+
+    Prerequisites:
+    - installed Python, version >=3.4
+
+    Example:
+    make_trace.py --images 4 --output trace_transfer.txt
+"""
+
+__version__ = '1.0.0'
+
+import argparse
+import random
+import sys
+
+
+TASK_ID_GATTM = 0x0B
+TASK_ID_GATTC = 0x0C
+TASK_ID_GAPM = 0x0D
+TASK_ID_GAPC = 0x0E
+TASK_ID_APP = 0x0F
+TASK_ID_DISS = 0x14
+
+
+def msg_id(task, index):
+    return (task << 8) | index
+
+
+GAPM_CMP_EVT = msg_id(TASK_ID_GAPM, 0x00)
+GAPM_DEV_BDADDR_IND = msg_id(TASK_ID_GAPM, 0x12)
+GAPM_PROFILE_ADDED_IND = msg_id(TASK_ID_GAPM, 0x1B)
+GATTM_ADD_SVC_RSP = msg_id(TASK_ID_GATTM, 0x01)
+GATTC_CMP_EVT = msg_id(TASK_ID_GATTC, 0x00)
+GATTC_MTU_CHANGED_IND = msg_id(TASK_ID_GATTC, 0x01)
+GATTC_READ_REQ_IND = msg_id(TASK_ID_GATTC, 0x13)
+GATTC_WRITE_REQ_IND = msg_id(TASK_ID_GATTC, 0x15)
+GAPC_CMP_EVT = msg_id(TASK_ID_GAPC, 0x00)
+GAPC_CONNECTION_REQ_IND = msg_id(TASK_ID_GAPC, 0x01)
+GAPC_DISCONNECT_IND = msg_id(TASK_ID_GAPC, 0x04)
+GAPC_PARAM_UPDATE_REQ_IND = msg_id(TASK_ID_GAPC, 0x13)
+GAPC_PARAM_UPDATED_IND = msg_id(TASK_ID_GAPC, 0x15)
+GAPC_LE_PKT_SIZE_IND = msg_id(TASK_ID_GAPC, 0x2D)
+DISS_SET_VALUE_RSP = msg_id(TASK_ID_DISS, 0x01)
+DISS_VALUE_REQ_IND = msg_id(TASK_ID_DISS, 0x02)
+# Kernel message IDs registered by the application, see
+# APP_BLE_PeripheralServerRegisterKernelMsgIds() and ble_dfus.c.
+APP_ADV_TIMEOUT = msg_id(TASK_ID_APP, 0x00)
+APP_PARAM_UPDATE_TIMEOUT = msg_id(TASK_ID_APP, 0x01)
+DFU_ENTER_TIMEOUT = msg_id(TASK_ID_APP, 250)
+DFU_DISCONNECT = msg_id(TASK_ID_APP, 251)
+
+# MsgHandler_Add() calls of the firmware in the order of initialization.
+SUBSCRIPTIONS = [
+    (TASK_ID_GAPM, 'APP_BLE_GAPM_GATTM_Handler'),
+    (GATTM_ADD_SVC_RSP, 'APP_BLE_GAPM_GATTM_Handler'),
+    (TASK_ID_GAPC, 'APP_BLE_GAPC_Handler'),
+    (TASK_ID_GATTC, 'APP_BLE_GATTC_Handler'),
+    (APP_ADV_TIMEOUT, 'APP_BLE_ADV_Timeout_Handler'),
+    (APP_PARAM_UPDATE_TIMEOUT, 'APP_BLE_ParamUpdate_Timeout_Handler'),
+    (TASK_ID_DISS, 'DISS_MsgHandler'),
+    (GAPM_CMP_EVT, 'DISS_MsgHandler'),
+    (GAPM_PROFILE_ADDED_IND, 'DISS_MsgHandler'),
+    (DISS_SET_VALUE_RSP, 'DISS_MsgHandler'),
+    (DISS_VALUE_REQ_IND, 'DISS_DeviceInfoValueReqInd'),
+    (GATTC_CMP_EVT, 'PTSS_MsgHandler'),
+    (GAPC_CONNECTION_REQ_IND, 'PTSS_MsgHandler'),
+    (GAPC_DISCONNECT_IND, 'PTSS_MsgHandler'),
+    (GATTC_MTU_CHANGED_IND, 'PTSS_MsgHandler'),
+    (GAPC_LE_PKT_SIZE_IND, 'PTSS_MsgHandler'),
+    (GAPC_DISCONNECT_IND, 'ESTSS_BleMsgHandler'),
+    (GAPC_CONNECTION_REQ_IND, 'ESTSS_BleMsgHandler'),
+    (GAPM_CMP_EVT, 'Dfus_MsgHandler'),
+    (DFU_ENTER_TIMEOUT, 'Dfus_MsgHandler'),
+    (DFU_DISCONNECT, 'Dfus_MsgHandler'),
+]
+
+
+class Trace:
+    def __init__(self):
+        self.lines = []
+
+    def comment(self, text):
+        self.lines.append('# ' + text)
+
+    def msg(self, msg, dest=TASK_ID_APP, src=None):
+        if src is None:
+            src = msg >> 8
+        self.lines.append('msg 0x%04x 0x%04x 0x%04x' % (msg, dest, src))
+
+
+def session(trace, images, image_size, payload, rng):
+    trace.comment('Boot: stack reset, services and DISS profile added')
+    for _ in range(3):
+        trace.msg(GAPM_CMP_EVT)
+    trace.msg(GAPM_DEV_BDADDR_IND)
+    for _ in range(4):
+        trace.msg(GATTM_ADD_SVC_RSP)
+    trace.msg(GAPM_PROFILE_ADDED_IND)
+    for _ in range(9):
+        trace.msg(DISS_SET_VALUE_RSP)
+    trace.msg(GAPM_CMP_EVT)
+
+    trace.comment('Advertising with duty cycle timer')
+    for _ in range(6):
+        trace.msg(APP_ADV_TIMEOUT)
+        trace.msg(GAPM_CMP_EVT)
+
+    trace.comment('Connection setup')
+    trace.msg(GAPC_CONNECTION_REQ_IND)
+    trace.msg(GAPM_CMP_EVT)
+    trace.msg(GATTC_MTU_CHANGED_IND, src=TASK_ID_GATTC)
+    trace.msg(GAPC_LE_PKT_SIZE_IND)
+    for _ in range(4):
+        trace.msg(DISS_VALUE_REQ_IND, src=TASK_ID_DISS)
+    for _ in range(6):
+        trace.msg(GATTC_WRITE_REQ_IND)
+        trace.msg(GATTC_CMP_EVT)
+    trace.msg(APP_PARAM_UPDATE_TIMEOUT)
+    trace.msg(GAPC_PARAM_UPDATE_REQ_IND)
+    trace.msg(GAPC_PARAM_UPDATED_IND)
+    trace.msg(GAPC_CMP_EVT)
+
+    for image in range(images):
+        trace.comment('Image %d: capture request and transfer' % image)
+        trace.msg(GATTC_WRITE_REQ_IND)
+        trace.msg(GATTC_CMP_EVT)
+        size = image_size + rng.randint(-image_size // 4, image_size // 4)
+        for _ in range((size + payload - 1) // payload):
+            # Every notification completes with GATTC_CMP_EVT, some
+            # connection events also carry a read of the status.
+            trace.msg(GATTC_CMP_EVT)
+            if rng.random() < 0.02:
+                trace.msg(GATTC_READ_REQ_IND)
+        trace.msg(GATTC_WRITE_REQ_IND)
+        trace.msg(GATTC_CMP_EVT)
+
+    trace.comment('Disconnection')
+    trace.msg(GAPC_DISCONNECT_IND)
+    trace.msg(GAPM_CMP_EVT)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Kernel message trace of a camera session.')
+    parser.add_argument('--images', type=int, default=4,
+                        help='number of transferred images')
+    parser.add_argument('--image-size', type=int, default=24000,
+                        help='average JPEG size in bytes')
+    parser.add_argument('--payload', type=int, default=244,
+                        help='image data bytes per notification')
+    parser.add_argument('--seed', type=int, default=1)
+    parser.add_argument('--output', default='-',
+                        help='output file, - for stdout')
+    args = parser.parse_args()
+
+    trace = Trace()
+    trace.comment('Generated by make_trace.py %s --images %d --image-size %d '
+                  '--payload %d --seed %d' % (__version__, args.images,
+                  args.image_size, args.payload, args.seed))
+    for msg, callback in SUBSCRIPTIONS:
+        trace.lines.append('sub 0x%04x %s' % (msg, callback))
+    session(trace, args.images, args.image_size, args.payload,
+            random.Random(args.seed))
+
+    text = '\n'.join(trace.lines) + '\n'
+    if args.output == '-':
+        sys.stdout.write(text)
+    else:
+        with open(args.output, 'w') as f:
+            f.write(text)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
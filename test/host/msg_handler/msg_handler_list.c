@@ -0,0 +1,127 @@
+/* ----------------------------------------------------------------------------
+ * msg_handler_list.c
+ * - Previous message handler implementation, see msg_handler_list.h
+ * ------------------------------------------------------------------------- */
+#include <stdlib.h>
+
+#include <ble_gap.h>
+#include <ble_gatt.h>
+
+#include "msg_handler_list.h"
+
+typedef struct MsgHandlerList {
+    uint16_t msg_id;
+    MsgHandler_Callback_t callback;
+    struct MsgHandlerList *next;
+} MsgHandlerList_t;
+
+static MsgHandlerList_t *msgHandlerHead = NULL;
+
+bool MsgHandlerList_Add(ke_msg_id_t const msg_id,
+                        MsgHandler_Callback_t callback)
+{
+    MsgHandlerList_t *newElem = malloc(sizeof(MsgHandlerList_t));
+
+    if(!newElem) /* Malloc error */
+    {
+        return false;
+    }
+
+    newElem->msg_id = msg_id;
+    newElem->callback = callback;
+    newElem->next = NULL;
+
+    if(!msgHandlerHead) /* If list is empty, newElem will be the new head */
+    {
+        msgHandlerHead = newElem;
+    }
+    else
+    {
+        MsgHandlerList_t *tmp = msgHandlerHead;
+        MsgHandlerList_Remove(msg_id, callback); /* Avoid handler duplication, in case it already exists */
+
+        while(tmp->next) /* Go to the end of the list */
+        {
+            tmp = tmp->next;
+        }
+        tmp->next = newElem; /* Insert newElem at the end of the list */
+    }
+
+    return true;
+}
+
+bool MsgHandlerList_Remove(ke_msg_id_t const msg_id,
+                           MsgHandler_Callback_t callback)
+{
+    MsgHandlerList_t *tmp, *prev;
+    bool removed = false;
+
+    if(!msgHandlerHead)
+    {
+        return false;
+    }
+
+    tmp = msgHandlerHead;
+
+    /* If the element to be removed is the head of the list */
+    if((msgHandlerHead->msg_id == msg_id) && (msgHandlerHead->callback == callback))
+    {
+        msgHandlerHead = msgHandlerHead->next;
+        free(tmp);
+        removed = true;
+    }
+    else /* Search the remainder of the list */
+    {
+        do {
+            prev = tmp; /* Keep track of previous element */
+            tmp = tmp->next;
+        } while(tmp && ((tmp->msg_id != msg_id) || (tmp->callback != callback)));
+
+        if(tmp) /* if element found */
+        {
+            prev->next = tmp->next; /* Remove element from list */
+            free(tmp);
+            removed = true;
+        }
+    }
+
+    return removed;
+}
+
+int MsgHandlerList_Notify(ke_msg_id_t const msg_id, void *param,
+                          ke_task_id_t const dest_id,
+                          ke_task_id_t const src_id)
+{
+    MsgHandlerList_t *tmp = msgHandlerHead;
+    uint8_t task_id = KE_IDX_GET(msg_id);
+
+    /* First notify abstraction layer handlers */
+    switch(task_id)
+    {
+        case TASK_ID_GAPC:
+            GAPC_MsgHandler(msg_id, param, dest_id, src_id);
+            break;
+        case TASK_ID_GAPM:
+            GAPM_MsgHandler(msg_id, param, dest_id, src_id);
+            break;
+        case TASK_ID_GATTC:
+            GATTC_MsgHandler(msg_id, param, dest_id, src_id);
+            break;
+        case TASK_ID_GATTM:
+            GATTM_MsgHandler(msg_id, param, dest_id, src_id);
+            break;
+    }
+
+    /* Notify subscribed application/profile handlers */
+    while(tmp)
+    {
+        /* If message ID matches or the handler should be called for all
+         * messages of this task type */
+        if((tmp->msg_id == msg_id) || (tmp->msg_id == task_id))
+        {
+            tmp->callback(msg_id, param, dest_id, src_id);
+        }
+        tmp = tmp->next;
+    }
+    return KE_MSG_CONSUMED;
+}
@@ -0,0 +1,24 @@
+/* ----------------------------------------------------------------------------
+ * msg_handler_list.h
+ * - Previous message handler implementation, a linked list searched for every
+ *   message. Kept as the baseline of the replay benchmark.
+ * ------------------------------------------------------------------------- */
+#ifndef MSG_HANDLER_LIST_H
+#define MSG_HANDLER_LIST_H
+
+#include <ke_msg.h>
+#include <stdbool.h>
+
+#include <msg_handler.h>
+
+bool MsgHandlerList_Add(ke_msg_id_t const msg_id,
+                        MsgHandler_Callback_t callback);
+
+bool MsgHandlerList_Remove(ke_msg_id_t const msg_id,
+                           MsgHandler_Callback_t callback);
+
+int MsgHandlerList_Notify(ke_msg_id_t const msg_id, void *param,
+                          ke_task_id_t const dest_id,
+                          ke_task_id_t const src_id);
+
+#endif    /* MSG_HANDLER_LIST_H */
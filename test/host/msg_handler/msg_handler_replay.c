@@ -0,0 +1,432 @@
+/* ----------------------------------------------------------------------------
+ * msg_handler_replay.c
+ * - Replays a recorded kernel message trace through the message handler
+ *   dispatch table and through the previous linked list implementation,
+ *   checks that both call the same handlers in the same order and compares
+ *   their dispatch time.
+ *
+ * Usage: msg_handler_replay <trace> [repeat]
+ *
+ * Trace lines, as printed by the firmware with MSG_HANDLER_TRACE_ENABLED
+ * (the "TRACE: " prefix is optional):
+ *
+ *   sub <msg_id> <callback>         MsgHandler_Add(msg_id, callback)
+ *   msg <msg_id> <dest_id> <src_id> Kernel message passed to Notify
+ *
+ * Callbacks are identified by any token, e.g. their address. Every distinct
+ * token is replaced by its own host handler. Other lines are ignored, so the
+ * complete log of the firmware can be replayed.
+ * ------------------------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <rsl10.h>
+#include <msg_handler.h>
+
+#include "msg_handler_list.h"
+
+#define REPLAY_MAX_CALLBACKS            32
+#define REPLAY_MAX_SUBSCRIPTIONS        128
+#define REPLAY_MAX_MESSAGES             65536
+#define REPLAY_DEFAULT_REPEAT           2000
+#define REPLAY_RUNS                     5
+
+/* Task of the call order check, not used by the BLE stack. */
+#define REPLAY_ORDER_TASK               0x7E
+
+typedef struct
+{
+    ke_msg_id_t msg_id;
+    ke_task_id_t dest_id;
+    ke_task_id_t src_id;
+} ReplayMsg_t;
+
+typedef struct
+{
+    ke_msg_id_t msg_id;
+    uint8_t callback;
+} ReplaySub_t;
+
+DWT_Type host_dwt;
+CoreDebug_Type host_core_debug;
+uint32_t SystemCoreClock = 48000000;
+
+/* Handlers called for the current message, in call order. */
+static uint8_t replay_calls[REPLAY_MAX_CALLBACKS];
+static uint32_t replay_call_count;
+
+static ReplayMsg_t replay_msgs[REPLAY_MAX_MESSAGES];
+static uint32_t replay_msg_count;
+static ReplaySub_t replay_subs[REPLAY_MAX_SUBSCRIPTIONS];
+static uint32_t replay_sub_count;
+static char replay_callback_names[REPLAY_MAX_CALLBACKS][32];
+static uint32_t replay_callback_count;
+
+/* Abstraction layer handlers of the BLE library, not part of the benchmark. */
+void GAPC_MsgHandler(ke_msg_id_t const msg_id, void const *param,
+                     ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+}
+
+void GAPM_MsgHandler(ke_msg_id_t const msg_id, void const *param,
+                     ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+}
+
+void GATTC_MsgHandler(ke_msg_id_t const msg_id, void const *param,
+                      ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+}
+
+void GATTM_MsgHandler(ke_msg_id_t const msg_id, void const *param,
+                      ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+}
+
+#define REPLAY_HANDLER(n) \
+    static void Replay_Handler##n(ke_msg_id_t const msg_id, \
+            void const *param, ke_task_id_t const dest_id, \
+            ke_task_id_t const src_id) \
+    { \
+        if (replay_call_count < REPLAY_MAX_CALLBACKS) \
+        { \
+            replay_calls[replay_call_count] = (n); \
+        } \
+        replay_call_count++; \
+    }
+
+REPLAY_HANDLER(0)  REPLAY_HANDLER(1)  REPLAY_HANDLER(2)  REPLAY_HANDLER(3)
+REPLAY_HANDLER(4)  REPLAY_HANDLER(5)  REPLAY_HANDLER(6)  REPLAY_HANDLER(7)
+REPLAY_HANDLER(8)  REPLAY_HANDLER(9)  REPLAY_HANDLER(10) REPLAY_HANDLER(11)
+REPLAY_HANDLER(12) REPLAY_HANDLER(13) REPLAY_HANDLER(14) REPLAY_HANDLER(15)
+REPLAY_HANDLER(16) REPLAY_HANDLER(17) REPLAY_HANDLER(18) REPLAY_HANDLER(19)
+REPLAY_HANDLER(20) REPLAY_HANDLER(21) REPLAY_HANDLER(22) REPLAY_HANDLER(23)
+REPLAY_HANDLER(24) REPLAY_HANDLER(25) REPLAY_HANDLER(26) REPLAY_HANDLER(27)
+REPLAY_HANDLER(28) REPLAY_HANDLER(29) REPLAY_HANDLER(30) REPLAY_HANDLER(31)
+
+static const MsgHandler_Callback_t replay_handlers[REPLAY_MAX_CALLBACKS] =
+{
+    Replay_Handler0,  Replay_Handler1,  Replay_Handler2,  Replay_Handler3,
+    Replay_Handler4,  Replay_Handler5,  Replay_Handler6,  Replay_Handler7,
+    Replay_Handler8,  Replay_Handler9,  Replay_Handler10, Replay_Handler11,
+    Replay_Handler12, Replay_Handler13, Replay_Handler14, Replay_Handler15,
+    Replay_Handler16, Replay_Handler17, Replay_Handler18, Replay_Handler19,
+    Replay_Handler20, Replay_Handler21, Replay_Handler22, Replay_Handler23,
+    Replay_Handler24, Replay_Handler25, Replay_Handler26, Replay_Handler27,
+    Replay_Handler28, Replay_Handler29, Replay_Handler30, Replay_Handler31,
+};
+
+/**
+ * Map callback token of the trace to the index of a host handler.
+ *
+ * @return
+ * Handler index, -1 if there are more distinct callbacks than handlers.
+ */
+static int Replay_CallbackIndex(const char *name)
+{
+    for (uint32_t i = 0; i < replay_callback_count; ++i)
+    {
+        if (strcmp(replay_callback_names[i], name) == 0)
+        {
+            return (int) i;
+        }
+    }
+
+    if (replay_callback_count >= REPLAY_MAX_CALLBACKS)
+    {
+        return -1;
+    }
+
+    snprintf(replay_callback_names[replay_callback_count],
+             sizeof(replay_callback_names[0]), "%s", name);
+    return (int) replay_callback_count++;
+}
+
+static bool Replay_LoadTrace(const char *path)
+{
+    char line[256];
+    unsigned int line_no = 0;
+    FILE *f = fopen(path, "r");
+
+    if (f == NULL)
+    {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return false;
+    }
+
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        char *p = line;
+        char kind[8];
+        char arg[3][32];
+        int n;
+
+        ++line_no;
+
+        if (strncmp(p, "TRACE: ", 7) == 0)
+        {
+            p += 7;
+        }
+
+        n = sscanf(p, "%7s %31s %31s %31s", kind, arg[0], arg[1], arg[2]);
+        if (n <= 0)
+        {
+            continue;
+        }
+
+        if ((strcmp(kind, "sub") != 0) && (strcmp(kind, "msg") != 0))
+        {
+            continue;
+        }
+
+        if ((strcmp(kind, "sub") == 0) && (n >= 3))
+        {
+            int callback = Replay_CallbackIndex(arg[1]);
+
+            if ((callback < 0) || (replay_sub_count >= REPLAY_MAX_SUBSCRIPTIONS))
+            {
+                fprintf(stderr, "%s:%u: too many subscriptions or callbacks\n",
+                        path, line_no);
+                fclose(f);
+                return false;
+            }
+            replay_subs[replay_sub_count].msg_id =
+                    (ke_msg_id_t) strtoul(arg[0], NULL, 0);
+            replay_subs[replay_sub_count].callback = (uint8_t) callback;
+            ++replay_sub_count;
+        }
+        else if ((strcmp(kind, "msg") == 0) && (n >= 4))
+        {
+            if (replay_msg_count >= REPLAY_MAX_MESSAGES)
+            {
+                fprintf(stderr, "%s:%u: too many messages\n", path, line_no);
+                fclose(f);
+                return false;
+            }
+            replay_msgs[replay_msg_count].msg_id =
+                    (ke_msg_id_t) strtoul(arg[0], NULL, 0);
+            replay_msgs[replay_msg_count].dest_id =
+                    (ke_task_id_t) strtoul(arg[1], NULL, 0);
+            replay_msgs[replay_msg_count].src_id =
+                    (ke_task_id_t) strtoul(arg[2], NULL, 0);
+            ++replay_msg_count;
+        }
+        else
+        {
+            fprintf(stderr, "%s:%u: invalid line\n", path, line_no);
+            fclose(f);
+            return false;
+        }
+    }
+
+    fclose(f);
+    return true;
+}
+
+/**
+ * Notify one message and record the handlers it calls.
+ *
+ * @return
+ * Number of called handlers, their indexes are written to p_calls.
+ */
+static uint32_t Replay_Calls(int (*notify)(ke_msg_id_t const msg_id,
+                                           void *param,
+                                           ke_task_id_t const dest_id,
+                                           ke_task_id_t const src_id),
+                             const ReplayMsg_t *p_msg, uint8_t *p_calls)
+{
+    replay_call_count = 0;
+    notify(p_msg->msg_id, NULL, p_msg->dest_id, p_msg->src_id);
+    memcpy(p_calls, replay_calls, sizeof(replay_calls));
+    return replay_call_count;
+}
+
+/**
+ * Handlers subscribed to a task and to one of its messages must be called in
+ * order of registration, also when a message subscription precedes the task
+ * subscription. The handlers of the trace are reused, their index tells the
+ * registration order.
+ *
+ * @return
+ * true if the dispatch table and the list call the handlers in that order.
+ */
+static bool Replay_CheckOrder(void)
+{
+    const ke_msg_id_t msg_id = (REPLAY_ORDER_TASK << 8) | 0x01;
+    const ReplayMsg_t msg = { msg_id, 0, REPLAY_ORDER_TASK };
+    const uint8_t expected[4] = { 0, 1, 3, 2 };
+    uint8_t table_calls[REPLAY_MAX_CALLBACKS];
+    uint8_t list_calls[REPLAY_MAX_CALLBACKS];
+    uint32_t table_count;
+    uint32_t list_count;
+    bool ok;
+
+    /* Message, task, two messages, and a re-registration that moves the
+     * handler 2 last: the expected order is 0 1 3 2. */
+    for (int impl = 0; impl < 2; ++impl)
+    {
+        bool (*add)(ke_msg_id_t const msg_id, MsgHandler_Callback_t callback) =
+            (impl == 0) ? MsgHandler_Add : MsgHandlerList_Add;
+
+        add(msg_id, replay_handlers[0]);
+        add(REPLAY_ORDER_TASK, replay_handlers[1]);
+        add(msg_id, replay_handlers[2]);
+        add(msg_id, replay_handlers[3]);
+        add(msg_id, replay_handlers[2]);
+    }
+
+    table_count = Replay_Calls(MsgHandler_Notify, &msg, table_calls);
+    list_count = Replay_Calls(MsgHandlerList_Notify, &msg, list_calls);
+
+    ok = (table_count == 4) && (list_count == 4)
+         && (memcmp(table_calls, expected, 4) == 0)
+         && (memcmp(list_calls, expected, 4) == 0);
+    if (!ok)
+    {
+        printf("Call order: table %u calls, list %u calls, expected 0 1 3 2\n",
+               table_count, list_count);
+    }
+
+    for (int impl = 0; impl < 2; ++impl)
+    {
+        bool (*remove)(ke_msg_id_t const msg_id,
+                       MsgHandler_Callback_t callback) =
+            (impl == 0) ? MsgHandler_Remove : MsgHandlerList_Remove;
+
+        remove(msg_id, replay_handlers[0]);
+        remove(REPLAY_ORDER_TASK, replay_handlers[1]);
+        remove(msg_id, replay_handlers[2]);
+        remove(msg_id, replay_handlers[3]);
+    }
+
+    return ok;
+}
+
+static double Replay_TimeNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * Replay the trace repeat times.
+ *
+ * @return
+ * Best of REPLAY_RUNS runs in nanoseconds per message.
+ */
+static double Replay_Benchmark(int (*notify)(ke_msg_id_t const msg_id,
+                                             void *param,
+                                             ke_task_id_t const dest_id,
+                                             ke_task_id_t const src_id),
+                               uint32_t repeat)
+{
+    double best = 0;
+
+    for (int run = 0; run < REPLAY_RUNS; ++run)
+    {
+        double start = Replay_TimeNs();
+        double ns;
+
+        for (uint32_t r = 0; r < repeat; ++r)
+        {
+            for (uint32_t i = 0; i < replay_msg_count; ++i)
+            {
+                notify(replay_msgs[i].msg_id, NULL, replay_msgs[i].dest_id,
+                       replay_msgs[i].src_id);
+            }
+        }
+
+        ns = (Replay_TimeNs() - start) / ((double) repeat * replay_msg_count);
+        if ((run == 0) || (ns < best))
+        {
+            best = ns;
+        }
+    }
+
+    return best;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t repeat = REPLAY_DEFAULT_REPEAT;
+    uint32_t mismatches = 0;
+    uint64_t calls = 0;
+    double table_ns;
+    double list_ns;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <trace> [repeat]\n", argv[0]);
+        return 2;
+    }
+    if (argc > 2)
+    {
+        repeat = (uint32_t) strtoul(argv[2], NULL, 0);
+    }
+
+    if (!Replay_LoadTrace(argv[1]) || (replay_msg_count == 0))
+    {
+        fprintf(stderr, "No messages in %s\n", argv[1]);
+        return 2;
+    }
+
+    for (uint32_t i = 0; i < replay_sub_count; ++i)
+    {
+        MsgHandler_Callback_t callback = replay_handlers[replay_subs[i].callback];
+
+        if (!MsgHandler_Add(replay_subs[i].msg_id, callback)
+            || !MsgHandlerList_Add(replay_subs[i].msg_id, callback))
+        {
+            fprintf(stderr, "MsgHandler_Add(0x%04x) failed\n",
+                    replay_subs[i].msg_id);
+            return 1;
+        }
+    }
+
+    /* Both implementations must call the same handlers in the same order
+     * for every message.
+     */
+    for (uint32_t i = 0; i < replay_msg_count; ++i)
+    {
+        uint8_t table_calls[REPLAY_MAX_CALLBACKS];
+        uint8_t list_calls[REPLAY_MAX_CALLBACKS];
+        uint32_t table_count = Replay_Calls(MsgHandler_Notify, &replay_msgs[i],
+                                            table_calls);
+        uint32_t list_count = Replay_Calls(MsgHandlerList_Notify,
+                                           &replay_msgs[i], list_calls);
+
+        if ((table_count != list_count) || (table_count > REPLAY_MAX_CALLBACKS)
+            || (memcmp(table_calls, list_calls, table_count) != 0))
+        {
+            if (mismatches++ < 10)
+            {
+                printf("Message %u (0x%04x): table called %u handlers, "
+                       "list %u, or in another order\n", i,
+                       replay_msgs[i].msg_id, table_count, list_count);
+            }
+        }
+        calls += table_count;
+    }
+
+    table_ns = Replay_Benchmark(MsgHandler_Notify, repeat);
+    list_ns = Replay_Benchmark(MsgHandlerList_Notify, repeat);
+
+    if (!Replay_CheckOrder())
+    {
+        ++mismatches;
+    }
+
+    printf("Trace: %u messages, %u subscriptions, %u callbacks, "
+           "%llu handler calls\n", replay_msg_count, replay_sub_count,
+           replay_callback_count, (unsigned long long) calls);
+    printf("Dispatch table: %.1f ns/message\n", table_ns);
+    printf("Linked list:    %.1f ns/message\n", list_ns);
+    printf("Speedup:        %.2fx\n", list_ns / table_ns);
+    printf("Mismatches:     %u\n", mismatches);
+
+    return (mismatches == 0) ? 0 : 1;
+}
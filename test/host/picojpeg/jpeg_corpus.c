@@ -0,0 +1,200 @@
+/* ----------------------------------------------------------------------------
+ * jpeg_corpus.c
+ * - Writes the JPEG corpus of the picojpeg conformance test and benchmark
+ *   with libjpeg: synthetic images in every chroma subsampling supported by
+ *   picojpeg, from 1x1 pixel to VGA size, with and without restart markers,
+ *   plus progressive images.
+ *
+ * Usage: jpeg_corpus <output directory>
+ * ------------------------------------------------------------------------- */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <jpeglib.h>
+
+typedef struct
+{
+    const char *name;
+    int h_samp;
+    int v_samp;
+    int gray;
+} CorpusSampling_t;
+
+static const CorpusSampling_t corpus_samplings[] =
+{
+    { "444",  1, 1, 0 },
+    { "422",  2, 1, 0 },
+    { "440",  1, 2, 0 },
+    { "420",  2, 2, 0 },
+    { "gray", 1, 1, 1 },
+};
+
+static const int corpus_sizes[][2] =
+{
+    { 1, 1 }, { 17, 9 }, { 127, 93 }, { 320, 240 }, { 641, 479 },
+};
+
+#define CORPUS_SAMPLING_COUNT   (sizeof(corpus_samplings) / sizeof(corpus_samplings[0]))
+#define CORPUS_SIZE_COUNT       (sizeof(corpus_sizes) / sizeof(corpus_sizes[0]))
+
+/**
+ * Deterministic test pattern: smooth colour gradients, hard edged shapes and
+ * a noise textured band, so that both low and high frequency coefficients
+ * are exercised.
+ */
+static void Corpus_Pixel(int x, int y, int width, int height, uint8_t *rgb)
+{
+    uint32_t noise = (uint32_t) (x * 73856093) ^ (uint32_t) (y * 19349663);
+    int r = (x * 255) / (width > 1 ? width - 1 : 1);
+    int g = (y * 255) / (height > 1 ? height - 1 : 1);
+    int b = 128 + ((x - y) % 97);
+
+    noise = (noise ^ (noise >> 13)) * 0x5bd1e995;
+    noise ^= noise >> 15;
+
+    /* Shapes: a dark square and a saturated disc. */
+    if ((x > width / 8) && (x < width / 3) && (y > height / 6) && (y < height / 2))
+    {
+        r = 20; g = 30; b = 200;
+    }
+    if ((x - 2 * width / 3) * (x - 2 * width / 3)
+        + (y - height / 2) * (y - height / 2) < (height / 4) * (height / 4))
+    {
+        r = 240; g = 220; b = 10;
+    }
+
+    /* Noise textured band in the bottom quarter. */
+    if (y > 3 * height / 4)
+    {
+        r += (int) (noise & 63) - 32;
+        g += (int) ((noise >> 6) & 63) - 32;
+        b += (int) ((noise >> 12) & 63) - 32;
+    }
+
+    rgb[0] = (uint8_t) (r < 0 ? 0 : r > 255 ? 255 : r);
+    rgb[1] = (uint8_t) (g < 0 ? 0 : g > 255 ? 255 : g);
+    rgb[2] = (uint8_t) (b < 0 ? 0 : b > 255 ? 255 : b);
+}
+
+static int Corpus_Write(const char *dir, int width, int height,
+                        const CorpusSampling_t *sampling, int quality,
+                        int restart_interval, int progressive)
+{
+    struct jpeg_compress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    char path[512];
+    uint8_t *row;
+    FILE *f;
+
+    snprintf(path, sizeof(path), "%s/%dx%d_%s_q%d_%s.jpg", dir, width, height,
+             sampling->name, quality,
+             progressive ? "prog" : restart_interval == 0 ? "r0"
+             : restart_interval == 1 ? "r1" : "r3");
+
+    f = fopen(path, "wb");
+    if (f == NULL)
+    {
+        fprintf(stderr, "Cannot create %s\n", path);
+        return 1;
+    }
+
+    row = malloc((size_t) width * 3);
+    if (row == NULL)
+    {
+        fclose(f);
+        return 1;
+    }
+
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+    jpeg_stdio_dest(&cinfo, f);
+
+    cinfo.image_width = (JDIMENSION) width;
+    cinfo.image_height = (JDIMENSION) height;
+    cinfo.input_components = sampling->gray ? 1 : 3;
+    cinfo.in_color_space = sampling->gray ? JCS_GRAYSCALE : JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, quality, TRUE);
+    cinfo.restart_interval = (unsigned int) restart_interval;
+    if (!sampling->gray)
+    {
+        cinfo.comp_info[0].h_samp_factor = sampling->h_samp;
+        cinfo.comp_info[0].v_samp_factor = sampling->v_samp;
+        cinfo.comp_info[1].h_samp_factor = 1;
+        cinfo.comp_info[1].v_samp_factor = 1;
+        cinfo.comp_info[2].h_samp_factor = 1;
+        cinfo.comp_info[2].v_samp_factor = 1;
+    }
+    if (progressive)
+    {
+        jpeg_simple_progression(&cinfo);
+    }
+
+    jpeg_start_compress(&cinfo, TRUE);
+    while (cinfo.next_scanline < cinfo.image_height)
+    {
+        JSAMPROW rows[1] = { row };
+        int y = (int) cinfo.next_scanline;
+
+        for (int x = 0; x < width; ++x)
+        {
+            uint8_t rgb[3];
+
+            Corpus_Pixel(x, y, width, height, rgb);
+            if (sampling->gray)
+            {
+                row[x] = (uint8_t) ((rgb[0] * 77 + rgb[1] * 150 + rgb[2] * 29) >> 8);
+            }
+            else
+            {
+                memcpy(&row[x * 3], rgb, 3);
+            }
+        }
+        jpeg_write_scanlines(&cinfo, rows, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+
+    free(row);
+    fclose(f);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int errors = 0;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s <output directory>\n", argv[0]);
+        return 2;
+    }
+
+    /* Every size in every subsampling, without restart markers. */
+    for (size_t s = 0; s < CORPUS_SIZE_COUNT; ++s)
+    {
+        for (size_t c = 0; c < CORPUS_SAMPLING_COUNT; ++c)
+        {
+            errors += Corpus_Write(argv[1], corpus_sizes[s][0],
+                                   corpus_sizes[s][1], &corpus_samplings[c],
+                                   90, 0, 0);
+        }
+    }
+
+    /* Restart intervals of 1 and 3 MCUs, also at low quality. */
+    for (int r = 1; r <= 3; r += 2)
+    {
+        errors += Corpus_Write(argv[1], 127, 93, &corpus_samplings[0], 90, r, 0);
+        errors += Corpus_Write(argv[1], 127, 93, &corpus_samplings[3], 90, r, 0);
+        errors += Corpus_Write(argv[1], 641, 479, &corpus_samplings[3], 50, r, 0);
+        errors += Corpus_Write(argv[1], 641, 479, &corpus_samplings[4], 50, r, 0);
+    }
+
+    /* Progressive images, decoded by picojpeg only at 1/8 scale. */
+    errors += Corpus_Write(argv[1], 320, 240, &corpus_samplings[3], 90, 0, 1);
+    errors += Corpus_Write(argv[1], 127, 93, &corpus_samplings[4], 90, 0, 1);
+
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,760 @@
+/* ----------------------------------------------------------------------------
+ * picojpeg_bench.c
+ * - Conformance test and benchmark of picojpeg on the host.
+ *
+ * Usage: picojpeg_bench [-q] <file.jpg>...
+ *
+ * Every image is decoded with pjpeg_decoder_decode_rows() in full size, 1/2
+ * and 1/4 scaled and 1/8 reduced mode and compared to the libjpeg decode at
+ * the same scale. libjpeg runs without fancy upsampling, which picojpeg does
+ * not implement either. Progressive images must be rejected in all modes but
+ * 1/8. Two decoders decoding interleaved must produce the same pixels as one
+ * decoder at a time.
+ *
+ * All tests run for the default build of picojpeg, which fuses the IDCT
+ * columns, chroma upsampling and colour conversion into one pass, and for a
+ * build with the separate passes (PJPG_FUSED_TRANSFORM 0). The error limits
+ * apply to the default build, the error of the separate passes is only
+ * reported and must not be lower than that of the fused pass.
+ *
+ * The luma error is checked in all modes, the RGB error only in full size:
+ * for H2V2 images scaled by libjpeg, the chroma is decoded with a larger IDCT
+ * instead of being upsampled, which makes it sharper than that of picojpeg.
+ *
+ * Per mode, the worst mean and maximum absolute luma error, the maximum RGB
+ * error, the decode speed in MCUs/s and JPEG bytes/s and the peak RAM are
+ * reported. Peak RAM is the decoder state, the output strip of one MCU row
+ * and the peak stack usage of a decode on the host. -q skips the speed
+ * measurement.
+ *
+ * Exit status is 0 if all images pass.
+ * ------------------------------------------------------------------------- */
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ucontext.h>
+
+#include <jpeglib.h>
+
+#include <picojpeg.h>
+
+#include "picojpeg_unfused.h"
+
+/* Minimum time to decode an image repeatedly for one speed sample. */
+#define BENCH_MIN_TIME_NS       10e6
+#define BENCH_SPEED_SAMPLES     3
+
+#define BENCH_STACK_SIZE        (256 * 1024)
+#define BENCH_STACK_PAINT       0xA5
+
+/* Rounding differences allowed between the fused and the separate passes. */
+#define BENCH_FUSED_MEAN_TOLERANCE  0.05
+#define BENCH_FUSED_MAX_TOLERANCE   2
+
+typedef struct
+{
+    const char *name;
+    unsigned char reduce;
+    int denom;
+
+    /* Limits of the per image mean and maximum absolute error. */
+    double max_luma_mean;
+    int max_luma_error;
+    int max_rgb_error;
+} Bench_Mode_t;
+
+/* Decoder implementation under test. */
+typedef struct
+{
+    const char *name;
+    bool check_limits;
+    const size_t *p_state_size;
+    unsigned char (*init)(pjpeg_decoder_t *pDecoder, pjpeg_image_info_t *pInfo,
+                          pjpeg_need_bytes_callback_t pNeed_bytes_callback,
+                          void *pCallback_data, unsigned char reduce);
+    unsigned char (*decode_rows)(pjpeg_decoder_t *pDecoder,
+                                 const pjpeg_row_config_t *pConfig,
+                                 unsigned char *pDst, int *pNumRows);
+} Bench_Decoder_t;
+
+typedef struct
+{
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+} Bench_Stream_t;
+
+typedef struct
+{
+    int width;
+    int height;
+    int comps;
+    int mcus;
+    int strip_size;
+    uint8_t *pixels;
+} Bench_Output_t;
+
+typedef struct
+{
+    double luma_mean;
+    int luma_max;
+    int rgb_max;
+} Bench_Error_t;
+
+typedef struct
+{
+    int images;
+    int failures;
+    Bench_Error_t worst;
+    double mcus;
+    double bytes;
+    double time_ns;
+    int strip_size;
+    size_t stack_size;
+} Bench_ModeStats_t;
+
+static const Bench_Mode_t bench_modes[] =
+{
+    { "full",        PJPG_REDUCE_NONE, 1, 1.0,  8,   8 },
+    { "scaled 1/2",  PJPG_REDUCE_1_2,  2, 6.0, 32, 255 },
+    { "scaled 1/4",  PJPG_REDUCE_1_4,  4, 6.0, 32, 255 },
+    { "reduced 1/8", PJPG_REDUCE_1_8,  8, 6.0, 32, 255 },
+};
+
+#define BENCH_MODE_COUNT        (sizeof(bench_modes) / sizeof(bench_modes[0]))
+
+static const size_t bench_decoder_size = sizeof(pjpeg_decoder_t);
+
+/* The fused build first, it is checked against the others. */
+static const Bench_Decoder_t bench_decoders[] =
+{
+    { "fused", true, &bench_decoder_size, pjpeg_decoder_init,
+      pjpeg_decoder_decode_rows },
+    { "unfused", false, &pjpeg_unfused_decoder_size, pjpeg_unfused_decoder_init,
+      pjpeg_unfused_decoder_decode_rows },
+};
+
+#define BENCH_DECODER_COUNT     (sizeof(bench_decoders) / sizeof(bench_decoders[0]))
+
+static Bench_ModeStats_t bench_stats[BENCH_DECODER_COUNT][BENCH_MODE_COUNT];
+
+static unsigned char Bench_NeedBytes(unsigned char *pBuf, unsigned char buf_size,
+                                     unsigned char *pBytes_actually_read,
+                                     void *pCallback_data)
+{
+    Bench_Stream_t *p_stream = pCallback_data;
+    size_t n = p_stream->size - p_stream->pos;
+
+    if (n > buf_size)
+    {
+        n = buf_size;
+    }
+    memcpy(pBuf, p_stream->data + p_stream->pos, n);
+    p_stream->pos += n;
+    *pBytes_actually_read = (unsigned char) n;
+
+    return 0;
+}
+
+static double Bench_TimeNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint8_t *Bench_ReadFile(const char *path, size_t *p_size)
+{
+    uint8_t *data;
+    long size;
+    FILE *f = fopen(path, "rb");
+
+    if (f == NULL)
+    {
+        return NULL;
+    }
+
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    data = malloc((size_t) size);
+    if ((data != NULL) && (fread(data, 1, (size_t) size, f) != (size_t) size))
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+
+    *p_size = (size_t) size;
+    return data;
+}
+
+/**
+ * Decode with libjpeg at 1/denom scale.
+ *
+ * @return
+ * true on success.
+ */
+static bool Bench_ReferenceDecode(const uint8_t *data, size_t size, int denom,
+                                  Bench_Output_t *p_out, bool *p_progressive)
+{
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    int pitch;
+
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, (unsigned char *) data, (unsigned long) size);
+    jpeg_read_header(&cinfo, TRUE);
+
+    *p_progressive = jpeg_has_multiple_scans(&cinfo);
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = (unsigned int) denom;
+    cinfo.dct_method = JDCT_ISLOW;
+    cinfo.do_fancy_upsampling = FALSE;
+    cinfo.out_color_space = (cinfo.num_components == 1) ? JCS_GRAYSCALE : JCS_RGB;
+    jpeg_start_decompress(&cinfo);
+
+    p_out->width = (int) cinfo.output_width;
+    p_out->height = (int) cinfo.output_height;
+    p_out->comps = cinfo.output_components;
+    pitch = p_out->width * p_out->comps;
+    p_out->pixels = malloc((size_t) pitch * p_out->height);
+
+    while (cinfo.output_scanline < cinfo.output_height)
+    {
+        JSAMPROW row = p_out->pixels + (size_t) cinfo.output_scanline * pitch;
+
+        jpeg_read_scanlines(&cinfo, &row, 1);
+    }
+
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    return true;
+}
+
+/**
+ * Open the image with decoder p_dec in mode p_mode.
+ *
+ * @return
+ * picojpeg status, 0 on success.
+ */
+static unsigned char Bench_Open(const Bench_Decoder_t *p_dec,
+                                pjpeg_decoder_t *p_state,
+                                Bench_Stream_t *p_stream,
+                                const Bench_Mode_t *p_mode,
+                                Bench_Output_t *p_out,
+                                pjpeg_row_config_t *p_config)
+{
+    pjpeg_image_info_t info;
+    int block_shift = (p_mode->denom == 1) ? 3 : (p_mode->denom == 2) ? 2
+                      : (p_mode->denom == 4) ? 1 : 0;
+    unsigned char status;
+
+    p_stream->pos = 0;
+    status = p_dec->init(p_state, &info, Bench_NeedBytes, p_stream,
+                         p_mode->reduce);
+    if (status)
+    {
+        return status;
+    }
+
+    p_out->width = (info.m_width + p_mode->denom - 1) / p_mode->denom;
+    p_out->height = (info.m_height + p_mode->denom - 1) / p_mode->denom;
+    p_out->comps = (info.m_comps == 1) ? 1 : 3;
+    p_out->mcus = info.m_MCUSPerRow * info.m_MCUSPerCol;
+    p_out->strip_size = p_out->width * p_out->comps
+                        * ((info.m_MCUHeight >> 3) << block_shift);
+
+    memset(p_config, 0, sizeof(*p_config));
+    p_config->m_format = (p_out->comps == 1) ? PJPG_PIXEL_GRAY8 : PJPG_PIXEL_RGB888;
+    p_config->m_scale = 1;
+    p_config->m_pitch = p_out->width * p_out->comps;
+
+    return 0;
+}
+
+/**
+ * Decode the next MCU row into p_out at row *p_row.
+ *
+ * @return
+ * picojpeg status, PJPG_NO_MORE_BLOCKS after the last row.
+ */
+static unsigned char Bench_DecodeRows(const Bench_Decoder_t *p_dec,
+                                      pjpeg_decoder_t *p_state,
+                                      const pjpeg_row_config_t *p_config,
+                                      Bench_Output_t *p_out, int *p_row)
+{
+    int rows = 0;
+    unsigned char status = p_dec->decode_rows(p_state, p_config,
+            p_out->pixels + (size_t) *p_row * p_config->m_pitch, &rows);
+
+    *p_row += rows;
+    return status;
+}
+
+/**
+ * Decode the complete image into p_out, allocating its pixels if needed.
+ *
+ * @return
+ * picojpeg status, 0 on success.
+ */
+static unsigned char Bench_Decode(const Bench_Decoder_t *p_dec,
+                                  pjpeg_decoder_t *p_state,
+                                  Bench_Stream_t *p_stream,
+                                  const Bench_Mode_t *p_mode,
+                                  Bench_Output_t *p_out)
+{
+    pjpeg_row_config_t config;
+    unsigned char status;
+    int row = 0;
+
+    status = Bench_Open(p_dec, p_state, p_stream, p_mode, p_out, &config);
+    if (status)
+    {
+        return status;
+    }
+
+    if (p_out->pixels == NULL)
+    {
+        p_out->pixels = malloc((size_t) config.m_pitch * p_out->height);
+    }
+
+    while ((status = Bench_DecodeRows(p_dec, p_state, &config, p_out, &row)) == 0)
+    {
+    }
+
+    return (status == PJPG_NO_MORE_BLOCKS) && (row == p_out->height) ? 0 : status;
+}
+
+/* Decode run on the painted stack by Bench_StackUsage(). */
+static struct
+{
+    const Bench_Decoder_t *p_dec;
+    pjpeg_decoder_t *p_state;
+    Bench_Stream_t *p_stream;
+    const Bench_Mode_t *p_mode;
+    Bench_Output_t *p_out;
+    ucontext_t caller;
+} bench_stack_job;
+
+static void Bench_StackJob(void)
+{
+    Bench_Decode(bench_stack_job.p_dec, bench_stack_job.p_state,
+                 bench_stack_job.p_stream, bench_stack_job.p_mode,
+                 bench_stack_job.p_out);
+}
+
+/**
+ * Decode the image once on a painted stack.
+ *
+ * @return
+ * Peak stack usage of the decode in bytes.
+ */
+static size_t Bench_StackUsage(const Bench_Decoder_t *p_dec,
+                               pjpeg_decoder_t *p_state,
+                               Bench_Stream_t *p_stream,
+                               const Bench_Mode_t *p_mode,
+                               Bench_Output_t *p_out)
+{
+    static uint8_t stack[BENCH_STACK_SIZE];
+    ucontext_t job;
+    size_t unused = 0;
+
+    memset(stack, BENCH_STACK_PAINT, sizeof(stack));
+
+    bench_stack_job.p_dec = p_dec;
+    bench_stack_job.p_state = p_state;
+    bench_stack_job.p_stream = p_stream;
+    bench_stack_job.p_mode = p_mode;
+    bench_stack_job.p_out = p_out;
+
+    getcontext(&job);
+    job.uc_stack.ss_sp = stack;
+    job.uc_stack.ss_size = sizeof(stack);
+    job.uc_link = &bench_stack_job.caller;
+    makecontext(&job, Bench_StackJob, 0);
+    swapcontext(&bench_stack_job.caller, &job);
+
+    /* The stack grows down, count the bytes never written. */
+    while ((unused < sizeof(stack)) && (stack[unused] == BENCH_STACK_PAINT))
+    {
+        ++unused;
+    }
+
+    return sizeof(stack) - unused;
+}
+
+static int Bench_Luma(const uint8_t *p_pixel, int comps)
+{
+    if (comps == 1)
+    {
+        return p_pixel[0];
+    }
+
+    return (77 * p_pixel[0] + 150 * p_pixel[1] + 29 * p_pixel[2] + 128) >> 8;
+}
+
+/**
+ * Compare decoded pixels to the reference.
+ *
+ * @return
+ * true if the images have the same size.
+ */
+static bool Bench_Compare(const Bench_Output_t *p_out, const Bench_Output_t *p_ref,
+                          Bench_Error_t *p_error)
+{
+    size_t pixels = (size_t) p_out->width * p_out->height;
+    int comps = p_out->comps;
+    uint64_t sum = 0;
+
+    memset(p_error, 0, sizeof(*p_error));
+    if ((p_out->width != p_ref->width) || (p_out->height != p_ref->height)
+        || (p_out->comps != p_ref->comps))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < pixels; ++i)
+    {
+        const uint8_t *p_a = p_out->pixels + i * comps;
+        const uint8_t *p_b = p_ref->pixels + i * comps;
+        int d = abs(Bench_Luma(p_a, comps) - Bench_Luma(p_b, comps));
+
+        sum += (uint64_t) d;
+        if (d > p_error->luma_max)
+        {
+            p_error->luma_max = d;
+        }
+
+        for (int c = 0; c < comps; ++c)
+        {
+            d = abs((int) p_a[c] - (int) p_b[c]);
+            if (d > p_error->rgb_max)
+            {
+                p_error->rgb_max = d;
+            }
+        }
+    }
+
+    p_error->luma_mean = (pixels > 0) ? (double) sum / pixels : 0;
+    return true;
+}
+
+/**
+ * Decode the image with two decoders at once, alternating between them after
+ * every MCU row, and compare with the separate decodes.
+ *
+ * @return
+ * true if the pixels are identical.
+ */
+static bool Bench_Interleaved(const Bench_Decoder_t *p_dec,
+                              const uint8_t *data, size_t size,
+                              const Bench_Mode_t *p_mode_a,
+                              const Bench_Mode_t *p_mode_b)
+{
+    const Bench_Mode_t *modes[2] = { p_mode_a, p_mode_b };
+    pjpeg_decoder_t *states[2];
+    Bench_Stream_t streams[2];
+    Bench_Output_t single[2] = { { 0 } };
+    Bench_Output_t both[2] = { { 0 } };
+    pjpeg_row_config_t configs[2];
+    unsigned char status[2] = { 0, 0 };
+    int rows[2] = { 0, 0 };
+    bool ok = true;
+
+    for (int i = 0; i < 2; ++i)
+    {
+        states[i] = malloc(*p_dec->p_state_size);
+        streams[i].data = data;
+        streams[i].size = size;
+        ok = ok && (Bench_Decode(p_dec, states[i], &streams[i], modes[i], &single[i]) == 0);
+    }
+
+    for (int i = 0; ok && (i < 2); ++i)
+    {
+        ok = (Bench_Open(p_dec, states[i], &streams[i], modes[i], &both[i], &configs[i]) == 0);
+        both[i].pixels = calloc(1, (size_t) configs[i].m_pitch * both[i].height);
+    }
+
+    while (ok && ((status[0] == 0) || (status[1] == 0)))
+    {
+        for (int i = 0; i < 2; ++i)
+        {
+            if (status[i] == 0)
+            {
+                status[i] = Bench_DecodeRows(p_dec, states[i], &configs[i], &both[i], &rows[i]);
+            }
+        }
+    }
+
+    for (int i = 0; i < 2; ++i)
+    {
+        ok = ok && (status[i] == PJPG_NO_MORE_BLOCKS)
+             && (memcmp(single[i].pixels, both[i].pixels,
+                        (size_t) configs[i].m_pitch * both[i].height) == 0);
+        free(single[i].pixels);
+        free(both[i].pixels);
+        free(states[i]);
+    }
+
+    return ok;
+}
+
+/**
+ * Test and time one image with one decoder in one mode.
+ *
+ * @param[out] p_error
+ * Error relative to libjpeg, a luma_mean of -1 if the image was not decoded.
+ *
+ * @return
+ * true if the image passes.
+ */
+static bool Bench_Image(const char *path, const uint8_t *data, size_t size,
+                        const Bench_Decoder_t *p_dec, const Bench_Mode_t *p_mode,
+                        Bench_ModeStats_t *p_stats, bool measure_speed,
+                        Bench_Error_t *p_error)
+{
+    Bench_Stream_t stream = { data, size, 0 };
+    Bench_Output_t ref = { 0 };
+    Bench_Output_t out = { 0 };
+    pjpeg_decoder_t *p_state = malloc(*p_dec->p_state_size);
+    bool progressive;
+    bool ok = true;
+    unsigned char status;
+    Bench_Error_t error = { -1, 0, 0 };
+
+    Bench_ReferenceDecode(data, size, p_mode->denom, &ref, &progressive);
+    status = Bench_Decode(p_dec, p_state, &stream, p_mode, &out);
+
+    p_stats->images++;
+
+    if (progressive && (p_mode->reduce != PJPG_REDUCE_1_8))
+    {
+        /* Only the DC scan of progressive images is supported. */
+        if (status != PJPG_UNSUPPORTED_MODE)
+        {
+            printf("FAIL %s %s %s: status %u, expected PJPG_UNSUPPORTED_MODE\n",
+                   p_dec->name, p_mode->name, path, status);
+            ok = false;
+        }
+    }
+    else if (status)
+    {
+        printf("FAIL %s %s %s: status %u\n", p_dec->name, p_mode->name, path,
+               status);
+        ok = false;
+    }
+    else if (!Bench_Compare(&out, &ref, &error))
+    {
+        printf("FAIL %s %s %s: %dx%d, expected %dx%d\n", p_dec->name,
+               p_mode->name, path, out.width, out.height, ref.width, ref.height);
+        ok = false;
+    }
+    else
+    {
+        if (p_dec->check_limits
+            && ((error.luma_mean > p_mode->max_luma_mean)
+                || (error.luma_max > p_mode->max_luma_error)
+                || (error.rgb_max > p_mode->max_rgb_error)))
+        {
+            printf("FAIL %s %s %s: luma error mean %.2f max %d, RGB error max %d\n",
+                   p_dec->name, p_mode->name, path, error.luma_mean,
+                   error.luma_max, error.rgb_max);
+            ok = false;
+        }
+        if (error.luma_mean > p_stats->worst.luma_mean)
+        {
+            p_stats->worst.luma_mean = error.luma_mean;
+        }
+        if (error.luma_max > p_stats->worst.luma_max)
+        {
+            p_stats->worst.luma_max = error.luma_max;
+        }
+        if (error.rgb_max > p_stats->worst.rgb_max)
+        {
+            p_stats->worst.rgb_max = error.rgb_max;
+        }
+        if (out.strip_size > p_stats->strip_size)
+        {
+            p_stats->strip_size = out.strip_size;
+        }
+
+        size_t stack_size = Bench_StackUsage(p_dec, p_state, &stream, p_mode, &out);
+        if (stack_size > p_stats->stack_size)
+        {
+            p_stats->stack_size = stack_size;
+        }
+
+        if (measure_speed)
+        {
+            double best = 0;
+
+            for (int sample = 0; sample < BENCH_SPEED_SAMPLES; ++sample)
+            {
+                double start = Bench_TimeNs();
+                double elapsed;
+                int count = 0;
+
+                do
+                {
+                    Bench_Decode(p_dec, p_state, &stream, p_mode, &out);
+                    ++count;
+                    elapsed = Bench_TimeNs() - start;
+                } while (elapsed < BENCH_MIN_TIME_NS);
+
+                if ((sample == 0) || (elapsed / count < best))
+                {
+                    best = elapsed / count;
+                }
+            }
+
+            p_stats->mcus += out.mcus;
+            p_stats->bytes += (double) size;
+            p_stats->time_ns += best;
+        }
+    }
+
+    if (!ok)
+    {
+        p_stats->failures++;
+    }
+
+    *p_error = error;
+    free(ref.pixels);
+    free(out.pixels);
+    free(p_state);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    bool measure_speed = true;
+    int failures = 0;
+    int files = 0;
+
+    for (int a = 1; a < argc; ++a)
+    {
+        size_t size;
+        uint8_t *data;
+        bool progressive;
+
+        if (strcmp(argv[a], "-q") == 0)
+        {
+            measure_speed = false;
+            continue;
+        }
+
+        data = Bench_ReadFile(argv[a], &size);
+        if (data == NULL)
+        {
+            printf("FAIL %s: cannot read\n", argv[a]);
+            ++failures;
+            continue;
+        }
+        ++files;
+
+        {
+            Bench_Output_t ref = { 0 };
+
+            Bench_ReferenceDecode(data, size, 8, &ref, &progressive);
+            free(ref.pixels);
+        }
+
+        for (size_t m = 0; m < BENCH_MODE_COUNT; ++m)
+        {
+            Bench_Error_t errors[BENCH_DECODER_COUNT];
+
+            for (size_t d = 0; d < BENCH_DECODER_COUNT; ++d)
+            {
+                if (!Bench_Image(argv[a], data, size, &bench_decoders[d],
+                                 &bench_modes[m], &bench_stats[d][m],
+                                 measure_speed, &errors[d]))
+                {
+                    ++failures;
+                }
+            }
+
+            for (size_t d = 1; d < BENCH_DECODER_COUNT; ++d)
+            {
+                if ((errors[0].luma_mean > errors[d].luma_mean + BENCH_FUSED_MEAN_TOLERANCE)
+                    || (errors[0].luma_max > errors[d].luma_max + BENCH_FUSED_MAX_TOLERANCE)
+                    || (errors[0].rgb_max > errors[d].rgb_max + BENCH_FUSED_MAX_TOLERANCE))
+                {
+                    printf("FAIL %s %s %s: luma error mean %.2f max %d, RGB error max %d, "
+                           "%s: %.2f %d %d\n", bench_decoders[0].name,
+                           bench_modes[m].name, argv[a], errors[0].luma_mean,
+                           errors[0].luma_max, errors[0].rgb_max,
+                           bench_decoders[d].name, errors[d].luma_mean,
+                           errors[d].luma_max, errors[d].rgb_max);
+                    ++failures;
+                }
+            }
+        }
+
+        for (size_t d = 0; d < BENCH_DECODER_COUNT; ++d)
+        {
+            /* Full and 1/2 scaled decode of the same image at once, or the
+             * 1/8 decode twice for progressive images. */
+            if (!Bench_Interleaved(&bench_decoders[d], data, size,
+                                   &bench_modes[progressive ? 3 : 0],
+                                   &bench_modes[progressive ? 3 : 1]))
+            {
+                printf("FAIL %s %s: interleaved decoders differ\n",
+                       bench_decoders[d].name, argv[a]);
+                ++failures;
+            }
+        }
+
+        free(data);
+    }
+
+    if (files == 0)
+    {
+        fprintf(stderr, "Usage: %s [-q] <file.jpg>...\n", argv[0]);
+        return 2;
+    }
+
+    printf("%d images\n", files);
+    printf("%-10s %-12s %6s %8s %8s %7s %6s %9s %7s %6s %6s %6s %6s\n",
+           "Decoder", "Mode", "Images", "Failures", "LumaMean", "LumaMax",
+           "RGBMax", "MCU/s", "MB/s", "State", "Strip", "Stack", "RAM");
+    for (size_t d = 0; d < BENCH_DECODER_COUNT; ++d)
+    {
+        for (size_t m = 0; m < BENCH_MODE_COUNT; ++m)
+        {
+            const Bench_ModeStats_t *p_stats = &bench_stats[d][m];
+            double seconds = p_stats->time_ns / 1e9;
+
+            printf("%-10s %-12s %6d %8d %8.2f %7d %6d %9.0f %7.2f %6zu %6d %6zu %6zu\n",
+                   bench_decoders[d].name, bench_modes[m].name,
+                   p_stats->images, p_stats->failures,
+                   p_stats->worst.luma_mean, p_stats->worst.luma_max,
+                   p_stats->worst.rgb_max,
+                   (seconds > 0) ? p_stats->mcus / seconds : 0,
+                   (seconds > 0) ? p_stats->bytes / seconds / 1e6 : 0,
+                   *bench_decoders[d].p_state_size, p_stats->strip_size,
+                   p_stats->stack_size,
+                   *bench_decoders[d].p_state_size + (size_t) p_stats->strip_size
+                   + p_stats->stack_size);
+        }
+    }
+
+    if (measure_speed)
+    {
+        for (size_t m = 0; m < BENCH_MODE_COUNT; ++m)
+        {
+            printf("Speedup of %s over %s, %s: %.2fx\n", bench_decoders[0].name,
+                   bench_decoders[1].name, bench_modes[m].name,
+                   bench_stats[1][m].time_ns / bench_stats[0][m].time_ns);
+        }
+    }
+    printf("%d failures\n", failures);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,23 @@
+/* ----------------------------------------------------------------------------
+ * picojpeg_unfused.c
+ * - Builds picojpeg.c unchanged with PJPG_FUSED_TRANSFORM 0 and its global
+ *   symbols renamed, so that it links next to the default build.
+ * ------------------------------------------------------------------------- */
+#include <stddef.h>
+
+#define PJPG_FUSED_TRANSFORM                0
+
+#define pjpeg_decoder_decode_mcu            pjpeg_unfused_decoder_decode_mcu
+#define pjpeg_decoder_reset                 pjpeg_unfused_decoder_reset
+#define pjpeg_decoder_init                  pjpeg_unfused_decoder_init
+#define pjpeg_decoder_init_window           pjpeg_unfused_decoder_init_window
+#define pjpeg_decoder_set_roi               pjpeg_unfused_decoder_set_roi
+#define pjpeg_decoder_decode_roi_mcu        pjpeg_unfused_decoder_decode_roi_mcu
+#define pjpeg_decoder_decode_rows           pjpeg_unfused_decoder_decode_rows
+#define pjpeg_decode_init                   pjpeg_unfused_decode_init
+#define pjpeg_decode_mcu                    pjpeg_unfused_decode_mcu
+#define gWinogradQuant                      pjpeg_unfused_gWinogradQuant
+
+#include "picojpeg.c"
+
+const size_t pjpeg_unfused_decoder_size = sizeof(pjpeg_decoder_t);
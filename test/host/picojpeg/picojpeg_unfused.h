@@ -0,0 +1,28 @@
+/* ----------------------------------------------------------------------------
+ * picojpeg_unfused.h
+ * - picojpeg built with PJPG_FUSED_TRANSFORM 0, i.e. with the separate IDCT
+ *   column, chroma upsampling and colour conversion passes, for comparison
+ *   with the fused transform. The functions are those of picojpeg.h with
+ *   the prefix pjpeg_unfused_ instead of pjpeg_, their decoder state has
+ *   the size pjpeg_unfused_decoder_size.
+ * ------------------------------------------------------------------------- */
+#ifndef PICOJPEG_UNFUSED_H
+#define PICOJPEG_UNFUSED_H
+
+#include <stddef.h>
+
+#include <picojpeg.h>
+
+extern const size_t pjpeg_unfused_decoder_size;
+
+unsigned char pjpeg_unfused_decoder_init(pjpeg_decoder_t *pDecoder,
+                                         pjpeg_image_info_t *pInfo,
+                                         pjpeg_need_bytes_callback_t pNeed_bytes_callback,
+                                         void *pCallback_data,
+                                         unsigned char reduce);
+unsigned char pjpeg_unfused_decoder_decode_rows(pjpeg_decoder_t *pDecoder,
+                                                const pjpeg_row_config_t *pConfig,
+                                                unsigned char *pDst,
+                                                int *pNumRows);
+
+#endif /* PICOJPEG_UNFUSED_H */
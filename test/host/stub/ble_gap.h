@@ -0,0 +1,25 @@
+/* ----------------------------------------------------------------------------
+ * ble_gap.h
+ * - Host stand-in for the GAP abstraction layer
+ * ------------------------------------------------------------------------- */
+#ifndef BLE_GAP_H
+#define BLE_GAP_H
+
+#include <ke_msg.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+void GAPC_MsgHandler(ke_msg_id_t const msg_id, void const *param,
+                     ke_task_id_t const dest_id, ke_task_id_t const src_id);
+
+void GAPM_MsgHandler(ke_msg_id_t const msg_id, void const *param,
+                     ke_task_id_t const dest_id, ke_task_id_t const src_id);
+
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif    /* BLE_GAP_H */
@@ -0,0 +1,25 @@
+/* ----------------------------------------------------------------------------
+ * ble_gatt.h
+ * - Host stand-in for the GATT abstraction layer
+ * ------------------------------------------------------------------------- */
+#ifndef BLE_GATT_H
+#define BLE_GATT_H
+
+#include <ke_msg.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+void GATTC_MsgHandler(ke_msg_id_t const msg_id, void const *param,
+                      ke_task_id_t const dest_id, ke_task_id_t const src_id);
+
+void GATTM_MsgHandler(ke_msg_id_t const msg_id, void const *param,
+                      ke_task_id_t const dest_id, ke_task_id_t const src_id);
+
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif    /* BLE_GATT_H */
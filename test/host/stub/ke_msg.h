@@ -0,0 +1,29 @@
+/* ----------------------------------------------------------------------------
+ * ke_msg.h
+ * - Host stand-in for the kernel message definitions of the BLE stack
+ * ------------------------------------------------------------------------- */
+#ifndef KE_MSG_H
+#define KE_MSG_H
+
+#include <stdint.h>
+
+typedef uint16_t ke_msg_id_t;
+typedef uint16_t ke_task_id_t;
+
+/* Message IDs hold the task number in the upper byte. */
+#define KE_IDX_GET(id)                  (((id) >> 8) & 0xFF)
+#define TASK_FIRST_MSG(task)            ((ke_msg_id_t) ((task) << 8))
+
+#define KE_MSG_CONSUMED                 0
+
+enum
+{
+    TASK_ID_L2CC  = 10,
+    TASK_ID_GATTM = 11,
+    TASK_ID_GATTC = 12,
+    TASK_ID_GAPM  = 13,
+    TASK_ID_GAPC  = 14,
+    TASK_ID_APP   = 15,
+};
+
+#endif    /* KE_MSG_H */
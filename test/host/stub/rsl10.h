@@ -0,0 +1,43 @@
+/* ----------------------------------------------------------------------------
+ * rsl10.h
+ * - Host stand-in for the RSL10 device header, provides only the core debug
+ *   registers used by the modules built in test/host
+ * ------------------------------------------------------------------------- */
+#ifndef RSL10_H
+#define RSL10_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+typedef struct
+{
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk          (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk      (1UL << 24)
+
+/* Registers are plain variables on the host, the cycle counter stays 0. */
+extern DWT_Type host_dwt;
+extern CoreDebug_Type host_core_debug;
+
+#define DWT                             (&host_dwt)
+#define CoreDebug                       (&host_core_debug)
+
+extern uint32_t SystemCoreClock;
+
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif    /* RSL10_H */
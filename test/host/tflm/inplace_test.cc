@@ -0,0 +1,223 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Host test of in-place operator execution: the outputs of a model whose
+// kernels write in place of dead inputs must be identical to the outputs with
+// TfLiteRegistration::inplace_operator cleared, the subgraph input must not be
+// overwritten, and the plan written by offline_memory_planner.py for the model
+// must pass the BufferUsage check of NonPersistentMemoryPlannerShim.
+//
+// Built with INPLACE_TEST_WRITE_MODEL, the program only writes the model to
+// the .tflite file given as argument, for offline_memory_planner.py.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "six_node_model.h"
+
+#ifndef INPLACE_TEST_WRITE_MODEL
+#include "inplace_memory_plan.h"
+#include "tensorflow/lite/micro/cortex_m_generic/debug_log_callback.h"
+#include "tensorflow/lite/micro/memory_planner/non_persistent_buffer_planner_shim.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#endif
+
+namespace {
+
+constexpr int kSize = 256;
+constexpr float kOutputScale = 0.05f;
+
+#ifdef INPLACE_TEST_WRITE_MODEL
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s MODEL.tflite\n", argv[0]);
+    return 2;
+  }
+  const std::vector<uint8_t> model_data =
+      BuildSixNodeModel(kSize, kOutputScale);
+  FILE* file = fopen(argv[1], "wb");
+  if ((file == nullptr) ||
+      (fwrite(model_data.data(), 1, model_data.size(), file) !=
+       model_data.size()) ||
+      (fclose(file) != 0)) {
+    perror(argv[1]);
+    return 1;
+  }
+  return 0;
+}
+
+#else
+
+constexpr int kInferences = 200;
+constexpr size_t kArenaSize = 8192;
+
+alignas(16) uint8_t reference_arena[kArenaSize];
+alignas(16) uint8_t inplace_arena[kArenaSize];
+alignas(16) uint8_t planned_arena[kArenaSize];
+
+int failures = 0;
+
+void Check(bool condition, const char* what, int inference) {
+  if (!condition) {
+    if (inference < 0) {
+      printf("FAIL %s\n", what);
+    } else if (failures < 10) {
+      printf("FAIL inference %d: %s\n", inference, what);
+    }
+    ++failures;
+  }
+}
+
+void LogToStdout(const char* s) { fputs(s, stdout); }
+
+// Resolver returning the registrations of another resolver with
+// inplace_operator cleared, so every output gets a buffer of its own.
+class NotInPlaceOpResolver : public tflite::MicroOpResolver {
+ public:
+  explicit NotInPlaceOpResolver(const tflite::MicroOpResolver& resolver)
+      : resolver_(resolver) {}
+
+  const TfLiteRegistration* FindOp(tflite::BuiltinOperator op) const override {
+    for (int i = 0; i < count_; ++i) {
+      if (ops_[i] == op) {
+        return &registrations_[i];
+      }
+    }
+    const TfLiteRegistration* registration = resolver_.FindOp(op);
+    if ((registration == nullptr) || (count_ == kMaxOps)) {
+      return nullptr;
+    }
+    ops_[count_] = op;
+    registrations_[count_] = *registration;
+    registrations_[count_].inplace_operator = kTfLiteInplaceOpNone;
+    return &registrations_[count_++];
+  }
+
+  const TfLiteRegistration* FindOp(const char* op) const override {
+    return nullptr;
+  }
+
+  BuiltinParseFunction GetOpDataParser(
+      tflite::BuiltinOperator op) const override {
+    return resolver_.GetOpDataParser(op);
+  }
+
+ private:
+  static constexpr int kMaxOps = 4;
+  const tflite::MicroOpResolver& resolver_;
+  mutable tflite::BuiltinOperator ops_[kMaxOps];
+  mutable TfLiteRegistration registrations_[kMaxOps];
+  mutable int count_ = 0;
+};
+
+}  // namespace
+
+int main() {
+  RegisterDebugLogCallback(LogToStdout);
+
+  const std::vector<uint8_t> model_data =
+      BuildSixNodeModel(kSize, kOutputScale);
+  const tflite::Model* model = tflite::GetModel(model_data.data());
+  tflite::MicroErrorReporter error_reporter;
+  tflite::MicroMutableOpResolver<4> resolver;
+  resolver.AddRelu();
+  resolver.AddAdd();
+  resolver.AddReshape();
+  resolver.AddQuantize();
+  NotInPlaceOpResolver reference_resolver(resolver);
+
+  tflite::MicroInterpreter reference(model, reference_resolver,
+                                     reference_arena, kArenaSize,
+                                     &error_reporter);
+  tflite::MicroInterpreter inplace(model, resolver, inplace_arena, kArenaSize,
+                                   &error_reporter);
+  // Same as inplace, with the buffers placed by the offline plan.
+  tflite::NonPersistentMemoryPlannerShim planner(g_inplace_memory_plan,
+                                                 g_inplace_memory_plan_usage);
+  tflite::MicroInterpreter planned(
+      model, resolver,
+      tflite::MicroAllocator::Create(planned_arena, kArenaSize, &planner,
+                                     &error_reporter),
+      &error_reporter);
+  if ((reference.AllocateTensors() != kTfLiteOk) ||
+      (inplace.AllocateTensors() != kTfLiteOk)) {
+    printf("FAIL AllocateTensors()\n");
+    return 1;
+  }
+  // Fails if the plan does not match the buffers the allocator requests.
+  if (planned.AllocateTensors() != kTfLiteOk) {
+    printf("FAIL AllocateTensors() with the offline plan\n");
+    return 1;
+  }
+
+  // All outputs are written in place of t1, only the subgraph input t0, which
+  // t7 reads, has a buffer of its own.
+  for (tflite::MicroInterpreter* interpreter : {&inplace, &planned}) {
+    const void* shared = interpreter->GetTensor(1)->data.data;
+    for (int index : {2, 4, 7, 5, 6}) {
+      Check(interpreter->GetTensor(index)->data.data == shared,
+            "output not in place of its input", -1);
+    }
+    Check(interpreter->GetTensor(0)->data.data != shared,
+          "subgraph input shared", -1);
+  }
+  Check(inplace.arena_used_bytes() < reference.arena_used_bytes(),
+        "arena not smaller", -1);
+
+  tflite::MicroInterpreter* const interpreters[] = {&reference, &inplace,
+                                                    &planned};
+  std::vector<float> values(kSize);
+  std::vector<int8_t> expected(kSize);
+
+  srand(1);
+  for (int inference = 0; inference < kInferences; ++inference) {
+    for (float& value : values) {
+      value = (rand() % 2001 - 1000) / 100.0f;
+    }
+
+    for (tflite::MicroInterpreter* interpreter : interpreters) {
+      float* input = interpreter->input(0)->data.f;
+      int8_t* output = interpreter->output(0)->data.int8;
+      memcpy(input, values.data(), kSize * sizeof(float));
+      memset(output, 0x55, kSize);
+      Check(interpreter->Invoke() == kTfLiteOk, "Invoke()", inference);
+      Check(memcmp(values.data(), input, kSize * sizeof(float)) == 0,
+            "input overwritten", inference);
+      if (interpreter == &reference) {
+        memcpy(expected.data(), output, kSize);
+      } else {
+        Check(memcmp(expected.data(), output, kSize) == 0,
+              "output differs from the reference", inference);
+      }
+    }
+  }
+
+  printf("%d inferences, arena %d bytes in place, %d bytes without, "
+         "offline plan %d bytes, %d failures\n",
+         kInferences, static_cast<int>(inplace.arena_used_bytes()),
+         static_cast<int>(reference.arena_used_bytes()),
+         kInplaceMemoryPlanSize, failures);
+  return (failures == 0) ? 0 : 1;
+}
+
+#endif  // INPLACE_TEST_WRITE_MODEL
@@ -0,0 +1,135 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Host test of MicroInterpreter::InvokeStep(): an inference split into time
+// slices of any budget must produce the outputs of Invoke() bit for bit, and
+// Invoke() must abandon a stepped inference in progress. Built with
+// TF_LITE_USE_CTIME, the budgets are in clock() ticks.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "six_node_model.h"
+#include "tensorflow/lite/micro/cortex_m_generic/debug_log_callback.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace {
+
+constexpr int kSize = 256;
+constexpr int kInferences = 200;
+constexpr float kOutputScale = 0.05f;
+constexpr size_t kArenaSize = 32768;
+
+alignas(16) uint8_t tensor_arena[kArenaSize];
+
+int failures = 0;
+
+void Check(bool condition, const char* what, int inference) {
+  if (!condition) {
+    if (failures < 10) {
+      printf("FAIL inference %d: %s\n", inference, what);
+    }
+    ++failures;
+  }
+}
+
+void LogToStdout(const char* s) { fputs(s, stdout); }
+
+}  // namespace
+
+int main() {
+  RegisterDebugLogCallback(LogToStdout);
+
+  const std::vector<uint8_t> model_data =
+      BuildSixNodeModel(kSize, kOutputScale);
+  tflite::MicroErrorReporter error_reporter;
+  tflite::MicroMutableOpResolver<4> resolver;
+  resolver.AddRelu();
+  resolver.AddAdd();
+  resolver.AddReshape();
+  resolver.AddQuantize();
+
+  tflite::MicroInterpreter interpreter(tflite::GetModel(model_data.data()),
+                                       resolver, tensor_arena, kArenaSize,
+                                       &error_reporter);
+  if (interpreter.AllocateTensors() != kTfLiteOk) {
+    printf("FAIL AllocateTensors()\n");
+    return 1;
+  }
+
+  const size_t node_count = interpreter.operators_size();
+  float* input = interpreter.input(0)->data.f;
+  int8_t* output = interpreter.output(0)->data.int8;
+  // 0 invokes one node per call, the largest budget the whole model.
+  const uint32_t budgets[] = {0, 1, 50, 0xFFFFFFFF};
+  std::vector<float> values(kSize);
+  std::vector<int8_t> expected(kSize);
+  long step_calls = 0;
+  int stepped = 0;
+
+  srand(1);
+  for (int inference = 0; inference < kInferences; ++inference) {
+    for (float& value : values) {
+      value = (rand() % 2001 - 1000) / 100.0f;
+    }
+
+    memcpy(input, values.data(), kSize * sizeof(float));
+    Check(interpreter.Invoke() == kTfLiteOk, "Invoke()", inference);
+    memcpy(expected.data(), output, kSize);
+
+    for (uint32_t budget : budgets) {
+      // A stepped inference abandoned by Invoke() must leave no state behind.
+      if (inference % 7 == 0) {
+        memcpy(input, values.data(), kSize * sizeof(float));
+        interpreter.InvokeStep(0);
+        Check(interpreter.invoke_in_progress(), "in progress after one step",
+              inference);
+        interpreter.Invoke();
+        Check(!interpreter.invoke_in_progress(), "abandoned by Invoke()",
+              inference);
+      }
+
+      memset(output, 0x55, kSize);
+      memcpy(input, values.data(), kSize * sizeof(float));
+      size_t calls = 0;
+      do {
+        if (interpreter.InvokeStep(budget) != kTfLiteOk) {
+          Check(false, "InvokeStep()", inference);
+          break;
+        }
+        ++calls;
+      } while (interpreter.invoke_in_progress() && calls <= node_count);
+
+      Check(!interpreter.invoke_in_progress(), "at most one call per node",
+            inference);
+      Check((budget != 0) || (calls == node_count), "one node per call",
+            inference);
+      Check(memcmp(expected.data(), output, kSize) == 0,
+            "output differs from Invoke()", inference);
+      step_calls += calls;
+      ++stepped;
+    }
+  }
+
+  printf("%d stepped inferences of %d nodes, %ld InvokeStep() calls, "
+         "%d failures\n",
+         stepped, static_cast<int>(node_count), step_calls, failures);
+  return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,425 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Host benchmark of the arena high-water mark of BranchAndBoundMemoryPlanner
+// against GreedyMemoryPlanner, with the default search budget of the device.
+//
+// The buffers are modeled from the layer shapes of common int8 vision and
+// audio models, not read from .tflite files: one buffer per activation tensor,
+// live from the node that writes it to the last node that reads it, like in
+// MicroAllocator::CommitStaticMemoryPlan(), plus the scratch buffers the
+// CMSIS-NN kernels request for the node. Sizes are rounded up to the arena
+// alignment of 16 bytes.
+//
+// Checks that both layouts have no overlapping buffers, that the search is
+// never worse than greedy nor better than the lower bound, and that the
+// greedy size reported by the search matches the GreedyMemoryPlanner. The same
+// checks run on random buffer sets, which also count the sets where the search
+// beats greedy.
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+#include "tensorflow/lite/micro/cortex_m_generic/debug_log_callback.h"
+#include "tensorflow/lite/micro/memory_planner/branch_and_bound_memory_planner.h"
+#include "tensorflow/lite/micro/memory_planner/greedy_memory_planner.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+
+namespace {
+
+constexpr int kAlignment = 16;
+constexpr int kRuns = 20;
+constexpr int kRandomSets = 300;
+
+struct Buffer {
+  int size;
+  int first_time_used;
+  int last_time_used;
+};
+
+// Builds the buffer lifetimes of a graph whose nodes run in the order they
+// are added.
+class Model {
+ public:
+  explicit Model(const char* name) : name_(name) {}
+
+  const char* name() const { return name_; }
+  const std::vector<Buffer>& buffers() const { return buffers_; }
+
+  // Model input, written before the first node.
+  int Input(int bytes) { return AddBuffer(bytes, 0); }
+
+  // Adds a node that reads the inputs and writes one output tensor.
+  int Node(std::vector<int> inputs, int output_bytes, int scratch_bytes = 0) {
+    const int node = node_count_++;
+    for (int input : inputs) {
+      if (buffers_[input].last_time_used < node) {
+        buffers_[input].last_time_used = node;
+      }
+    }
+    if (scratch_bytes > 0) {
+      AddBuffer(scratch_bytes, node);
+    }
+    return AddBuffer(output_bytes, node);
+  }
+
+  // The model output is read after the last node.
+  void Output(int tensor) { buffers_[tensor].last_time_used = node_count_ - 1; }
+
+ private:
+  int AddBuffer(int bytes, int time) {
+    const int size = (bytes + kAlignment - 1) / kAlignment * kAlignment;
+    buffers_.push_back({size, time, time});
+    return static_cast<int>(buffers_.size()) - 1;
+  }
+
+  const char* name_;
+  std::vector<Buffer> buffers_;
+  int node_count_ = 0;
+};
+
+// Activation tensor of an int8 feature map.
+struct Tensor {
+  int id;
+  int height;
+  int width;
+  int channels;
+};
+
+int Bytes(int height, int width, int channels) {
+  return height * width * channels;
+}
+
+// arm_convolve_s8() im2col buffer of two int16 columns, none for 1x1 kernels
+// with arm_convolve_1x1_s8_fast().
+Tensor Conv(Model* m, Tensor in, int channels, int kernel_h, int kernel_w,
+            int stride) {
+  const int height = (in.height + stride - 1) / stride;
+  const int width = (in.width + stride - 1) / stride;
+  const int im2col_bytes = 2 * in.channels * kernel_h * kernel_w *
+                           static_cast<int>(sizeof(int16_t));
+  const int scratch = (kernel_h * kernel_w == 1) ? 0 : im2col_bytes;
+  return {m->Node({in.id}, Bytes(height, width, channels), scratch), height,
+          width, channels};
+}
+
+// 3x3 depthwise convolutions run in arm_depthwise_conv_3x3_s8() without a
+// scratch buffer.
+Tensor DepthwiseConv(Model* m, Tensor in, int stride) {
+  const int height = (in.height + stride - 1) / stride;
+  const int width = (in.width + stride - 1) / stride;
+  return {m->Node({in.id}, Bytes(height, width, in.channels)), height, width,
+          in.channels};
+}
+
+Tensor Add(Model* m, Tensor a, Tensor b) {
+  return {m->Node({a.id, b.id}, Bytes(a.height, a.width, a.channels)),
+          a.height, a.width, a.channels};
+}
+
+// Global average pooling with the int32 sum buffer of arm_avgpool_s8().
+Tensor AveragePool(Model* m, Tensor in) {
+  return {m->Node({in.id}, in.channels,
+                  in.channels * static_cast<int>(sizeof(int32_t))),
+          1, 1, in.channels};
+}
+
+Tensor FullyConnected(Model* m, Tensor in, int units) {
+  return {m->Node({in.id}, units), 1, 1, units};
+}
+
+// Classifier head: the probabilities of softmax are the model output.
+void Classifier(Model* m, Tensor features, int classes) {
+  Tensor logits = FullyConnected(m, features, classes);
+  m->Output(m->Node({logits.id}, classes));
+}
+
+Tensor InputTensor(Model* m, int height, int width, int channels) {
+  return {m->Input(Bytes(height, width, channels)), height, width, channels};
+}
+
+// Person detection: MobileNetV1 0.25 on 96x96 grayscale.
+Model MobileNetV1() {
+  Model m("MobileNetV1 0.25 96x96");
+  Tensor x = Conv(&m, InputTensor(&m, 96, 96, 1), 8, 3, 3, 2);
+  const struct {
+    int channels;
+    int stride;
+  } blocks[] = {{16, 1},  {32, 2},  {32, 1},  {64, 2},  {64, 1},
+                {128, 2}, {128, 1}, {128, 1}, {128, 1}, {128, 1},
+                {128, 1}, {256, 2}, {256, 1}};
+  for (const auto& block : blocks) {
+    x = DepthwiseConv(&m, x, block.stride);
+    x = Conv(&m, x, block.channels, 1, 1, 1);
+  }
+  Classifier(&m, AveragePool(&m, x), 2);
+  return m;
+}
+
+// Visual wake words: MobileNetV2 0.35 on 96x96 RGB with the residual adds of
+// the inverted bottleneck blocks.
+Model MobileNetV2() {
+  Model m("MobileNetV2 0.35 96x96");
+  Tensor x = Conv(&m, InputTensor(&m, 96, 96, 3), 16, 3, 3, 2);
+  const struct {
+    int expansion;
+    int channels;
+    int repeats;
+    int stride;
+  } stages[] = {{1, 8, 1, 1},  {6, 8, 2, 2},  {6, 16, 3, 2}, {6, 24, 4, 2},
+                {6, 32, 3, 1}, {6, 56, 3, 2}, {6, 112, 1, 1}};
+  for (const auto& stage : stages) {
+    for (int i = 0; i < stage.repeats; ++i) {
+      const int stride = (i == 0) ? stage.stride : 1;
+      Tensor y = x;
+      if (stage.expansion != 1) {
+        y = Conv(&m, y, x.channels * stage.expansion, 1, 1, 1);
+      }
+      y = DepthwiseConv(&m, y, stride);
+      y = Conv(&m, y, stage.channels, 1, 1, 1);
+      x = (stride == 1 && x.channels == stage.channels) ? Add(&m, x, y) : y;
+    }
+  }
+  x = Conv(&m, x, 1280, 1, 1, 1);
+  Classifier(&m, AveragePool(&m, x), 2);
+  return m;
+}
+
+// Image classification: ResNet-8 on 32x32 RGB, with 1x1 convolutions on the
+// shortcut of the downsampling stacks.
+Model ResNet8() {
+  Model m("ResNet-8 32x32");
+  Tensor x = Conv(&m, InputTensor(&m, 32, 32, 3), 16, 3, 3, 1);
+  const struct {
+    int channels;
+    int stride;
+  } stacks[] = {{16, 1}, {32, 2}, {64, 2}};
+  for (const auto& stack : stacks) {
+    Tensor y = Conv(&m, x, stack.channels, 3, 3, stack.stride);
+    y = Conv(&m, y, stack.channels, 3, 3, 1);
+    if (stack.stride != 1) {
+      x = Conv(&m, x, stack.channels, 1, 1, stack.stride);
+    }
+    x = Add(&m, x, y);
+  }
+  Classifier(&m, AveragePool(&m, x), 10);
+  return m;
+}
+
+// Keyword spotting: micro_speech tiny_conv on a 49x40 spectrogram.
+Model MicroSpeech() {
+  Model m("micro_speech tiny_conv");
+  Tensor x = Conv(&m, InputTensor(&m, 49, 40, 1), 8, 10, 8, 2);
+  Classifier(&m, x, 4);
+  return m;
+}
+
+// Keyword spotting: DS-CNN on 49x10 MFCC features.
+Model DsCnn() {
+  Model m("DS-CNN KWS 49x10");
+  Tensor x = Conv(&m, InputTensor(&m, 49, 10, 1), 64, 10, 4, 2);
+  for (int i = 0; i < 4; ++i) {
+    x = DepthwiseConv(&m, x, 1);
+    x = Conv(&m, x, 64, 1, 1, 1);
+  }
+  Classifier(&m, AveragePool(&m, x), 12);
+  return m;
+}
+
+// Anomaly detection: fully connected autoencoder on 5 frames of 128 mel bins.
+Model Autoencoder() {
+  Model m("FC autoencoder 640");
+  Tensor x = InputTensor(&m, 1, 1, 640);
+  const int units[] = {128, 128, 128, 128, 8, 128, 128, 128, 128, 640};
+  for (int n : units) {
+    x = FullyConnected(&m, x, n);
+  }
+  m.Output(x.id);
+  return m;
+}
+
+// Keyword spotting: WaveNet style temporal convolution network on 49 frames of
+// 40 MFCC features, with two dilated residual blocks of 64 channels. Every
+// block has a side branch of 32 channels to the skip connections, which are
+// summed after the last block.
+Model Tcn() {
+  Model m("TCN KWS 49x40");
+  Tensor x = Conv(&m, InputTensor(&m, 49, 1, 40), 64, 1, 1, 1);
+  std::vector<int> skips;
+  for (int block = 0; block < 2; ++block) {
+    Tensor y = Conv(&m, x, 64, 3, 1, 1);
+    y = Conv(&m, y, 64, 1, 1, 1);
+    skips.push_back(Conv(&m, y, 32, 1, 1, 1).id);
+    x = Add(&m, x, y);
+  }
+  Tensor sum = {m.Node(skips, Bytes(49, 1, 32)), 49, 1, 32};
+  x = Conv(&m, sum, 64, 1, 1, 1);
+  Classifier(&m, AveragePool(&m, x), 12);
+  return m;
+}
+
+void LogToStdout(const char* s) { fputs(s, stdout); }
+
+double Microseconds(clock_t start) {
+  return (clock() - start) * 1e6 / CLOCKS_PER_SEC / kRuns;
+}
+
+bool CheckLayout(tflite::MicroMemoryPlanner* planner,
+                 const std::vector<Buffer>& buffers, size_t memory_size,
+                 tflite::ErrorReporter* error_reporter) {
+  std::vector<int> offsets(buffers.size());
+  for (size_t i = 0; i < buffers.size(); ++i) {
+    if (planner->GetOffsetForBuffer(error_reporter, static_cast<int>(i),
+                                    &offsets[i]) != kTfLiteOk ||
+        offsets[i] < 0 ||
+        offsets[i] + buffers[i].size > static_cast<int>(memory_size)) {
+      return false;
+    }
+    for (size_t j = 0; j < i; ++j) {
+      const bool overlap_in_time =
+          buffers[i].first_time_used <= buffers[j].last_time_used &&
+          buffers[j].first_time_used <= buffers[i].last_time_used;
+      const bool overlap_in_memory =
+          offsets[i] < offsets[j] + buffers[j].size &&
+          offsets[j] < offsets[i] + buffers[i].size;
+      if (overlap_in_time && overlap_in_memory) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+template <typename Planner>
+void AddBuffers(Planner* planner, const std::vector<Buffer>& buffers,
+                tflite::ErrorReporter* error_reporter) {
+  for (const Buffer& buffer : buffers) {
+    planner->AddBuffer(error_reporter, buffer.size, buffer.first_time_used,
+                       buffer.last_time_used);
+  }
+}
+
+}  // namespace
+
+int main() {
+  RegisterDebugLogCallback(LogToStdout);
+  tflite::MicroErrorReporter error_reporter;
+
+  const Model models[] = {MobileNetV1(), MobileNetV2(), ResNet8(),
+                          MicroSpeech(), DsCnn(),       Autoencoder(),
+                          Tcn()};
+  int failures = 0;
+
+  printf("%-24s %7s %8s %8s %8s %6s %6s %9s %9s\n", "Model", "Buffers",
+         "Greedy", "BnB", "Bound", "Saved", "Steps", "Greedy us", "BnB us");
+  for (const Model& model : models) {
+    const std::vector<Buffer>& buffers = model.buffers();
+    const int count = static_cast<int>(buffers.size());
+
+    std::vector<unsigned char> greedy_scratch(
+        count * tflite::GreedyMemoryPlanner::per_buffer_size());
+    std::vector<unsigned char> search_scratch(
+        count * tflite::BranchAndBoundMemoryPlanner::per_buffer_size());
+    tflite::GreedyMemoryPlanner greedy;
+    tflite::BranchAndBoundMemoryPlanner search;
+
+    // Planning runs on the first query after the buffers are added.
+    size_t greedy_size = 0;
+    clock_t start = clock();
+    for (int run = 0; run < kRuns; ++run) {
+      greedy.Init(greedy_scratch.data(), greedy_scratch.size());
+      AddBuffers(&greedy, buffers, &error_reporter);
+      greedy_size = greedy.GetMaximumMemorySize();
+    }
+    const double greedy_us = Microseconds(start);
+
+    size_t search_size = 0;
+    start = clock();
+    for (int run = 0; run < kRuns; ++run) {
+      search.Init(search_scratch.data(), search_scratch.size());
+      AddBuffers(&search, buffers, &error_reporter);
+      search_size = search.GetMaximumMemorySize();
+    }
+    const double search_us = Microseconds(start);
+
+    const size_t bound = search.GetLowerBoundMemorySize();
+    const bool ok =
+        greedy.GetBufferCount() == count && search.GetBufferCount() == count &&
+        CheckLayout(&greedy, buffers, greedy_size, &error_reporter) &&
+        CheckLayout(&search, buffers, search_size, &error_reporter) &&
+        search.GetGreedyMemorySize() == greedy_size &&
+        search_size <= greedy_size && search_size >= bound;
+    if (!ok) {
+      ++failures;
+    }
+
+    printf("%-24s %7d %8d %8d %8d %5.1f%% %6d %9.1f %9.1f%s\n", model.name(),
+           count, static_cast<int>(greedy_size),
+           static_cast<int>(search_size), static_cast<int>(bound),
+           100.0 * (greedy_size - search_size) / greedy_size,
+           search.GetSearchSteps(), greedy_us, search_us, ok ? "" : " FAIL");
+  }
+
+  // Random buffer sets, for lifetimes that don't come from a chain of layers.
+  srand(1);
+  int better = 0;
+  int at_bound = 0;
+  int greedy_at_bound = 0;
+  long saved_bytes = 0;
+  for (int set = 0; set < kRandomSets; ++set) {
+    const int count = 6 + rand() % 19;
+    const int nodes = 4 + rand() % 13;
+    std::vector<Buffer> buffers;
+    for (int i = 0; i < count; ++i) {
+      const int first = rand() % nodes;
+      const int last = first + rand() % (nodes - first);
+      buffers.push_back({kAlignment * (1 + rand() % 64), first, last});
+    }
+
+    std::vector<unsigned char> greedy_scratch(
+        count * tflite::GreedyMemoryPlanner::per_buffer_size());
+    std::vector<unsigned char> search_scratch(
+        count * tflite::BranchAndBoundMemoryPlanner::per_buffer_size());
+    tflite::GreedyMemoryPlanner greedy;
+    tflite::BranchAndBoundMemoryPlanner search;
+    greedy.Init(greedy_scratch.data(), greedy_scratch.size());
+    search.Init(search_scratch.data(), search_scratch.size());
+    AddBuffers(&greedy, buffers, &error_reporter);
+    AddBuffers(&search, buffers, &error_reporter);
+    const size_t greedy_size = greedy.GetMaximumMemorySize();
+    const size_t search_size = search.GetMaximumMemorySize();
+    const size_t bound = search.GetLowerBoundMemorySize();
+
+    if (!CheckLayout(&greedy, buffers, greedy_size, &error_reporter) ||
+        !CheckLayout(&search, buffers, search_size, &error_reporter) ||
+        search.GetGreedyMemorySize() != greedy_size ||
+        search_size > greedy_size || search_size < bound) {
+      printf("Random set %d FAIL\n", set);
+      ++failures;
+    }
+    better += (search_size < greedy_size) ? 1 : 0;
+    at_bound += (search_size == bound) ? 1 : 0;
+    greedy_at_bound += (greedy_size == bound) ? 1 : 0;
+    saved_bytes += greedy_size - search_size;
+  }
+  printf("%d random sets: smaller than greedy in %d (%ld bytes), at the lower "
+         "bound in %d, greedy in %d\n",
+         kRandomSets, better, saved_bytes, at_bound, greedy_at_bound);
+
+  printf("%d failures\n", failures);
+  return (failures == 0) ? 0 : 1;
+}
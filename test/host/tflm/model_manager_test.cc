@@ -0,0 +1,212 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Host test of MicroModelManager: models sharing one arena must produce the
+// outputs of interpreters with arenas of their own, in less memory, and
+// pending models must run by priority and then in the order they were added.
+// An arena too small for the overlaid plans must fail AllocateTensors().
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "six_node_model.h"
+#include "tensorflow/lite/micro/cortex_m_generic/debug_log_callback.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_model_manager.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+
+namespace {
+
+constexpr int kRounds = 500;
+constexpr size_t kArenaSize = 32768;
+
+alignas(16) uint8_t shared_arena[kArenaSize];
+alignas(16) uint8_t separate_arenas[3][kArenaSize];
+alignas(16) uint8_t small_arena[kArenaSize];
+
+int failures = 0;
+
+void Check(bool condition, const char* what, int round) {
+  if (!condition) {
+    if (round < 0) {
+      printf("FAIL %s\n", what);
+    } else if (failures < 10) {
+      printf("FAIL round %d: %s\n", round, what);
+    }
+    ++failures;
+  }
+}
+
+void LogToStdout(const char* s) { fputs(s, stdout); }
+
+void LogNothing(const char* s) {}
+
+// State of one model of the manager, passed to the callbacks as user data.
+struct ModelState {
+  int id;
+  int size;
+  tflite::MicroInterpreter* reference;
+  std::vector<float> values;
+  std::vector<int8_t> outputs;
+  std::vector<int>* run_order;
+};
+
+TfLiteStatus FillInputs(tflite::MicroInterpreter* interpreter,
+                        void* user_data) {
+  ModelState* state = static_cast<ModelState*>(user_data);
+  memcpy(interpreter->input(0)->data.f, state->values.data(),
+         state->size * sizeof(float));
+  return kTfLiteOk;
+}
+
+void HandleOutputs(tflite::MicroInterpreter* interpreter, void* user_data) {
+  ModelState* state = static_cast<ModelState*>(user_data);
+  memcpy(state->outputs.data(), interpreter->output(0)->data.int8,
+         state->size);
+  state->run_order->push_back(state->id);
+}
+
+}  // namespace
+
+int main() {
+  RegisterDebugLogCallback(LogToStdout);
+
+  tflite::MicroErrorReporter error_reporter;
+  tflite::MicroMutableOpResolver<4> resolver;
+  resolver.AddRelu();
+  resolver.AddAdd();
+  resolver.AddReshape();
+  resolver.AddQuantize();
+
+  // Models 0 and 2 are identical and share the lower priority, model 1 is
+  // smaller and has the higher priority.
+  const int sizes[3] = {512, 128, 512};
+  const int priorities[3] = {1, 2, 1};
+  std::vector<uint8_t> model_data[3];
+  std::vector<tflite::MicroInterpreter*> references;
+  size_t separate_bytes = 0;
+  for (int i = 0; i < 3; ++i) {
+    model_data[i] = BuildSixNodeModel(sizes[i], 0.05f);
+    references.push_back(new tflite::MicroInterpreter(
+        tflite::GetModel(model_data[i].data()), resolver, separate_arenas[i],
+        kArenaSize, &error_reporter));
+    if (references[i]->AllocateTensors() != kTfLiteOk) {
+      printf("FAIL AllocateTensors() of reference %d\n", i);
+      return 1;
+    }
+    // The manager keeps the interpreters in the arena as well.
+    separate_bytes +=
+        references[i]->arena_used_bytes() + sizeof(tflite::MicroInterpreter);
+  }
+
+  std::vector<int> run_order;
+  ModelState states[3];
+  tflite::MicroModelManager manager(shared_arena, kArenaSize, &error_reporter);
+  for (int i = 0; i < 3; ++i) {
+    states[i] = {i,
+                 sizes[i],
+                 references[i],
+                 std::vector<float>(sizes[i]),
+                 std::vector<int8_t>(sizes[i]),
+                 &run_order};
+    if (manager.AddModel(tflite::GetModel(model_data[i].data()), resolver,
+                         priorities[i], FillInputs, HandleOutputs,
+                         &states[i]) != i) {
+      printf("FAIL AddModel() %d\n", i);
+      return 1;
+    }
+  }
+  if (manager.AllocateTensors() != kTfLiteOk) {
+    printf("FAIL AllocateTensors()\n");
+    return 1;
+  }
+  const size_t shared_bytes = manager.arena_used_bytes();
+  Check(shared_bytes < separate_bytes, "shared arena not smaller", -1);
+
+  srand(1);
+  int invokes = 0;
+  for (int round = 0; round < kRounds; ++round) {
+    std::vector<int> requested;
+    for (int i = 0; i < 3; ++i) {
+      if (rand() % 2) {
+        for (float& value : states[i].values) {
+          value = (rand() % 2001 - 1000) / 100.0f;
+        }
+        Check(manager.RequestInvoke(i) == kTfLiteOk, "RequestInvoke()", round);
+        requested.push_back(i);
+      }
+    }
+
+    run_order.clear();
+    int model_id;
+    do {
+      Check(manager.InvokeNext(&model_id) == kTfLiteOk, "InvokeNext()", round);
+    } while (model_id != -1);
+    Check(!manager.HasPendingInvoke(), "invoke still pending", round);
+
+    // Higher priority first, then in the order of AddModel().
+    std::vector<int> expected_order;
+    for (int i : {1, 0, 2}) {
+      for (int id : requested) {
+        if (id == i) {
+          expected_order.push_back(i);
+        }
+      }
+    }
+    Check(run_order == expected_order, "run order", round);
+
+    for (int id : run_order) {
+      ModelState* state = &states[id];
+      tflite::MicroInterpreter* reference = state->reference;
+      memcpy(reference->input(0)->data.f, state->values.data(),
+             state->size * sizeof(float));
+      Check(reference->Invoke() == kTfLiteOk, "Invoke() of reference", round);
+      Check(memcmp(reference->output(0)->data.int8, state->outputs.data(),
+                   state->size) == 0,
+            "output differs from the reference", round);
+      ++invokes;
+    }
+  }
+
+  // In a smaller arena the persistent allocations of a later model grow into
+  // the plan of an earlier one, which AllocateTensors() must report instead of
+  // crashing or overlapping the buffers. The errors logged on the way are
+  // expected.
+  RegisterDebugLogCallback(LogNothing);
+  int too_small = 0;
+  for (size_t arena_size = shared_bytes - 2048; arena_size < shared_bytes;
+       arena_size += 16) {
+    tflite::MicroModelManager small_manager(small_arena, arena_size,
+                                            &error_reporter);
+    for (int i = 0; i < 3; ++i) {
+      small_manager.AddModel(tflite::GetModel(model_data[i].data()), resolver,
+                             priorities[i], FillInputs, HandleOutputs,
+                             &states[i]);
+    }
+    Check(small_manager.AllocateTensors() != kTfLiteOk,
+          "AllocateTensors() in too small arena", -1);
+    ++too_small;
+  }
+  RegisterDebugLogCallback(LogToStdout);
+
+  printf("%d models, %d invokes, shared arena %d bytes, separate arenas %d "
+         "bytes, %d too small arenas rejected, %d failures\n",
+         manager.model_count(), invokes, static_cast<int>(shared_bytes),
+         static_cast<int>(separate_bytes), too_small, failures);
+  return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Test model of the TFLM host tests, built with the flatbuffers API.
+
+#ifndef TEST_HOST_TFLM_SIX_NODE_MODEL_H_
+#define TEST_HOST_TFLM_SIX_NODE_MODEL_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "flatbuffers/flatbuffers.h"  // from @flatbuffers
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+// Model of six nodes with float and int8 tensors, an int32 shape tensor in a
+// buffer and a tensor read by two nodes:
+//
+//   t1 = RELU(t0)
+//   t2 = ADD(t1, t1)
+//   t4 = RESHAPE(t2, t3)
+//   t7 = ADD(t4, t0)
+//   t5 = QUANTIZE(t7)
+//   t6 = RELU(t5)
+//
+// All tensors but t3 have size elements, t5 and t6 are int8 with output_scale.
+//
+// Written in place, t2, t4, t7, t5 and t6 all share the buffer of t1.
+inline std::vector<uint8_t> BuildSixNodeModel(int size, float output_scale) {
+  using flatbuffers::Offset;
+  // The flatbuffers of TFLM do not fall back to the default allocator.
+  flatbuffers::DefaultAllocator allocator;
+  flatbuffers::FlatBufferBuilder builder(1024, &allocator);
+
+  auto vector = [&](std::vector<int32_t> values) {
+    return builder.CreateVector(values);
+  };
+  auto quantization = [&](float scale) {
+    return tflite::CreateQuantizationParameters(
+        builder, 0, 0, builder.CreateVector(std::vector<float>{scale}),
+        builder.CreateVector(std::vector<int64_t>{0}));
+  };
+
+  const int32_t shape_data[2] = {1, size};
+  std::vector<Offset<tflite::Buffer>> buffers = {
+      tflite::CreateBuffer(builder),
+      tflite::CreateBuffer(
+          builder,
+          builder.CreateVector(reinterpret_cast<const uint8_t*>(shape_data),
+                               sizeof(shape_data)))};
+
+  std::vector<Offset<tflite::Tensor>> tensors;
+  for (int i = 0; i < 3; ++i) {
+    tensors.push_back(tflite::CreateTensor(builder, vector({1, size}),
+                                           tflite::TensorType_FLOAT32, 0));
+  }
+  tensors.push_back(tflite::CreateTensor(builder, vector({2}),
+                                         tflite::TensorType_INT32, 1));
+  tensors.push_back(tflite::CreateTensor(builder, vector({1, size}),
+                                         tflite::TensorType_FLOAT32, 0));
+  for (int i = 0; i < 2; ++i) {
+    tensors.push_back(tflite::CreateTensor(builder, vector({1, size}),
+                                           tflite::TensorType_INT8, 0, 0,
+                                           quantization(output_scale)));
+  }
+  tensors.push_back(tflite::CreateTensor(builder, vector({1, size}),
+                                         tflite::TensorType_FLOAT32, 0));
+
+  enum { kRelu, kAdd, kReshape, kQuantize };
+  std::vector<Offset<tflite::OperatorCode>> operator_codes = {
+      tflite::CreateOperatorCode(builder, tflite::BuiltinOperator_RELU, 0, 1,
+                                 tflite::BuiltinOperator_RELU),
+      tflite::CreateOperatorCode(builder, tflite::BuiltinOperator_ADD, 0, 1,
+                                 tflite::BuiltinOperator_ADD),
+      tflite::CreateOperatorCode(builder, tflite::BuiltinOperator_RESHAPE, 0,
+                                 1, tflite::BuiltinOperator_RESHAPE),
+      tflite::CreateOperatorCode(builder, tflite::BuiltinOperator_QUANTIZE, 0,
+                                 1, tflite::BuiltinOperator_QUANTIZE)};
+
+  auto add_options = [&] {
+    return tflite::CreateAddOptions(builder).Union();
+  };
+  std::vector<Offset<tflite::Operator>> operators = {
+      tflite::CreateOperator(builder, kRelu, vector({0}), vector({1})),
+      tflite::CreateOperator(builder, kAdd, vector({1, 1}), vector({2}),
+                             tflite::BuiltinOptions_AddOptions,
+                             add_options()),
+      tflite::CreateOperator(builder, kReshape, vector({2, 3}), vector({4})),
+      tflite::CreateOperator(builder, kAdd, vector({4, 0}), vector({7}),
+                             tflite::BuiltinOptions_AddOptions,
+                             add_options()),
+      tflite::CreateOperator(builder, kQuantize, vector({7}), vector({5})),
+      tflite::CreateOperator(builder, kRelu, vector({5}), vector({6}))};
+
+  auto subgraph = tflite::CreateSubGraph(
+      builder, builder.CreateVector(tensors), vector({0}), vector({6}),
+      builder.CreateVector(operators));
+  builder.Finish(
+      tflite::CreateModel(
+          builder, TFLITE_SCHEMA_VERSION, builder.CreateVector(operator_codes),
+          builder.CreateVector(
+              std::vector<Offset<tflite::SubGraph>>{subgraph}),
+          0, builder.CreateVector(buffers)),
+      tflite::ModelIdentifier());
+
+  return std::vector<uint8_t>(builder.GetBufferPointer(),
+                              builder.GetBufferPointer() + builder.GetSize());
+}
+
+#endif  // TEST_HOST_TFLM_SIX_NODE_MODEL_H_